@@ -0,0 +1,907 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "include/amvarena.hpp"
+#include "include/amvpool.hpp"
+#include "include/amvstr.hpp"
+
+using AMV::CAmvArenaHeap;
+using AMV::CAmvArenaStringMgr;
+using AMV::CAmvHeap;
+using AMV::CAmvPoolHeap;
+using AMV::CAmvStringMgr;
+using AMV::IAmvStringMgr;
+
+namespace
+{
+/* 메모리 관리자 MemMgr를 사용하는 문자열 관리자.  할당자를 비교하려면
+ * 아래의 BENCHMARK_TEMPLATE에 메모리 관리자 타입을 추가한다. */
+template <class MemMgr>
+IAmvStringMgr *StringMgr()
+{
+    static MemMgr mem;
+    static CAmvStringMgr mgr(&mem);
+    return &mgr;
+}
+
+std::string Text(size_t nLength)
+{
+    static const char kWords[] = "lorem ipsum dolor sit amet consectetur ";
+    std::string s;
+
+    while (s.size() < nLength)
+        s += kWords;
+    s.resize(nLength);
+    return s;
+}
+
+// state.range(0): 문자열 길이
+template <class MemMgr>
+void BM_BStringConstruct(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+    std::string text = Text(state.range(0));
+
+    for (auto _ : state)
+    {
+        BString s(text.c_str(), pMgr);
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK_TEMPLATE(BM_BStringConstruct, CAmvHeap)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_BStringConstruct, CAmvArenaHeap)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_BStringConstruct, CAmvPoolHeap)->Range(8, 4096);
+
+void BM_StdStringConstruct(benchmark::State &state)
+{
+    std::string text = Text(state.range(0));
+
+    for (auto _ : state)
+    {
+        std::string s(text.c_str());
+        benchmark::DoNotOptimize(s.data());
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_StdStringConstruct)->Range(8, 4096);
+
+// state.range(0): 16 Byte 조각을 붙이는 횟수
+template <class MemMgr>
+void BM_BStringAppend(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+    const char *piece = "0123456789abcdef";
+
+    for (auto _ : state)
+    {
+        BString s(pMgr);
+        for (int64_t n = 0; n < state.range(0); n++)
+            s += piece;
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    SetBytesAndCycles(state, 16 * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_BStringAppend, CAmvHeap)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_BStringAppend, CAmvArenaHeap)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_BStringAppend, CAmvPoolHeap)->Range(1, 4096);
+
+void BM_StdStringAppend(benchmark::State &state)
+{
+    const char *piece = "0123456789abcdef";
+
+    for (auto _ : state)
+    {
+        std::string s;
+        for (int64_t n = 0; n < state.range(0); n++)
+            s += piece;
+        benchmark::DoNotOptimize(s.data());
+    }
+    SetBytesAndCycles(state, 16 * state.range(0));
+}
+BENCHMARK(BM_StdStringAppend)->Range(1, 4096);
+
+// 요청 로그 한 줄: 문자열 여러 개를 operator+로 잇는다.
+// state.range(0): 각 field의 길이
+void BM_BStringConcat(benchmark::State &state)
+{
+    BString method("GET"), status("200");
+    BString path(std::string(state.range(0), 'p').c_str());
+    BString agent(std::string(state.range(0), 'a').c_str());
+
+    for (auto _ : state)
+    {
+        BString line = method + ' ' + path + " status=" + status + " agent=" + agent + '\n';
+        benchmark::DoNotOptimize(line.GetString());
+    }
+    SetBytesAndCycles(state, 2 * state.range(0) + 24);
+}
+BENCHMARK(BM_BStringConcat)->Range(8, 4096);
+
+// 같은 줄을 BString::Concat()으로 한 번에 할당해서 만든다.
+void BM_BStringConcatOnce(benchmark::State &state)
+{
+    BString method("GET"), status("200");
+    BString path(std::string(state.range(0), 'p').c_str());
+    BString agent(std::string(state.range(0), 'a').c_str());
+
+    for (auto _ : state)
+    {
+        BString line =
+            BString::Concat(method, ' ', path, " status=", status, " agent=", agent, '\n');
+        benchmark::DoNotOptimize(line.GetString());
+    }
+    SetBytesAndCycles(state, 2 * state.range(0) + 24);
+}
+BENCHMARK(BM_BStringConcatOnce)->Range(8, 4096);
+
+void BM_StdStringConcat(benchmark::State &state)
+{
+    std::string method("GET"), status("200");
+    std::string path(state.range(0), 'p');
+    std::string agent(state.range(0), 'a');
+
+    for (auto _ : state)
+    {
+        std::string line = method + ' ' + path + " status=" + status + " agent=" + agent + '\n';
+        benchmark::DoNotOptimize(line.data());
+    }
+    SetBytesAndCycles(state, 2 * state.range(0) + 24);
+}
+BENCHMARK(BM_StdStringConcat)->Range(8, 4096);
+
+// BM_BStringAppend와 같은 내용을 BStringBuilder로 모은다.  builder는
+// Empty()로 chunk를 남겨 다시 쓴다.
+void BM_BStringBuilder(benchmark::State &state)
+{
+    const char *piece = "0123456789abcdef";
+    BStringBuilder builder;
+
+    for (auto _ : state)
+    {
+        builder.Empty();
+        for (int64_t n = 0; n < state.range(0); n++)
+            builder += piece;
+        BString s = builder.ToString();
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    SetBytesAndCycles(state, 16 * state.range(0));
+}
+BENCHMARK(BM_BStringBuilder)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_BStringAppend, CAmvHeap)->Arg(1 << 16);
+
+/* 로그 한 줄처럼 한 글자씩 붙여 긴 문자열을 만든다.
+ * state.range(0): 문자열 길이 */
+template <class MemMgr>
+void BM_BStringAppendChar(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+
+    for (auto _ : state)
+    {
+        BString s(pMgr);
+        for (int64_t n = 0; n < state.range(0); n++)
+            s.AppendChar(static_cast<char>('a' + n % 26));
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    SetBytesAndCycles(state, state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_BStringAppendChar, CAmvHeap)->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(BM_BStringAppendChar, CAmvPoolHeap)->Range(64, 1 << 20);
+
+void BM_StdStringAppendChar(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        std::string s;
+        for (int64_t n = 0; n < state.range(0); n++)
+            s += static_cast<char>('a' + n % 26);
+        benchmark::DoNotOptimize(s.data());
+    }
+    SetBytesAndCycles(state, state.range(0));
+}
+BENCHMARK(BM_StdStringAppendChar)->Range(64, 1 << 20);
+
+/* 모든 "dolor"를 "pain"으로 바꾼다.  원본은 공유 상태에서 복사하므로
+ * 매번 copy-on-write 분기와 치환이 함께 측정된다. */
+template <class MemMgr>
+void BM_BStringReplace(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+    std::string text = Text(state.range(0));
+    BString src(text.c_str(), pMgr);
+
+    for (auto _ : state)
+    {
+        BString s(src);
+        benchmark::DoNotOptimize(s.Replace("dolor", "pain"));
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK_TEMPLATE(BM_BStringReplace, CAmvHeap)->Range(64, 1 << 16);
+
+// 길어지는 치환: "sit"를 "sit down"으로
+void BM_BStringReplaceGrow(benchmark::State &state)
+{
+    std::string text = Text(state.range(0));
+    BString src(text.c_str());
+
+    for (auto _ : state)
+    {
+        BString s(src);
+        benchmark::DoNotOptimize(s.Replace("sit", "sit down"));
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringReplaceGrow)->Range(64, 1 << 16);
+
+void BM_StdStringReplaceGrow(benchmark::State &state)
+{
+    std::string text = Text(state.range(0));
+
+    for (auto _ : state)
+    {
+        std::string s(text);
+        for (size_t i = s.find("sit"); i != std::string::npos; i = s.find("sit", i + 8))
+            s.replace(i, 3, "sit down");
+        benchmark::DoNotOptimize(s.data());
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_StdStringReplaceGrow)->Range(64, 1 << 16);
+
+/* 서식 채우기: 약 40 Byte마다 "{key0}" ~ "{key15}" 중 하나가 있는 문서에서
+ * 16개의 자리 표시자를 바꾼다.  ReplaceAll은 한 번, 비교용 Replace는
+ * 자리 표시자마다 한 번씩 훑는다. */
+std::string TemplateText(size_t nLength)
+{
+    static const char kWords[] = "lorem ipsum dolor sit amet consectetur ";
+    std::string s;
+
+    for (int i = 0; s.size() < nLength; i++)
+        s += kWords + ("{key" + std::to_string(i % 16) + "} ");
+    s.resize(nLength);
+    return s;
+}
+
+std::vector<std::pair<std::string, std::string>> TemplateKeys()
+{
+    std::vector<std::pair<std::string, std::string>> keys;
+
+    for (int i = 0; i < 16; i++)
+        keys.push_back(std::make_pair("{key" + std::to_string(i) + "}",
+                                      "value #" + std::to_string(i)));
+    return keys;
+}
+
+void BM_BStringReplaceAll(benchmark::State &state)
+{
+    std::string text = TemplateText(state.range(0));
+    BString src(text.c_str());
+    AMV::CAmvReplaceSet set;
+    for (const std::pair<std::string, std::string> &key : TemplateKeys())
+        set.Add(key.first.c_str(), key.second.c_str());
+    set.Build();
+
+    for (auto _ : state)
+    {
+        BString s(src);
+        benchmark::DoNotOptimize(s.ReplaceAll(set));
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringReplaceAll)->Range(64, 1 << 16);
+
+void BM_BStringReplaceEach(benchmark::State &state)
+{
+    std::string text = TemplateText(state.range(0));
+    BString src(text.c_str());
+    const std::vector<std::pair<std::string, std::string>> keys = TemplateKeys();
+
+    for (auto _ : state)
+    {
+        BString s(src);
+        for (const std::pair<std::string, std::string> &key : keys)
+            s.Replace(key.first.c_str(), key.second.c_str());
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringReplaceEach)->Range(64, 1 << 16);
+
+/* CSV 읽기: 줄마다 field를 나눠 첫 field의 길이를 더한다.  View는 원래
+ * 문자열을 가리키기만 하고, 비교용은 field마다 BString을 만든다. */
+std::string CsvText(size_t nLength)
+{
+    std::string s;
+
+    for (int i = 0; s.size() < nLength; i++)
+        s += std::to_string(i) + ",lorem ipsum,dolor," + std::to_string(i * 7 % 100) + ",\n";
+    s.resize(nLength);
+    return s;
+}
+
+void BM_BStringViewCsv(benchmark::State &state)
+{
+    std::string text = CsvText(state.range(0));
+    BString csv(text.c_str());
+
+    for (auto _ : state)
+    {
+        int nSum = 0;
+        BStringTokenizer lines(csv, '\n');
+        BStringView line;
+        while (lines.Next(line))
+        {
+            BStringTokenizer fields(line, ',', true);
+            BStringView field;
+            while (fields.Next(field))
+                nSum += field.GetLength();
+        }
+        benchmark::DoNotOptimize(nSum);
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringViewCsv)->Range(64, 1 << 16);
+
+void BM_BStringCopyCsv(benchmark::State &state)
+{
+    std::string text = CsvText(state.range(0));
+    BString csv(text.c_str());
+
+    for (auto _ : state)
+    {
+        int nSum = 0;
+        for (int iLine = 0; iLine < csv.GetLength();)
+        {
+            int iEnd = csv.Find('\n', iLine);
+            if (iEnd < 0)
+                iEnd = csv.GetLength();
+            BString line(BStringView(csv).Mid(iLine, iEnd - iLine));
+            for (int iField = 0; iField <= line.GetLength();)
+            {
+                int iComma = line.Find(',', iField);
+                if (iComma < 0)
+                    iComma = line.GetLength();
+                BString field(BStringView(line).Mid(iField, iComma - iField));
+                nSum += field.GetLength();
+                iField = iComma + 1;
+            }
+            iLine = iEnd + 1;
+        }
+        benchmark::DoNotOptimize(nSum);
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringCopyCsv)->Range(64, 1 << 16);
+
+// 문자열 끝에 있는 부분 문자열 찾기
+template <class MemMgr>
+void BM_BStringFind(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+    std::string text = Text(state.range(0)) + "needle";
+    BString s(text.c_str(), pMgr);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(s.Find("needle"));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK_TEMPLATE(BM_BStringFind, CAmvHeap)->Range(64, 1 << 16);
+
+void BM_BStringFindChar(benchmark::State &state)
+{
+    std::string text = Text(state.range(0)) + "#";
+    BString s(text.c_str());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(s.Find('#'));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringFindChar)->Range(64, 1 << 16);
+
+void BM_StdStringFind(benchmark::State &state)
+{
+    std::string text = Text(state.range(0)) + "needle";
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(text.find("needle"));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_StdStringFind)->Range(64, 1 << 16);
+
+/* 길이가 같은 두 문자열의 비교.  마지막 글자만 다르다.
+ * state.range(0): 문자열 길이 */
+void BM_BStringEqual(benchmark::State &state)
+{
+    std::string text = Text(state.range(0));
+    BString a(text.c_str());
+    text.back() = '#';
+    BString b(text.c_str());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a == b);
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringEqual)->Range(64, 1 << 16);
+
+// 길이가 다르면 내용을 보지 않는다
+void BM_BStringNotEqualLength(benchmark::State &state)
+{
+    BString a(Text(state.range(0)).c_str());
+    BString b(Text(state.range(0) - 1).c_str());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a == b);
+    SetBytesAndCycles(state, state.range(0));
+}
+BENCHMARK(BM_BStringNotEqualLength)->Range(64, 1 << 16);
+
+void BM_BStringCompareNoCase(benchmark::State &state)
+{
+    std::string text = Text(state.range(0));
+    BString a(text.c_str());
+    for (char &ch : text)
+        ch = static_cast<char>(toupper(ch));
+    BString b(text.c_str());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.CompareNoCase(b));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringCompareNoCase)->Range(64, 1 << 16);
+
+/* 로그 정리에 쓰는 문자 집합 검색과 한 글자 치환.  모두 문자열 끝까지 훑는다.
+ * state.range(0): 문자열 길이 */
+void BM_BStringFindOneOf(benchmark::State &state)
+{
+    std::string text = Text(state.range(0)) + "\n";
+    BString s(text.c_str());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(s.FindOneOf("\r\n\t\"'"));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringFindOneOf)->Range(64, 1 << 16);
+
+void BM_StdStringFindFirstOf(benchmark::State &state)
+{
+    std::string text = Text(state.range(0)) + "\n";
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(text.find_first_of("\r\n\t\"'"));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_StdStringFindFirstOf)->Range(64, 1 << 16);
+
+void BM_BStringReverseFind(benchmark::State &state)
+{
+    std::string text = "#" + Text(state.range(0));
+    BString s(text.c_str());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(s.ReverseFind('#'));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringReverseFind)->Range(64, 1 << 16);
+
+void BM_BStringTrimLeft(benchmark::State &state)
+{
+    std::string text = std::string(state.range(0), ' ') + "x";
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        BString s(text.c_str());
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(s.TrimLeft(" \t\r\n").GetString());
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringTrimLeft)->Range(64, 1 << 16);
+
+void BM_BStringReplaceChar(benchmark::State &state)
+{
+    BString s(Text(state.range(0)).c_str());
+
+    // 매번 되돌리므로 두 번 치환한다
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(s.Replace(' ', '_'));
+        benchmark::DoNotOptimize(s.Replace('_', ' '));
+    }
+    SetBytesAndCycles(state, 2 * s.GetLength());
+}
+BENCHMARK(BM_BStringReplaceChar)->Range(64, 1 << 16);
+
+void BM_BStringRemove(benchmark::State &state)
+{
+    std::string text = Text(state.range(0));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        BString s(text.c_str());
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(s.Remove(' '));
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringRemove)->Range(64, 1 << 16);
+
+/* 복사는 참조 계수만 올리고, 처음 쓰는 순간 버퍼를 새로 할당해
+ * 복사한다(copy-on-write fork). */
+template <class MemMgr>
+void BM_BStringCopyOnWrite(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+    std::string text = Text(state.range(0));
+    BString src(text.c_str(), pMgr);
+
+    for (auto _ : state)
+    {
+        BString s(src);
+        s.SetAt(0, 'L');
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK_TEMPLATE(BM_BStringCopyOnWrite, CAmvHeap)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_BStringCopyOnWrite, CAmvArenaHeap)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_BStringCopyOnWrite, CAmvPoolHeap)->Range(8, 1 << 16);
+
+// 복사만 하고 쓰지 않으면 할당이 없다
+template <class MemMgr>
+void BM_BStringCopyShared(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+    std::string text = Text(state.range(0));
+    BString src(text.c_str(), pMgr);
+
+    for (auto _ : state)
+    {
+        BString s(src);
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK_TEMPLATE(BM_BStringCopyShared, CAmvHeap)->Range(8, 1 << 16);
+
+// 한 thread에서만 쓰는 관리자는 참조 계수를 원자 연산 없이 바꾼다
+void BM_BStringCopyConfined(benchmark::State &state)
+{
+    static CAmvHeap mem;
+    static CAmvStringMgr mgr(&mem);
+    mgr.SetThreadConfined(true);
+    std::string text = Text(state.range(0));
+    BString src(text.c_str(), &mgr);
+
+    for (auto _ : state)
+    {
+        BString s(src);
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_BStringCopyConfined)->Range(8, 1 << 16);
+
+/* 긴 문자열을 vector에 채운다.  옮기기(move)는 참조 계수를 건드리지 않고,
+ * vector가 커질 때도 원소를 옮긴다. */
+template <class MemMgr>
+void BM_BStringVectorFill(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+    BString src(Text(64).c_str(), pMgr);
+
+    for (auto _ : state)
+    {
+        std::vector<BString> v;
+        for (int64_t n = 0; n < state.range(0); n++)
+        {
+            BString s(src);
+            v.push_back(std::move(s));
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_BStringVectorFill, CAmvHeap)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_BStringVectorFill, CAmvPoolHeap)->Range(8, 4096);
+
+/* 여러 thread가 같은 문자열 관리자로 짧게 쓰고 버리는 문자열을 만든다.
+ * state.range(0): 문자열 길이 */
+template <class MemMgr>
+void BM_BStringChurn(benchmark::State &state)
+{
+    IAmvStringMgr *pMgr = StringMgr<MemMgr>();
+    std::string text = Text(state.range(0));
+
+    for (auto _ : state)
+    {
+        BString s(text.c_str(), pMgr);
+        s += "; ";
+        benchmark::DoNotOptimize(s.GetString());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_BStringChurn, CAmvHeap)
+    ->Arg(64)
+    ->Arg(1024)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_BStringChurn, CAmvPoolHeap)
+    ->Arg(64)
+    ->Arg(1024)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+// CAmvArenaStringMgr와 비교할 malloc 기반 문자열 관리자
+class CHeapStringMgr : public CAmvStringMgr
+{
+public:
+    CHeapStringMgr() : CAmvStringMgr(&m_heap) {}
+
+private:
+    CAmvHeap m_heap;
+};
+
+void ResetStringMgr(CHeapStringMgr *) {}
+void ResetStringMgr(CAmvArenaStringMgr *pMgr) { pMgr->Reset(); }
+
+/* 요청 하나를 처리하는 동안 만든 임시 문자열이 한꺼번에 없어지는 상황.
+ * state.range(0): 요청 하나에서 만드는 문자열 수 */
+template <class StringMgr>
+void BM_BStringRequest(benchmark::State &state)
+{
+    StringMgr mgr;
+    std::string text = Text(200);
+
+    for (auto _ : state)
+    {
+        {
+            std::vector<BString> v;
+            v.reserve(state.range(0));
+            for (int64_t n = 0; n < state.range(0); n++)
+            {
+                BString s(text.c_str() + n % 150, &mgr);
+                s += "; ";
+                v.push_back(std::move(s));
+            }
+            benchmark::DoNotOptimize(v.data());
+        }
+        ResetStringMgr(&mgr);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_BStringRequest, CHeapStringMgr)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_BStringRequest, CAmvArenaStringMgr)->Range(8, 4096);
+
+/* 해시 함수 자체의 처리량.
+ * state.range(0): 문자열 길이 */
+void BM_AmvHash(benchmark::State &state)
+{
+    std::string text = Text(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(AMV::AmvHash(text.data(), text.size()));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_AmvHash)->Range(8, 1 << 16);
+
+void BM_StdStringHash(benchmark::State &state)
+{
+    std::string text = Text(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(std::hash<std::string>()(text));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_StdStringHash)->Range(8, 1 << 16);
+
+/* 같은 BString key로 unordered_map을 반복해서 찾는다.  AMV_STRING_CACHE_HASH로
+ * 빌드하면 key마다 한 번만 해시한다.
+ * state.range(0): key 길이 */
+void BM_BStringMapFind(benchmark::State &state)
+{
+    std::unordered_map<BString, int> map;
+    std::vector<BString> keys;
+    for (int i = 0; i < 1024; i++)
+    {
+        BString key(Text(state.range(0)).c_str());
+        key.SetAt(i % key.GetLength(), static_cast<char>('A' + i % 26));
+        key.SetAt((i / 26) % key.GetLength(), static_cast<char>('a' + i / 26 % 26));
+        map[key] = i;
+        keys.push_back(key);
+    }
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(map.find(keys[i]));
+        i = (i + 1) % keys.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BStringMapFind)->Range(8, 4096);
+
+void BM_StdStringMapFind(benchmark::State &state)
+{
+    std::unordered_map<std::string, int> map;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1024; i++)
+    {
+        std::string key = Text(state.range(0));
+        key[i % key.size()] = static_cast<char>('A' + i % 26);
+        key[(i / 26) % key.size()] = static_cast<char>('a' + i / 26 % 26);
+        map[key] = i;
+        keys.push_back(key);
+    }
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(map.find(keys[i]));
+        i = (i + 1) % keys.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StdStringMapFind)->Range(8, 4096);
+
+/* 중복이 많은 header 이름을 받아 저장한다.  Intern은 이미 있는 내용이면 할당
+ * 없이 공유 버퍼를 돌려준다.
+ * state.range(0): 서로 다른 이름의 개수 */
+void BM_BStringIntern(benchmark::State &state)
+{
+    BStringPool pool;
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < state.range(0); i++)
+        names.push_back("X-Request-Header-Name-" + std::to_string(i));
+
+    std::vector<BString> v(4096);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const std::string &name = names[i % names.size()];
+        v[i % v.size()] = pool.Intern(BStringView(name.data(), static_cast<int>(name.size())));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BStringIntern)->Range(8, 4096);
+
+void BM_BStringNoIntern(benchmark::State &state)
+{
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < state.range(0); i++)
+        names.push_back("X-Request-Header-Name-" + std::to_string(i));
+
+    std::vector<BString> v(4096);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const std::string &name = names[i % names.size()];
+        v[i % v.size()] = BString(BStringView(name.data(), static_cast<int>(name.size())));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BStringNoIntern)->Range(8, 4096);
+
+/* 고정 길이 필드 조립.  inline 용량보다 긴 필드를 BString과 스택 버퍼의
+ * BInlineString으로 만든다. */
+template <class TString>
+void BM_FixedField(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        TString s;
+        s += "2022-01-01T00:00:00.000000Z";
+        s += " id=";
+        s += "0123456789abcdef";
+        benchmark::DoNotOptimize(s.GetString());
+    }
+}
+BENCHMARK_TEMPLATE(BM_FixedField, BString);
+BENCHMARK_TEMPLATE(BM_FixedField, BInlineString<64>);
+
+/* 로그 한 줄 만들기.  snprintf로 std::string에 쓰고 BString으로 복사하는
+ * 방법과 Format()으로 버퍼에 바로 쓰는 방법을 비교한다. */
+void BM_LogLineSprintf(benchmark::State &state)
+{
+    BString line;
+    int i = 0;
+    for (auto _ : state)
+    {
+        std::string text(128, '\0');
+        int n = snprintf(&text[0], text.size(), "%s [%d] request id=%08x took %.3f ms",
+                         "2022-01-02T03:04:05Z", i, i * 7919u, i * 0.25);
+        text.resize(n);
+        line = text.c_str();
+        benchmark::DoNotOptimize(line.GetString());
+        // 자릿수가 비슷하도록 값의 범위를 묶는다
+        i = (i + 1) & 1023;
+    }
+}
+BENCHMARK(BM_LogLineSprintf);
+
+void BM_LogLineFormat(benchmark::State &state)
+{
+    BString line;
+    int i = 0;
+    for (auto _ : state)
+    {
+        line.Format("{} [{}] request id={:08x} took {:.3f} ms", "2022-01-02T03:04:05Z", i,
+                    i * 7919u, i * 0.25);
+        benchmark::DoNotOptimize(line.GetString());
+        i = (i + 1) & 1023;
+    }
+}
+BENCHMARK(BM_LogLineFormat);
+
+/* UTF-8 검사.  한글 위주의 문자열로 SIMD 커널과 scalar를 비교한다.
+ * state.range(0): 문자열 길이 */
+std::string Utf8Text(size_t nLength)
+{
+    static const char *apszWords[] = {"한글 ", "문자열 ", "text ", "검사 ", "😀 "};
+    std::string s;
+    // 잘린 sequence가 남지 않게 단어 단위로 채운다
+    for (size_t i = 0; s.size() + strlen(apszWords[i % 5]) <= nLength; i++)
+        s += apszWords[i % 5];
+    return s;
+}
+
+void BM_Utf8Validate(benchmark::State &state)
+{
+    std::string text = Utf8Text(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(AMV::AmvUtf8Validate(text.data(), text.size()));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_Utf8Validate)->Range(8, 1 << 16);
+
+void BM_Utf8ValidateScalar(benchmark::State &state)
+{
+    std::string text = Utf8Text(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(AMV::AmvSimd::Utf8ValidateScalar(text.data(), text.size()));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_Utf8ValidateScalar)->Range(8, 1 << 16);
+
+/* 문자열 끝까지 code point 단위로 넘기.  ChTraitsUtf8::CharAdvance()와 byte 단위 walk를 비교한다.
+ * state.range(0): 문자열 길이 */
+void BM_Utf8Advance(benchmark::State &state)
+{
+    std::string text = Utf8Text(state.range(0));
+    size_t nChars = AMV::AmvUtf8Count(text.data(), text.size());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(AMV::AmvUtf8Advance(text.data(), text.size(), nChars));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_Utf8Advance)->Range(8, 1 << 16);
+
+void BM_Utf8AdvanceScalar(benchmark::State &state)
+{
+    std::string text = Utf8Text(state.range(0));
+    size_t nChars = AMV::AmvUtf8Count(text.data(), text.size());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            AMV::AmvSimd::Utf8AdvanceScalar(text.data(), text.size(), nChars));
+    SetBytesAndCycles(state, text.size());
+}
+BENCHMARK(BM_Utf8AdvanceScalar)->Range(8, 1 << 16);
+
+}  // namespace
@@ -0,0 +1,257 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "include/CAria.hpp"
+#include "include/CAriaGcm.hpp"
+#include "include/CAriaKey.hpp"
+#include "include/CAriaParallel.hpp"
+
+using Awesome_mix_vol_1::CAria;
+using Awesome_mix_vol_1::CAriaBackend;
+using Awesome_mix_vol_1::CAriaGcm;
+using Awesome_mix_vol_1::CAriaKey;
+using Awesome_mix_vol_1::CAriaParallel;
+
+namespace
+{
+const Byte kMasterKey[32] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                             0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+                             0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+                             0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10};
+const Byte kIv[16] = {0x0f, 0x1e, 0x2d, 0x3c, 0x4b, 0x5a, 0x69, 0x78,
+                      0x87, 0x96, 0xa5, 0xb4, 0xc3, 0xd2, 0xe1, 0xf0};
+
+// 16 B ~ 16 MiB
+const int64_t kMinBytes = 16;
+const int64_t kMaxBytes = 16 << 20;
+
+// state.range(0): key bits
+void BM_Crypt(benchmark::State &state)
+{
+    CAria aria;
+    Byte rk[16 * 17], block[16] = {0};
+    int Nr = aria.EncKeySetup(kMasterKey, rk, state.range(0));
+
+    for (auto _ : state)
+    {
+        aria.Crypt(block, Nr, rk, block);
+        benchmark::DoNotOptimize(block);
+    }
+    SetBytesAndCycles(state, 16);
+}
+BENCHMARK(BM_Crypt)->Arg(128)->Arg(192)->Arg(256);
+
+void BM_EncKeySetup(benchmark::State &state)
+{
+    CAria aria;
+    Byte rk[16 * 17];
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(aria.EncKeySetup(kMasterKey, rk, state.range(0)));
+        benchmark::ClobberMemory();
+    }
+    SetBytesAndCycles(state, state.range(0) / 8);
+}
+BENCHMARK(BM_EncKeySetup)->Arg(128)->Arg(192)->Arg(256);
+
+void BM_DecKeySetup(benchmark::State &state)
+{
+    CAria aria;
+    Byte rk[16 * 17];
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(aria.DecKeySetup(kMasterKey, rk, state.range(0)));
+        benchmark::ClobberMemory();
+    }
+    SetBytesAndCycles(state, state.range(0) / 8);
+}
+BENCHMARK(BM_DecKeySetup)->Arg(128)->Arg(192)->Arg(256);
+
+void BM_KeyObjectSetup(benchmark::State &state)
+{
+    CAriaKey key;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(key.Setup(kMasterKey, state.range(0)));
+        benchmark::ClobberMemory();
+    }
+    SetBytesAndCycles(state, state.range(0) / 8);
+}
+BENCHMARK(BM_KeyObjectSetup)->Arg(128)->Arg(192)->Arg(256);
+
+/* 백엔드 하나의 CryptBlocks() 처리량(bytes/s).  짧게 재므로 대략적인 값이다. */
+double MeasureBackend(const CAriaBackend *backend, const Byte *rk, int Nr,
+                      const std::vector<Byte> &in, std::vector<Byte> *out)
+{
+    using Clock = std::chrono::steady_clock;
+    const size_t nBlocks = in.size() / 16;
+    size_t nDone = 0;
+    const Clock::time_point start = Clock::now();
+    Clock::duration elapsed;
+
+    do
+    {
+        backend->CryptBlocks(in.data(), nBlocks, Nr, rk, out->data());
+        benchmark::ClobberMemory();
+        nDone += in.size();
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(20));
+    return nDone / std::chrono::duration<double>(elapsed).count();
+}
+
+/* 자동으로 선택된 백엔드가 실제로 가장 빠른지 확인한다.  목록 순서가 틀렸거나
+ * 느린 대체 구현이 선택되었으면 결과를 에러로 남긴다.  counters에 백엔드별
+ * 처리량을 가장 빠른 것에 대한 비율로 기록한다. */
+void BM_SelectedBackend(benchmark::State &state)
+{
+    CAria aria;
+    Byte rk[16 * 17];
+    int Nr = aria.EncKeySetup(kMasterKey, rk, 128);
+    std::vector<Byte> in = BenchInput(64 << 10), out(in.size());
+    const CAriaBackend *selected = CAria::GetBackend();
+    const CAriaBackend *fastest = selected;
+    double selectedRate = 0, bestRate = 0;
+
+    for (const CAriaBackend *const *b = CAria::GetBackends(); *b; b++)
+    {
+        double rate = MeasureBackend(*b, rk, Nr, in, &out);
+        state.counters[(*b)->name] = rate;
+        if (*b == selected)
+            selectedRate = rate;
+        if (rate > bestRate)
+        {
+            bestRate = rate;
+            fastest = *b;
+        }
+    }
+    for (auto &counter : state.counters)
+        counter.second = counter.second / bestRate;
+
+    // 측정 오차를 감안해 가장 빠른 것의 3/4 이상이면 통과
+    if (selectedRate < bestRate * 0.75)
+    {
+        std::string error = std::string("selected backend ") + selected->name +
+                            " is slower than " + fastest->name;
+        state.SkipWithError(error.c_str());
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        selected->CryptBlocks(in.data(), in.size() / 16, Nr, rk, out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    SetBytesAndCycles(state, in.size());
+    state.SetLabel(selected->name);
+}
+BENCHMARK(BM_SelectedBackend);
+
+/* 대량 처리 모드.  백엔드마다 등록하고 state.range(0)이 입력 크기이다.
+ * CAriaKey는 Setup() 당시의 백엔드에 맞춰 준비되므로 백엔드를 바꾼 다음에
+ * 만든다. */
+enum BulkMode
+{
+    kCtr,
+    kEcbEncrypt,
+    kEcbDecrypt,
+    kCbcEncrypt,
+    kCbcDecrypt,
+    kGcmEncrypt,
+    kParallelCtr,
+};
+
+void BM_Bulk(benchmark::State &state, const CAriaBackend *backend,
+             BulkMode mode)
+{
+    CAria aria;
+    const size_t len = state.range(0);
+    std::vector<Byte> in = BenchInput(len), out(len);
+    Byte tag[16];
+
+    if (CAria::SetBackend(backend->name) != 0)
+    {
+        state.SkipWithError("backend not available");
+        return;
+    }
+    std::shared_ptr<CAriaKey> key = std::make_shared<CAriaKey>();
+    key->Setup(kMasterKey, 128);
+    CAriaGcm gcm;
+    gcm.SetKey(key);
+    CAriaParallel parallel;
+
+    for (auto _ : state)
+    {
+        switch (mode)
+        {
+        case kCtr:
+            aria.CtrCrypt(in.data(), len, kIv, *key, out.data());
+            break;
+        case kEcbEncrypt:
+            aria.EcbEncrypt(in.data(), len, *key, out.data());
+            break;
+        case kEcbDecrypt:
+            aria.EcbDecrypt(in.data(), len, *key, out.data());
+            break;
+        case kCbcEncrypt:
+            aria.CbcEncrypt(in.data(), len, kIv, *key, out.data());
+            break;
+        case kCbcDecrypt:
+            aria.CbcDecrypt(in.data(), len, kIv, *key, out.data());
+            break;
+        case kGcmEncrypt:
+            gcm.Encrypt(kIv, 12, NULL, 0, in.data(), len, out.data(), tag, 16);
+            break;
+        case kParallelCtr:
+            parallel.CtrCrypt(in.data(), len, kIv, *key, out.data());
+            break;
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    SetBytesAndCycles(state, len);
+
+    CAria::SetBackend(NULL);
+}
+
+int RegisterBulkBenchmarks()
+{
+    static const struct
+    {
+        const char *name;
+        BulkMode mode;
+    } modes[] = {
+        {"CtrCrypt", kCtr},
+        {"EcbEncrypt", kEcbEncrypt},
+        {"EcbDecrypt", kEcbDecrypt},
+        {"CbcEncrypt", kCbcEncrypt},
+        {"CbcDecrypt", kCbcDecrypt},
+        {"GcmEncrypt", kGcmEncrypt},
+        {"ParallelCtrCrypt", kParallelCtr},
+    };
+
+    for (const auto &m : modes)
+    {
+        for (const CAriaBackend *const *b = CAria::GetBackends(); *b; b++)
+        {
+            std::string name = std::string("BM_") + m.name + "/" + (*b)->name;
+            benchmark::RegisterBenchmark(name.c_str(), BM_Bulk, *b, m.mode)
+                ->RangeMultiplier(16)
+                ->Range(kMinBytes, kMaxBytes);
+        }
+    }
+    return 0;
+}
+const int kBulkRegistered = RegisterBulkBenchmarks();
+
+}  // namespace
@@ -0,0 +1,42 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef BENCH_BENCH_UTIL_HPP_
+#define BENCH_BENCH_UTIL_HPP_
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+/* 반복 한 번에 nBytes를 처리했을 때의 처리량과 cycles/byte를 기록한다.
+ * cycle 수는 측정한 시간에 Google Benchmark가 읽은 CPU 클럭을 곱해 구한다.
+ * "cpb"는 cycles/byte, "cycles"는 반복 한 번의 cycle 수이다. */
+inline void SetBytesAndCycles(benchmark::State &state, size_t nBytes)
+{
+    const double hz = benchmark::CPUInfo::Get().cycles_per_second;
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * nBytes));
+    state.counters["cpb"] = benchmark::Counter(
+        static_cast<double>(nBytes) / hz,
+        benchmark::Counter::kIsIterationInvariantRate |
+            benchmark::Counter::kInvert);
+    state.counters["cycles"] = benchmark::Counter(
+        1.0 / hz, benchmark::Counter::kIsIterationInvariantRate |
+                      benchmark::Counter::kInvert);
+}
+
+/* 압축되지 않는 임의의 입력 */
+inline std::vector<unsigned char> BenchInput(size_t nBytes)
+{
+    std::vector<unsigned char> v(nBytes);
+    unsigned int x = 0x9e3779b9;
+
+    for (size_t i = 0; i < nBytes; i++)
+    {
+        x = x * 1103515245 + 12345;
+        v[i] = static_cast<unsigned char>(x >> 24);
+    }
+    return v;
+}
+
+#endif // BENCH_BENCH_UTIL_HPP_
@@ -0,0 +1,23 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* 문자열 / UTF-8 SIMD 커널을 단순한 구현과 비교하는 libFuzzer target.
+ * 입력 형식은 fuzz/fuzz_diff.hpp의 StringDiff()를 본다. */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "fuzz/fuzz_diff.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    std::string strError;
+
+    if (!AmvFuzz::StringDiff(data, size, &strError))
+    {
+        fprintf(stderr, "%s\n", strError.c_str());
+        abort();
+    }
+    return 0;
+}
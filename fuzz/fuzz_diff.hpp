@@ -0,0 +1,671 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* 가속 구현을 기준 구현과 Byte 단위로 비교하는 differential harness.
+ *
+ * AriaDiff(), StringDiff()는 임의의 Byte 열 하나를 키, 길이, 정렬, 입력으로
+ * 풀어서 이 CPU에서 돌릴 수 있는 모든 백엔드와 커널에 넣고 기준 구현과
+ * 비교한다.  ARIA의 기준은 블록 하나씩 처리하는 CAria::Crypt()이고, 문자열
+ * 커널의 기준은 이 파일의 단순한 반복문이다.
+ *
+ * fuzz 디렉토리의 libFuzzer target과 tests의 *Diff_test.cc가 같이 쓴다.
+ * 다르면 false를 돌려주고 어디서 달랐는지 *pstrError에 쓴다. */
+
+#ifndef FUZZ_FUZZ_DIFF_HPP_
+#define FUZZ_FUZZ_DIFF_HPP_
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "include/CAria.hpp"
+#include "include/CAriaKey.hpp"
+#include "include/CAriaParallel.hpp"
+#include "include/amvsimd.hpp"
+#include "include/amvstr.hpp"
+#include "include/amvutf8.hpp"
+
+namespace AmvFuzz
+{
+
+/* 한 번에 처리하는 입력의 최대 길이 */
+const size_t kMaxBytes = 4096;
+
+/* 입력 Byte 열을 앞에서부터 꺼내 쓴다.  다 쓰면 0이 나온다. */
+class CFuzzInput
+{
+public:
+    CFuzzInput(const uint8_t *data, size_t size) : m_p(data), m_n(size) {}
+
+    uint8_t Next()
+    {
+        if (m_n == 0)
+            return 0;
+        m_n--;
+        return *m_p++;
+    }
+
+    /* 다음 n Byte를 dest에 복사한다.  모자라는 부분은 0으로 채운다. */
+    void Take(void *dest, size_t n)
+    {
+        size_t nCopy = std::min(n, m_n);
+        if (nCopy > 0)
+            memcpy(dest, m_p, nCopy);
+        memset(static_cast<uint8_t *>(dest) + nCopy, 0, n - nCopy);
+        m_p += nCopy;
+        m_n -= nCopy;
+    }
+
+    /* 남은 Byte 전부. 최대 nMax Byte */
+    std::vector<uint8_t> Rest(size_t nMax)
+    {
+        size_t n = std::min(m_n, nMax);
+        std::vector<uint8_t> v(m_p, m_p + n);
+        m_p += n;
+        m_n -= n;
+        return v;
+    }
+
+private:
+    const uint8_t *m_p;
+    size_t m_n;
+};
+
+/* 처음으로 다른 위치. 같으면 n */
+inline size_t FirstDiff(const void *p1, const void *p2, size_t n)
+{
+    const uint8_t *a = static_cast<const uint8_t *>(p1);
+    const uint8_t *b = static_cast<const uint8_t *>(p2);
+    size_t i = 0;
+    while (i < n && a[i] == b[i])
+        i++;
+    return i;
+}
+
+/* ---------------------------------------------------------------- ARIA --- */
+
+/* 블록 하나씩 CAria::Crypt()로 만든 기준 결과 */
+struct CAriaReference
+{
+    std::vector<Byte> ecbEnc, ecbDec, ctr, cbcEnc, cbcDec;
+
+    CAriaReference(Awesome_mix_vol_1::CAria &aria, const Byte *in, size_t len,
+                   const Byte *iv, const Byte *rkEnc, const Byte *rkDec, int Nr)
+        : ecbEnc(len & ~static_cast<size_t>(15)), ecbDec(ecbEnc.size()), ctr(len),
+          cbcEnc(ecbEnc.size()), cbcDec(ecbEnc.size())
+    {
+        const size_t len16 = ecbEnc.size();
+        Byte counter[16], ks[16], x[16];
+
+        for (size_t i = 0; i < len16; i += 16)
+        {
+            aria.Crypt(in + i, Nr, rkEnc, &ecbEnc[i]);
+            aria.Crypt(in + i, Nr, rkDec, &ecbDec[i]);
+        }
+
+        memcpy(counter, iv, 16);
+        for (size_t i = 0; i < len; i += 16)
+        {
+            aria.Crypt(counter, Nr, rkEnc, ks);
+            for (size_t j = 0; j < 16 && i + j < len; j++)
+                ctr[i + j] = in[i + j] ^ ks[j];
+            for (int j = 15; j >= 0; j--)
+                if (++counter[j] != 0)
+                    break;
+        }
+
+        const Byte *prev = iv;
+        for (size_t i = 0; i < len16; i += 16)
+        {
+            for (int j = 0; j < 16; j++)
+                x[j] = in[i + j] ^ prev[j];
+            aria.Crypt(x, Nr, rkEnc, &cbcEnc[i]);
+            prev = &cbcEnc[i];
+        }
+
+        /* 입력을 암호문으로 보고 복호화한 결과 */
+        prev = iv;
+        for (size_t i = 0; i < len16; i += 16)
+        {
+            aria.Crypt(in + i, Nr, rkDec, x);
+            for (int j = 0; j < 16; j++)
+                cbcDec[i + j] = x[j] ^ prev[j];
+            prev = in + i;
+        }
+    }
+};
+
+/* 함수가 끝날 때 가장 빠른 백엔드로 되돌린다 */
+struct CAriaBackendRestore
+{
+    ~CAriaBackendRestore() { Awesome_mix_vol_1::CAria::SetBackend(NULL); }
+};
+
+/* 입력 형식:
+ *   [0] 키 길이 (128, 192, 256 중 % 3)
+ *   [1] 입력 버퍼의 정렬 (% 64)   [2] 출력 버퍼의 정렬 (% 64)
+ *   [3] bit 0: 입력과 출력이 같은 버퍼
+ *   [4, 36) 마스터 키   [36, 52) IV   나머지: 평문 (최대 kMaxBytes)
+ * 모든 백엔드의 CryptBlocks(), CryptBlocksPrepared()와, 각 백엔드를 선택한
+ * 상태의 CTR/ECB/CBC 모드 함수, CAriaParallel을 기준과 비교한다.  출력
+ * 버퍼의 앞뒤에 쓰면 그것도 실패이다. */
+inline bool AriaDiff(const uint8_t *data, size_t size, std::string *pstrError)
+{
+    using Awesome_mix_vol_1::CAria;
+    using Awesome_mix_vol_1::CAriaBackend;
+    using Awesome_mix_vol_1::CAriaKey;
+    using Awesome_mix_vol_1::CAriaParallel;
+    using Awesome_mix_vol_1::CAriaThreadPool;
+
+    CFuzzInput input(data, size);
+    const int keyBits = 128 + 64 * (input.Next() % 3);
+    const size_t inOff = input.Next() % 64;
+    const size_t outOff = input.Next() % 64;
+    const bool bInPlace = (input.Next() & 1) != 0;
+    Byte mk[32], iv[16];
+    input.Take(mk, sizeof(mk));
+    input.Take(iv, sizeof(iv));
+    const std::vector<uint8_t> plain = input.Rest(kMaxBytes);
+    const size_t len = plain.size();
+    const size_t len16 = len & ~static_cast<size_t>(15);
+
+    CAria aria;
+    Byte rkEnc[16 * 17], rkDec[16 * 17];
+    const int Nr = aria.EncKeySetup(mk, rkEnc, keyBits);
+    aria.DecKeySetup(mk, rkDec, keyBits);
+
+    /* 정확한 크기로 잡아 sanitizer가 범위 밖 접근을 잡게 한다 */
+    std::vector<Byte> in(inOff + len);
+    std::copy(plain.begin(), plain.end(), in.begin() + inOff);
+    const CAriaReference ref(aria, in.data() + inOff, len, iv, rkEnc, rkDec, Nr);
+    const size_t kGuard = 32;
+    std::vector<Byte> out(outOff + len + kGuard);
+
+    /* chunk를 작게 잡아 여러 thread로 나뉘게 한다 */
+    static CAriaThreadPool pool(2);
+    CAriaParallel parallel(&pool, 256);
+
+    CAriaBackendRestore restore;
+    const char *pszBackend = "";
+
+    /* op(src, dst, n)를 부르고 dst[0, n)이 want와 같은지 본다.
+     * nRet은 op가 돌려줘야 하는 값이다. */
+    auto Check = [&](const char *pszWhat, const std::vector<Byte> &want, size_t n,
+                     int nRet, auto op) -> bool
+    {
+        std::fill(out.begin(), out.end(), 0xa5);
+        Byte *dst = out.data() + outOff;
+        const Byte *src = in.data() + inOff;
+        if (bInPlace)
+        {
+            std::copy(in.begin() + inOff, in.end(), out.begin() + outOff);
+            src = dst;
+        }
+        int nGot = op(src, dst, n);
+        size_t iDiff = (nRet == 0) ? FirstDiff(dst, want.data(), n) : n;
+        bool bGuard = std::all_of(out.begin(), out.begin() + outOff,
+                                  [](Byte b) { return b == 0xa5; }) &&
+                      std::all_of(out.begin() + outOff + len, out.end(),
+                                  [](Byte b) { return b == 0xa5; });
+        if (nGot == nRet && iDiff == n && bGuard)
+            return true;
+
+        *pstrError = fmt::format(
+            "backend={} {} keyBits={} len={} n={} inOff={} outOff={} inPlace={}: ",
+            pszBackend, pszWhat, keyBits, len, n, inOff, outOff, bInPlace);
+        if (nGot != nRet)
+            *pstrError += fmt::format("returned {} instead of {}", nGot, nRet);
+        else if (iDiff != n)
+            *pstrError += fmt::format("first difference at byte {}", iDiff);
+        else
+            *pstrError += "wrote outside the output";
+        return false;
+    };
+
+    for (const CAriaBackend *const *pb = CAria::GetBackends(); *pb != NULL; pb++)
+    {
+        const CAriaBackend *b = *pb;
+        pszBackend = b->name;
+
+        /* 백엔드 자체. nBlocks가 0인 호출은 모드 함수가 하지 않는다. */
+        if (len16 > 0)
+        {
+            alignas(64) Byte prepared[ARIA_PREPARED_KEY_SIZE];
+            const Byte *rks[2] = {rkEnc, rkDec};
+            const std::vector<Byte> *wants[2] = {&ref.ecbEnc, &ref.ecbDec};
+            for (int dec = 0; dec < 2; dec++)
+            {
+                bool bOk = Check(dec ? "CryptBlocks/dec" : "CryptBlocks/enc", *wants[dec],
+                                 len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                                 { b->CryptBlocks(s, n / 16, Nr, rks[dec], d); return 0; });
+                b->PrepareKey(rks[dec], Nr, prepared);
+                bOk = bOk &&
+                      Check(dec ? "CryptBlocksPrepared/dec" : "CryptBlocksPrepared/enc",
+                            *wants[dec], len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                            { b->CryptBlocksPrepared(s, n / 16, Nr, prepared, d); return 0; });
+                if (!bOk)
+                    return false;
+            }
+        }
+
+        /* 이 백엔드를 선택한 상태의 모드 함수 */
+        if (CAria::SetBackend(b->name) != 0)
+        {
+            *pstrError = fmt::format("backend={} SetBackend() failed", b->name);
+            return false;
+        }
+        std::unique_ptr<CAriaKey> key(new CAriaKey);
+        key->Setup(mk, keyBits);
+        if (key->Backend() != b)
+        {
+            *pstrError = fmt::format("backend={} CAriaKey prepared for {}", b->name,
+                                     key->Backend()->name);
+            return false;
+        }
+
+        bool bOk =
+            Check("CtrCrypt/key", ref.ctr, len, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { aria.CtrCrypt(s, n, iv, *key, d); return 0; }) &&
+            Check("CtrCrypt/rk", ref.ctr, len, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { aria.CtrCrypt(s, n, iv, rkEnc, Nr, d); return 0; }) &&
+            Check("EcbEncrypt/key", ref.ecbEnc, len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { return aria.EcbEncrypt(s, n, *key, d); }) &&
+            Check("EcbDecrypt/key", ref.ecbDec, len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { return aria.EcbDecrypt(s, n, *key, d); }) &&
+            Check("EcbCrypt/rk", ref.ecbEnc, len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { return aria.EcbCrypt(s, n, rkEnc, Nr, d); }) &&
+            Check("CbcEncrypt/key", ref.cbcEnc, len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { return aria.CbcEncrypt(s, n, iv, *key, d); }) &&
+            Check("CbcDecrypt/key", ref.cbcDec, len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { return aria.CbcDecrypt(s, n, iv, *key, d); }) &&
+            Check("CbcEncrypt/rk", ref.cbcEnc, len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { return aria.CbcEncrypt(s, n, iv, rkEnc, Nr, d); }) &&
+            Check("CbcDecrypt/rk", ref.cbcDec, len16, 0, [&](const Byte *s, Byte *d, size_t n)
+                  { return aria.CbcDecrypt(s, n, iv, rkDec, Nr, d); }) &&
+            Check("CAriaParallel::CtrCrypt", ref.ctr, len, 0,
+                  [&](const Byte *s, Byte *d, size_t n)
+                  { parallel.CtrCrypt(s, n, iv, *key, d); return 0; }) &&
+            Check("CAriaParallel::EcbEncrypt", ref.ecbEnc, len16, 0,
+                  [&](const Byte *s, Byte *d, size_t n)
+                  { return parallel.EcbEncrypt(s, n, *key, d); }) &&
+            Check("CAriaParallel::EcbDecrypt", ref.ecbDec, len16, 0,
+                  [&](const Byte *s, Byte *d, size_t n)
+                  { return parallel.EcbDecrypt(s, n, *key, d); });
+        /* 16의 배수가 아닌 길이는 쓰지 않고 거절해야 한다 */
+        if (bOk && len != len16)
+        {
+            bOk = Check("EcbEncrypt/partial", ref.ecbEnc, 0, -1,
+                        [&](const Byte *s, Byte *d, size_t)
+                        { return aria.EcbEncrypt(s, len, *key, d); }) &&
+                  Check("CbcEncrypt/partial", ref.cbcEnc, 0, -1,
+                        [&](const Byte *s, Byte *d, size_t)
+                        { return aria.CbcEncrypt(s, len, iv, *key, d); });
+        }
+        if (!bOk)
+            return false;
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------- strings --- */
+
+template <class Func>
+struct CKernel
+{
+    const char *pszName;
+    Func pfn;
+};
+
+typedef size_t (*SpanFunc)(const char *, size_t, const AMV::CAmvCharSet &, bool);
+typedef const char *(*FindStringFunc)(const char *, size_t, const char *, size_t);
+typedef int (*CompareFunc)(const char *, size_t, const char *, size_t);
+typedef size_t (*ReplaceFunc)(char *, size_t, char, char);
+typedef size_t (*RemoveFunc)(char *, size_t, char);
+typedef bool (*Utf8ValidateFunc)(const char *, size_t);
+typedef size_t (*Utf8CountFunc)(const char *, size_t);
+
+/* 이 CPU에서 돌릴 수 있는 커널들.  마지막은 ChTraitsOS와 BStringT가 쓰는
+ * 자동 선택 함수이다. */
+inline std::vector<CKernel<SpanFunc>> SpanKernels()
+{
+    std::vector<CKernel<SpanFunc>> v;
+    v.push_back({"SpanScalar", AMV::AmvSimd::SpanScalar});
+#if defined(AMV_SIMD_X86)
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_SSSE3)
+        v.push_back({"SpanSsse3", AMV::AmvSimd::SpanSsse3});
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back({"SpanAvx2", AMV::AmvSimd::SpanAvx2});
+#elif defined(AMV_SIMD_NEON)
+    v.push_back({"SpanNeon", AMV::AmvSimd::SpanNeon});
+#endif
+    v.push_back({"Span", AMV::AmvSimd::Span});
+    return v;
+}
+
+/* 2 <= nSub <= n 에서만 부른다 (AmvFindString()이 나머지를 처리한다) */
+inline std::vector<CKernel<FindStringFunc>> FindStringKernels()
+{
+    std::vector<CKernel<FindStringFunc>> v;
+    v.push_back({"FindStringScalar", AMV::AmvSimd::FindStringScalar});
+#if defined(AMV_SIMD_X86)
+    v.push_back({"FindStringSse2", AMV::AmvSimd::FindStringSse2});
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back({"FindStringAvx2", AMV::AmvSimd::FindStringAvx2});
+#elif defined(AMV_SIMD_NEON)
+    v.push_back({"FindStringNeon", AMV::AmvSimd::FindStringNeon});
+#endif
+    v.push_back({"AmvFindString", AMV::AmvFindString});
+    return v;
+}
+
+inline int CompareNoCaseScalar(const char *p1, size_t n1, const char *p2, size_t n2)
+{
+    return AMV::AmvSimd::CompareNoCaseScalar(p1, n1, p2, n2);
+}
+
+inline std::vector<CKernel<CompareFunc>> CompareNoCaseKernels()
+{
+    std::vector<CKernel<CompareFunc>> v;
+    v.push_back({"CompareNoCaseScalar", CompareNoCaseScalar});
+#if defined(AMV_SIMD_X86)
+    v.push_back({"CompareNoCaseSse2", AMV::AmvSimd::CompareNoCaseSse2});
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back({"CompareNoCaseAvx2", AMV::AmvSimd::CompareNoCaseAvx2});
+    if (AMV::AmvSimd::GetLevel() == AMV::AmvSimd::LEVEL_AVX512)
+        v.push_back({"CompareNoCaseAvx512", AMV::AmvSimd::CompareNoCaseAvx512});
+#elif defined(AMV_SIMD_NEON)
+    v.push_back({"CompareNoCaseNeon", AMV::AmvSimd::CompareNoCaseNeon});
+#endif
+    v.push_back({"AmvCompareNoCase", AMV::AmvCompareNoCase});
+    return v;
+}
+
+inline std::vector<CKernel<ReplaceFunc>> ReplaceKernels()
+{
+    std::vector<CKernel<ReplaceFunc>> v;
+    v.push_back({"ReplaceCharScalar", AMV::AmvSimd::ReplaceCharScalar});
+#if defined(AMV_SIMD_X86)
+    v.push_back({"ReplaceCharSse2", AMV::AmvSimd::ReplaceCharSse2});
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back({"ReplaceCharAvx2", AMV::AmvSimd::ReplaceCharAvx2});
+#elif defined(AMV_SIMD_NEON)
+    v.push_back({"ReplaceCharNeon", AMV::AmvSimd::ReplaceCharNeon});
+#endif
+    v.push_back({"AmvReplaceChar", AMV::AmvReplaceChar});
+    return v;
+}
+
+inline std::vector<CKernel<RemoveFunc>> RemoveKernels()
+{
+    std::vector<CKernel<RemoveFunc>> v;
+    v.push_back({"RemoveCharScalar", AMV::AmvSimd::RemoveCharScalar});
+#if defined(AMV_SIMD_X86)
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_SSSE3)
+        v.push_back({"RemoveCharSsse3", AMV::AmvSimd::RemoveCharSsse3});
+#elif defined(AMV_SIMD_NEON)
+    v.push_back({"RemoveCharNeon", AMV::AmvSimd::RemoveCharNeon});
+#endif
+    v.push_back({"AmvRemoveChar", AMV::AmvRemoveChar});
+    return v;
+}
+
+inline std::vector<CKernel<Utf8ValidateFunc>> Utf8ValidateKernels()
+{
+    std::vector<CKernel<Utf8ValidateFunc>> v;
+    v.push_back({"Utf8ValidateScalar", AMV::AmvSimd::Utf8ValidateScalar});
+#if defined(AMV_SIMD_X86)
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_SSSE3)
+        v.push_back({"Utf8ValidateSsse3", AMV::AmvSimd::Utf8ValidateSsse3});
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back({"Utf8ValidateAvx2", AMV::AmvSimd::Utf8ValidateAvx2});
+#elif defined(AMV_SIMD_NEON)
+    v.push_back({"Utf8ValidateNeon", AMV::AmvSimd::Utf8ValidateNeon});
+#endif
+    v.push_back({"AmvUtf8Validate", AMV::AmvUtf8Validate});
+    return v;
+}
+
+inline std::vector<CKernel<Utf8CountFunc>> Utf8CountKernels()
+{
+    std::vector<CKernel<Utf8CountFunc>> v;
+    v.push_back({"Utf8CountScalar", AMV::AmvSimd::Utf8CountScalar});
+#if defined(AMV_SIMD_X86)
+    v.push_back({"Utf8CountSse2", AMV::AmvSimd::Utf8CountSse2});
+#elif defined(AMV_SIMD_NEON)
+    v.push_back({"Utf8CountNeon", AMV::AmvSimd::Utf8CountNeon});
+#endif
+    v.push_back({"AmvUtf8Count", AMV::AmvUtf8Count});
+    return v;
+}
+
+/* 하나씩 디코딩하는 UTF-8 검사 */
+inline bool Utf8ValidateReference(const char *pch, size_t n)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(pch);
+    static const uint32_t anMin[5] = {0, 0, 0x80, 0x800, 0x10000};
+    size_t i = 0;
+    while (i < n)
+    {
+        uint32_t cp = p[i];
+        size_t nLength = (cp < 0x80)            ? 1
+                         : ((cp >> 5) == 0x06) ? 2
+                         : ((cp >> 4) == 0x0e) ? 3
+                         : ((cp >> 3) == 0x1e) ? 4
+                                               : 0;
+        if (nLength == 0 || n - i < nLength)
+            return false;
+        if (nLength > 1)
+            cp &= (0x7f >> nLength);
+        for (size_t j = 1; j < nLength; j++)
+        {
+            if ((p[i + j] & 0xc0) != 0x80)
+                return false;
+            cp = (cp << 6) | (p[i + j] & 0x3f);
+        }
+        if (cp < anMin[nLength] || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+            return false;
+        i += nLength;
+    }
+    return true;
+}
+
+inline int Sign(int n) { return (n > 0) - (n < 0); }
+
+/* 입력 형식:
+ *   [0] bit 0: 찾을 문자열을 본문에서 잘라 온다
+ *       bit 1: 비교할 문자열의 대소문자를 뒤집는다
+ *       bit 2: 비교할 문자열을 한 글자 짧게 한다
+ *   [1] 본문의 정렬 (% 64)   [2] 바꿀 문자   [3] 바꿀 값
+ *   [4] 문자 집합의 크기 (% 9), 그 다음 집합의 문자들
+ *   그 다음 찾을 문자열의 길이 (% 17)와 문자들
+ *   그 다음 [고칠 위치] [고칠 값]   나머지: 본문 (최대 kMaxBytes)
+ * 각 커널과 ChTraitsOS의 길이를 받는 함수를 단순한 반복문과 비교한다. */
+inline bool StringDiff(const uint8_t *data, size_t size, std::string *pstrError)
+{
+    typedef AMV::ChTraitsOS<char> Traits;
+
+    CFuzzInput input(data, size);
+    const uint8_t nFlags = input.Next();
+    const size_t off = input.Next() % 64;
+    const char chOld = static_cast<char>(input.Next());
+    const char chNew = static_cast<char>(input.Next());
+    char achSet[8];
+    const size_t nSet = input.Next() % 9;
+    input.Take(achSet, nSet);
+    char achSub[16];
+    size_t nSub = input.Next() % 17;
+    input.Take(achSub, nSub);
+    const uint8_t iEdit = input.Next();
+    const char chEdit = static_cast<char>(input.Next());
+    const std::vector<uint8_t> rest = input.Rest(kMaxBytes);
+    const size_t n = rest.size();
+
+    /* 정확한 크기로 잡아 sanitizer가 범위 밖 읽기를 잡게 한다 */
+    /* 빈 vector의 data()는 NULL일 수 있는데, 실제 호출자는 NULL을 넘기지 않는다 */
+    std::vector<char> text(off + n);
+    std::copy(rest.begin(), rest.end(), text.begin() + off);
+    char achEmpty[1] = {0};
+    auto Text = [&](std::vector<char> &buf) { return buf.empty() ? achEmpty : buf.data() + off; };
+    const char *p = Text(text);
+    if ((nFlags & 1) && n > 0)
+    {
+        size_t iFrom = iEdit % n;
+        nSub = std::min(nSub, n - iFrom);
+        memcpy(achSub, p + iFrom, nSub);
+    }
+
+    auto Fail = [&](const std::string &strWhat) -> bool
+    {
+        *pstrError = fmt::format("{} n={} off={} nSub={} nSet={} flags={:#x}", strWhat, n,
+                                 off, nSub, nSet, nFlags);
+        return false;
+    };
+
+    /* span */
+    bool abSet[256] = {false};
+    for (size_t i = 0; i < nSet; i++)
+        abSet[static_cast<unsigned char>(achSet[i])] = true;
+    AMV::CAmvCharSet set(achSet, nSet);
+    for (int bIn = 0; bIn < 2; bIn++)
+    {
+        size_t nExpect = 0;
+        while (nExpect < n && abSet[static_cast<unsigned char>(p[nExpect])] == (bIn != 0))
+            nExpect++;
+        for (const auto &k : SpanKernels())
+        {
+            size_t nGot = k.pfn(p, n, set, bIn != 0);
+            if (nGot != nExpect)
+                return Fail(fmt::format("{}(in={}) = {}, expected {}", k.pszName, bIn, nGot,
+                                        nExpect));
+        }
+        int nTraits = bIn ? Traits::StringSpanIncluding(p, static_cast<int>(n), set)
+                          : Traits::StringSpanExcluding(p, static_cast<int>(n), set);
+        if (nTraits != static_cast<int>(nExpect))
+            return Fail(fmt::format("ChTraitsOS::StringSpan(in={}) = {}, expected {}", bIn,
+                                    nTraits, nExpect));
+    }
+
+    /* 문자열 / 문자 찾기 */
+    const char *pExpect = std::search(p, p + n, achSub, achSub + nSub);
+    if (pExpect == p + n && nSub > 0)
+        pExpect = NULL;
+    if (nSub >= 2 && nSub <= n)
+    {
+        for (const auto &k : FindStringKernels())
+        {
+            const char *pGot = k.pfn(p, n, achSub, nSub);
+            if (pGot != pExpect)
+                return Fail(fmt::format("{} = {}, expected {}", k.pszName,
+                                        pGot ? pGot - p : -1, pExpect ? pExpect - p : -1));
+        }
+    }
+    const char *pTraits =
+        Traits::StringFindString(p, static_cast<int>(n), achSub, static_cast<int>(nSub));
+    if (pTraits != pExpect)
+        return Fail(fmt::format("ChTraitsOS::StringFindString = {}, expected {}",
+                                pTraits ? pTraits - p : -1, pExpect ? pExpect - p : -1));
+
+    const char *pFirst = std::find(p, p + n, chOld);
+    pFirst = (pFirst == p + n) ? NULL : pFirst;
+    const char *pLast = NULL;
+    for (size_t i = n; i > 0 && pLast == NULL; i--)
+        pLast = (p[i - 1] == chOld) ? p + i - 1 : NULL;
+    if (Traits::StringFindChar(p, static_cast<int>(n), chOld) != pFirst)
+        return Fail("ChTraitsOS::StringFindChar");
+    if (Traits::StringFindCharRev(p, static_cast<int>(n), chOld) != pLast)
+        return Fail("ChTraitsOS::StringFindCharRev");
+
+    /* 비교: 대소문자를 뒤집고 한 글자를 고친 복사본과 */
+    size_t nOther = ((nFlags & 4) && n > 0) ? n - 1 : n;
+    std::string other(p, nOther);
+    if (nFlags & 2)
+    {
+        for (char &ch : other)
+        {
+            if (ch >= 'a' && ch <= 'z')
+                ch = static_cast<char>(ch - 'a' + 'A');
+            else if (ch >= 'A' && ch <= 'Z')
+                ch = static_cast<char>(ch - 'A' + 'a');
+        }
+    }
+    if (iEdit != 0 && nOther > 0)
+        other[iEdit % nOther] = chEdit;
+    int nExpectNoCase = 0;
+    int nExpectCase = 0;
+    for (size_t i = 0; i < std::min(n, nOther); i++)
+    {
+        int c1 = static_cast<unsigned char>(p[i]), c2 = static_cast<unsigned char>(other[i]);
+        if (nExpectCase == 0)
+            nExpectCase = Sign(c1 - c2);
+        c1 = (c1 >= 'A' && c1 <= 'Z') ? c1 + 'a' - 'A' : c1;
+        c2 = (c2 >= 'A' && c2 <= 'Z') ? c2 + 'a' - 'A' : c2;
+        if (nExpectNoCase == 0)
+            nExpectNoCase = Sign(c1 - c2);
+    }
+    if (nExpectCase == 0)
+        nExpectCase = Sign(static_cast<int>(n) - static_cast<int>(nOther));
+    if (nExpectNoCase == 0)
+        nExpectNoCase = Sign(static_cast<int>(n) - static_cast<int>(nOther));
+    for (const auto &k : CompareNoCaseKernels())
+    {
+        int nGot = Sign(k.pfn(p, n, other.data(), nOther));
+        if (nGot != nExpectNoCase)
+            return Fail(fmt::format("{} = {}, expected {}", k.pszName, nGot, nExpectNoCase));
+    }
+    if (Sign(Traits::StringCompareIgnore(p, static_cast<int>(n), other.data(),
+                                         static_cast<int>(nOther))) != nExpectNoCase)
+        return Fail("ChTraitsOS::StringCompareIgnore");
+    if (Sign(Traits::StringCompare(p, static_cast<int>(n), other.data(),
+                                   static_cast<int>(nOther))) != nExpectCase)
+        return Fail("ChTraitsOS::StringCompare");
+
+    /* 바꾸기 / 지우기: 같은 정렬의 복사본에서 */
+    std::string strReplaced(p, n);
+    size_t nReplaced = std::count(strReplaced.begin(), strReplaced.end(), chOld);
+    std::replace(strReplaced.begin(), strReplaced.end(), chOld, chNew);
+    for (const auto &k : ReplaceKernels())
+    {
+        std::vector<char> buf(text);
+        size_t nGot = k.pfn(Text(buf), n, chOld, chNew);
+        if (nGot != nReplaced || memcmp(Text(buf), strReplaced.data(), n) != 0)
+            return Fail(fmt::format("{} = {}, expected {}", k.pszName, nGot, nReplaced));
+    }
+    std::string strRemoved(p, n);
+    strRemoved.erase(std::remove(strRemoved.begin(), strRemoved.end(), chOld),
+                     strRemoved.end());
+    for (const auto &k : RemoveKernels())
+    {
+        std::vector<char> buf(text);
+        size_t nGot = k.pfn(Text(buf), n, chOld);
+        if (nGot != strRemoved.size() ||
+            memcmp(Text(buf), strRemoved.data(), strRemoved.size()) != 0)
+            return Fail(fmt::format("{} = {}, expected {}", k.pszName, nGot, strRemoved.size()));
+    }
+
+    /* UTF-8 */
+    const bool bValid = Utf8ValidateReference(p, n);
+    for (const auto &k : Utf8ValidateKernels())
+    {
+        if (k.pfn(p, n) != bValid)
+            return Fail(fmt::format("{} = {}, expected {}", k.pszName, !bValid, bValid));
+    }
+    size_t nCodePoints = 0;
+    for (size_t i = 0; i < n; i++)
+        nCodePoints += (static_cast<unsigned char>(p[i]) & 0xc0) != 0x80;
+    for (const auto &k : Utf8CountKernels())
+    {
+        size_t nGot = k.pfn(p, n);
+        if (nGot != nCodePoints)
+            return Fail(fmt::format("{} = {}, expected {}", k.pszName, nGot, nCodePoints));
+    }
+    return true;
+}
+
+} // namespace AmvFuzz
+
+#endif // FUZZ_FUZZ_DIFF_HPP_
@@ -3,20 +3,104 @@
 #ifndef BSTRINGT_HPP_
 #define BSTRINGT_HPP_
 
+#include <fmt/format.h>
+
+#include <charconv>
+#include <climits>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "include/amvaho.hpp"
 #include "include/amvalloc.hpp"
+#include "include/amvconcat.hpp"
 #include "include/amvcore.hpp"
+#include "include/amvsimd.hpp"
 #include "include/amvsimpstr.hpp"
+#include "include/amvstrview.hpp"
+#include "include/amvutf8.hpp"
 #include "salieri-src/salieri.h"
 
 namespace AMV
 {
 
+    // Matches found by the single search pass of Replace() and ReplaceAll().
+    // The first t_nInline live in the object; beyond that the buffer grows on
+    // the heap, doubling each time.
+    template <typename T, int t_nInline = 64>
+    class CAmvMatchBuffer
+    {
+    public:
+        CAmvMatchBuffer() throw() : m_pData(m_aInline), m_nCount(0), m_nCapacity(t_nInline) {}
+
+        ~CAmvMatchBuffer() throw()
+        {
+            if (m_pData != m_aInline)
+            {
+                delete[] m_pData;
+            }
+        }
+
+        void Add(_In_ const T &t)
+        {
+            if (m_nCount == m_nCapacity)
+            {
+                Grow();
+            }
+            m_pData[m_nCount++] = t;
+        }
+
+        int GetCount() const throw() { return (m_nCount); }
+
+        const T *begin() const throw() { return (m_pData); }
+        const T *end() const throw() { return (m_pData + m_nCount); }
+
+    private:
+        void Grow()
+        {
+            int nCapacity = (m_nCapacity <= INT_MAX / 2) ? m_nCapacity * 2 : INT_MAX;
+            if (nCapacity == m_nCapacity)
+            {
+                AmvThrow("Out of memory");
+            }
+            T *pData = new T[nCapacity];
+            for (int i = 0; i < m_nCount; i++)
+            {
+                pData[i] = m_pData[i];
+            }
+            if (m_pData != m_aInline)
+            {
+                delete[] m_pData;
+            }
+            m_pData = pData;
+            m_nCapacity = nCapacity;
+        }
+
+        T m_aInline[t_nInline];
+        T *m_pData;
+        int m_nCount;
+        int m_nCapacity;
+
+    private:
+        CAmvMatchBuffer(_In_ const CAmvMatchBuffer &) throw();
+        CAmvMatchBuffer &operator=(_In_ const CAmvMatchBuffer &) throw();
+    };
+
+    // BaseType is char, char16_t or wchar_t.  Format(), AppendNumber(),
+    // ParseNumber(), the UTF-8 functions, ReplaceAll() and the CAmvCharSet
+    // overloads build on char and only compile for char strings.
     template <typename BaseType, class StringTraits>
     class BStringT : public CSimpleStringT<BaseType>
     {
     public:
         typedef CSimpleStringT<BaseType> CThisSimpleString;
+        typedef CAmvStringViewT<BaseType> CThisStringView;
         typedef StringTraits StrTraits;
+        typedef typename CThisSimpleString::XCHAR XCHAR;
+        typedef typename CThisSimpleString::PXSTR PXSTR;
+        typedef typename CThisSimpleString::PCXSTR PCXSTR;
 
     public:
         BStringT() throw() : CThisSimpleString(StringTraits::GetDefaultManager()) {}
@@ -31,6 +115,10 @@ namespace AMV
    * 형변환을 막아야 한다면 이 상황에서는 처치할 수가 없음 */
         BStringT(_In_ const BStringT &strSrc) : CThisSimpleString(strSrc) {}
 
+        // Move constructor: takes the buffer, strSrc is left empty
+        BStringT(_Inout_ BStringT &&strSrc) noexcept
+            : CThisSimpleString(std::move(strSrc)) {}
+
         // // Construct from CSimpleStringT
         // operator CSimpleStringT<BaseType>&() {
         //
@@ -40,13 +128,13 @@ namespace AMV
         explicit BStringT(_In_ const CSimpleStringT<BaseType> &strSrc)
             : CThisSimpleString(strSrc) {}
 
-        explicit BStringT(_In_opt_z_ const char *pszSrc)
+        explicit BStringT(_In_opt_z_ const XCHAR *pszSrc)
             : CThisSimpleString(StringTraits::GetDefaultManager())
         {
             *this = pszSrc;
         }
 
-        BStringT(_In_opt_z_ const char *pszSrc, _In_ IAmvStringMgr *pStringMgr)
+        BStringT(_In_opt_z_ const XCHAR *pszSrc, _In_ IAmvStringMgr *pStringMgr)
             : CThisSimpleString(pStringMgr)
         {
             *this = pszSrc;
@@ -54,13 +142,24 @@ namespace AMV
 
         BStringT(_In_opt_z_ const unsigned char *pszSrc,
                  _In_ IAmvStringMgr *pStringMgr)
-            : CThisSimpleString(pStringMgr)
+            : CThisSimpleString(pszSrc, ByteStringLength(pszSrc), pStringMgr)
         {
-            *this = reinterpret_cast<const char *>(pszSrc);
         }
         BStringT(_In_reads_(nLength) const unsigned char *puch, _In_ int nLength)
             : CThisSimpleString(puch, nLength, StringTraits::GetDefaultManager()) {}
 
+        explicit BStringT(_In_ const CThisStringView &view)
+            : CThisSimpleString(StringTraits::GetDefaultManager())
+        {
+            this->SetString(view.GetString(), view.GetLength());
+        }
+
+        BStringT(_In_ const CThisStringView &view, _In_ IAmvStringMgr *pStringMgr)
+            : CThisSimpleString(pStringMgr)
+        {
+            this->SetString(view.GetString(), view.GetLength());
+        }
+
         // Destructor
         ~BStringT() throw() {}
 
@@ -72,6 +171,13 @@ namespace AMV
             return (*this);
         }
 
+        BStringT &operator=(_Inout_ BStringT &&strSrc) noexcept
+        {
+            CThisSimpleString::operator=(std::move(strSrc));
+
+            return (*this);
+        }
+
         BStringT &operator=(_In_ const CSimpleStringT<BaseType> &strSrc)
         {
             CThisSimpleString::operator=(strSrc);
@@ -79,16 +185,23 @@ namespace AMV
             return (*this);
         }
 
-        BStringT &operator=(_In_opt_z_ const char *pszSrc)
+        BStringT &operator=(_In_opt_z_ const XCHAR *pszSrc)
         {
             CThisSimpleString::operator=(pszSrc);
 
             return (*this);
         }
 
-        BStringT &operator=(_In_ char ch)
+        BStringT &operator=(_In_ const CThisStringView &view)
         {
-            char ach[2] = {ch, 0};
+            this->SetString(view.GetString(), view.GetLength());
+
+            return (*this);
+        }
+
+        BStringT &operator=(_In_ XCHAR ch)
+        {
+            XCHAR ach[2] = {ch, 0};
 
             return (operator=(ach));
         }
@@ -100,21 +213,28 @@ namespace AMV
             return (*this);
         }
 
-        BStringT &operator+=(_In_z_ const char *pszSrc)
+        BStringT &operator+=(_In_z_ const XCHAR *pszSrc)
         {
             CThisSimpleString::operator+=(pszSrc);
 
             return (*this);
         }
         template <int t_nSize>
-        BStringT &operator+=(_In_ const CStaticString<char, t_nSize> &strSrc)
+        BStringT &operator+=(_In_ const CStaticString<XCHAR, t_nSize> &strSrc)
         {
             CThisSimpleString::operator+=(strSrc);
 
             return (*this);
         }
 
-        BStringT &operator+=(_In_ char ch)
+        BStringT &operator+=(_In_ const CThisStringView &view)
+        {
+            this->Append(view.GetString(), view.GetLength());
+
+            return (*this);
+        }
+
+        BStringT &operator+=(_In_ XCHAR ch)
         {
             CThisSimpleString::operator+=(ch);
 
@@ -142,18 +262,184 @@ namespace AMV
 
         // Comparison
 
-        int Compare(_In_z_ const char *psz) const
+        /* The whole length of this string is compared, so embedded '\0' are
+         * ordinary chars here.  psz ends at its first '\0'. */
+        int Compare(_In_z_ const XCHAR *psz) const
         {
             AMVENSURE(AmvIsValidString(psz));
             // AmvIsValidString guarantees that psz != NULL
-            return (StringTraits::StringCompare(this->GetString(), psz));
+            return (StringTraits::StringCompare(this->GetString(), this->GetLength(), psz,
+                                                StringTraits::SafeStringLen(psz)));
+        }
+
+        int Compare(_In_ const CThisSimpleString &str) const throw()
+        {
+            // Copies and interned strings share their chars
+            if (this->GetString() == str.GetString())
+            {
+                return (0);
+            }
+            return (StringTraits::StringCompare(this->GetString(), this->GetLength(),
+                                                str.GetString(), str.GetLength()));
         }
 
-        int CompareNoCase(_In_z_ const char *psz) const
+        // Case-insensitive for ASCII letters, as strcasecmp() in the "C" locale
+        int CompareNoCase(_In_z_ const XCHAR *psz) const
         {
             AMVENSURE(AmvIsValidString(psz));
             // AmvIsValidString guarantees that psz != NULL
-            return (StringTraits::StringCompareIgnore(this->GetString(), psz));
+            return (StringTraits::StringCompareIgnore(this->GetString(), this->GetLength(),
+                                                      psz, StringTraits::SafeStringLen(psz)));
+        }
+
+        int CompareNoCase(_In_ const CThisSimpleString &str) const throw()
+        {
+            return (StringTraits::StringCompareIgnore(this->GetString(), this->GetLength(),
+                                                      str.GetString(), str.GetLength()));
+        }
+
+        int Compare(_In_ const CThisStringView &view) const throw()
+        {
+            return (StringTraits::StringCompare(this->GetString(), this->GetLength(),
+                                                view.GetString(), view.GetLength()));
+        }
+
+        int CompareNoCase(_In_ const CThisStringView &view) const throw()
+        {
+            return (StringTraits::StringCompareIgnore(this->GetString(), this->GetLength(),
+                                                      view.GetString(), view.GetLength()));
+        }
+
+        // Equality check that only looks at the chars when the lengths match
+        bool IsEqual(_In_ const CThisSimpleString &str) const throw()
+        {
+            return (IsEqual(CThisStringView(str)));
+        }
+
+        bool IsEqual(_In_ const CThisStringView &view) const throw()
+        {
+            int nLength = this->GetLength();
+            return ((nLength == view.GetLength()) &&
+                    ((this->GetString() == view.GetString()) ||
+                     (memcmp(this->GetString(), view.GetString(),
+                             nLength * sizeof(XCHAR)) == 0)));
+        }
+
+        // Formatting
+
+        /* Appends args formatted by fmt ("{}" placeholders) straight into the
+         * buffer.  The spare capacity is tried first; if the text does not
+         * fit, the string grows by the manager's policy and the text is
+         * formatted again.  The args must not point into this string. */
+        template <typename... Args>
+        void AppendFormat(_In_z_ const XCHAR *pszFormat, const Args &...args)
+        {
+            int nLength = this->GetLength();
+            size_t nSpare = static_cast<size_t>(this->GetAllocLength() - nLength);
+            XCHAR *pszBuffer = this->GetBuffer(this->GetAllocLength());
+            size_t nFormatted;
+            try
+            {
+                nFormatted =
+                    fmt::format_to_n(pszBuffer + nLength, nSpare, pszFormat, args...).size;
+                if (nFormatted > nSpare)
+                {
+                    if (nFormatted > static_cast<size_t>(INT_MAX - nLength))
+                    {
+                        AmvThrow("Invalid arguments");
+                    }
+                    pszBuffer = this->GetBuffer(nLength + static_cast<int>(nFormatted));
+                    fmt::format_to(pszBuffer + nLength, pszFormat, args...);
+                }
+            }
+            catch (...)
+            {
+                // The text may have run over the terminator
+                this->ReleaseBufferSetLength(nLength);
+                throw;
+            }
+            this->ReleaseBufferSetLength(nLength + static_cast<int>(nFormatted));
+        }
+
+        // Replaces the contents, see AppendFormat().  A buffer of our own is
+        // kept with its capacity; a shared one is dropped, not copied.
+        template <typename... Args>
+        void Format(_In_z_ const XCHAR *pszFormat, const Args &...args)
+        {
+            if (this->IsShared())
+            {
+                this->Empty();
+            }
+            else
+            {
+                this->Truncate(0);
+            }
+            AppendFormat(pszFormat, args...);
+        }
+
+        // Shortest text of an integer or floating point value, std::to_chars()
+        template <typename T>
+        BStringT &AppendNumber(_In_ T value)
+        {
+            static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+                          "AppendNumber() takes a number");
+            // Room for any integer, or the shortest round trip of a double
+            const int nMaxChars = 32;
+            int nLength = this->GetLength();
+            XCHAR *pszBuffer = this->GetBuffer(nLength + nMaxChars);
+            std::to_chars_result result =
+                std::to_chars(pszBuffer + nLength, pszBuffer + nLength + nMaxChars, value);
+            AMVASSERT(result.ec == std::errc());
+            this->ReleaseBufferSetLength(static_cast<int>(result.ptr - pszBuffer));
+
+            return (*this);
+        }
+
+        // The whole string as a number, see CAmvStringView::ParseNumber()
+        template <typename T>
+        bool ParseNumber(_Inout_ T &value) const throw()
+        {
+            return (CThisStringView(*this).ParseNumber(value));
+        }
+
+        // UTF-8
+
+        bool IsValidUtf8() const throw()
+        {
+            return (AmvUtf8Validate(this->GetString(), this->GetLength()));
+        }
+
+        // Code points, not chars; the string should be valid UTF-8
+        int GetUtf8Length() const throw()
+        {
+            return (static_cast<int>(AmvUtf8Count(this->GetString(), this->GetLength())));
+        }
+
+        // Replaces the contents with the UTF-8 form of p[0, nLength).  Throws
+        // on an unpaired surrogate.
+        void SetUtf16(_In_reads_(nLength) const char16_t *p, _In_ int nLength)
+        {
+            int nChars = AmvUtf16ToUtf8(p, nLength, NULL, 0);
+            if (nChars < 0)
+            {
+                AmvThrow("Invalid UTF-16");
+            }
+            XCHAR *pszBuffer = this->GetBuffer(nChars);
+            AmvUtf16ToUtf8(p, nLength, pszBuffer, nChars);
+            this->ReleaseBufferSetLength(nChars);
+        }
+
+        // UTF-16 form of the string.  Throws if it is not valid UTF-8.
+        std::u16string GetUtf16() const
+        {
+            int nUnits = AmvUtf8ToUtf16(this->GetString(), this->GetLength(), NULL, 0);
+            if (nUnits < 0)
+            {
+                AmvThrow("Invalid UTF-8");
+            }
+            std::u16string str(nUnits, u'\0');
+            AmvUtf8ToUtf16(this->GetString(), this->GetLength(), &str[0], nUnits);
+            return (str);
         }
 
         // Advanced manipulation
@@ -176,9 +462,9 @@ namespace AMV
             {
                 int nNewLength = nLength - nCount;
                 int nXCHARsToCopy = nLength - (iIndex + nCount) + 1;
-                char *pszBuffer = this->GetBuffer();
-                memmove_s(pszBuffer + iIndex, nXCHARsToCopy * sizeof(char),
-                          pszBuffer + iIndex + nCount, nXCHARsToCopy * sizeof(char));
+                XCHAR *pszBuffer = this->GetBuffer();
+                memmove_s(pszBuffer + iIndex, nXCHARsToCopy * sizeof(XCHAR),
+                          pszBuffer + iIndex + nCount, nXCHARsToCopy * sizeof(XCHAR));
                 this->ReleaseBufferSetLength(nNewLength);
             }
 
@@ -186,7 +472,7 @@ namespace AMV
         }
 
         // Insert character 'ch' before index 'iIndex'
-        int Insert(_In_ int iIndex, _In_ char ch)
+        int Insert(_In_ int iIndex, _In_ XCHAR ch)
         {
             if (iIndex < 0)
                 iIndex = 0;
@@ -197,11 +483,11 @@ namespace AMV
             }
             int nNewLength = this->GetLength() + 1;
 
-            char *pszBuffer = this->GetBuffer(nNewLength);
+            XCHAR *pszBuffer = this->GetBuffer(nNewLength);
 
             // move existing bytes down
-            memmove_s(pszBuffer + iIndex + 1, (nNewLength - iIndex) * sizeof(char),
-                      pszBuffer + iIndex, (nNewLength - iIndex) * sizeof(char));
+            memmove_s(pszBuffer + iIndex + 1, (nNewLength - iIndex) * sizeof(XCHAR),
+                      pszBuffer + iIndex, (nNewLength - iIndex) * sizeof(XCHAR));
             pszBuffer[iIndex] = ch;
 
             this->ReleaseBufferSetLength(nNewLength);
@@ -210,7 +496,7 @@ namespace AMV
         }
 
         // Insert string 'psz' before index 'iIndex'
-        int Insert(_In_ int iIndex, _In_z_ const char *psz)
+        int Insert(_In_ int iIndex, _In_z_ const XCHAR *psz)
         {
             if (iIndex < 0)
                 iIndex = 0;
@@ -227,14 +513,14 @@ namespace AMV
             {
                 nNewLength += nInsertLength;
 
-                char *pszBuffer = this->GetBuffer(nNewLength);
+                XCHAR *pszBuffer = this->GetBuffer(nNewLength);
                 // move existing bytes down
                 memmove_s(pszBuffer + iIndex + nInsertLength,
-                          (nNewLength - iIndex - nInsertLength + 1) * sizeof(char),
+                          (nNewLength - iIndex - nInsertLength + 1) * sizeof(XCHAR),
                           pszBuffer + iIndex,
-                          (nNewLength - iIndex - nInsertLength + 1) * sizeof(char));
-                memcpy_s(pszBuffer + iIndex, nInsertLength * sizeof(char), psz,
-                         nInsertLength * sizeof(char));
+                          (nNewLength - iIndex - nInsertLength + 1) * sizeof(XCHAR));
+                memcpy_s(pszBuffer + iIndex, nInsertLength * sizeof(XCHAR), psz,
+                         nInsertLength * sizeof(XCHAR));
                 this->ReleaseBufferSetLength(nNewLength);
             }
 
@@ -242,47 +528,34 @@ namespace AMV
         }
 
         // Replace all occurrences of character 'chOld' with character 'chNew'
-        int Replace(_In_ char chOld, _In_ char chNew)
+        int Replace(_In_ XCHAR chOld, _In_ XCHAR chNew)
         {
-            int nCount = 0;
-
             // short-circuit the nop case
-            if (chOld != chNew)
+            if (chOld == chNew)
             {
-                // otherwise modify each character that matches in the string
-                bool bCopied = false;
-                // We don't actually write to pszBuffer until we've called GetBuffer().
-                char *pszBuffer = const_cast<char *>(this->GetString());
+                return (0);
+            }
 
-                int nLength = this->GetLength();
-                int iChar = 0;
-                while (iChar < nLength)
-                {
-                    // replace instances of the specified character only
-                    if (pszBuffer[iChar] == chOld)
-                    {
-                        if (!bCopied)
-                        {
-                            bCopied = true;
-                            pszBuffer = this->GetBuffer(nLength);
-                        }
-                        pszBuffer[iChar] = chNew;
-                        nCount++;
-                    }
-                    iChar = static_cast<int>(StringTraits::CharNext(pszBuffer + iChar) -
-                                             pszBuffer);
-                }
-                if (bCopied)
-                {
-                    this->ReleaseBufferSetLength(nLength);
-                }
+            // Don't call GetBuffer() (and unshare) unless there is a match
+            int nLength = this->GetLength();
+            const XCHAR *pszMatch =
+                StringTraits::StringFindChar(this->GetString(), nLength, chOld);
+            if (pszMatch == NULL)
+            {
+                return (0);
             }
 
+            int iFirst = static_cast<int>(pszMatch - this->GetString());
+            XCHAR *pszBuffer = this->GetBuffer(nLength);
+            int nCount = static_cast<int>(
+                AmvReplaceChar(pszBuffer + iFirst, nLength - iFirst, chOld, chNew));
+            this->ReleaseBufferSetLength(nLength);
+
             return (nCount);
         }
 
         // Replace all occurrences of string 'pszOld' with string 'pszNew'
-        int Replace(_In_z_ const char *pszOld, _In_z_ const char *pszNew)
+        int Replace(_In_z_ const XCHAR *pszOld, _In_z_ const XCHAR *pszNew)
         {
             // can't have empty or NULL lpszOld
 
@@ -293,102 +566,133 @@ namespace AMV
             // nReplacementLen is in XCHARs
             int nReplacementLen = StringTraits::SafeStringLen(pszNew);
 
-            // loop once to figure out the size of the result string
-            int nCount = 0;
+            // Don't call GetBuffer() (and unshare) unless there is a match
+            int nLength = this->GetLength();
+            const XCHAR *pszSrc = this->GetString();
+            const XCHAR *pszMatch =
+                StringTraits::StringFindString(pszSrc, nLength, pszOld, nSourceLen);
+            if (pszMatch == NULL)
             {
-                const char *pszStart = this->GetString();
-                const char *pszEnd = pszStart + this->GetLength();
-                while (pszStart < pszEnd)
-                {
-                    const char *pszTarget;
-                    while ((pszTarget = StringTraits::StringFindString(pszStart, pszOld)) !=
-                           NULL)
-                    {
-                        nCount++;
-                        pszStart = pszTarget + nSourceLen;
-                    }
-                    pszStart += StringTraits::SafeStringLen(pszStart) + 1;
-                }
+                return (0);
             }
 
-            // if any changes were made, make them
-            if (nCount > 0)
+            if (nReplacementLen <= nSourceLen)
             {
-                // if the buffer is too small, just allocate a new buffer (slow but sure)
-                int nOldLength = this->GetLength();
-                int nNewLength = nOldLength + (nReplacementLen - nSourceLen) * nCount;
+                return (ReplaceShrink(static_cast<int>(pszMatch - pszSrc), pszOld, nSourceLen,
+                                      pszNew, nReplacementLen));
+            }
 
-                char *pszBuffer = this->GetBuffer(__max(nNewLength, nOldLength));
+            // Growing: find every match once, then build the result in a
+            // buffer of the final size from the saved offsets
+            CAmvMatchBuffer<int> matches;
+            const XCHAR *pszEnd = pszSrc + nLength;
+            while (pszMatch != NULL)
+            {
+                matches.Add(static_cast<int>(pszMatch - pszSrc));
+                pszMatch += nSourceLen;
+                pszMatch = StringTraits::StringFindString(
+                    pszMatch, static_cast<int>(pszEnd - pszMatch), pszOld, nSourceLen);
+            }
+            int nCount = matches.GetCount();
 
-                char *pszStart = pszBuffer;
-                char *pszEnd = pszStart + nOldLength;
+            long long nNewLength =
+                nLength + static_cast<long long>(nReplacementLen - nSourceLen) * nCount;
+            if (nNewLength > INT_MAX - 8)
+            {
+                CThisSimpleString::ThrowMemoryException();
+            }
 
-                // loop again to actually do the work
-                while (pszStart < pszEnd)
-                {
-                    char *pszTarget;
-                    while ((pszTarget = StringTraits::StringFindString(pszStart, pszOld)) !=
-                           NULL)
-                    {
-                        int nBalance =
-                            nOldLength - static_cast<int>(pszTarget - pszBuffer + nSourceLen);
-                        memmove_s(pszTarget + nReplacementLen, nBalance * sizeof(char),
-                                  pszTarget + nSourceLen, nBalance * sizeof(char));
-                        memcpy_s(pszTarget, nReplacementLen * sizeof(char), pszNew,
-                                 nReplacementLen * sizeof(char));
-                        pszStart = pszTarget + nReplacementLen;
-                        pszTarget[nReplacementLen + nBalance] = 0;
-                        nOldLength += (nReplacementLen - nSourceLen);
-                    }
-                    pszStart += StringTraits::SafeStringLen(pszStart) + 1;
-                }
-                AMVASSERT(pszBuffer[nNewLength] == 0);
-                this->ReleaseBufferSetLength(nNewLength);
+            CThisSimpleString strNew(this->GetManager());
+            XCHAR *pszDest = strNew.GetBuffer(static_cast<int>(nNewLength));
+            const XCHAR *pszRead = pszSrc;
+            for (int iMatch : matches)
+            {
+                pszMatch = pszSrc + iMatch;
+                int nGap = static_cast<int>(pszMatch - pszRead);
+                memcpy(pszDest, pszRead, nGap * sizeof(XCHAR));
+                memcpy(pszDest + nGap, pszNew, nReplacementLen * sizeof(XCHAR));
+                pszDest += nGap + nReplacementLen;
+                pszRead = pszMatch + nSourceLen;
             }
+            memcpy(pszDest, pszRead, (pszEnd - pszRead) * sizeof(XCHAR));
+            strNew.ReleaseBufferSetLength(static_cast<int>(nNewLength));
+            this->TakeString(strNew);
 
             return (nCount);
         }
 
-        // Remove all occurrences of character 'chRemove'
-        int Remove(_In_ char chRemove)
+        // Replace, in one pass, every match of the (old, new) pairs of 'set'.
+        // At each position the longest old string wins; the replaced text is
+        // not searched again.
+        int ReplaceAll(_In_ const CAmvReplaceSet &set)
         {
+            const CAmvAhoCorasick &matcher = set.GetMatcher();
             int nLength = this->GetLength();
-            char *pszBuffer = this->GetBuffer(nLength);
-
-            char *pszSource = pszBuffer;
-            char *pszDest = pszBuffer;
-            char *pszEnd = pszBuffer + nLength;
+            const XCHAR *pszSrc = this->GetString();
+
+            CAmvMatchBuffer<std::pair<int, int>> matches;
+            long long nNewLength = nLength;
+            matcher.FindAll(pszSrc, nLength, [&](int iStart, int iPattern) {
+                matches.Add(std::make_pair(iStart, iPattern));
+                nNewLength += set.GetReplacementLength(iPattern) -
+                              matcher.GetPatternLength(iPattern);
+            });
+            if (matches.GetCount() == 0)
+            {
+                return (0);
+            }
+            if (nNewLength > INT_MAX - 8)
+            {
+                CThisSimpleString::ThrowMemoryException();
+            }
 
-            while (pszSource < pszEnd)
+            CThisSimpleString strNew(this->GetManager());
+            XCHAR *pszDest = strNew.GetBuffer(static_cast<int>(nNewLength));
+            int iRead = 0;
+            for (const std::pair<int, int> &match : matches)
             {
-                char *pszNewSource = StringTraits::CharNext(pszSource);
-                if (*pszSource != chRemove)
+                int nNew = set.GetReplacementLength(match.second);
+                memcpy(pszDest, pszSrc + iRead, (match.first - iRead) * sizeof(XCHAR));
+                pszDest += match.first - iRead;
+                if (nNew > 0)
                 {
-                    /* Copy the source to the destination.  Remember to copy all bytes of an
-         * MBCS character */
-                    size_t NewSourceGap = (pszNewSource - pszSource);
-                    char *pszNewDest = pszDest + NewSourceGap;
-                    size_t i = 0;
-                    for (i = 0; pszDest != pszNewDest && i < NewSourceGap; i++)
-                    {
-                        *pszDest = *pszSource;
-                        pszSource++;
-                        pszDest++;
-                    }
+                    memcpy(pszDest, set.GetReplacement(match.second), nNew * sizeof(XCHAR));
+                    pszDest += nNew;
                 }
-                pszSource = pszNewSource;
+                iRead = match.first + matcher.GetPatternLength(match.second);
             }
-            *pszDest = 0;
-            int nCount = static_cast<int>(pszSource - pszDest);
-            this->ReleaseBufferSetLength(nLength - nCount);
+            memcpy(pszDest, pszSrc + iRead, (nLength - iRead) * sizeof(XCHAR));
+            strNew.ReleaseBufferSetLength(static_cast<int>(nNewLength));
+            this->TakeString(strNew);
 
-            return (nCount);
+            return (matches.GetCount());
+        }
+
+        int ReplaceAll(_In_ std::initializer_list<std::pair<const char *, const char *>> pairs)
+        {
+            return (ReplaceAll(CAmvReplaceSet(pairs)));
+        }
+
+        // Remove all occurrences of character 'chRemove'
+        int Remove(_In_ XCHAR chRemove)
+        {
+            int nLength = this->GetLength();
+            if (StringTraits::StringFindChar(this->GetString(), nLength, chRemove) == NULL)
+            {
+                return (0);
+            }
+
+            XCHAR *pszBuffer = this->GetBuffer(nLength);
+            int nNewLength = static_cast<int>(AmvRemoveChar(pszBuffer, nLength, chRemove));
+            this->ReleaseBufferSetLength(nNewLength);
+
+            return (nLength - nNewLength);
         }
 
         // find routines
 
         // Find the first occurrence of character 'ch', starting at index 'iStart'
-        int Find(_In_ char ch, _In_ int iStart = 0) const throw()
+        int Find(_In_ XCHAR ch, _In_ int iStart = 0) const throw()
         {
             // iStart is in XCHARs
             AMVASSERT(iStart >= 0);
@@ -400,9 +704,9 @@ namespace AMV
                 return (-1);
             }
 
-            // find first single character
-            const char *psz =
-                StringTraits::StringFindChar(this->GetString() + iStart, ch);
+            // find first single character; the '\0' at the end is found too
+            const XCHAR *psz = StringTraits::StringFindChar(this->GetString() + iStart,
+                                                           nLength - iStart + 1, ch);
 
             // return -1 if not found and index otherwise
             return ((psz == NULL) ? -1 : static_cast<int>(psz - this->GetString()));
@@ -411,7 +715,7 @@ namespace AMV
         // look for a specific sub-string
 
         // Find the first occurrence of string 'pszSub', starting at index 'iStart'
-        int Find(_In_z_ const char *pszSub, _In_ int iStart = 0) const throw()
+        int Find(_In_z_ const XCHAR *pszSub, _In_ int iStart = 0) const throw()
         {
             // iStart is in XCHARs
             AMVASSERT(iStart >= 0);
@@ -429,27 +733,59 @@ namespace AMV
             }
 
             // find first matching substring
-            const char *psz =
-                StringTraits::StringFindString(this->GetString() + iStart, pszSub);
+            const XCHAR *psz =
+                StringTraits::StringFindString(this->GetString() + iStart, nLength - iStart,
+                                               pszSub, StringTraits::SafeStringLen(pszSub));
 
             // return -1 for not found, distance from beginning otherwise
             return ((psz == NULL) ? -1 : static_cast<int>(psz - this->GetString()));
         }
 
+        // Same as above for a sub-string that may hold '\0'
+        int Find(_In_ const CThisSimpleString &strSub, _In_ int iStart = 0) const throw()
+        {
+            return (Find(CThisStringView(strSub), iStart));
+        }
+
+        int Find(_In_ const CThisStringView &sub, _In_ int iStart = 0) const throw()
+        {
+            AMVASSERT(iStart >= 0);
+
+            int nLength = this->GetLength();
+            if (iStart < 0 || iStart > nLength)
+            {
+                return (-1);
+            }
+
+            const XCHAR *psz =
+                StringTraits::StringFindString(this->GetString() + iStart, nLength - iStart,
+                                               sub.GetString(), sub.GetLength());
+
+            return ((psz == NULL) ? -1 : static_cast<int>(psz - this->GetString()));
+        }
+
         // Find the first occurrence of any of the characters in string 'pszCharSet'
-        int FindOneOf(_In_z_ const char *pszCharSet) const throw()
+        int FindOneOf(_In_z_ const XCHAR *pszCharSet) const throw()
         {
             AMVASSERT(AmvIsValidString(pszCharSet));
-            const char *psz =
-                StringTraits::StringScanSet(this->GetString(), pszCharSet);
-            return ((psz == NULL) ? -1 : static_cast<int>(psz - this->GetString()));
+            int nLength = this->GetLength();
+            int iChar = StringTraits::StringSpanExcluding(this->GetString(), nLength, pszCharSet);
+            return ((iChar == nLength) ? -1 : iChar);
+        }
+
+        int FindOneOf(_In_ const CAmvCharSet &set) const throw()
+        {
+            int nLength = this->GetLength();
+            int iChar = StringTraits::StringSpanExcluding(this->GetString(), nLength, set);
+            return ((iChar == nLength) ? -1 : iChar);
         }
 
         // Find the last occurrence of character 'ch'
-        int ReverseFind(_In_ char ch) const throw()
+        int ReverseFind(_In_ XCHAR ch) const throw()
         {
-            // find last single character
-            const char *psz = StringTraits::StringFindCharRev(this->GetString(), ch);
+            // find last single character; the '\0' at the end is found too
+            const XCHAR *psz = StringTraits::StringFindCharRev(this->GetString(),
+                                                              this->GetLength() + 1, ch);
 
             // return -1 if not found, distance from beginning otherwise
             return ((psz == NULL) ? -1 : static_cast<int>(psz - this->GetString()));
@@ -460,29 +796,17 @@ namespace AMV
         // Remove all trailing whitespace
         BStringT &TrimRight()
         {
-            // find beginning of trailing spaces by starting at beginning (DBCS aware)
-            const char *psz = this->GetString();
-            const char *pszLast = NULL;
-
-            while (*psz != 0)
+            // find beginning of trailing spaces
+            const XCHAR *psz = this->GetString();
+            int iLast = this->GetLength();
+            while (iLast > 0 && StringTraits::IsSpace(psz[iLast - 1]))
             {
-                if (StringTraits::IsSpace(*psz))
-                {
-                    if (pszLast == NULL)
-                        pszLast = psz;
-                }
-                else
-                {
-                    pszLast = NULL;
-                }
-                psz = StringTraits::CharNext(psz);
+                iLast--;
             }
 
-            if (pszLast != NULL)
+            if (iLast != this->GetLength())
             {
                 // truncate at trailing space start
-                int iLast = static_cast<int>(pszLast - this->GetString());
-
                 this->Truncate(iLast);
             }
 
@@ -494,9 +818,10 @@ namespace AMV
         {
             // find first non-space character
 
-            const char *psz = this->GetString();
+            const XCHAR *psz = this->GetString();
+            const XCHAR *pszEnd = psz + this->GetLength();
 
-            while (StringTraits::IsSpace(*psz))
+            while (psz < pszEnd && StringTraits::IsSpace(*psz))
             {
                 psz = StringTraits::CharNext(psz);
             }
@@ -505,11 +830,11 @@ namespace AMV
             {
                 // fix up data and length
                 int iFirst = static_cast<int>(psz - this->GetString());
-                char *pszBuffer = this->GetBuffer(this->GetLength());
+                XCHAR *pszBuffer = this->GetBuffer(this->GetLength());
                 psz = pszBuffer + iFirst;
                 int nDataLength = this->GetLength() - iFirst;
-                memmove_s(pszBuffer, (this->GetLength() + 1) * sizeof(char), psz,
-                          (nDataLength + 1) * sizeof(char));
+                memmove_s(pszBuffer, (this->GetLength() + 1) * sizeof(XCHAR), psz,
+                          (nDataLength + 1) * sizeof(XCHAR));
                 this->ReleaseBufferSetLength(nDataLength);
             }
 
@@ -520,14 +845,14 @@ namespace AMV
         BStringT &Trim() { return (TrimRight().TrimLeft()); }
 
         // Remove all leading and trailing occurrences of character 'chTarget'
-        BStringT &Trim(_In_ char chTarget)
+        BStringT &Trim(_In_ XCHAR chTarget)
         {
             return (TrimRight(chTarget).TrimLeft(chTarget));
         }
 
         /* Remove all leading and trailing occurrences of any of the characters in the
    * string 'pszTargets' */
-        BStringT &Trim(_In_z_ const char *pszTargets)
+        BStringT &Trim(_In_z_ const XCHAR *pszTargets)
         {
             return (TrimRight(pszTargets).TrimLeft(pszTargets));
         }
@@ -541,34 +866,19 @@ namespace AMV
         // trimming anything (either side)
 
         // Remove all trailing occurrences of character 'chTarget'
-        BStringT &TrimRight(_In_ char chTarget)
+        BStringT &TrimRight(_In_ XCHAR chTarget)
         {
             // find beginning of trailing matches
-            // by starting at beginning (DBCS aware)
-
-            const char *psz = this->GetString();
-            const char *pszLast = NULL;
-
-            while (*psz != 0)
+            const XCHAR *psz = this->GetString();
+            int iLast = this->GetLength();
+            while (iLast > 0 && psz[iLast - 1] == chTarget)
             {
-                if (*psz == chTarget)
-                {
-                    if (pszLast == NULL)
-                    {
-                        pszLast = psz;
-                    }
-                }
-                else
-                {
-                    pszLast = NULL;
-                }
-                psz = StringTraits::CharNext(psz);
+                iLast--;
             }
 
-            if (pszLast != NULL)
+            if (iLast != this->GetLength())
             {
                 // truncate at left-most matching character
-                int iLast = static_cast<int>(pszLast - this->GetString());
                 this->Truncate(iLast);
             }
 
@@ -577,7 +887,7 @@ namespace AMV
 
         /* Remove all trailing occurrences of any of the characters in string
    * 'pszTargets' */
-        BStringT &TrimRight(_In_z_ const char *pszTargets)
+        BStringT &TrimRight(_In_z_ const XCHAR *pszTargets)
         {
             // if we're not trimming anything, we're not doing any work
             if ((pszTargets == NULL) || (*pszTargets == 0))
@@ -586,31 +896,12 @@ namespace AMV
             }
 
             // find beginning of trailing matches
-            // by starting at beginning (DBCS aware)
+            int iLast = StringTraits::StringSpanIncludingRev(this->GetString(),
+                                                             this->GetLength(), pszTargets);
 
-            const char *psz = this->GetString();
-            const char *pszLast = NULL;
-
-            while (*psz != 0)
-            {
-                if (StringTraits::StringFindChar(pszTargets, *psz) != NULL)
-                {
-                    if (pszLast == NULL)
-                    {
-                        pszLast = psz;
-                    }
-                }
-                else
-                {
-                    pszLast = NULL;
-                }
-                psz = StringTraits::CharNext(psz);
-            }
-
-            if (pszLast != NULL)
+            if (iLast != this->GetLength())
             {
                 // truncate at left-most matching character
-                int iLast = static_cast<int>(pszLast - this->GetString());
                 this->Truncate(iLast);
             }
 
@@ -618,12 +909,13 @@ namespace AMV
         }
 
         // Remove all leading occurrences of character 'chTarget'
-        BStringT &TrimLeft(_In_ char chTarget)
+        BStringT &TrimLeft(_In_ XCHAR chTarget)
         {
             // find first non-matching character
-            const char *psz = this->GetString();
+            const XCHAR *psz = this->GetString();
+            const XCHAR *pszEnd = psz + this->GetLength();
 
-            while (chTarget == *psz)
+            while (psz < pszEnd && chTarget == *psz)
             {
                 psz = StringTraits::CharNext(psz);
             }
@@ -632,11 +924,11 @@ namespace AMV
             {
                 // fix up data and length
                 int iFirst = static_cast<int>(psz - this->GetString());
-                char *pszBuffer = this->GetBuffer(this->GetLength());
+                XCHAR *pszBuffer = this->GetBuffer(this->GetLength());
                 psz = pszBuffer + iFirst;
                 int nDataLength = this->GetLength() - iFirst;
-                memmove_s(pszBuffer, (this->GetLength() + 1) * sizeof(char), psz,
-                          (nDataLength + 1) * sizeof(char));
+                memmove_s(pszBuffer, (this->GetLength() + 1) * sizeof(XCHAR), psz,
+                          (nDataLength + 1) * sizeof(XCHAR));
                 this->ReleaseBufferSetLength(nDataLength);
             }
 
@@ -645,7 +937,7 @@ namespace AMV
 
         /* Remove all leading occurrences of any of the characters in string
    * 'pszTargets' */
-        BStringT &TrimLeft(_In_z_ const char *pszTargets)
+        BStringT &TrimLeft(_In_z_ const XCHAR *pszTargets)
         {
             // if we're not trimming anything, we're not doing any work
             if ((pszTargets == NULL) || (*pszTargets == 0))
@@ -653,229 +945,119 @@ namespace AMV
                 return (*this);
             }
 
-            const char *psz = this->GetString();
-            while ((*psz != 0) &&
-                   (StringTraits::StringFindChar(pszTargets, *psz) != NULL))
-            {
-                psz = StringTraits::CharNext(psz);
-            }
+            const XCHAR *psz = this->GetString();
+            psz += StringTraits::StringSpanIncluding(psz, this->GetLength(), pszTargets);
 
             if (psz != this->GetString())
             {
                 // fix up data and length
                 int iFirst = static_cast<int>(psz - this->GetString());
-                char *pszBuffer = this->GetBuffer(this->GetLength());
+                XCHAR *pszBuffer = this->GetBuffer(this->GetLength());
                 psz = pszBuffer + iFirst;
                 int nDataLength = this->GetLength() - iFirst;
-                memmove_s(pszBuffer, (this->GetLength() + 1) * sizeof(char), psz,
-                          (nDataLength + 1) * sizeof(char));
+                memmove_s(pszBuffer, (this->GetLength() + 1) * sizeof(XCHAR), psz,
+                          (nDataLength + 1) * sizeof(XCHAR));
                 this->ReleaseBufferSetLength(nDataLength);
             }
 
             return (*this);
         }
 
-        friend BStringT operator+(_In_ const BStringT &str1,
-                                  _In_ const BStringT &str2)
+        // The pieces (strings, views, C strings and chars) as one string,
+        // made with a single allocation through the manager of the first
+        // BStringT among them: a chain of operator+ may grow its result a few
+        // times, Concat(a, b, c, d) computes the total length first.
+        template <class... TPieces>
+        static BStringT Concat(_In_ const TPieces &...pieces)
         {
-            BStringT strResult(str1.GetManager());
-
-            CThisSimpleString::Concatenate(strResult, str1, str1.GetLength(), str2,
-                                           str2.GetLength());
+            IAmvStringMgr *pStringMgr = NULL;
+            ((pStringMgr = (pStringMgr != NULL) ? pStringMgr : ConcatManager(pieces)), ...);
+            if (pStringMgr == NULL)
+            {
+                pStringMgr = StringTraits::GetDefaultManager();
+            }
 
-            return (strResult);
+            return (ConcatPieces(pStringMgr, ConcatPiece(pieces)...));
         }
 
-        friend BStringT operator+(_In_ const BStringT &str1,
-                                  _In_z_ const char *psz2)
+        friend BStringT operator+(_In_ const BStringT &str1, _In_ const BStringT &str2)
         {
-            BStringT strResult(str1.GetManager());
-
-            CThisSimpleString::Concatenate(strResult, str1, str1.GetLength(), psz2,
-                                           CThisSimpleString::StringLength(psz2));
-
-            return (strResult);
+            return (Concat(str1, str2));
         }
 
-        friend BStringT operator+(_In_z_ const char *psz1,
-                                  _In_ const BStringT &str2)
+        friend BStringT operator+(_In_ const BStringT &str1, _In_z_ const XCHAR *psz2)
         {
-            BStringT strResult(str2.GetManager());
-
-            CThisSimpleString::Concatenate(strResult, psz1,
-                                           CThisSimpleString::StringLength(psz1), str2,
-                                           str2.GetLength());
-
-            return (strResult);
+            return (Concat(str1, CThisStringView(psz2)));
         }
 
-<<<<<<< HEAD:include/BStringt.hpp
-  friend BStringT operator+(_In_ const BStringT& str1, _In_ char ch2) {
-    BStringT strResult(str1.GetManager());
-
-    CThisSimpleString::Concatenate(strResult, str1, str1.GetLength(), &ch2, 1);
-
-    return (strResult);
-  }
-
-  friend BStringT operator+(_In_ char ch1, _In_ const BStringT& str2) {
-    BStringT strResult(str2.GetManager());
-
-    CThisSimpleString::Concatenate(strResult, &ch1, 1, str2, str2.GetLength());
-
-    return (strResult);
-  }
-
-  friend bool operator==(_In_ const BStringT& str1,
-                         _In_ const BStringT& str2) throw() {
-    return (str1.Compare(str2) == 0);
-  }
-
-  friend bool operator==(_In_ const BStringT& str1,
-                         _In_z_ const char* psz2) throw() {
-    return (str1.Compare(psz2) == 0);
-  }
-
-  friend bool operator==(_In_z_ const char* psz1,
-                         _In_ const BStringT& str2) throw() {
-    return (str2.Compare(psz1) == 0);
-  }
-
-  friend bool operator!=(_In_ const BStringT& str1,
-                         _In_ const BStringT& str2) throw() {
-    return (str1.Compare(str2) != 0);
-  }
-
-  friend bool operator!=(_In_ const BStringT& str1,
-                         _In_z_ const char* psz2) throw() {
-    return (str1.Compare(psz2) != 0);
-  }
-
-  friend bool operator!=(_In_z_ const char* psz1,
-                         _In_ const BStringT& str2) throw() {
-    return (str2.Compare(psz1) != 0);
-  }
-
-  friend bool operator<(_In_ const BStringT& str1,
-                        _In_ const BStringT& str2) throw() {
-    return (str1.Compare(str2) < 0);
-  }
-
-  friend bool operator<(_In_ const BStringT& str1,
-                        _In_z_ const char* psz2) throw() {
-    return (str1.Compare(psz2) < 0);
-  }
-
-  friend bool operator<(_In_z_ const char* psz1,
-                        _In_ const BStringT& str2) throw() {
-    return (str2.Compare(psz1) > 0);
-  }
-
-  friend bool operator>(_In_ const BStringT& str1,
-                        _In_ const BStringT& str2) throw() {
-    return (str1.Compare(str2) > 0);
-  }
-
-  friend bool operator>(_In_ const BStringT& str1,
-                        _In_z_ const char* psz2) throw() {
-    return (str1.Compare(psz2) > 0);
-  }
-
-  friend bool operator>(_In_z_ const char* psz1,
-                        _In_ const BStringT& str2) throw() {
-    return (str2.Compare(psz1) < 0);
-  }
-
-  friend bool operator<=(_In_ const BStringT& str1,
-                         _In_ const BStringT& str2) throw() {
-    return (str1.Compare(str2) <= 0);
-  }
-
-  friend bool operator<=(_In_ const BStringT& str1,
-                         _In_z_ const char* psz2) throw() {
-    return (str1.Compare(psz2) <= 0);
-  }
-
-  friend bool operator<=(_In_z_ const char* psz1,
-                         _In_ const BStringT& str2) throw() {
-    return (str2.Compare(psz1) >= 0);
-  }
+        friend BStringT operator+(_In_z_ const XCHAR *psz1, _In_ const BStringT &str2)
+        {
+            return (Concat(CThisStringView(psz1), str2));
+        }
 
-  friend bool operator>=(_In_ const BStringT& str1,
-                         _In_ const BStringT& str2) throw() {
-    return (str1.Compare(str2) >= 0);
-  }
+        friend BStringT operator+(_In_ const BStringT &str1, _In_ const CThisStringView &view2)
+        {
+            return (Concat(str1, view2));
+        }
 
-  friend bool operator>=(_In_ const BStringT& str1,
-                         _In_z_ const char* psz2) throw() {
-    return (str1.Compare(psz2) >= 0);
-  }
+        friend BStringT operator+(_In_ const CThisStringView &view1, _In_ const BStringT &str2)
+        {
+            return (Concat(view1, str2));
+        }
 
-  friend bool operator>=(_In_z_ const char* psz1,
-                         _In_ const BStringT& str2) throw() {
-    return (str2.Compare(psz1) <= 0);
-  }
+        friend BStringT operator+(_In_ const BStringT &str1, _In_ XCHAR ch2)
+        {
+            return (Concat(str1, ch2));
+        }
 
-  friend bool operator==(_In_ char ch1, _In_ const BStringT& str2) throw() {
-    return ((str2.GetLength() == 1) && (str2[0] == ch1));
-  }
+        friend BStringT operator+(_In_ XCHAR ch1, _In_ const BStringT &str2)
+        {
+            return (Concat(ch1, str2));
+        }
 
-  friend bool operator==(_In_ const BStringT& str1, _In_ char ch2) throw() {
-    return ((str1.GetLength() == 1) && (str1[0] == ch2));
-  }
+        // a + b + c: the temporary on the left is appended to, not copied
 
-  friend bool operator!=(_In_ char ch1, _In_ const BStringT& str2) throw() {
-    return ((str2.GetLength() != 1) || (str2[0] != ch1));
-  }
+        friend BStringT operator+(_Inout_ BStringT &&str1, _In_ const BStringT &str2)
+        {
+            str1 += str2;
 
-  friend bool operator!=(_In_ const BStringT& str1, _In_ char ch2) throw() {
-    return ((str1.GetLength() != 1) || (str1[0] != ch2));
-  }
-};
+            return (std::move(str1));
+        }
 
-}  // namespace AMV
+        friend BStringT operator+(_Inout_ BStringT &&str1, _In_z_ const XCHAR *psz2)
+        {
+            str1 += psz2;
 
-#endif  // BSTRINGT_HPP_
-=======
-#define _CSTRING_CHAR_T char
+            return (std::move(str1));
+        }
 
-        friend BStringT operator+(_In_ const BStringT &str1,
-                                  _In_ _CSTRING_CHAR_T ch2)
+        friend BStringT operator+(_Inout_ BStringT &&str1, _In_ const CThisStringView &view2)
         {
-            BStringT strResult(str1.GetManager());
-            char chTemp = char(ch2);
-
-            CThisSimpleString::Concatenate(strResult, str1, str1.GetLength(), &chTemp,
-                                           1);
+            str1 += view2;
 
-            return (strResult);
+            return (std::move(str1));
         }
 
-        friend BStringT operator+(_In_ _CSTRING_CHAR_T ch1,
-                                  _In_ const BStringT &str2)
+        friend BStringT operator+(_Inout_ BStringT &&str1, _In_ XCHAR ch2)
         {
-            BStringT strResult(str2.GetManager());
-            char chTemp = char(ch1);
+            str1 += ch2;
 
-            CThisSimpleString::Concatenate(strResult, &chTemp, 1, str2,
-                                           str2.GetLength());
-
-            return (strResult);
+            return (std::move(str1));
         }
 
         friend bool operator==(_In_ const BStringT &str1,
                                _In_ const BStringT &str2) throw()
         {
-            return (str1.Compare(str2) == 0);
+            return (str1.IsEqual(str2));
         }
 
         friend bool operator==(_In_ const BStringT &str1,
-                               _In_z_ const char *psz2) throw()
+                               _In_z_ const XCHAR *psz2) throw()
         {
             return (str1.Compare(psz2) == 0);
         }
 
-        friend bool operator==(_In_z_ const char *psz1,
+        friend bool operator==(_In_z_ const XCHAR *psz1,
                                _In_ const BStringT &str2) throw()
         {
             return (str2.Compare(psz1) == 0);
@@ -884,16 +1066,16 @@ namespace AMV
         friend bool operator!=(_In_ const BStringT &str1,
                                _In_ const BStringT &str2) throw()
         {
-            return (str1.Compare(str2) != 0);
+            return (!str1.IsEqual(str2));
         }
 
         friend bool operator!=(_In_ const BStringT &str1,
-                               _In_z_ const char *psz2) throw()
+                               _In_z_ const XCHAR *psz2) throw()
         {
             return (str1.Compare(psz2) != 0);
         }
 
-        friend bool operator!=(_In_z_ const char *psz1,
+        friend bool operator!=(_In_z_ const XCHAR *psz1,
                                _In_ const BStringT &str2) throw()
         {
             return (str2.Compare(psz1) != 0);
@@ -906,12 +1088,12 @@ namespace AMV
         }
 
         friend bool operator<(_In_ const BStringT &str1,
-                              _In_z_ const char *psz2) throw()
+                              _In_z_ const XCHAR *psz2) throw()
         {
             return (str1.Compare(psz2) < 0);
         }
 
-        friend bool operator<(_In_z_ const char *psz1,
+        friend bool operator<(_In_z_ const XCHAR *psz1,
                               _In_ const BStringT &str2) throw()
         {
             return (str2.Compare(psz1) > 0);
@@ -924,12 +1106,12 @@ namespace AMV
         }
 
         friend bool operator>(_In_ const BStringT &str1,
-                              _In_z_ const char *psz2) throw()
+                              _In_z_ const XCHAR *psz2) throw()
         {
             return (str1.Compare(psz2) > 0);
         }
 
-        friend bool operator>(_In_z_ const char *psz1,
+        friend bool operator>(_In_z_ const XCHAR *psz1,
                               _In_ const BStringT &str2) throw()
         {
             return (str2.Compare(psz1) < 0);
@@ -942,12 +1124,12 @@ namespace AMV
         }
 
         friend bool operator<=(_In_ const BStringT &str1,
-                               _In_z_ const char *psz2) throw()
+                               _In_z_ const XCHAR *psz2) throw()
         {
             return (str1.Compare(psz2) <= 0);
         }
 
-        friend bool operator<=(_In_z_ const char *psz1,
+        friend bool operator<=(_In_z_ const XCHAR *psz1,
                                _In_ const BStringT &str2) throw()
         {
             return (str2.Compare(psz1) >= 0);
@@ -960,39 +1142,172 @@ namespace AMV
         }
 
         friend bool operator>=(_In_ const BStringT &str1,
-                               _In_z_ const char *psz2) throw()
+                               _In_z_ const XCHAR *psz2) throw()
         {
             return (str1.Compare(psz2) >= 0);
         }
 
-        friend bool operator>=(_In_z_ const char *psz1,
+        friend bool operator>=(_In_z_ const XCHAR *psz1,
                                _In_ const BStringT &str2) throw()
         {
             return (str2.Compare(psz1) <= 0);
         }
 
-        friend bool operator==(_In_ char ch1, _In_ const BStringT &str2) throw()
+        friend bool operator==(_In_ XCHAR ch1, _In_ const BStringT &str2) throw()
         {
             return ((str2.GetLength() == 1) && (str2[0] == ch1));
         }
 
-        friend bool operator==(_In_ const BStringT &str1, _In_ char ch2) throw()
+        friend bool operator==(_In_ const BStringT &str1, _In_ XCHAR ch2) throw()
         {
             return ((str1.GetLength() == 1) && (str1[0] == ch2));
         }
 
-        friend bool operator!=(_In_ char ch1, _In_ const BStringT &str2) throw()
+        friend bool operator!=(_In_ XCHAR ch1, _In_ const BStringT &str2) throw()
         {
             return ((str2.GetLength() != 1) || (str2[0] != ch1));
         }
 
-        friend bool operator!=(_In_ const BStringT &str1, _In_ char ch2) throw()
+        friend bool operator!=(_In_ const BStringT &str1, _In_ XCHAR ch2) throw()
         {
             return ((str1.GetLength() != 1) || (str1[0] != ch2));
         }
+
+    private:
+        // One char per byte, as in the (puch, nLength) constructor
+        static int ByteStringLength(_In_opt_z_ const unsigned char *psz) throw()
+        {
+            return ((psz != NULL) ? static_cast<int>(strlen(reinterpret_cast<const char *>(psz)))
+                                  : 0);
+        }
+
+        // The pieces of Concat(): each becomes a view or a char, and the first
+        // BStringT gives the manager
+
+        static CThisStringView ConcatPiece(_In_ const CThisStringView &view) throw()
+        {
+            return (view);
+        }
+
+        static XCHAR ConcatPiece(_In_ XCHAR ch) throw() { return (ch); }
+
+        static IAmvStringMgr *ConcatManager(_In_ const BStringT &str) throw()
+        {
+            return (str.GetManager());
+        }
+
+        template <class T>
+        static IAmvStringMgr *ConcatManager(_In_ const T &) throw()
+        {
+            return (NULL);
+        }
+
+        template <class... TPieces>
+        static BStringT ConcatPieces(_In_ IAmvStringMgr *pStringMgr, _In_ const TPieces &...pieces)
+        {
+            // The string needs a '\0' and the manager some rounding on top
+            int64_t nLength = 0;
+            ((nLength += AmvConcatLength(pieces)), ...);
+            if (nLength > INT_MAX - 8)
+            {
+                CThisSimpleString::ThrowMemoryException();
+            }
+
+            BStringT str(pStringMgr);
+            XCHAR *pch = str.GetBuffer(static_cast<int>(nLength));
+            ((pch = AmvConcatCopy(pch, pieces)), ...);
+            str.ReleaseBufferSetLength(static_cast<int>(nLength));
+
+            return (str);
+        }
+
+        // Replace() when the string does not grow: the output never overtakes
+        // the input, so the matches are compacted in place in one pass
+        int ReplaceShrink(_In_ int iFirst, _In_reads_(nSourceLen) const XCHAR *pszOld,
+                          _In_ int nSourceLen, _In_reads_(nReplacementLen) const XCHAR *pszNew,
+                          _In_ int nReplacementLen)
+        {
+            int nLength = this->GetLength();
+            XCHAR *pszBuffer = this->GetBuffer(nLength);
+            const XCHAR *pszEnd = pszBuffer + nLength;
+            const XCHAR *pszRead = pszBuffer + iFirst;
+            const XCHAR *pszMatch = pszRead;
+            XCHAR *pszWrite = pszBuffer + iFirst;
+            int nCount = 0;
+
+            do
+            {
+                int nGap = static_cast<int>(pszMatch - pszRead);
+                if (pszWrite != pszRead)
+                {
+                    memmove(pszWrite, pszRead, nGap * sizeof(XCHAR));
+                }
+                if (nReplacementLen > 0)
+                {
+                    memcpy(pszWrite + nGap, pszNew, nReplacementLen * sizeof(XCHAR));
+                }
+                pszWrite += nGap + nReplacementLen;
+                pszRead = pszMatch + nSourceLen;
+                nCount++;
+                pszMatch = StringTraits::StringFindString(
+                    pszRead, static_cast<int>(pszEnd - pszRead), pszOld, nSourceLen);
+            } while (pszMatch != NULL);
+
+            int nTail = static_cast<int>(pszEnd - pszRead);
+            if (pszWrite != pszRead)
+            {
+                memmove(pszWrite, pszRead, nTail * sizeof(XCHAR));
+            }
+            this->ReleaseBufferSetLength(static_cast<int>(pszWrite - pszBuffer) + nTail);
+
+            return (nCount);
+        }
     };
 
 } // namespace AMV
 
-#endif // BSTRINGT_H_
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/bstringt.h
+namespace std
+{
+
+    // Cached with AMV_STRING_CACHE_HASH, see CSimpleStringT::GetHash()
+    template <typename BaseType, class StringTraits>
+    struct hash<AMV::BStringT<BaseType, StringTraits>>
+    {
+        size_t operator()(_In_ const AMV::BStringT<BaseType, StringTraits> &str) const throw()
+        {
+            return (static_cast<size_t>(str.GetHash()));
+        }
+    };
+
+} // namespace std
+
+namespace fmt
+{
+
+    // "{}" prints the chars, NULs included; the string_view format specs apply
+    template <>
+    struct formatter<AMV::CAmvStringView> : formatter<string_view>
+    {
+        template <typename FormatContext>
+        auto format(_In_ const AMV::CAmvStringView &view, _Inout_ FormatContext &ctx)
+            -> decltype(ctx.out())
+        {
+            return (formatter<string_view>::format(
+                string_view(view.GetString(), view.GetLength()), ctx));
+        }
+    };
+
+    template <class StringTraits>
+    struct formatter<AMV::BStringT<char, StringTraits>> : formatter<AMV::CAmvStringView>
+    {
+        template <typename FormatContext>
+        auto format(_In_ const AMV::BStringT<char, StringTraits> &str,
+                    _Inout_ FormatContext &ctx) -> decltype(ctx.out())
+        {
+            return (formatter<AMV::CAmvStringView>::format(AMV::CAmvStringView(str), ctx));
+        }
+    };
+
+} // namespace fmt
+
+#endif // BSTRINGT_HPP_
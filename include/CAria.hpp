@@ -3,6 +3,8 @@
 #ifndef CARIA_HPP_
 #define CARIA_HPP_
 
+#include <cstddef>
+
 typedef unsigned char Byte;
 typedef unsigned int Word;
 
@@ -110,7 +112,14 @@ const Word X2[256] = {
 
 #define BY(X, Y) ((reinterpret_cast<Byte *>((&X)))[Y])
 #define BRF(T, R) ((Byte)((T) >> (R)))
+#if defined(__GNUC__)
+/* 입력, 출력, 키 Byte array는 4 Byte 정렬이 아닐 수 있다.  정렬과 alias를
+ * 가정하지 않는 Word로 읽고 쓰며, x86과 aarch64에서는 같은 명령어가 된다. */
+typedef Word __attribute__((aligned(1), may_alias)) UnalignedWord;
+#define WO(X, Y) ((reinterpret_cast<UnalignedWord *>((X)))[Y])
+#else
 #define WO(X, Y) ((reinterpret_cast<Word *>((X)))[Y])
+#endif
 
 /* abcd의 4 Byte로 된 Word를 dcba로 변환하는 함수  */
 #if defined(_MSC_VER)
@@ -152,6 +161,17 @@ const Word X2[256] = {
   }
 #endif
 
+/* GCC, clang은 __builtin_bswap32()를 x86의 BSWAP, aarch64의 REV 명령어
+ * 하나로 컴파일하므로 Byte 단위로 옮기는 것보다 빠르다. */
+#if defined(__GNUC__) && defined(_LITTLE_ENDIAN_)
+#undef WordLoad
+#define WordLoad(ORIG, DEST) \
+  { (DEST) = __builtin_bswap32((ORIG)); }
+#undef ReverseWord
+#define ReverseWord(W) \
+  { (W) = __builtin_bswap32((W)); }
+#endif
+
 /* Key XOR Layer */
 #define KXL                              \
   {                                      \
@@ -225,6 +245,75 @@ const Word X2[256] = {
     MM(t0, t1, t2, t3) P(t2, t3, t0, t1) MM(t0, t1, t2, t3) \
   }
 
+/* 여러 블록을 동시에 처리하기 위한 마크로.
+ * KXL, FO, FE와 동일하지만 상태 Word와 라운드 키를 인자로 받는다.
+ * 서로 독립인 블록들의 테이블 참조가 겹쳐서 실행될 수 있도록
+ * CtrCrypt()에서 블록 4개를 한 번에 처리할 때 사용한다. */
+#define KXL_N(T0, T1, T2, T3, RK)          \
+  {                                        \
+    (T0) ^= WO(const_cast<Byte *>(RK), 0); \
+    (T1) ^= WO(const_cast<Byte *>(RK), 1); \
+    (T2) ^= WO(const_cast<Byte *>(RK), 2); \
+    (T3) ^= WO(const_cast<Byte *>(RK), 3); \
+  }
+#define FO_N(T0, T1, T2, T3)                                \
+  {                                                         \
+    SBL1_M(T0, T1, T2, T3)                                  \
+    MM(T0, T1, T2, T3) P(T0, T1, T2, T3) MM(T0, T1, T2, T3) \
+  }
+#define FE_N(T0, T1, T2, T3)                                \
+  {                                                         \
+    SBL2_M(T0, T1, T2, T3)                                  \
+    MM(T0, T1, T2, T3) P(T2, T3, T0, T1) MM(T0, T1, T2, T3) \
+  }
+
+/* 최종 라운드: S-Box Layer 2 + Key XOR Layer. 결과를 Byte array O에 쓴다. */
+#ifdef _LITTLE_ENDIAN_
+#define LAST_ROUND(T0, T1, T2, T3, RK, O)              \
+  {                                                    \
+    (O)[0] = (Byte)(X1[BRF(T0, 24)]) ^ (RK)[3];        \
+    (O)[1] = (Byte)(X2[BRF(T0, 16)] >> 8) ^ (RK)[2];   \
+    (O)[2] = (Byte)(S1[BRF(T0, 8)]) ^ (RK)[1];         \
+    (O)[3] = (Byte)(S2[BRF(T0, 0)]) ^ (RK)[0];         \
+    (O)[4] = (Byte)(X1[BRF(T1, 24)]) ^ (RK)[7];        \
+    (O)[5] = (Byte)(X2[BRF(T1, 16)] >> 8) ^ (RK)[6];   \
+    (O)[6] = (Byte)(S1[BRF(T1, 8)]) ^ (RK)[5];         \
+    (O)[7] = (Byte)(S2[BRF(T1, 0)]) ^ (RK)[4];         \
+    (O)[8] = (Byte)(X1[BRF(T2, 24)]) ^ (RK)[11];       \
+    (O)[9] = (Byte)(X2[BRF(T2, 16)] >> 8) ^ (RK)[10];  \
+    (O)[10] = (Byte)(S1[BRF(T2, 8)]) ^ (RK)[9];        \
+    (O)[11] = (Byte)(S2[BRF(T2, 0)]) ^ (RK)[8];        \
+    (O)[12] = (Byte)(X1[BRF(T3, 24)]) ^ (RK)[15];      \
+    (O)[13] = (Byte)(X2[BRF(T3, 16)] >> 8) ^ (RK)[14]; \
+    (O)[14] = (Byte)(S1[BRF(T3, 8)]) ^ (RK)[13];       \
+    (O)[15] = (Byte)(S2[BRF(T3, 0)]) ^ (RK)[12];       \
+  }
+#else
+#define LAST_ROUND(T0, T1, T2, T3, RK, O)      \
+  {                                            \
+    (O)[0] = (Byte)(X1[BRF(T0, 24)]);          \
+    (O)[1] = (Byte)(X2[BRF(T0, 16)] >> 8);     \
+    (O)[2] = (Byte)(S1[BRF(T0, 8)]);           \
+    (O)[3] = (Byte)(S2[BRF(T0, 0)]);           \
+    (O)[4] = (Byte)(X1[BRF(T1, 24)]);          \
+    (O)[5] = (Byte)(X2[BRF(T1, 16)] >> 8);     \
+    (O)[6] = (Byte)(S1[BRF(T1, 8)]);           \
+    (O)[7] = (Byte)(S2[BRF(T1, 0)]);           \
+    (O)[8] = (Byte)(X1[BRF(T2, 24)]);          \
+    (O)[9] = (Byte)(X2[BRF(T2, 16)] >> 8);     \
+    (O)[10] = (Byte)(S1[BRF(T2, 8)]);          \
+    (O)[11] = (Byte)(S2[BRF(T2, 0)]);          \
+    (O)[12] = (Byte)(X1[BRF(T3, 24)]);         \
+    (O)[13] = (Byte)(X2[BRF(T3, 16)] >> 8);    \
+    (O)[14] = (Byte)(S1[BRF(T3, 8)]);          \
+    (O)[15] = (Byte)(S2[BRF(T3, 0)]);          \
+    WO(O, 0) ^= WO(const_cast<Byte *>(RK), 0); \
+    WO(O, 1) ^= WO(const_cast<Byte *>(RK), 1); \
+    WO(O, 2) ^= WO(const_cast<Byte *>(RK), 2); \
+    WO(O, 3) ^= WO(const_cast<Byte *>(RK), 3); \
+  }
+#endif
+
 /* n-bit right shift of Y XORed to X */
 /* Word 단위로 정의된 블록에서의 회전 + XOR이다. */
 #define GSRK(X, Y, n)                                                        \
@@ -256,18 +345,89 @@ const Word X2[256] = {
 
 namespace Awesome_mix_vol_1 {
 
+/* 백엔드 전용 형식으로 바꾼 라운드 키의 최대 크기 (Byte) */
+#define ARIA_PREPARED_KEY_SIZE (16 * 17)
+
+/* 여러 블록을 한 번에 처리하는 ARIA 구현(백엔드).
+ * CryptBlocks()는 nBlocks개의 연속된 블록(16 Byte씩)에 대해 CAria::Crypt()와
+ * 같은 결과를 만들며, i와 o는 같은 버퍼여도 된다.
+ * name: 백엔드 이름
+ *       ("avx512-gfni", "avx2-gfni", "aesni", "neon", "table")
+ * nParallel: 한 번에 처리하는 블록 수. 이 배수로 주면 가장 효율적이다.
+ * PrepareKey: 라운드 키를 백엔드가 쓰기 좋은 형식으로 바꾼다.
+ *             (최대 ARIA_PREPARED_KEY_SIZE Byte)
+ * CryptBlocksPrepared: PrepareKey()의 결과를 쓰는 CryptBlocks()
+ */
+struct CAriaBackend {
+  const char *name;
+  size_t nParallel;
+  void (*CryptBlocks)(const Byte *i, size_t nBlocks, int Nr, const Byte *rk,
+                      Byte *o);
+  void (*PrepareKey)(const Byte *rk, int Nr, Byte *prepared);
+  void (*CryptBlocksPrepared)(const Byte *i, size_t nBlocks, int Nr,
+                              const Byte *prepared, Byte *o);
+};
+
+class CAriaKey;
+
 class CAria {
  public:
   static void CHECK_ENDIAN();
+  /* EcbCrypt(), CtrCrypt(), CbcDecrypt()가 사용하는 백엔드.
+   * 처음에는 CPU가 지원하는 것 중 가장 빠른 것이 선택된다. */
+  static const CAriaBackend *GetBackend();
+  /* 현재 CPU에서 사용할 수 있는 백엔드 목록. 빠른 순서이며 NULL로 끝난다. */
+  static const CAriaBackend *const *GetBackends();
+  /* 이름으로 백엔드를 선택한다. name이 NULL이면 가장 빠른 것을 선택한다.
+   * return: 성공하면 0, 사용할 수 없는 백엔드면 -1 */
+  static int SetBackend(const char *name);
   void Crypt(const Byte *i, int Nr, const Byte *rk, Byte *o);
+  /* 라운드 수(12, 14, 16)가 컴파일 시간에 정해진 Crypt() */
+  template <int Nr>
+  void Crypt(const Byte *i, const Byte *rk, Byte *o);
+  void CtrCrypt(const Byte *in, size_t len, const Byte *iv, const Byte *rk,
+                int Nr, Byte *out);
+  int EcbCrypt(const Byte *in, size_t len, const Byte *rk, int Nr, Byte *out);
+  int CbcEncrypt(const Byte *in, size_t len, const Byte *iv, const Byte *rk,
+                 int Nr, Byte *out);
+  int CbcDecrypt(const Byte *in, size_t len, const Byte *iv, const Byte *rk,
+                 int Nr, Byte *out);
+  /* CAriaKey를 사용하는 모드 함수.  암호화/복호화에 맞는 라운드 키와
+   * 백엔드 전용 형식의 라운드 키를 CAriaKey에서 골라 쓴다. */
+  void CtrCrypt(const Byte *in, size_t len, const Byte *iv,
+                const CAriaKey &key, Byte *out);
+  int EcbEncrypt(const Byte *in, size_t len, const CAriaKey &key, Byte *out);
+  int EcbDecrypt(const Byte *in, size_t len, const CAriaKey &key, Byte *out);
+  int CbcEncrypt(const Byte *in, size_t len, const Byte *iv,
+                 const CAriaKey &key, Byte *out);
+  int CbcDecrypt(const Byte *in, size_t len, const Byte *iv,
+                 const CAriaKey &key, Byte *out);
   int EncKeySetup(const Byte *mk, Byte *rk, int keyBits);
   int DecKeySetup(const Byte *mk, Byte *rk, int keyBits);
+  /* 키 길이(128, 192, 256)가 컴파일 시간에 정해진 키 스케줄 생성 */
+  template <int KeyBits>
+  int EncKeySetup(const Byte *mk, Byte *rk);
+  template <int KeyBits>
+  int DecKeySetup(const Byte *mk, Byte *rk);
+  /* 키 길이에 따른 라운드 수 */
+  static constexpr int RoundsOf(int keyBits) { return (keyBits + 256) / 32; }
   void printBlockOfLength(Byte *b, int len);
   void printBlock(Byte *b);
 
  protected:
  private:
 };
+
+/* lib/CAria.cc에서 명시적으로 인스턴스화 한다 */
+extern template void CAria::Crypt<12>(const Byte *i, const Byte *rk, Byte *o);
+extern template void CAria::Crypt<14>(const Byte *i, const Byte *rk, Byte *o);
+extern template void CAria::Crypt<16>(const Byte *i, const Byte *rk, Byte *o);
+extern template int CAria::EncKeySetup<128>(const Byte *mk, Byte *rk);
+extern template int CAria::EncKeySetup<192>(const Byte *mk, Byte *rk);
+extern template int CAria::EncKeySetup<256>(const Byte *mk, Byte *rk);
+extern template int CAria::DecKeySetup<128>(const Byte *mk, Byte *rk);
+extern template int CAria::DecKeySetup<192>(const Byte *mk, Byte *rk);
+extern template int CAria::DecKeySetup<256>(const Byte *mk, Byte *rk);
 }  // namespace Awesome_mix_vol_1
 
 #endif  // CARIA_HPP_
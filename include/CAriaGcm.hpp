@@ -0,0 +1,85 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* ARIA-GCM 인증 암호화 (NIST SP 800-38D, RFC 6209의 ARIA-GCM suite)
+ *
+ * CTR 키 스트림 생성과 GHASH를 같은 chunk 단위로 처리해서, 방금 만든
+ * 암호문이 cache에 남아 있는 동안 GHASH를 계산한다.  GHASH는
+ * PCLMULQDQ(x86) 또는 PMULL(aarch64)로 블록 8개씩 모아서 계산하고, 두
+ * 명령어가 없으면 4-bit 테이블로 계산한다.
+ */
+
+#ifndef CARIAGCM_HPP_
+#define CARIAGCM_HPP_
+
+#include <memory>
+
+#include "include/CAriaKey.hpp"
+
+namespace Awesome_mix_vol_1 {
+
+struct CAriaGhash;
+struct CAriaGhashKey;
+
+class CAriaGcm {
+ public:
+  CAriaGcm();
+  ~CAriaGcm();
+
+  /* 키 설정
+   * const Byte *mk: 마스터 키
+   * int keyBits: 마스터 키의 길이 (128, 192, 256)
+   * return: 라운드 수, keyBits가 잘못되었으면 -1
+   */
+  int SetKey(const Byte *mk, int keyBits);
+  /* CAriaKeyCache 등에서 얻은 키를 같이 쓴다 */
+  int SetKey(std::shared_ptr<const CAriaKey> key);
+
+  /* 인증 암호화
+   * const Byte *iv: IV (96-bit 권장)
+   * size_t ivLen: IV의 길이 (Byte, 1 이상)
+   * const Byte *aad: 추가 인증 데이터
+   * size_t aadLen: 추가 인증 데이터의 길이 (Byte)
+   * const Byte *in: 평문
+   * size_t len: 평문의 길이 (Byte)
+   * Byte *out: 암호문 (len Byte, in과 같아도 된다)
+   * Byte *tag: 인증 태그
+   * size_t tagLen: 인증 태그의 길이 (4 ~ 16 Byte)
+   * return: 성공하면 0, 키가 없거나 인자가 잘못되었으면 -1
+   */
+  int Encrypt(const Byte *iv, size_t ivLen, const Byte *aad, size_t aadLen,
+              const Byte *in, size_t len, Byte *out, Byte *tag,
+              size_t tagLen) const;
+  /* 인증 복호화.  인자는 Encrypt()와 같다.
+   * return: 성공하면 0, 인자가 잘못되었으면 -1, 태그가 맞지 않으면 -2
+   *         (이때 out은 0으로 지운다) */
+  int Decrypt(const Byte *iv, size_t ivLen, const Byte *aad, size_t aadLen,
+              const Byte *in, size_t len, Byte *out, const Byte *tag,
+              size_t tagLen) const;
+
+  /* 사용하는 GHASH 구현의 이름 ("pclmul", "pmull", "table") */
+  const char *GhashName() const;
+  /* 이름으로 GHASH 구현을 고른다.  NULL이면 가장 빠른 것을 고른다.
+   * 키를 설정한 뒤에 바꾸면 H의 테이블을 다시 만든다.
+   * return: 성공하면 0, 사용할 수 없는 구현이면 -1 */
+  int SetGhash(const char *name);
+
+ private:
+  CAriaGcm(const CAriaGcm &);
+  CAriaGcm &operator=(const CAriaGcm &);
+
+  void InitGhashKey();
+  void Counter0(const Byte *iv, size_t ivLen, Byte *j0) const;
+  void GhashPadded(Byte *y, const Byte *in, size_t len) const;
+  void Tag(Byte *y, const Byte *j0, size_t aadLen, size_t len) const;
+  void CtrGhash(const Byte *j0, const Byte *in, size_t len, Byte *out,
+                Byte *y, bool dec) const;
+
+  std::shared_ptr<const CAriaKey> key_;
+  const CAriaGhash *ghash_;
+  std::unique_ptr<CAriaGhashKey> ghashKey_;
+  Byte h_[16];
+};
+
+}  // namespace Awesome_mix_vol_1
+
+#endif  // CARIAGCM_HPP_
@@ -0,0 +1,112 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* 미리 계산해 둔 ARIA 키 스케줄과 그 캐시.
+ *
+ * CAriaKey는 마스터 키 하나에 대한 암호화/복호화 라운드 키와 라운드 수,
+ * 그리고 키를 만들 때 선택되어 있던 백엔드 전용 형식의 라운드 키를 함께
+ * 가진다.  한 번 만든 CAriaKey는 바뀌지 않으므로 여러 thread에서 동시에
+ * 사용해도 된다.
+ *
+ * CAriaKeyCache는 마스터 키의 fingerprint로 CAriaKey를 찾는 thread-safe한
+ * LRU 캐시이다.  자주 쓰는 키는 EncKeySetup()/DecKeySetup()을 다시 하지
+ * 않는다.
+ */
+
+#ifndef CARIAKEY_HPP_
+#define CARIAKEY_HPP_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "include/CAria.hpp"
+
+namespace Awesome_mix_vol_1 {
+
+class alignas(64) CAriaKey {
+ public:
+  CAriaKey();
+  ~CAriaKey();
+
+  /* 키 스케줄 생성
+   * const Byte *mk: 마스터 키
+   * int keyBits: 마스터 키의 길이 (128, 192, 256)
+   * return: 라운드 수, keyBits가 잘못되었으면 -1
+   */
+  int Setup(const Byte *mk, int keyBits);
+
+  int Nr() const { return nr_; }
+  int KeyBits() const { return keyBits_; }
+  /* EncKeySetup(), DecKeySetup()의 결과 */
+  const Byte *EncRoundKeys() const { return enc_; }
+  const Byte *DecRoundKeys() const { return dec_; }
+
+  /* Setup() 할 때 선택되어 있던 백엔드와 그 백엔드 전용 형식의 라운드 키 */
+  const CAriaBackend *Backend() const { return backend_; }
+  const Byte *PreparedEncRoundKeys() const { return preparedEnc_; }
+  const Byte *PreparedDecRoundKeys() const { return preparedDec_; }
+
+ private:
+  CAriaKey(const CAriaKey &);
+  CAriaKey &operator=(const CAriaKey &);
+
+  alignas(64) Byte enc_[16 * 17];
+  alignas(64) Byte dec_[16 * 17];
+  alignas(64) Byte preparedEnc_[ARIA_PREPARED_KEY_SIZE];
+  alignas(64) Byte preparedDec_[ARIA_PREPARED_KEY_SIZE];
+  const CAriaBackend *backend_;
+  int nr_;
+  int keyBits_;
+};
+
+typedef CAriaKey AriaKey;
+
+class CAriaKeyCache {
+ public:
+  /* size_t capacity: 최대로 가지고 있을 키의 개수 */
+  explicit CAriaKeyCache(size_t capacity);
+  ~CAriaKeyCache();
+
+  /* mk에 대한 CAriaKey를 돌려준다.  캐시에 없으면 새로 만들어 넣고, 가득
+   * 찼으면 가장 오래 사용하지 않은 키를 버린다.  버려진 키도 돌려받은 쪽이
+   * 가지고 있는 동안에는 유효하다.
+   * return: keyBits가 잘못되었으면 nullptr */
+  std::shared_ptr<const CAriaKey> Get(const Byte *mk, int keyBits);
+
+  void Clear();
+  size_t Size() const;
+  size_t Capacity() const { return capacity_; }
+  uint64_t Hits() const;
+  uint64_t Misses() const;
+
+  /* 마스터 키의 fingerprint (FNV-1a 64-bit) */
+  static uint64_t Fingerprint(const Byte *mk, int keyBits);
+
+ private:
+  CAriaKeyCache(const CAriaKeyCache &);
+  CAriaKeyCache &operator=(const CAriaKeyCache &);
+
+  /* fingerprint가 같아도 다른 키일 수 있으므로 마스터 키도 비교한다 */
+  struct Entry {
+    uint64_t fingerprint;
+    int keyBits;
+    Byte mk[32];
+    std::shared_ptr<const CAriaKey> key;
+  };
+  typedef std::list<Entry> EntryList;
+
+  void Erase(EntryList::iterator it);
+
+  size_t capacity_;
+  mutable std::mutex mutex_;
+  EntryList lru_; /* 앞쪽일수록 최근에 사용한 키 */
+  std::unordered_map<uint64_t, EntryList::iterator> map_;
+  uint64_t hits_;
+  uint64_t misses_;
+};
+
+}  // namespace Awesome_mix_vol_1
+
+#endif  // CARIAKEY_HPP_
@@ -0,0 +1,113 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* 여러 thread로 큰 버퍼를 처리하는 ARIA CTR/ECB 엔진.
+ *
+ * CAriaThreadPool은 thread마다 작업 queue를 가지는 work-stealing thread
+ * pool이다.  자기 queue가 비면 다른 thread의 queue에서 작업을 훔쳐 온다.
+ * 여러 CAriaParallel이 pool 하나를 같이 써도 된다.
+ *
+ * CAriaParallel은 입력을 chunkSize Byte씩 나누어 pool에 넘긴다.  CTR 모드는
+ * chunk의 시작 블록 번호만큼 카운터를 더해 두면 chunk 사이에 의존성이 없다.
+ */
+
+#ifndef CARIAPARALLEL_HPP_
+#define CARIAPARALLEL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "include/CAriaKey.hpp"
+
+namespace Awesome_mix_vol_1 {
+
+class CAriaThreadPool {
+ public:
+  /* size_t nThreads: thread 수. 0이면 CPU 수만큼 만든다. */
+  explicit CAriaThreadPool(size_t nThreads = 0);
+  /* 남은 작업을 모두 처리한 다음 thread를 끝낸다 */
+  ~CAriaThreadPool();
+
+  size_t Size() const { return threads_.size(); }
+
+  /* 작업을 넣는다.  pool의 thread에서 부르면 그 thread의 queue에 넣는다. */
+  void Submit(std::function<void()> task);
+  /* 기다리고 있는 작업 하나를 부른 thread에서 처리한다.
+   * return: 처리한 작업이 있으면 true */
+  bool RunPending();
+
+  /* 프로그램 전체가 같이 쓰는 pool */
+  static CAriaThreadPool &Default();
+
+ private:
+  CAriaThreadPool(const CAriaThreadPool &);
+  CAriaThreadPool &operator=(const CAriaThreadPool &);
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  /* self번째 queue의 뒤에서, 비어 있으면 다른 queue의 앞에서 꺼낸다 */
+  bool Pop(size_t self, std::function<void()> *task);
+  void Worker(size_t self);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex sleepMutex_;
+  std::condition_variable sleepCv_;
+  std::atomic<size_t> pending_;
+  std::atomic<size_t> next_;
+  bool stop_;
+};
+
+class CAriaParallel {
+ public:
+  /* 작업이 끝나면 불리는 함수. 인자는 성공하면 0이다. */
+  typedef std::function<void(int)> Callback;
+
+  /* CAriaThreadPool *pool: 사용할 pool. NULL이면 CAriaThreadPool::Default()
+   * size_t chunkSize: 작업 하나가 처리하는 크기 (Byte, 16의 배수로 내림) */
+  explicit CAriaParallel(CAriaThreadPool *pool = NULL,
+                         size_t chunkSize = 64 * 1024);
+
+  size_t ChunkSize() const { return chunkSize_; }
+
+  /* CAria의 같은 이름의 함수와 결과가 같다.  모든 chunk가 끝날 때까지
+   * 기다리며, 기다리는 동안 부른 thread도 남은 chunk를 처리한다. */
+  void CtrCrypt(const Byte *in, size_t len, const Byte *iv,
+                const CAriaKey &key, Byte *out);
+  int EcbEncrypt(const Byte *in, size_t len, const CAriaKey &key, Byte *out);
+  int EcbDecrypt(const Byte *in, size_t len, const CAriaKey &key, Byte *out);
+
+  /* 기다리지 않는 버전.  마지막 chunk를 처리한 thread에서 done(0)을 부른다.
+   * in, out, key는 done이 불릴 때까지 유효해야 한다.  len이 chunkSize 이하면
+   * 부른 thread에서 바로 처리하고 done을 부른다.
+   * return: 작업을 시작했으면 0, ECB에서 len이 16의 배수가 아니면 done을
+   *         부르지 않고 -1 */
+  int CtrCryptAsync(const Byte *in, size_t len, const Byte *iv,
+                    const CAriaKey &key, Byte *out, Callback done);
+  int EcbEncryptAsync(const Byte *in, size_t len, const CAriaKey &key,
+                      Byte *out, Callback done);
+  int EcbDecryptAsync(const Byte *in, size_t len, const CAriaKey &key,
+                      Byte *out, Callback done);
+
+ private:
+  /* chunk 하나를 처리하는 함수. 인자는 (chunk의 시작 위치, 길이) */
+  typedef std::function<void(size_t, size_t)> ChunkFn;
+
+  void RunSync(size_t len, const ChunkFn &fn);
+  void RunAsync(size_t len, const ChunkFn &fn, Callback done);
+
+  CAriaThreadPool *pool_;
+  size_t chunkSize_;
+};
+
+}  // namespace Awesome_mix_vol_1
+
+#endif  // CARIAPARALLEL_HPP_
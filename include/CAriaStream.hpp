@@ -0,0 +1,93 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* 조각난 입력을 이어서 처리하는 ARIA 스트림 컨텍스트.
+ *
+ * CAria의 모드 함수는 한 번에 버퍼 전체를 받고 CBC는 16 Byte 단위만
+ * 처리한다.  CAriaStream은 호출 사이에 남은 부분 블록과 카운터/IV를
+ * 기억하므로, 입력을 어떤 크기로 나누어 Update()에 넣어도 한 번에 처리한 것과
+ * 결과가 같다.  블록 단위로 처리할 수 있는 부분은 입력에서 출력으로 바로
+ * 처리하고, 16 Byte 미만의 조각만 내부에 보관한다.
+ */
+
+#ifndef CARIASTREAM_HPP_
+#define CARIASTREAM_HPP_
+
+#include <sys/uio.h>
+
+#include <memory>
+
+#include "include/CAriaKey.hpp"
+
+namespace Awesome_mix_vol_1 {
+
+class CAriaStream {
+ public:
+  enum Mode {
+    kCtr,        /* CTR 암호화/복호화 */
+    kCbcEncrypt, /* CBC 암호화 */
+    kCbcDecrypt  /* CBC 복호화 */
+  };
+
+  CAriaStream();
+  ~CAriaStream();
+
+  /* 스트림 시작
+   * Mode mode: 모드
+   * std::shared_ptr<const CAriaKey> key: 키
+   * const Byte *iv: CTR은 초기 카운터 블록, CBC는 초기 벡터 (16 Byte)
+   * bool padding: CBC에서 PKCS#7 padding을 쓸지 여부 (CTR은 무시)
+   * return: 성공하면 0, key가 없으면 -1
+   */
+  int Init(Mode mode, std::shared_ptr<const CAriaKey> key, const Byte *iv,
+           bool padding = false);
+
+  /* 입력을 이어서 처리한다.  CTR은 in과 out이 같은 버퍼여도 되지만, CBC는
+   * 보관한 조각 때문에 출력이 입력보다 앞설 수 있으므로 겹치면 안 된다.
+   * Byte *out: 출력. len + 16 Byte가 있어야 한다.
+   * size_t *outLen: 출력한 길이. CTR은 항상 len이고, CBC는 16의 배수이다.
+   * return: 성공하면 0, Init() 전이거나 Final() 뒤이면 -1
+   */
+  int Update(const Byte *in, size_t len, Byte *out, size_t *outLen);
+  /* 흩어진 입력(iovec)을 모아서 out에 이어서 출력한다.  출력은 gather만
+   * 하고 호출자의 iovec에 나누어 쓰지는 않는다.
+   * Byte *out: 출력. 모든 iov_len의 합 + 16 Byte가 있어야 한다.
+   * size_t *outLen: 출력한 길이. 실패하면 그때까지 출력한 길이이다.
+   * return: 성공하면 0, 조각 하나라도 실패하면 그 조각의 결과 (-1)
+   */
+  int Update(const struct iovec *iov, int iovcnt, Byte *out, size_t *outLen);
+  /* 흩어진 버퍼들을 제자리에서 처리한다.  CBC는 부분 블록을 보관하느라
+   * 출력이 입력과 어긋나므로 CTR 모드만 된다.
+   * return: 성공하면 0, CTR 모드가 아니면 -1 */
+  int UpdateInPlace(const struct iovec *iov, int iovcnt);
+
+  /* 스트림을 끝낸다.  다시 쓰려면 Init()을 부른다.
+   * Byte *out: 남은 출력 (16 Byte가 있어야 한다)
+   * size_t *outLen: 출력한 길이
+   * return: 성공하면 0, padding 없는 CBC에서 입력이 16의 배수가 아니었거나
+   *         CBC 복호화의 padding이 잘못되었으면 -1
+   */
+  int Final(Byte *out, size_t *outLen);
+
+ private:
+  CAriaStream(const CAriaStream &);
+  CAriaStream &operator=(const CAriaStream &);
+
+  void CtrUpdate(const Byte *in, size_t len, Byte *out);
+  size_t CbcEncryptUpdate(const Byte *in, size_t len, Byte *out);
+  size_t CbcDecryptUpdate(const Byte *in, size_t len, Byte *out);
+  void Reset();
+
+  std::shared_ptr<const CAriaKey> key_;
+  Mode mode_;
+  bool padding_;
+  bool active_;
+  Byte iv_[16];  /* CTR은 다음 카운터, CBC는 앞 블록의 암호문 */
+  Byte buf_[16]; /* CTR은 남은 키 스트림, CBC는 남은 입력 */
+  size_t bufLen_;
+};
+
+typedef CAriaStream AriaStream;
+
+}  // namespace Awesome_mix_vol_1
+
+#endif  // CARIASTREAM_HPP_
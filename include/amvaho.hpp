@@ -0,0 +1,336 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVAHO_HPP_
+#define AMVAHO_HPP_
+
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include "include/amvdefine.hpp"
+#include "include/amvsimd.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // Aho-Corasick automaton over byte strings.
+    //
+    // Add() the patterns, Build() once, then FindAll() reports the leftmost
+    // longest, non-overlapping matches in a single pass over the text: at
+    // each position the longest pattern starting there wins, and the scan
+    // resumes after it.  Bytes that occur in no pattern share one input
+    // class, so the transition table is (states x classes) rather than
+    // (states x 256).  A built automaton is read-only and may be shared by
+    // threads.
+    class CAmvAhoCorasick
+    {
+    public:
+        CAmvAhoCorasick() : m_nClasses(1), m_nMaxLength(0), m_nRing(1), m_bBuilt(false)
+        {
+            memset(m_aClass, 0, sizeof(m_aClass));
+        }
+
+        // Returns the index of the pattern, or -1 for an empty one.  Adding
+        // the same pattern twice returns the first index.
+        int Add(_In_reads_(nLength) const char *pch, _In_ int nLength)
+        {
+            AMVASSERT(!m_bBuilt);
+            if (nLength <= 0)
+            {
+                return (-1);
+            }
+            for (int i = 0; i < GetPatternCount(); i++)
+            {
+                if (m_anLength[i] == nLength && memcmp(&m_chars[m_anStart[i]], pch, nLength) == 0)
+                {
+                    return (i);
+                }
+            }
+
+            m_anStart.push_back(static_cast<int>(m_chars.size()));
+            m_anLength.push_back(nLength);
+            m_chars.insert(m_chars.end(), pch, pch + nLength);
+            m_first.Add(pch[0]);
+            if (nLength > m_nMaxLength)
+            {
+                m_nMaxLength = nLength;
+            }
+            return (GetPatternCount() - 1);
+        }
+
+        void Build()
+        {
+            AMVASSERT(!m_bBuilt);
+
+            // Input classes: 0 for bytes in no pattern
+            for (size_t i = 0; i < m_chars.size(); i++)
+            {
+                unsigned char uch = static_cast<unsigned char>(m_chars[i]);
+                if (m_aClass[uch] == 0)
+                {
+                    m_aClass[uch] = static_cast<unsigned short>(m_nClasses++);
+                }
+            }
+
+            // Trie
+            NewState(0);
+            for (int iPattern = 0; iPattern < GetPatternCount(); iPattern++)
+            {
+                int nState = 0;
+                for (int i = 0; i < m_anLength[iPattern]; i++)
+                {
+                    size_t iNext =
+                        nState * m_nClasses + ClassOf(m_chars[m_anStart[iPattern] + i]);
+                    if (m_anNext[iNext] == 0)
+                    {
+                        // NewState() grows m_anNext: no reference across it
+                        int nNew = NewState(i + 1);
+                        m_anNext[iNext] = nNew;
+                    }
+                    nState = m_anNext[iNext];
+                }
+                m_anPattern[nState] = iPattern;
+            }
+
+            // Failure links in BFS order, folded into the table so that the
+            // scan takes exactly one transition per byte.  m_anOutput[] links
+            // each state to the next shorter suffix that ends a pattern.
+            std::vector<int> anFail(m_anPattern.size(), 0);
+            std::vector<int> anQueue;
+            anQueue.reserve(m_anPattern.size());
+            anQueue.push_back(0);
+            for (size_t iHead = 0; iHead < anQueue.size(); iHead++)
+            {
+                int nState = anQueue[iHead];
+                for (int c = 0; c < m_nClasses; c++)
+                {
+                    int &nNext = m_anNext[nState * m_nClasses + c];
+                    int nFailNext =
+                        (nState == 0) ? 0 : m_anNext[anFail[nState] * m_nClasses + c];
+                    if (nNext == 0)
+                    {
+                        nNext = nFailNext;
+                        continue;
+                    }
+
+                    anFail[nNext] = nFailNext;
+                    m_anOutput[nNext] = m_anFirstOutput[nFailNext];
+                    m_anFirstOutput[nNext] =
+                        (m_anPattern[nNext] >= 0) ? nNext : m_anOutput[nNext];
+                    anQueue.push_back(nNext);
+                }
+            }
+
+            // Premultiplied rows take a multiply off the per-byte dependency
+            // chain
+            const int W = m_nClasses + 1;
+            std::vector<int> anRows(m_anPattern.size() * W);
+            for (size_t nState = 0; nState < m_anPattern.size(); nState++)
+            {
+                for (int c = 0; c < m_nClasses; c++)
+                {
+                    anRows[nState * W + c] = m_anNext[nState * m_nClasses + c] * W;
+                }
+                anRows[nState * W + m_nClasses] = static_cast<int>(nState);
+            }
+            m_anNext.swap(anRows);
+
+            // Unsettled positions never span more than m_nMaxLength + 1
+            while (m_nRing <= m_nMaxLength)
+            {
+                m_nRing <<= 1;
+            }
+            m_bBuilt = true;
+        }
+
+        bool IsBuilt() const throw() { return (m_bBuilt); }
+
+        int GetPatternCount() const throw() { return (static_cast<int>(m_anLength.size())); }
+
+        int GetPatternLength(_In_ int iPattern) const throw() { return (m_anLength[iPattern]); }
+
+        int GetMaxLength() const throw() { return (m_nMaxLength); }
+
+        // Calls f(iStart, iPattern) for every match, left to right, and
+        // returns the number of matches
+        template <class F>
+        int FindAll(_In_reads_(nLength) const char *pch, _In_ int nLength, _In_ F f) const
+        {
+            AMVASSERT(m_bBuilt);
+            if (m_nMaxLength == 0)
+            {
+                return (0);
+            }
+
+            // Longest pattern found so far starting at each position that is
+            // not settled yet.  A position is settled once no pattern starting
+            // there can still be in progress, i.e. once it lies before the
+            // prefix the automaton is in.
+            std::vector<int> anBest(m_nRing, -1);
+            const int nMask = m_nRing - 1;
+            const int *pnNext = m_anNext.data();
+            const int *pnLength = m_anLength.data();
+            int iSettle = 0;
+            int iNext = 0;
+            int nCount = 0;
+            int nRow = 0;
+
+            for (int e = 0; e < nLength; e++)
+            {
+                if (nRow == 0 && !m_first.Contains(pch[e]))
+                {
+                    // Nothing in progress: skip to the next byte that can start
+                    // a pattern
+                    e += static_cast<int>(AmvSpanExcluding(pch + e, nLength - e, m_first));
+                    if (e == nLength)
+                    {
+                        break;
+                    }
+                    iSettle = e;
+                }
+
+                nRow = pnNext[nRow + ClassOf(pch[e])];
+                int nState = pnNext[nRow + m_nClasses];
+                for (int s = m_anFirstOutput[nState]; s != 0; s = m_anOutput[s])
+                {
+                    int iPattern = m_anPattern[s];
+                    int &iBest = anBest[(e + 1 - pnLength[iPattern]) & nMask];
+                    if (iBest < 0 || pnLength[iBest] < pnLength[iPattern])
+                    {
+                        iBest = iPattern;
+                    }
+                }
+
+                for (int iLast = e - m_anDepth[nState]; iSettle <= iLast; iSettle++)
+                {
+                    int &iBest = anBest[iSettle & nMask];
+                    if (iBest >= 0)
+                    {
+                        if (iSettle >= iNext)
+                        {
+                            f(iSettle, iBest);
+                            iNext = iSettle + pnLength[iBest];
+                            nCount++;
+                        }
+                        iBest = -1;
+                    }
+                }
+            }
+
+            // What is left can only end at the end of the text
+            for (; iSettle < nLength; iSettle++)
+            {
+                int iBest = anBest[iSettle & nMask];
+                if (iBest >= 0 && iSettle >= iNext)
+                {
+                    f(iSettle, iBest);
+                    iNext = iSettle + pnLength[iBest];
+                    nCount++;
+                }
+            }
+
+            return (nCount);
+        }
+
+    private:
+        int ClassOf(_In_ char ch) const throw()
+        {
+            return (m_aClass[static_cast<unsigned char>(ch)]);
+        }
+
+        int NewState(_In_ int nDepth)
+        {
+            m_anNext.resize(m_anNext.size() + m_nClasses, 0);
+            m_anPattern.push_back(-1);
+            m_anFirstOutput.push_back(0);
+            m_anOutput.push_back(0);
+            m_anDepth.push_back(nDepth);
+            return (static_cast<int>(m_anPattern.size()) - 1);
+        }
+
+        unsigned short m_aClass[256];
+        int m_nClasses;
+        int m_nMaxLength;
+        // Size of the FindAll() ring, a power of two above m_nMaxLength
+        int m_nRing;
+        bool m_bBuilt;
+        // First bytes of the patterns
+        CAmvCharSet m_first;
+        // Patterns back to back, pattern i at m_anStart[i]
+        std::vector<char> m_chars;
+        std::vector<int> m_anStart;
+        std::vector<int> m_anLength;
+        // Transitions; state 0 is the root and, while building, "no state".
+        // Once built, one row of m_nClasses + 1 ints per state: the offsets of
+        // the next rows, then the state itself.
+        std::vector<int> m_anNext;
+        // Per state: the pattern ending there or -1, the longest pattern that
+        // is a suffix of it (the state itself or m_anOutput[]) or 0, the next
+        // shorter such pattern or 0, and the length of its prefix
+        std::vector<int> m_anPattern;
+        std::vector<int> m_anFirstOutput;
+        std::vector<int> m_anOutput;
+        std::vector<int> m_anDepth;
+    };
+
+    // (old, new) pairs that BStringT::ReplaceAll() applies in one pass
+    class CAmvReplaceSet
+    {
+    public:
+        CAmvReplaceSet() {}
+
+        CAmvReplaceSet(_In_ std::initializer_list<std::pair<const char *, const char *>> pairs)
+        {
+            for (const std::pair<const char *, const char *> &pair : pairs)
+            {
+                Add(pair.first, pair.second);
+            }
+            Build();
+        }
+
+        // An empty pszOld is ignored; for a repeated pszOld the first pszNew is
+        // kept
+        void Add(_In_z_ const char *pszOld, _In_opt_z_ const char *pszNew)
+        {
+            int nOldLength = (pszOld != NULL) ? static_cast<int>(strlen(pszOld)) : 0;
+            int iPattern = m_matcher.Add(pszOld, nOldLength);
+            if (iPattern == static_cast<int>(m_anStart.size()))
+            {
+                m_anStart.push_back(static_cast<int>(m_chars.size()));
+                if (pszNew != NULL)
+                {
+                    m_chars.insert(m_chars.end(), pszNew, pszNew + strlen(pszNew));
+                }
+            }
+        }
+
+        void Build()
+        {
+            m_anStart.push_back(static_cast<int>(m_chars.size()));
+            m_matcher.Build();
+        }
+
+        const CAmvAhoCorasick &GetMatcher() const throw() { return (m_matcher); }
+
+        const char *GetReplacement(_In_ int iPattern) const throw()
+        {
+            return (m_chars.data() + m_anStart[iPattern]);
+        }
+
+        int GetReplacementLength(_In_ int iPattern) const throw()
+        {
+            return (m_anStart[iPattern + 1] - m_anStart[iPattern]);
+        }
+
+    private:
+        CAmvAhoCorasick m_matcher;
+        std::vector<char> m_chars;
+        std::vector<int> m_anStart;
+    };
+
+} // namespace AMV
+
+#endif // AMVAHO_HPP_
@@ -45,102 +45,60 @@ namespace AMV
         static const uint64_t _Max = ULONG_MAX;
     };
 
-    /* generic version */
+    /* Checked arithmetic.  The compiler builtins report overflow from the
+     * flags of the add or multiply itself, for any integer type, so there
+     * is no division and no wider type to multiply in.  *ptResult is only
+     * written on success. */
     template <typename T>
-    inline int64_t AmvAdd(_Out_ T *ptResult, _In_ T tLeft, _In_ T tRight)
+    constexpr int64_t AmvAdd(_Out_ T *ptResult, _In_ T tLeft, _In_ T tRight)
     {
-        if (::AMV::AmvLimits<T>::_Max - tLeft < tRight)
+        T tResult = 0;
+        if (__builtin_add_overflow(tLeft, tRight, &tResult))
         {
-            return ERROR_ARITHMETIC_OVERFLOW;
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
         }
-        *ptResult = tLeft + tRight;
+        *ptResult = tResult;
         return S_OK;
     }
 
     template <typename T>
-    inline int64_t AmvAddThrow(_In_ T tLeft, _In_ T tRight)
+    constexpr T AmvAddThrow(_In_ T tLeft, _In_ T tRight)
     {
-        T tResult;
-        int64_t l;
-        if ((l = AmvAdd(&tResult, tLeft, tRight)) != S_OK)
+        T tResult = 0;
+        int64_t l = AmvAdd(&tResult, tLeft, tRight);
+        if (l != S_OK)
         {
             AmvThrow(l);
         }
         return tResult;
     }
 
-    /* generic but comparatively slow version */
     template <typename T>
-    inline int64_t AmvMultiply(_Out_ T *ptResult, _In_ T tLeft, _In_ T tRight)
+    constexpr int64_t AmvMultiply(_Out_ T *ptResult, _In_ T tLeft, _In_ T tRight)
     {
-        /* avoid divide 0 */
-        if (tLeft == 0)
+        T tResult = 0;
+        if (__builtin_mul_overflow(tLeft, tRight, &tResult))
         {
-            *ptResult = 0;
-            return S_OK;
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
         }
-        if (::AMV::AmvLimits<T>::_Max / tLeft < tRight)
-        {
-            return ERROR_ARITHMETIC_OVERFLOW;
-        }
-        *ptResult = tLeft * tRight;
+        *ptResult = tResult;
         return S_OK;
     }
 
-    /* fast version for 32 bit integers */
-    template <>
-    inline int64_t AmvMultiply(_Out_ int *piResult, _In_ int iLeft,
-                               _In_ int iRight)
-    {
-        int64_t i64Result =
-            static_cast<int64_t>(iLeft) * static_cast<int64_t>(iRight);
-        if (i64Result > INT_MAX || i64Result < INT_MIN)
-        {
-            return ERROR_ARITHMETIC_OVERFLOW;
-        }
-        *piResult = static_cast<int>(i64Result);
-        return S_OK;
-    }
-
-    template <>
-    inline int64_t AmvMultiply(_Out_ unsigned int *piResult,
-                               _In_ unsigned int iLeft, _In_ unsigned int iRight)
-    {
-        uint64_t i64Result =
-            static_cast<uint64_t>(iLeft) * static_cast<uint64_t>(iRight);
-        if (i64Result > UINT_MAX)
-        {
-            return ERROR_ARITHMETIC_OVERFLOW;
-        }
-        *piResult = static_cast<unsigned int>(i64Result);
-        return S_OK;
-    }
-
-    template <>
-    inline int64_t AmvMultiply(_Out_ int64_t *piResult, _In_ int64_t iLeft,
-                               _In_ int64_t iRight)
-    {
-        int64_t i64Result =
-            static_cast<int64_t>(iLeft) * static_cast<int64_t>(iRight);
-        if (i64Result > LONG_MAX || i64Result < LONG_MIN)
-        {
-            return ERROR_ARITHMETIC_OVERFLOW;
-        }
-        *piResult = static_cast<int64_t>(i64Result);
-        return S_OK;
-    }
-
-    template <>
-    inline int64_t AmvMultiply(_Out_ uint64_t *piResult, _In_ uint64_t iLeft,
-                               _In_ uint64_t iRight)
+    /* tLeft * tRight + tAdd in one check, for allocation sizes: header plus
+     * count times element size */
+    template <typename T>
+    constexpr int64_t AmvMultiplyAdd(_Out_ T *ptResult, _In_ T tLeft, _In_ T tRight,
+                                     _In_ T tAdd)
     {
-        uint64_t i64Result =
-            static_cast<uint64_t>(iLeft) * static_cast<uint64_t>(iRight);
-        if (i64Result > ULONG_MAX)
+        T tProduct = 0;
+        T tResult = 0;
+        if (__builtin_mul_overflow(tLeft, tRight, &tProduct) ||
+            __builtin_add_overflow(tProduct, tAdd, &tResult))
         {
-            return ERROR_ARITHMETIC_OVERFLOW;
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
         }
-        *piResult = static_cast<uint64_t>(i64Result);
+        *ptResult = tResult;
         return S_OK;
     }
 
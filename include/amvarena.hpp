@@ -0,0 +1,263 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVARENA_HPP_
+#define AMVARENA_HPP_
+
+#include <cstdlib>
+#include <cstring>
+
+#include "include/amvdefine.hpp"
+#include "include/amvmem.hpp"
+#include "include/amvstr.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // Monotonic (bump pointer) memory manager.  Memory is carved out of large
+    // chunks and only comes back all at once with Reset() or the destructor.
+    // Free() only rewinds the most recent block, and Reallocate() grows the
+    // most recent block in place.  Not thread-safe: use one arena per thread
+    // or per request.
+    class CAmvArenaHeap : public IAmvMemMgr
+    {
+    public:
+        static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+        explicit CAmvArenaHeap(_In_ size_t nChunkSize = DEFAULT_CHUNK_SIZE) throw()
+            : m_pChunk(NULL),
+              m_pNext(NULL),
+              m_pEnd(NULL),
+              m_pLast(NULL),
+              m_nChunkSize(nChunkSize),
+              m_nChunks(0)
+        {
+        }
+
+        virtual ~CAmvArenaHeap() throw() { FreeChunks(NULL); }
+
+        // IAmvMemMgr
+        virtual void *Allocate(_In_ size_t nBytes) throw()
+        {
+            size_t nSize = AmvAlignUp(nBytes, ALIGNMENT);
+            if (nSize < nBytes)
+            {
+                return NULL;
+            }
+            if (static_cast<size_t>(m_pEnd - m_pNext) < sizeof(Header) + nSize &&
+                !NewChunk(nSize))
+            {
+                return NULL;
+            }
+
+            Header *pHeader = reinterpret_cast<Header *>(m_pNext);
+            pHeader->nBytes = nSize;
+            m_pLast = pHeader + 1;
+            m_pNext = static_cast<char *>(m_pLast) + nSize;
+
+            return (m_pLast);
+        }
+
+        virtual void Free(_In_opt_ void *p) throw()
+        {
+            // Only the most recent block can be given back
+            if (p != NULL && p == m_pLast)
+            {
+                m_pNext = reinterpret_cast<char *>(GetHeader(p));
+                m_pLast = NULL;
+            }
+        }
+
+        virtual void *Reallocate(_In_opt_ void *p, _In_ size_t nBytes) throw()
+        {
+            if (p == NULL)
+            {
+                return (Allocate(nBytes));
+            }
+
+            if (nBytes == 0)
+            {
+                Free(p);
+                return NULL;
+            }
+
+            Header *pHeader = GetHeader(p);
+            if (nBytes <= pHeader->nBytes)
+            {
+                return (p);
+            }
+
+            size_t nSize = AmvAlignUp(nBytes, ALIGNMENT);
+            if (p == m_pLast && nSize >= nBytes &&
+                static_cast<size_t>(m_pEnd - static_cast<char *>(p)) >= nSize)
+            {
+                // Last block: grow in place
+                pHeader->nBytes = nSize;
+                m_pNext = static_cast<char *>(p) + nSize;
+                return (p);
+            }
+
+            void *pNew = Allocate(nBytes);
+            if (pNew != NULL)
+            {
+                memcpy(pNew, p, pHeader->nBytes);
+            }
+            return (pNew);
+        }
+
+        virtual size_t GetSize(_In_ void *p) throw() { return (GetHeader(p)->nBytes); }
+
+        // Gives all blocks back at once.  One chunk of the default size is kept
+        // for the next round.
+        void Reset() throw()
+        {
+            Chunk *pKeep = m_pChunk;
+            while (pKeep != NULL && pKeep->nSize != m_nChunkSize)
+            {
+                pKeep = pKeep->pPrev;
+            }
+            FreeChunks(pKeep);
+
+            if (pKeep != NULL)
+            {
+                pKeep->pPrev = NULL;
+                m_pChunk = pKeep;
+                m_pNext = reinterpret_cast<char *>(pKeep + 1);
+                m_pEnd = reinterpret_cast<char *>(pKeep) + pKeep->nSize;
+                m_nChunks = 1;
+            }
+        }
+
+        // Number of chunks taken from malloc() and still held
+        size_t GetChunkCount() const throw() { return (m_nChunks); }
+
+    private:
+        static const size_t ALIGNMENT = 8;
+
+        struct Chunk
+        {
+            Chunk *pPrev;
+            size_t nSize;
+        };
+
+        struct Header
+        {
+            size_t nBytes;
+        };
+
+        static Header *GetHeader(_In_ void *p) throw()
+        {
+            return (static_cast<Header *>(p) - 1);
+        }
+
+        bool NewChunk(_In_ size_t nSize) throw()
+        {
+            size_t nChunkSize = sizeof(Chunk) + sizeof(Header) + nSize;
+            if (nChunkSize < nSize)
+            {
+                return false;
+            }
+            if (nChunkSize < m_nChunkSize)
+            {
+                nChunkSize = m_nChunkSize;
+            }
+
+            Chunk *pChunk = static_cast<Chunk *>(malloc(nChunkSize));
+            if (pChunk == NULL)
+            {
+                return false;
+            }
+            pChunk->pPrev = m_pChunk;
+            pChunk->nSize = nChunkSize;
+            m_pChunk = pChunk;
+            m_pNext = reinterpret_cast<char *>(pChunk + 1);
+            m_pEnd = reinterpret_cast<char *>(pChunk) + nChunkSize;
+            m_pLast = NULL;
+            m_nChunks++;
+
+            return true;
+        }
+
+        // Frees every chunk except pKeep
+        void FreeChunks(_In_opt_ Chunk *pKeep) throw()
+        {
+            Chunk *pChunk = m_pChunk;
+            while (pChunk != NULL)
+            {
+                Chunk *pPrev = pChunk->pPrev;
+                if (pChunk != pKeep)
+                {
+                    free(pChunk);
+                }
+                pChunk = pPrev;
+            }
+            m_pChunk = NULL;
+            m_pNext = NULL;
+            m_pEnd = NULL;
+            m_pLast = NULL;
+            m_nChunks = 0;
+        }
+
+        Chunk *m_pChunk;
+        char *m_pNext;
+        char *m_pEnd;
+        void *m_pLast;
+        size_t m_nChunkSize;
+        size_t m_nChunks;
+
+    private:
+        CAmvArenaHeap(_In_ const CAmvArenaHeap &) throw();
+        CAmvArenaHeap &operator=(_In_ const CAmvArenaHeap &) throw();
+    };
+
+    // String manager whose strings live in its own CAmvArenaHeap.  Strings are
+    // expected to die together: Reset() releases all their memory at once and
+    // must only be called when no string of this manager is alive.
+    class CAmvArenaStringMgr : public CAmvStringMgr
+    {
+    public:
+        explicit CAmvArenaStringMgr(
+            _In_ size_t nChunkSize = CAmvArenaHeap::DEFAULT_CHUNK_SIZE) throw()
+            : CAmvStringMgr(&m_heap), m_heap(nChunkSize), m_nStrings(0)
+        {
+        }
+
+        virtual ~CAmvArenaStringMgr() throw() { AMVASSERT(m_nStrings == 0); }
+
+        // IAmvStringMgr
+        virtual BStringData *Allocate(_In_ int nChars, _In_ int nCharSize) throw()
+        {
+            BStringData *pData = CAmvStringMgr::Allocate(nChars, nCharSize);
+            if (pData != NULL)
+            {
+                m_nStrings++;
+            }
+            return (pData);
+        }
+
+        virtual void Free(_In_ BStringData *pData) throw()
+        {
+            AMVASSERT(m_nStrings > 0);
+            m_nStrings--;
+            CAmvStringMgr::Free(pData);
+        }
+
+        void Reset() throw()
+        {
+            AMVASSERT(m_nStrings == 0);
+            m_heap.Reset();
+        }
+
+        CAmvArenaHeap &GetHeap() throw() { return (m_heap); }
+
+        // Number of heap BStringData currently alive
+        size_t GetStringCount() const throw() { return (m_nStrings); }
+
+    private:
+        CAmvArenaHeap m_heap;
+        size_t m_nStrings;
+    };
+
+} // namespace AMV
+
+#endif // AMVARENA_HPP_
@@ -0,0 +1,228 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVCONCAT_HPP_
+#define AMVCONCAT_HPP_
+
+#include <climits>
+#include <cstring>
+#include <vector>
+
+#include "include/amvdefine.hpp"
+#include "include/amvsimpstr.hpp"
+#include "include/amvstrview.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // The pieces of BStringT::Concat() are views and single chars of the char
+    // type XCHAR of the string
+
+    template <typename XCHAR>
+    inline int AmvConcatLength(_In_ const CAmvStringViewT<XCHAR> &view) throw()
+    {
+        return (view.GetLength());
+    }
+
+    inline int AmvConcatLength(_In_ char) throw() { return (1); }
+
+    inline int AmvConcatLength(_In_ char16_t) throw() { return (1); }
+
+    inline int AmvConcatLength(_In_ wchar_t) throw() { return (1); }
+
+    template <typename XCHAR>
+    inline XCHAR *AmvConcatCopy(_Out_ XCHAR *pch, _In_ const CAmvStringViewT<XCHAR> &view) throw()
+    {
+        memcpy(pch, view.GetString(), view.GetLength() * sizeof(XCHAR));
+        return (pch + view.GetLength());
+    }
+
+    template <typename XCHAR>
+    inline XCHAR *AmvConcatCopy(_Out_ XCHAR *pch, _In_ XCHAR ch) throw()
+    {
+        *pch = ch;
+        return (pch + 1);
+    }
+
+    // Collects a long output in chunks and makes the string once, at the end.
+    // Appending never moves what is already written, so the cost per char
+    // stays flat however large the output grows.  The chunks come from the
+    // string manager and are kept by Empty() for the next output.
+    template <class TString>
+    class CAmvStringBuilderT
+    {
+    public:
+        typedef typename TString::XCHAR XCHAR;
+        typedef CAmvStringViewT<XCHAR> CView;
+
+        explicit CAmvStringBuilderT(_In_opt_ IAmvStringMgr *pStringMgr = NULL)
+            : m_pStringMgr((pStringMgr != NULL) ? pStringMgr
+                                                : TString::StrTraits::GetDefaultManager()),
+              m_iChunk(-1),
+              m_pchWrite(NULL),
+              m_pchEnd(NULL),
+              m_nLength(0)
+        {
+        }
+
+        ~CAmvStringBuilderT() throw()
+        {
+            for (size_t i = 0; i < m_apChunks.size(); i++)
+            {
+                m_apChunks[i]->pStringMgr->Free(m_apChunks[i]);
+            }
+        }
+
+        int GetLength() const throw() { return (m_nLength); }
+
+        bool IsEmpty() const throw() { return (m_nLength == 0); }
+
+        // Forgets the content but keeps the chunks
+        void Empty() throw()
+        {
+            m_iChunk = -1;
+            m_pchWrite = NULL;
+            m_pchEnd = NULL;
+            m_nLength = 0;
+        }
+
+        void Append(_In_reads_(nLength) const XCHAR *pch, _In_ int nLength)
+        {
+            AMVASSERT(nLength >= 0 && (pch != NULL || nLength == 0));
+            if (nLength > INT_MAX - 8 - m_nLength)
+            {
+                AmvThrow("Out of memory");
+            }
+            m_nLength += nLength;
+            while (nLength > 0)
+            {
+                if (m_pchWrite == m_pchEnd)
+                {
+                    NextChunk();
+                }
+                int nCopy = static_cast<int>(m_pchEnd - m_pchWrite);
+                if (nCopy > nLength)
+                {
+                    nCopy = nLength;
+                }
+                memcpy(m_pchWrite, pch, nCopy * sizeof(XCHAR));
+                m_pchWrite += nCopy;
+                pch += nCopy;
+                nLength -= nCopy;
+            }
+        }
+
+        void Append(_In_opt_z_ const XCHAR *psz)
+        {
+            Append(CView(psz));
+        }
+
+        void Append(_In_ const CView &view)
+        {
+            Append(view.GetString(), view.GetLength());
+        }
+
+        void Append(_In_ XCHAR ch)
+        {
+            if (m_pchWrite != m_pchEnd && m_nLength < INT_MAX - 8)
+            {
+                *m_pchWrite++ = ch;
+                m_nLength++;
+                return;
+            }
+            Append(&ch, 1);
+        }
+
+        void Append(_In_ const TString &str)
+        {
+            Append(str.GetString(), str.GetLength());
+        }
+
+        template <class T>
+        CAmvStringBuilderT &operator+=(_In_ const T &src)
+        {
+            Append(src);
+
+            return (*this);
+        }
+
+        // The content as one string, made with a single allocation
+        TString ToString() const
+        {
+            TString str(m_pStringMgr);
+            AppendTo(str);
+
+            return (str);
+        }
+
+        void AppendTo(_Inout_ TString &str) const
+        {
+            int nOldLength = str.GetLength();
+            if (m_nLength > INT_MAX - 8 - nOldLength)
+            {
+                AmvThrow("Out of memory");
+            }
+            XCHAR *pch = str.GetBuffer(nOldLength + m_nLength) + nOldLength;
+            for (int i = 0; i < m_iChunk; i++)
+            {
+                BStringData *pData = m_apChunks[i];
+                memcpy(pch, pData->data(), pData->nAllocLength * sizeof(XCHAR));
+                pch += pData->nAllocLength;
+            }
+            if (m_iChunk >= 0)
+            {
+                const XCHAR *pchChunk = static_cast<const XCHAR *>(m_apChunks[m_iChunk]->data());
+                memcpy(pch, pchChunk, (m_pchWrite - pchChunk) * sizeof(XCHAR));
+            }
+            str.ReleaseBufferSetLength(nOldLength + m_nLength);
+        }
+
+    private:
+        // Chunks grow with the output, between these sizes
+        static const int MIN_CHUNK_LENGTH = 256 - 1;
+        static const int MAX_CHUNK_LENGTH = 1024 * 1024 - 1;
+
+        void NextChunk()
+        {
+            m_iChunk++;
+            if (m_iChunk == static_cast<int>(m_apChunks.size()))
+            {
+                int nChunkLength = m_nLength;
+                if (nChunkLength < MIN_CHUNK_LENGTH)
+                {
+                    nChunkLength = MIN_CHUNK_LENGTH;
+                }
+                if (nChunkLength > MAX_CHUNK_LENGTH)
+                {
+                    nChunkLength = MAX_CHUNK_LENGTH;
+                }
+                m_apChunks.reserve(m_apChunks.size() + 1);
+                BStringData *pData = m_pStringMgr->Allocate(nChunkLength, sizeof(XCHAR));
+                if (pData == NULL)
+                {
+                    m_iChunk--;
+                    AmvThrow("Out of memory");
+                }
+                m_apChunks.push_back(pData);
+            }
+            BStringData *pData = m_apChunks[m_iChunk];
+            m_pchWrite = static_cast<XCHAR *>(pData->data());
+            m_pchEnd = m_pchWrite + pData->nAllocLength;
+        }
+
+        IAmvStringMgr *m_pStringMgr;
+        // Chunks before m_iChunk are full; m_iChunk is filled up to m_pchWrite
+        std::vector<BStringData *> m_apChunks;
+        int m_iChunk;
+        XCHAR *m_pchWrite;
+        XCHAR *m_pchEnd;
+        int m_nLength;
+
+    private:
+        CAmvStringBuilderT(_In_ const CAmvStringBuilderT &) throw();
+        CAmvStringBuilderT &operator=(_In_ const CAmvStringBuilderT &) throw();
+    };
+
+} // namespace AMV
+
+#endif // AMVCONCAT_HPP_
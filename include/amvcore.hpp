@@ -1,20 +1,17 @@
 // Copyright 2021~2022 `anothel` All rights reserved
 
-<<<<<<< HEAD:include/amvcore.hpp
 #ifndef AMVCORE_HPP_
 #define AMVCORE_HPP_
 
 #include "include/amvdefine.hpp"
 
-namespace AMV {
-=======
-namespace
+namespace AMV
 {
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/amvcore.h
 
     /////////////////////////////////////////////////////////////////////////////
     // Verify that a null-terminated string points to valid memory
-    inline BOOL AmvIsValidString(_In_reads_z_(nMaxLength) const char *psz,
+    template <typename CharType>
+    inline BOOL AmvIsValidString(_In_reads_z_(nMaxLength) const CharType *psz,
                                  _In_ size_t nMaxLength = UINT_MAX)
     {
         return (psz != NULL);
@@ -49,16 +46,6 @@ namespace
         //*p == 0, but ch also == 0, so NULL terminator address is returned
         return (*p == ch) ? p : NULL;
     }
-<<<<<<< HEAD:include/amvcore.hpp
-    p = AmvCharNext(p);
-  }
-  // strchr for '\0' should succeed - the while loop terminates
-  // *p == 0, but ch also == 0, so NULL terminator address is returned
-  return (*p == ch) ? p : NULL;
-}
-}  // namespace AMV
+} // namespace AMV
 
-#endif  // AMVCORE_HPP_
-=======
-} // namespace
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/amvcore.h
+#endif // AMVCORE_HPP_
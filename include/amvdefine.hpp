@@ -11,8 +11,6 @@
 #define AMVENSURE_RETURN_VAL(x, y) assert(x)
 #define FAILED(hr) (hr < 0)
 #define AMVENSURE_THROW(x, s) assert(x)
-#define _InterlockedIncrement(x) __sync_fetch_and_add((x), 1)
-#define _InterlockedDecrement(x) __sync_fetch_and_sub((x), 1)
 #define __cdecl
 #define _AMV_INSECURE_DEPRECATE(s)
 #define AmvThrow throw
@@ -54,6 +52,9 @@ typedef ULONG_PTR DWORD_PTR, *PDWORD_PTR;
 
 #define ERROR_ARITHMETIC_OVERFLOW 534L
 
+// Win32 error code as a failed (negative) HRESULT, for FAILED()
+#define HRESULT_FROM_WIN32(x) ((int64_t)(int32_t)(((x)&0x0000FFFF) | (7 << 16) | 0x80000000))
+
 // Minimum and maximum macros
 #define __max(a, b) (((a) > (b)) ? (a) : (b))
 #define __min(a, b) (((a) < (b)) ? (a) : (b))
@@ -70,8 +71,4 @@ typedef ULONG_PTR DWORD_PTR, *PDWORD_PTR;
 
 #define log1 printf("[jpk] %s(%d), %s \n", __FILE__, __LINE__, __func__);
 
-<<<<<<< HEAD:include/amvdefine.hpp
-#endif  // AMVDEFINE_HPP_
-=======
-#endif // AMVDEFINE_H_
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/amvdefine.h
+#endif // AMVDEFINE_HPP_
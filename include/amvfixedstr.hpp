@@ -0,0 +1,346 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVFIXEDSTR_HPP_
+#define AMVFIXEDSTR_HPP_
+
+#include "include/amvdefine.hpp"
+#include "include/amvsimpstr.hpp"
+#include "include/amvstrview.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // String manager that owns a single buffer of t_nChars chars, embedded in
+    // the manager itself.  Allocate() hands out that buffer while it is free
+    // and fails otherwise; nothing ever comes from a heap.  Strings up to
+    // AMV_SSO_CAPACITY chars stay in their own inline storage, so the buffer
+    // only exists when t_nChars is larger than that.
+    //
+    // The buffer belongs to the one string that uses this manager.  Clone()
+    // returns pCloneMgr, so copies of the string are made with that manager
+    // and never share the buffer.  CAmvFixedStringT keeps the string that
+    // uses the buffer from being moved as a StringType, so no other string
+    // ever takes it over.
+    template <int t_nChars>
+    class CAmvFixedStringMgr : public IAmvStringMgr
+    {
+    public:
+        static const int CAPACITY =
+            (t_nChars > AMV_SSO_CAPACITY) ? t_nChars : AMV_SSO_CAPACITY;
+
+        explicit CAmvFixedStringMgr(_In_ IAmvStringMgr *pCloneMgr) throw()
+            : m_pCloneMgr(pCloneMgr)
+        {
+            AMVASSERT(pCloneMgr != NULL);
+            m_nil.SetManager(this);
+            m_data.pStringMgr = this;
+            m_data.nAllocLength = BUFFER_CHARS;
+            m_data.nFlags = 0;
+            FreeBuffer();
+            AMVASSERT(m_data.data() == m_achData);
+        }
+
+        // IAmvStringMgr
+    public:
+        virtual BStringData *Allocate(_In_ int nChars, _In_ int nCharSize) throw()
+        {
+            AMVASSERT(nCharSize == sizeof(char));
+            (void)nCharSize;
+
+            // Free is marked by a zero reference count
+            if (nChars > BUFFER_CHARS || m_data.nRefs != 0)
+            {
+                return (NULL);
+            }
+            m_data.nRefs = 1;
+            m_data.nDataLength = 0;
+            m_data.ResetHash();
+
+            return (&m_data);
+        }
+
+        virtual void Free(_In_ BStringData *pData) throw()
+        {
+            AMVASSERT(pData == &m_data);
+            (void)pData;
+
+            FreeBuffer();
+        }
+
+        // The buffer never moves
+        virtual BStringData *Reallocate(_Inout_ BStringData *pData, _In_ int nChars,
+                                        _In_ int nCharSize) throw()
+        {
+            AMVASSERT(pData == &m_data);
+            (void)nCharSize;
+
+            return ((nChars <= pData->nAllocLength) ? pData : NULL);
+        }
+
+        virtual int GetGrowLength(_In_ int nAllocLength, _In_ int nLength) throw()
+        {
+            (void)nAllocLength;
+
+            return ((nLength <= BUFFER_CHARS) ? BUFFER_CHARS : nLength);
+        }
+
+        virtual BStringData *GetNilString() throw()
+        {
+            m_nil.AddRef();
+            return &m_nil;
+        }
+
+        virtual IAmvStringMgr *Clone() throw() { return m_pCloneMgr; }
+
+    private:
+        static const int BUFFER_CHARS = (t_nChars > AMV_SSO_CAPACITY) ? t_nChars : 0;
+
+        void FreeBuffer() throw()
+        {
+            m_data.nRefs = 0;
+            m_data.nDataLength = 0;
+            m_data.ResetHash();
+            m_achData[0] = 0;
+        }
+
+        IAmvStringMgr *m_pCloneMgr;
+        CNilStringData m_nil;
+        // The chars follow the header, as BStringData::data() expects
+        BStringData m_data;
+        char m_achData[BUFFER_CHARS + 1];
+
+    private:
+        CAmvFixedStringMgr(_In_ const CAmvFixedStringMgr &) throw();
+        CAmvFixedStringMgr &operator=(_In_ const CAmvFixedStringMgr &) throw();
+    };
+
+    // String with room for t_nChars chars inside the object, for strings of
+    // bounded length that should not touch the heap.  It has the interface of
+    // StringType but is not one: its buffer cannot be handed to another
+    // string, so it does not bind to a StringType& or StringType&&.  It reads
+    // as a view, and ToString() makes a StringType copy.  Moving it copies
+    // the chars.  Growing past GetCapacity() throws instead of allocating;
+    // the string keeps its old contents then.
+    template <class StringType, int t_nChars>
+    class CAmvFixedStringT : private CAmvFixedStringMgr<t_nChars>, private StringType
+    {
+        typedef CAmvFixedStringMgr<t_nChars> CThisStringMgr;
+
+    public:
+        typedef typename StringType::XCHAR XCHAR;
+        typedef typename StringType::CThisStringView CThisStringView;
+
+        CAmvFixedStringT() throw()
+            : CThisStringMgr(StringType::StrTraits::GetDefaultManager()),
+              StringType(static_cast<IAmvStringMgr *>(this))
+        {
+        }
+
+        CAmvFixedStringT(_In_ const CAmvFixedStringT &str)
+            : CThisStringMgr(StringType::StrTraits::GetDefaultManager()),
+              StringType(static_cast<IAmvStringMgr *>(this))
+        {
+            StringType::operator=(str.GetView());
+        }
+
+        explicit CAmvFixedStringT(_In_ const StringType &str)
+            : CThisStringMgr(StringType::StrTraits::GetDefaultManager()),
+              StringType(static_cast<IAmvStringMgr *>(this))
+        {
+            StringType::operator=(CThisStringView(str));
+        }
+
+        explicit CAmvFixedStringT(_In_opt_z_ const XCHAR *psz)
+            : CThisStringMgr(StringType::StrTraits::GetDefaultManager()),
+              StringType(static_cast<IAmvStringMgr *>(this))
+        {
+            StringType::operator=(psz);
+        }
+
+        explicit CAmvFixedStringT(_In_ const CThisStringView &view)
+            : CThisStringMgr(StringType::StrTraits::GetDefaultManager()),
+              StringType(static_cast<IAmvStringMgr *>(this))
+        {
+            StringType::operator=(view);
+        }
+
+        CAmvFixedStringT &operator=(_In_ const CAmvFixedStringT &str)
+        {
+            StringType::operator=(str.GetView());
+
+            return (*this);
+        }
+
+        CAmvFixedStringT &operator=(_In_ const StringType &str)
+        {
+            StringType::operator=(CThisStringView(str));
+
+            return (*this);
+        }
+
+        CAmvFixedStringT &operator=(_In_opt_z_ const XCHAR *psz)
+        {
+            StringType::operator=(psz);
+
+            return (*this);
+        }
+
+        CAmvFixedStringT &operator=(_In_ const CThisStringView &view)
+        {
+            StringType::operator=(view);
+
+            return (*this);
+        }
+
+        // The members of StringType that return the string itself, so that
+        // no StringType& escapes
+        template <typename T>
+        CAmvFixedStringT &operator+=(_In_ const T &src)
+        {
+            StringType::operator+=(src);
+
+            return (*this);
+        }
+
+        template <typename... TArgs>
+        CAmvFixedStringT &Trim(_In_ const TArgs &...args)
+        {
+            StringType::Trim(args...);
+
+            return (*this);
+        }
+
+        template <typename... TArgs>
+        CAmvFixedStringT &TrimLeft(_In_ const TArgs &...args)
+        {
+            StringType::TrimLeft(args...);
+
+            return (*this);
+        }
+
+        template <typename... TArgs>
+        CAmvFixedStringT &TrimRight(_In_ const TArgs &...args)
+        {
+            StringType::TrimRight(args...);
+
+            return (*this);
+        }
+
+        template <typename T>
+        CAmvFixedStringT &AppendNumber(_In_ T value)
+        {
+            StringType::AppendNumber(value);
+
+            return (*this);
+        }
+
+        using StringType::operator[];
+        using StringType::operator const XCHAR *;
+        using StringType::Append;
+        using StringType::AppendChar;
+        using StringType::AppendFormat;
+        using StringType::Compare;
+        using StringType::CompareNoCase;
+        using StringType::Delete;
+        using StringType::Detach;
+        using StringType::Empty;
+        using StringType::Find;
+        using StringType::FindOneOf;
+        using StringType::Format;
+        using StringType::FreeExtra;
+        using StringType::GetAllocLength;
+        using StringType::GetAt;
+        using StringType::GetBuffer;
+        using StringType::GetBufferSetLength;
+        using StringType::GetHash;
+        using StringType::GetLength;
+        using StringType::GetManager;
+        using StringType::GetString;
+        using StringType::GetUtf16;
+        using StringType::GetUtf8Length;
+        using StringType::Insert;
+        using StringType::IsEmpty;
+        using StringType::IsEqual;
+        using StringType::IsInline;
+        using StringType::IsValidUtf8;
+        using StringType::LockBuffer;
+        using StringType::ParseNumber;
+        using StringType::Preallocate;
+        using StringType::ReleaseBuffer;
+        using StringType::ReleaseBufferSetLength;
+        using StringType::Remove;
+        using StringType::Replace;
+        using StringType::ReplaceAll;
+        using StringType::Reserve;
+        using StringType::ReverseFind;
+        using StringType::SetAt;
+        using StringType::SetString;
+        using StringType::SetUtf16;
+        using StringType::Truncate;
+        using StringType::UnlockBuffer;
+
+        CThisStringView GetView() const throw()
+        {
+            return (CThisStringView(GetString(), GetLength()));
+        }
+
+        operator CThisStringView() const throw() { return (GetView()); }
+
+        // A copy of the chars made with the default manager
+        StringType ToString() const { return (StringType(GetView())); }
+
+        // Chars the string holds without a heap, at least t_nChars
+        static int GetCapacity() throw() { return (CThisStringMgr::CAPACITY); }
+
+        // The operators of StringType would need the hidden base, so these
+        // take the fixed string with anything that converts to a view
+        template <typename T>
+        friend StringType operator+(_In_ const CAmvFixedStringT &str1, _In_ const T &str2)
+        {
+            return (StringType::Concat(str1.GetView(), str2));
+        }
+
+        // T&& so that it also beats the StringType&& overloads of StringType
+        template <typename T>
+        friend StringType operator+(_In_ T &&str1, _In_ const CAmvFixedStringT &str2)
+        {
+            return (StringType::Concat(str1, str2.GetView()));
+        }
+
+        friend StringType operator+(_In_ const CAmvFixedStringT &str1,
+                                    _In_ const CAmvFixedStringT &str2)
+        {
+            return (StringType::Concat(str1.GetView(), str2.GetView()));
+        }
+
+#define AMV_FIXED_STRING_COMPARE(op)                                                            \
+    template <typename T>                                                                       \
+    friend bool operator op(_In_ const CAmvFixedStringT &str1, _In_ const T &str2) throw()      \
+    {                                                                                           \
+        return (str1.Compare(CThisStringView(str2)) op 0);                                      \
+    }                                                                                           \
+    template <typename T>                                                                       \
+    friend bool operator op(_In_ const T &str1, _In_ const CAmvFixedStringT &str2) throw()      \
+    {                                                                                           \
+        return (0 op str2.Compare(CThisStringView(str1)));                                      \
+    }                                                                                           \
+    friend bool operator op(_In_ const CAmvFixedStringT &str1,                                  \
+                            _In_ const CAmvFixedStringT &str2) throw()                          \
+    {                                                                                           \
+        return (str1.Compare(str2.GetView()) op 0);                                             \
+    }
+
+        AMV_FIXED_STRING_COMPARE(==)
+        AMV_FIXED_STRING_COMPARE(!=)
+        AMV_FIXED_STRING_COMPARE(<)
+        AMV_FIXED_STRING_COMPARE(>)
+        AMV_FIXED_STRING_COMPARE(<=)
+        AMV_FIXED_STRING_COMPARE(>=)
+
+#undef AMV_FIXED_STRING_COMPARE
+    };
+
+} // namespace AMV
+
+#endif // AMVFIXEDSTR_HPP_
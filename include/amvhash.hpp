@@ -0,0 +1,145 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVHASH_HPP_
+#define AMVHASH_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include "include/amvdefine.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // Fast non-cryptographic hash of chars for hash tables, after wyhash.
+    // Inputs above 48 bytes are mixed in three independent 64-bit lanes, so
+    // long keys run at several bytes per cycle.  The value depends on the byte
+    // order of the host and is not meant to be stored or sent anywhere.  It
+    // does not resist inputs crafted to collide.
+    namespace AmvHashImpl
+    {
+        static const uint64_t SECRET[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                                           0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+        // 64 x 64 -> 128 bit product, low half in *pA and high half in *pB
+        inline void Multiply(_Inout_ uint64_t *pA, _Inout_ uint64_t *pB) throw()
+        {
+#if defined(__SIZEOF_INT128__)
+            __uint128_t r = *pA;
+            r *= *pB;
+            *pA = static_cast<uint64_t>(r);
+            *pB = static_cast<uint64_t>(r >> 64);
+#else
+            uint64_t ha = *pA >> 32, hb = *pB >> 32;
+            uint64_t la = static_cast<uint32_t>(*pA), lb = static_cast<uint32_t>(*pB);
+            uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+            uint64_t t = rl + (rm0 << 32);
+            uint64_t c = (t < rl);
+            uint64_t lo = t + (rm1 << 32);
+            c += (lo < t);
+            *pA = lo;
+            *pB = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+        }
+
+        inline uint64_t Mix(_In_ uint64_t a, _In_ uint64_t b) throw()
+        {
+            Multiply(&a, &b);
+            return (a ^ b);
+        }
+
+        inline uint64_t Read8(_In_reads_(8) const unsigned char *p) throw()
+        {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            return (v);
+        }
+
+        inline uint64_t Read4(_In_reads_(4) const unsigned char *p) throw()
+        {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return (v);
+        }
+
+        // 1 to 3 bytes
+        inline uint64_t Read3(_In_reads_(n) const unsigned char *p, _In_ size_t n) throw()
+        {
+            return ((static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[n >> 1]) << 8) |
+                    p[n - 1]);
+        }
+    } // namespace AmvHashImpl
+
+    inline uint64_t AmvHash(_In_reads_(nLength) const char *pch, _In_ size_t nLength,
+                            _In_ uint64_t nSeed = 0) throw()
+    {
+        using namespace AmvHashImpl;
+
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(pch);
+        uint64_t a, b;
+
+        nSeed ^= Mix(nSeed ^ SECRET[0], SECRET[1]);
+        if (nLength <= 16)
+        {
+            if (nLength >= 4)
+            {
+                // Two overlapping reads from each end cover 4 to 16 bytes
+                size_t nSkip = (nLength >> 3) << 2;
+                a = (Read4(p) << 32) | Read4(p + nSkip);
+                b = (Read4(p + nLength - 4) << 32) | Read4(p + nLength - 4 - nSkip);
+            }
+            else if (nLength > 0)
+            {
+                a = Read3(p, nLength);
+                b = 0;
+            }
+            else
+            {
+                a = b = 0;
+            }
+        }
+        else
+        {
+            size_t i = nLength;
+            if (i > 48)
+            {
+                uint64_t nSeed1 = nSeed, nSeed2 = nSeed;
+                do
+                {
+                    nSeed = Mix(Read8(p) ^ SECRET[1], Read8(p + 8) ^ nSeed);
+                    nSeed1 = Mix(Read8(p + 16) ^ SECRET[2], Read8(p + 24) ^ nSeed1);
+                    nSeed2 = Mix(Read8(p + 32) ^ SECRET[3], Read8(p + 40) ^ nSeed2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                nSeed ^= nSeed1 ^ nSeed2;
+            }
+            while (i > 16)
+            {
+                nSeed = Mix(Read8(p) ^ SECRET[1], Read8(p + 8) ^ nSeed);
+                p += 16;
+                i -= 16;
+            }
+            // The last 16 bytes, overlapping what was mixed already
+            a = Read8(p + i - 16);
+            b = Read8(p + i - 8);
+        }
+
+        a ^= SECRET[1];
+        b ^= nSeed;
+        Multiply(&a, &b);
+        return (Mix(a ^ SECRET[0] ^ nLength, b ^ SECRET[1]));
+    }
+
+    // Wider chars (char16_t, wchar_t) hash their bytes
+    template <typename XCHAR>
+    inline uint64_t AmvHash(_In_reads_(nLength) const XCHAR *pch, _In_ size_t nLength,
+                            _In_ uint64_t nSeed = 0) throw()
+    {
+        return (AmvHash(reinterpret_cast<const char *>(pch), nLength * sizeof(XCHAR), nSeed));
+    }
+
+} // namespace AMV
+
+#endif // AMVHASH_HPP_
@@ -0,0 +1,256 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVINTERN_HPP_
+#define AMVINTERN_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "include/amvdefine.hpp"
+#include "include/amvhash.hpp"
+#include "include/amvsimpstr.hpp"
+#include "include/amvstrview.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // Interning table: every distinct content is stored once, in a BStringData
+    // owned by the pool, and Intern() hands out strings sharing that buffer.
+    // The pool keeps one reference, so the buffer is always shared and any
+    // write forks a private copy; the interned chars never change.  Copies of
+    // an interned string share the buffer even when it is short (see
+    // CSimpleStringT::CloneData()), so two interned strings have the same
+    // content exactly when IsSame() says so.
+    //
+    // The table is split into NUM_SHARDS shards by hash, each behind its own
+    // reader/writer lock.  A hit takes only the shared lock, so concurrent
+    // lookups of known strings do not serialize.  Strings handed out stay
+    // valid after Purge() or the destruction of the pool; they only lose
+    // their identity with later interned copies.  The manager must not be
+    // thread-confined (CAmvStringMgr::SetThreadConfined()).
+    template <class TString>
+    class CAmvStringPoolT
+    {
+    public:
+        static const int NUM_SHARDS = 64;
+
+        explicit CAmvStringPoolT(_In_opt_ IAmvStringMgr *pStringMgr = NULL)
+            : m_pStringMgr((pStringMgr != NULL) ? pStringMgr
+                                                : TString::StrTraits::GetDefaultManager())
+        {
+        }
+
+        ~CAmvStringPoolT() throw() { Clear(); }
+
+        // The empty string is not pooled and comes back as a plain string
+        TString Intern(_In_ const CAmvStringView &view)
+        {
+            TString str(m_pStringMgr);
+            if (view.GetLength() == 0)
+            {
+                return (str);
+            }
+
+            CKey key = {view, AmvHash(view.GetString(), view.GetLength())};
+            CShard &shard = m_aShards[key.nHash % NUM_SHARDS];
+            BStringData *pData;
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.m);
+                pData = shard.Find(key);
+                if (pData != NULL)
+                {
+                    pData->AddRef();
+                }
+            }
+            if (pData == NULL)
+            {
+                pData = Insert(shard, key);
+            }
+            str.Attach(pData);
+
+            return (str);
+        }
+
+        // An interned str is returned as is, without a lookup by content
+        TString Intern(_In_ const TString &str)
+        {
+            if (IsInterned(str))
+            {
+                return (str);
+            }
+            return (Intern(CAmvStringView(str)));
+        }
+
+        // true if str shares the buffer of this pool
+        bool IsInterned(_In_ const TString &str) const
+        {
+            if (str.IsEmpty())
+            {
+                return (false);
+            }
+
+            CKey key = {CAmvStringView(str), str.GetHash()};
+            const CShard &shard = m_aShards[key.nHash % NUM_SHARDS];
+            std::shared_lock<std::shared_mutex> lock(shard.m);
+
+            BStringData *pData = shard.Find(key);
+
+            return (pData != NULL && pData->data() == str.GetString());
+        }
+
+        // Equality of interned strings: one pointer compare
+        static bool IsSame(_In_ const TString &str1, _In_ const TString &str2) throw()
+        {
+            return (str1.GetString() == str2.GetString());
+        }
+
+        // Number of distinct strings in the pool
+        size_t GetCount() const
+        {
+            size_t nCount = 0;
+            for (int i = 0; i < NUM_SHARDS; i++)
+            {
+                std::shared_lock<std::shared_mutex> lock(m_aShards[i].m);
+                nCount += m_aShards[i].map.size();
+            }
+
+            return (nCount);
+        }
+
+        // Drops the strings nobody else holds.  Returns how many were freed.
+        size_t Purge()
+        {
+            size_t nFreed = 0;
+            for (int i = 0; i < NUM_SHARDS; i++)
+            {
+                CShard &shard = m_aShards[i];
+                std::unique_lock<std::shared_mutex> lock(shard.m);
+                for (typename CShard::CMap::iterator it = shard.map.begin();
+                     it != shard.map.end();)
+                {
+                    // New references are only taken under the shard lock or
+                    // from a string that holds one already
+                    if (__atomic_load_n(&it->second->nRefs, __ATOMIC_ACQUIRE) == 1)
+                    {
+                        it->second->Release();
+                        it = shard.map.erase(it);
+                        nFreed++;
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+
+            return (nFreed);
+        }
+
+        // Drops every string.  Strings handed out keep their buffers.
+        void Clear() throw()
+        {
+            for (int i = 0; i < NUM_SHARDS; i++)
+            {
+                CShard &shard = m_aShards[i];
+                std::unique_lock<std::shared_mutex> lock(shard.m);
+                for (typename CShard::CMap::iterator it = shard.map.begin();
+                     it != shard.map.end(); ++it)
+                {
+                    it->second->Release();
+                }
+                shard.map.clear();
+            }
+        }
+
+    private:
+        // The view points into the pooled buffer, which never changes
+        struct CKey
+        {
+            CAmvStringView view;
+            uint64_t nHash;
+        };
+
+        struct CKeyHash
+        {
+            size_t operator()(_In_ const CKey &key) const throw()
+            {
+                return (static_cast<size_t>(key.nHash / NUM_SHARDS));
+            }
+        };
+
+        struct CKeyEqual
+        {
+            bool operator()(_In_ const CKey &key1, _In_ const CKey &key2) const throw()
+            {
+                return (key1.nHash == key2.nHash && key1.view.IsEqual(key2.view));
+            }
+        };
+
+        // Own cache line each, so that readers of different shards do not
+        // bounce the same line between cores
+        struct alignas(64) CShard
+        {
+            typedef std::unordered_map<CKey, BStringData *, CKeyHash, CKeyEqual> CMap;
+
+            BStringData *Find(_In_ const CKey &key) const
+            {
+                typename CMap::const_iterator it = map.find(key);
+                return ((it != map.end()) ? it->second : NULL);
+            }
+
+            mutable std::shared_mutex m;
+            CMap map;
+        };
+
+        AMV_NOINLINE BStringData *Insert(_Inout_ CShard &shard, _In_ const CKey &key)
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.m);
+            // Another thread may have added it since the shared lock was dropped
+            BStringData *pData = shard.Find(key);
+            if (pData == NULL)
+            {
+                int nLength = key.view.GetLength();
+                pData = m_pStringMgr->Allocate(nLength, sizeof(char));
+                if (pData == NULL)
+                {
+                    AmvThrow("Out of memory");
+                }
+                memcpy(pData->data(), key.view.GetString(), nLength * sizeof(char));
+                static_cast<char *>(pData->data())[nLength] = 0;
+                pData->nDataLength = nLength;
+#ifdef AMV_STRING_CACHE_HASH
+                pData->nHash = key.nHash;
+#endif
+                CKey keyPooled = {CAmvStringView(static_cast<const char *>(pData->data()), nLength),
+                                  key.nHash};
+                try
+                {
+                    shard.map.emplace(keyPooled, pData);
+                }
+                catch (...)
+                {
+                    m_pStringMgr->Free(pData);
+                    throw;
+                }
+            }
+            // One for the caller, the pool keeps the first
+            pData->AddRef();
+
+            return (pData);
+        }
+
+        IAmvStringMgr *m_pStringMgr;
+        CShard m_aShards[NUM_SHARDS];
+
+    private:
+        CAmvStringPoolT(_In_ const CAmvStringPoolT &) throw();
+        CAmvStringPoolT &operator=(_In_ const CAmvStringPoolT &) throw();
+    };
+
+} // namespace AMV
+
+#endif // AMVINTERN_HPP_
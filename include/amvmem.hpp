@@ -19,9 +19,6 @@ namespace AMV
         return (N((n + (nAlign - 1)) & ~(N(nAlign) - 1)));
     }
 
-<<<<<<< HEAD:include/amvmem.hpp
-#endif  // AMVMEM_HPP_
-=======
     __interface __declspec(uuid("654F7EF5-CFDF-4df9-A450-6C6A13C622C0"))
         IAmvMemMgr
     {
@@ -36,6 +33,12 @@ namespace AMV
         virtual size_t GetSize(_In_ void *p) throw() = 0;
     };
 
+    // GCC 11+ traces the Nil string of a static CAmvStringMgr into free() and
+    // realloc(), but its reference count never drops to zero
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfree-nonheap-object"
+#endif
     class CAmvHeap : public IAmvMemMgr
     {
     public:
@@ -76,7 +79,9 @@ namespace AMV
             return (malloc_usable_size(p));
         }
     };
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
 } // namespace AMV
 
-#endif // AMVMEM_H_
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/amvmem.h
+#endif // AMVMEM_HPP_
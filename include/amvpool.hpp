@@ -0,0 +1,357 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVPOOL_HPP_
+#define AMVPOOL_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include "include/amvdefine.hpp"
+#include "include/amvmem.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // Size-class pool allocator with thread-local caches.
+    //
+    // Blocks of up to MAX_POOLED_SIZE bytes are rounded up to a power of two
+    // (16, 32, ... 4096) and served from the calling thread's cache without
+    // locks.  Every block carries a small header with its owning cache and size
+    // class, so GetSize() needs no malloc_usable_size().  A block freed by
+    // another thread is pushed onto the owner's lock-free remote list, which
+    // the owner drains when its own free list runs dry.  Larger blocks go
+    // straight to malloc().
+    //
+    // Caches are never destroyed: when a thread exits its cache is parked and
+    // handed to the next new thread, so blocks still in use elsewhere stay
+    // valid.  Slab memory is reused, not returned to the system.
+    class CAmvPoolHeap : public IAmvMemMgr
+    {
+    public:
+        static const int NUM_CLASSES = 9;
+        static const size_t MIN_POOLED_SIZE = 16;
+        static const size_t MAX_POOLED_SIZE = MIN_POOLED_SIZE << (NUM_CLASSES - 1);
+        static const size_t SLAB_SIZE = 64 * 1024;
+
+        CAmvPoolHeap() throw() {}
+
+        static CAmvPoolHeap *GetInstance() throw()
+        {
+            static CAmvPoolHeap heap;
+            return &heap;
+        }
+
+        // IAmvMemMgr
+        virtual void *Allocate(_In_ size_t nBytes) throw()
+        {
+            CCache *pCache = (nBytes <= MAX_POOLED_SIZE) ? CCache::Current() : NULL;
+            if (pCache == NULL)
+            {
+                return (AllocateLarge(nBytes));
+            }
+            return (pCache->Pop(SizeClass(nBytes)));
+        }
+
+        virtual void Free(_In_opt_ void *p) throw()
+        {
+            if (p == NULL)
+            {
+                return;
+            }
+
+            Header *pHeader = GetHeader(p);
+            CCache *pOwner = pHeader->pOwner;
+            if (pOwner == NULL)
+            {
+                free(pHeader);
+            }
+            else if (pOwner == CCache::Peek())
+            {
+                pOwner->Push(static_cast<int>(pHeader->nInfo), p);
+            }
+            else
+            {
+                pOwner->PushRemote(p);
+            }
+        }
+
+        virtual void *Reallocate(_In_opt_ void *p, _In_ size_t nBytes) throw()
+        {
+            if (p == NULL)
+            {
+                return (Allocate(nBytes));
+            }
+
+            if (nBytes == 0)
+            {
+                Free(p);
+                return NULL;
+            }
+
+            size_t nOldBytes = GetSize(p);
+            if (nBytes <= nOldBytes)
+            {
+                return (p);
+            }
+
+            void *pNew = Allocate(nBytes);
+            if (pNew != NULL)
+            {
+                memcpy(pNew, p, nOldBytes);
+                Free(p);
+            }
+            return (pNew);
+        }
+
+        virtual size_t GetSize(_In_ void *p) throw()
+        {
+            Header *pHeader = GetHeader(p);
+            return (pHeader->pOwner == NULL ? pHeader->nInfo
+                                            : ClassSize(static_cast<int>(pHeader->nInfo)));
+        }
+
+        // Number of thread caches created so far (alive or parked)
+        static size_t GetCacheCount() throw()
+        {
+            std::lock_guard<std::mutex> lock(CCache::Registry().m);
+            return (CCache::Registry().nCaches);
+        }
+
+        static int SizeClass(_In_ size_t nBytes) throw()
+        {
+            if (nBytes <= MIN_POOLED_SIZE)
+            {
+                return 0;
+            }
+            return (64 - __builtin_clzll(static_cast<uint64_t>(nBytes - 1))) - 4;
+        }
+
+        static size_t ClassSize(_In_ int nClass) throw()
+        {
+            return (MIN_POOLED_SIZE << nClass);
+        }
+
+    private:
+        class CCache;
+
+        // Keeps the blocks 16-byte aligned
+        struct Header
+        {
+            // NULL for blocks from malloc()
+            CCache *pOwner;
+            // Size class of pooled blocks, byte size of the others
+            size_t nInfo;
+        };
+
+        struct FreeBlock
+        {
+            FreeBlock *pNext;
+        };
+
+        static Header *GetHeader(_In_ void *p) throw()
+        {
+            return (static_cast<Header *>(p) - 1);
+        }
+
+        static void *AllocateLarge(_In_ size_t nBytes) throw()
+        {
+            if (nBytes > SIZE_MAX - sizeof(Header))
+            {
+                return NULL;
+            }
+            Header *pHeader = static_cast<Header *>(malloc(sizeof(Header) + nBytes));
+            if (pHeader == NULL)
+            {
+                return NULL;
+            }
+            pHeader->pOwner = NULL;
+            pHeader->nInfo = nBytes;
+            return (pHeader + 1);
+        }
+
+        class CCache
+        {
+        public:
+            struct CRegistry
+            {
+                std::mutex m;
+                CCache *pIdle;
+                size_t nCaches;
+            };
+
+            static CRegistry &Registry() throw()
+            {
+                static CRegistry registry = {};
+                return registry;
+            }
+
+            // The calling thread's cache, created or taken over on first use.
+            // NULL once the thread is shutting down or out of memory.
+            static CCache *Current() throw()
+            {
+                CCache *&pCache = Tls();
+                if (pCache == NULL && !TlsExited())
+                {
+                    pCache = Acquire();
+                    static thread_local CTlsGuard guard;
+                }
+                return pCache;
+            }
+
+            // The calling thread's cache, without creating one
+            static CCache *Peek() throw() { return Tls(); }
+
+            void *Pop(_In_ int nClass) throw()
+            {
+                FreeBlock *pBlock = m_apFree[nClass];
+                if (pBlock == NULL)
+                {
+                    DrainRemote();
+                    pBlock = m_apFree[nClass];
+                }
+                if (pBlock != NULL)
+                {
+                    m_apFree[nClass] = pBlock->pNext;
+                    return pBlock;
+                }
+                return (Carve(nClass));
+            }
+
+            void Push(_In_ int nClass, _In_ void *p) throw()
+            {
+                FreeBlock *pBlock = static_cast<FreeBlock *>(p);
+                pBlock->pNext = m_apFree[nClass];
+                m_apFree[nClass] = pBlock;
+            }
+
+            // Any thread may push; only the owner takes the list (all at once),
+            // so there is no ABA problem
+            void PushRemote(_In_ void *p) throw()
+            {
+                FreeBlock *pBlock = static_cast<FreeBlock *>(p);
+                FreeBlock *pHead = m_pRemote.load(std::memory_order_relaxed);
+                do
+                {
+                    pBlock->pNext = pHead;
+                } while (!m_pRemote.compare_exchange_weak(pHead, pBlock,
+                                                          std::memory_order_release,
+                                                          std::memory_order_relaxed));
+            }
+
+        private:
+            struct CTlsGuard
+            {
+                ~CTlsGuard()
+                {
+                    Park(Tls());
+                    Tls() = NULL;
+                    TlsExited() = true;
+                }
+            };
+
+            static CCache *&Tls() throw()
+            {
+                static thread_local CCache *pCache = NULL;
+                return pCache;
+            }
+
+            static bool &TlsExited() throw()
+            {
+                static thread_local bool bExited = false;
+                return bExited;
+            }
+
+            static CCache *Acquire() throw()
+            {
+                CRegistry &r = Registry();
+                {
+                    std::lock_guard<std::mutex> lock(r.m);
+                    CCache *pCache = r.pIdle;
+                    if (pCache != NULL)
+                    {
+                        r.pIdle = pCache->m_pNextIdle;
+                        return pCache;
+                    }
+                }
+
+                void *p = malloc(sizeof(CCache));
+                if (p == NULL)
+                {
+                    return NULL;
+                }
+                CCache *pCache = new (p) CCache();
+                std::lock_guard<std::mutex> lock(r.m);
+                r.nCaches++;
+                return pCache;
+            }
+
+            static void Park(_In_opt_ CCache *pCache) throw()
+            {
+                if (pCache == NULL)
+                {
+                    return;
+                }
+                CRegistry &r = Registry();
+                std::lock_guard<std::mutex> lock(r.m);
+                pCache->m_pNextIdle = r.pIdle;
+                r.pIdle = pCache;
+            }
+
+            CCache() throw() : m_pRemote(NULL), m_pBump(NULL), m_pBumpEnd(NULL), m_pNextIdle(NULL)
+            {
+                for (int i = 0; i < NUM_CLASSES; i++)
+                {
+                    m_apFree[i] = NULL;
+                }
+            }
+
+            void DrainRemote() throw()
+            {
+                FreeBlock *pBlock = m_pRemote.exchange(NULL, std::memory_order_acquire);
+                while (pBlock != NULL)
+                {
+                    FreeBlock *pNext = pBlock->pNext;
+                    Push(static_cast<int>(GetHeader(pBlock)->nInfo), pBlock);
+                    pBlock = pNext;
+                }
+            }
+
+            // Cuts a new block off the current slab
+            void *Carve(_In_ int nClass) throw()
+            {
+                size_t nStride = sizeof(Header) + ClassSize(nClass);
+                if (static_cast<size_t>(m_pBumpEnd - m_pBump) < nStride)
+                {
+                    char *pSlab = static_cast<char *>(malloc(SLAB_SIZE));
+                    if (pSlab == NULL)
+                    {
+                        return NULL;
+                    }
+                    // The rest of the old slab is given up
+                    m_pBump = pSlab;
+                    m_pBumpEnd = pSlab + SLAB_SIZE;
+                }
+
+                Header *pHeader = reinterpret_cast<Header *>(m_pBump);
+                pHeader->pOwner = this;
+                pHeader->nInfo = nClass;
+                m_pBump += nStride;
+                return (pHeader + 1);
+            }
+
+            FreeBlock *m_apFree[NUM_CLASSES];
+            std::atomic<FreeBlock *> m_pRemote;
+            char *m_pBump;
+            char *m_pBumpEnd;
+            CCache *m_pNextIdle;
+        };
+    };
+
+} // namespace AMV
+
+#endif // AMVPOOL_HPP_
@@ -0,0 +1,1036 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVSIMD_HPP_
+#define AMVSIMD_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "include/amvdefine.hpp"
+#include "salieri-src/salieri.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define AMV_SIMD_X86
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define AMV_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace AMV
+{
+
+    // Set of chars as a 256-bit bitmap, built once and then used for every
+    // membership test.  The same bits are also kept as two 16-byte nibble
+    // tables so that the SIMD kernels can test 16 or 32 chars with a few
+    // shuffles: bit h of m_rows[l] says whether (h << 4 | l) is in the set for
+    // h < 8, and m_rows[16 + l] holds h >= 8.
+    class CAmvCharSet
+    {
+    public:
+        CAmvCharSet() throw() { memset(this, 0, sizeof(*this)); }
+
+        explicit CAmvCharSet(_In_opt_z_ const char *pszSet) throw()
+        {
+            memset(this, 0, sizeof(*this));
+            if (pszSet != NULL)
+            {
+                while (*pszSet != 0)
+                {
+                    Add(*pszSet++);
+                }
+            }
+        }
+
+        CAmvCharSet(_In_reads_(nLength) const char *pchSet, _In_ size_t nLength) throw()
+        {
+            memset(this, 0, sizeof(*this));
+            for (size_t i = 0; i < nLength; i++)
+            {
+                Add(pchSet[i]);
+            }
+        }
+
+        void Add(_In_ char ch) throw()
+        {
+            unsigned int c = static_cast<unsigned char>(ch);
+            m_bits[c >> 6] |= static_cast<uint64_t>(1) << (c & 63);
+            m_rows[(c & 0x0f) + (c & 0x80 ? 16 : 0)] |= static_cast<uint8_t>(1 << ((c >> 4) & 7));
+        }
+
+        bool Contains(_In_ char ch) const throw()
+        {
+            unsigned int c = static_cast<unsigned char>(ch);
+            return ((m_bits[c >> 6] >> (c & 63)) & 1) != 0;
+        }
+
+        const uint8_t *GetRows() const throw() { return (m_rows); }
+
+    private:
+        alignas(16) uint8_t m_rows[32];
+        uint64_t m_bits[4];
+    };
+
+    // The kernels of each instruction set.  Callers use the dispatching
+    // functions below; the variants are public so that tests can compare them.
+    namespace AmvSimd
+    {
+
+        enum Level
+        {
+            LEVEL_SCALAR = 0,
+            LEVEL_SSSE3 = 1,
+            LEVEL_AVX2 = 2,
+            LEVEL_AVX512 = 3,
+            LEVEL_NEON = 4
+        };
+
+        inline Level DetectLevel() throw()
+        {
+#if defined(AMV_SIMD_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512bw"))
+            {
+                return LEVEL_AVX512;
+            }
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return LEVEL_AVX2;
+            }
+            if (__builtin_cpu_supports("ssse3"))
+            {
+                return LEVEL_SSSE3;
+            }
+            return LEVEL_SCALAR;
+#elif defined(AMV_SIMD_NEON)
+            return LEVEL_NEON;
+#else
+            return LEVEL_SCALAR;
+#endif
+        }
+
+        // Best level of this CPU, detected once
+        inline Level GetLevel() throw()
+        {
+            static const Level level = DetectLevel();
+            return level;
+        }
+
+        // Length of the prefix of p[0, n) whose chars are (bIn) or are not
+        // (!bIn) in set
+        inline size_t SpanScalar(_In_reads_(n) const char *p, _In_ size_t n,
+                                 _In_ const CAmvCharSet &set, _In_ bool bIn) throw()
+        {
+            size_t i = 0;
+            while (i < n && set.Contains(p[i]) == bIn)
+            {
+                i++;
+            }
+            return i;
+        }
+
+        // Number of chOld replaced with chNew in p[0, n)
+        inline size_t ReplaceCharScalar(_Inout_updates_(n) char *p, _In_ size_t n,
+                                        _In_ char chOld, _In_ char chNew) throw()
+        {
+            size_t nCount = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                if (p[i] == chOld)
+                {
+                    p[i] = chNew;
+                    nCount++;
+                }
+            }
+            return nCount;
+        }
+
+        // Removes every ch from p[0, n) and returns the new length
+        inline size_t RemoveCharScalar(_Inout_updates_(n) char *p, _In_ size_t n,
+                                       _In_ char ch) throw()
+        {
+            char *pDest = p;
+            for (size_t i = 0; i < n; i++)
+            {
+                // No branch: the char is always written and kept only if wanted
+                char c = p[i];
+                *pDest = c;
+                pDest += (c != ch);
+            }
+            return pDest - p;
+        }
+
+        // ASCII case folding, the same as tolower() in the "C" locale
+        inline unsigned int FoldCase(_In_ char ch) throw()
+        {
+            unsigned int c = static_cast<unsigned char>(ch);
+            return (c - 'A' < 26) ? c + ('a' - 'A') : c;
+        }
+
+        // strcasecmp() over p1[0, n1) and p2[0, n2); a shorter prefix is less
+        inline int CompareNoCaseScalar(_In_reads_(n1) const char *p1, _In_ size_t n1,
+                                       _In_reads_(n2) const char *p2, _In_ size_t n2,
+                                       _In_ size_t iStart = 0) throw()
+        {
+            size_t n = (n1 < n2) ? n1 : n2;
+            for (size_t i = iStart; i < n; i++)
+            {
+                unsigned int c1 = FoldCase(p1[i]);
+                unsigned int c2 = FoldCase(p2[i]);
+                if (c1 != c2)
+                {
+                    return static_cast<int>(c1) - static_cast<int>(c2);
+                }
+            }
+            return (n1 < n2) ? -1 : (n1 > n2) ? 1 : 0;
+        }
+
+        // memmem() (Two-Way on glibc): linear whatever the input.  1 <= nSub.
+        inline const char *FindStringScalar(_In_reads_(n) const char *p, _In_ size_t n,
+                                            _In_reads_(nSub) const char *pSub,
+                                            _In_ size_t nSub) throw()
+        {
+            if (nSub > n)
+            {
+                return NULL;
+            }
+#if defined(__GLIBC__)
+            return static_cast<const char *>(memmem(p, n, pSub, nSub));
+#else
+            const char *pLast = p + (n - nSub);
+            while (p <= pLast)
+            {
+                p = static_cast<const char *>(memchr(p, *pSub, pLast - p + 1));
+                if (p == NULL || memcmp(p + 1, pSub + 1, nSub - 1) == 0)
+                {
+                    return p;
+                }
+                p++;
+            }
+            return NULL;
+#endif
+        }
+
+        // The start positions from i on, one by one: the end of the vector
+        // kernels below.  2 <= nSub.
+        inline const char *FindStringTail(_In_reads_(n) const char *p, _In_ size_t n,
+                                          _In_reads_(nSub) const char *pSub, _In_ size_t nSub,
+                                          _In_ size_t i) throw()
+        {
+            for (; i + nSub <= n; i++)
+            {
+                if (p[i] == pSub[0] && p[i + nSub - 1] == pSub[nSub - 1] &&
+                    memcmp(p + i + 1, pSub + 1, nSub - 2) == 0)
+                {
+                    return p + i;
+                }
+            }
+            return NULL;
+        }
+
+        // Bytes compared in vain after which the kernels below hand the rest
+        // to FindStringScalar(), on top of the bytes scanned so far
+        const size_t FIND_STRING_SLACK = 256;
+
+        // For each 8-bit mask of chars to drop, the shuffle that packs the
+        // others to the front (0x80 = nothing)
+        struct CRemoveTable
+        {
+            uint8_t m_idx[256][8];
+
+            CRemoveTable() throw()
+            {
+                for (int m = 0; m < 256; m++)
+                {
+                    int k = 0;
+                    for (int j = 0; j < 8; j++)
+                    {
+                        if ((m & (1 << j)) == 0)
+                        {
+                            m_idx[m][k++] = static_cast<uint8_t>(j);
+                        }
+                    }
+                    while (k < 8)
+                    {
+                        m_idx[m][k++] = 0x80;
+                    }
+                }
+            }
+        };
+
+        inline const CRemoveTable &GetRemoveTable() throw()
+        {
+            static const CRemoveTable table;
+            return table;
+        }
+
+#if defined(AMV_SIMD_X86)
+
+        __attribute__((target("ssse3"))) inline size_t SpanSsse3(
+            _In_reads_(n) const char *p, _In_ size_t n, _In_ const CAmvCharSet &set,
+            _In_ bool bIn) throw()
+        {
+            const __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i *>(set.GetRows()));
+            const __m128i hi =
+                _mm_load_si128(reinterpret_cast<const __m128i *>(set.GetRows() + 16));
+            const __m128i bitsel = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8,
+                                                 16, 32, 64, -128);
+            const __m128i nibble = _mm_set1_epi8(0x0f);
+            const __m128i top = _mm_set1_epi8(-128);
+            const unsigned int nFlip = bIn ? 0xffff : 0;
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                // PSHUFB gives 0 for indexes with the top bit set, which picks the
+                // right table for each char
+                __m128i rows = _mm_or_si128(_mm_shuffle_epi8(lo, v),
+                                            _mm_shuffle_epi8(hi, _mm_xor_si128(v, top)));
+                __m128i bit = _mm_shuffle_epi8(bitsel,
+                                               _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+                unsigned int nMask = static_cast<unsigned int>(_mm_movemask_epi8(
+                                         _mm_cmpeq_epi8(_mm_and_si128(rows, bit), bit))) ^
+                                     nFlip;
+                if (nMask != 0)
+                {
+                    return i + __builtin_ctz(nMask);
+                }
+            }
+            return i + SpanScalar(p + i, n - i, set, bIn);
+        }
+
+        __attribute__((target("avx2"))) inline size_t SpanAvx2(
+            _In_reads_(n) const char *p, _In_ size_t n, _In_ const CAmvCharSet &set,
+            _In_ bool bIn) throw()
+        {
+            const __m256i lo = _mm256_broadcastsi128_si256(
+                _mm_load_si128(reinterpret_cast<const __m128i *>(set.GetRows())));
+            const __m256i hi = _mm256_broadcastsi128_si256(
+                _mm_load_si128(reinterpret_cast<const __m128i *>(set.GetRows() + 16)));
+            const __m256i bitsel = _mm256_setr_epi8(
+                1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16,
+                32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            const __m256i nibble = _mm256_set1_epi8(0x0f);
+            const __m256i top = _mm256_set1_epi8(-128);
+            const unsigned int nFlip = bIn ? 0xffffffffu : 0;
+
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+                __m256i rows = _mm256_or_si256(
+                    _mm256_shuffle_epi8(lo, v),
+                    _mm256_shuffle_epi8(hi, _mm256_xor_si256(v, top)));
+                __m256i bit = _mm256_shuffle_epi8(
+                    bitsel, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+                unsigned int nMask =
+                    static_cast<unsigned int>(_mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8(_mm256_and_si256(rows, bit), bit))) ^
+                    nFlip;
+                if (nMask != 0)
+                {
+                    return i + __builtin_ctz(nMask);
+                }
+            }
+            return i + SpanSsse3(p + i, n - i, set, bIn);
+        }
+
+        // Lower-cases 'A'..'Z': after adding 0x80 - 'A' they are the only
+        // chars in [-128, -128 + 26) as signed bytes
+        inline __m128i FoldCaseSse2(_In_ __m128i v) throw()
+        {
+            __m128i up = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8(0x80 - 'A')),
+                                        _mm_set1_epi8(-128 + 26));
+            return _mm_or_si128(v, _mm_and_si128(up, _mm_set1_epi8(0x20)));
+        }
+
+        inline int CompareNoCaseSse2(_In_reads_(n1) const char *p1, _In_ size_t n1,
+                                     _In_reads_(n2) const char *p2, _In_ size_t n2) throw()
+        {
+            size_t n = (n1 < n2) ? n1 : n2;
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i a = FoldCaseSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p1 + i)));
+                __m128i b = FoldCaseSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p2 + i)));
+                unsigned int nMask =
+                    static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+                if (nMask != 0xffff)
+                {
+                    size_t j = i + __builtin_ctz(~nMask);
+                    return static_cast<int>(FoldCase(p1[j])) - static_cast<int>(FoldCase(p2[j]));
+                }
+            }
+            return CompareNoCaseScalar(p1, n1, p2, n2, i);
+        }
+
+        __attribute__((target("avx2"))) inline __m256i FoldCaseAvx2(_In_ __m256i v) throw()
+        {
+            __m256i up = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26),
+                                           _mm256_add_epi8(v, _mm256_set1_epi8(0x80 - 'A')));
+            return _mm256_or_si256(v, _mm256_and_si256(up, _mm256_set1_epi8(0x20)));
+        }
+
+        __attribute__((target("avx2"))) inline int CompareNoCaseAvx2(
+            _In_reads_(n1) const char *p1, _In_ size_t n1, _In_reads_(n2) const char *p2,
+            _In_ size_t n2) throw()
+        {
+            size_t n = (n1 < n2) ? n1 : n2;
+
+            size_t i = 0;
+            // Two blocks per test while they match
+            for (; i + 64 <= n; i += 64)
+            {
+                const __m256i *q1 = reinterpret_cast<const __m256i *>(p1 + i);
+                const __m256i *q2 = reinterpret_cast<const __m256i *>(p2 + i);
+                __m256i e0 = _mm256_cmpeq_epi8(FoldCaseAvx2(_mm256_loadu_si256(q1)),
+                                               FoldCaseAvx2(_mm256_loadu_si256(q2)));
+                __m256i e1 = _mm256_cmpeq_epi8(FoldCaseAvx2(_mm256_loadu_si256(q1 + 1)),
+                                               FoldCaseAvx2(_mm256_loadu_si256(q2 + 1)));
+                if (static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_and_si256(e0, e1))) !=
+                    0xffffffffu)
+                {
+                    break;
+                }
+            }
+            for (; i + 32 <= n; i += 32)
+            {
+                __m256i a = FoldCaseAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p1 + i)));
+                __m256i b = FoldCaseAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p2 + i)));
+                unsigned int nMask =
+                    static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+                if (nMask != 0xffffffffu)
+                {
+                    size_t j = i + __builtin_ctz(~nMask);
+                    return static_cast<int>(FoldCase(p1[j])) - static_cast<int>(FoldCase(p2[j]));
+                }
+            }
+            return CompareNoCaseScalar(p1, n1, p2, n2, i);
+        }
+
+        // 64 chars per step; the tail is read with a masked load, which never
+        // touches the bytes masked out
+        __attribute__((target("avx512bw"))) inline int CompareNoCaseAvx512(
+            _In_reads_(n1) const char *p1, _In_ size_t n1, _In_reads_(n2) const char *p2,
+            _In_ size_t n2) throw()
+        {
+            const __m512i shift = _mm512_set1_epi8(0x80 - 'A');
+            const __m512i limit = _mm512_set1_epi8(-128 + 26);
+            const __m512i bit = _mm512_set1_epi8(0x20);
+            size_t n = (n1 < n2) ? n1 : n2;
+
+            for (size_t i = 0; i < n; i += 64)
+            {
+                __mmask64 nLoad = (n - i >= 64) ? ~static_cast<__mmask64>(0)
+                                                : (static_cast<__mmask64>(1) << (n - i)) - 1;
+                __m512i a = _mm512_maskz_loadu_epi8(nLoad, p1 + i);
+                __m512i b = _mm512_maskz_loadu_epi8(nLoad, p2 + i);
+                a = _mm512_mask_add_epi8(a, _mm512_cmplt_epi8_mask(_mm512_add_epi8(a, shift), limit),
+                                         a, bit);
+                b = _mm512_mask_add_epi8(b, _mm512_cmplt_epi8_mask(_mm512_add_epi8(b, shift), limit),
+                                         b, bit);
+                __mmask64 nDiff = _mm512_cmpneq_epi8_mask(a, b);
+                if (nDiff != 0)
+                {
+                    size_t j = i + __builtin_ctzll(nDiff);
+                    return static_cast<int>(FoldCase(p1[j])) - static_cast<int>(FoldCase(p2[j]));
+                }
+            }
+            return (n1 < n2) ? -1 : (n1 > n2) ? 1 : 0;
+        }
+
+        // The first and the last char of pSub are tested at 16 positions at
+        // once; only the positions where both match are compared.  When
+        // those keep failing ("aab" in "aaaa...") the rest goes to
+        // FindStringScalar(), so the worst case stays linear.
+        // 2 <= nSub <= n.
+        inline const char *FindStringSse2(_In_reads_(n) const char *p, _In_ size_t n,
+                                          _In_reads_(nSub) const char *pSub,
+                                          _In_ size_t nSub) throw()
+        {
+            const __m128i first = _mm_set1_epi8(pSub[0]);
+            const __m128i last = _mm_set1_epi8(pSub[nSub - 1]);
+            const size_t nStarts = n - nSub + 1;
+            size_t nWasted = 0;
+
+            size_t i = 0;
+            for (; i + 16 <= nStarts; i += 16)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + nSub - 1));
+                unsigned int nMask = static_cast<unsigned int>(_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+                for (; nMask != 0; nMask &= nMask - 1)
+                {
+                    size_t j = i + __builtin_ctz(nMask);
+                    if (memcmp(p + j + 1, pSub + 1, nSub - 2) == 0)
+                    {
+                        return p + j;
+                    }
+                    nWasted += nSub;
+                }
+                if (nWasted > i + FIND_STRING_SLACK)
+                {
+                    return FindStringScalar(p + i + 16, n - i - 16, pSub, nSub);
+                }
+            }
+            return FindStringTail(p, n, pSub, nSub, i);
+        }
+
+        __attribute__((target("avx2"))) inline const char *FindStringAvx2(
+            _In_reads_(n) const char *p, _In_ size_t n, _In_reads_(nSub) const char *pSub,
+            _In_ size_t nSub) throw()
+        {
+            const __m256i first = _mm256_set1_epi8(pSub[0]);
+            const __m256i last = _mm256_set1_epi8(pSub[nSub - 1]);
+            const size_t nStarts = n - nSub + 1;
+            size_t nWasted = 0;
+
+            size_t i = 0;
+            for (; i + 32 <= nStarts; i += 32)
+            {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+                __m256i b =
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + nSub - 1));
+                unsigned int nMask = static_cast<unsigned int>(_mm256_movemask_epi8(
+                    _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+                for (; nMask != 0; nMask &= nMask - 1)
+                {
+                    size_t j = i + __builtin_ctz(nMask);
+                    if (memcmp(p + j + 1, pSub + 1, nSub - 2) == 0)
+                    {
+                        return p + j;
+                    }
+                    nWasted += nSub;
+                }
+                if (nWasted > i + FIND_STRING_SLACK)
+                {
+                    return FindStringScalar(p + i + 32, n - i - 32, pSub, nSub);
+                }
+            }
+            return FindStringSse2(p + i, n - i, pSub, nSub);
+        }
+
+        // SSE2 is part of x86-64 itself
+        inline size_t ReplaceCharSse2(_Inout_updates_(n) char *p, _In_ size_t n,
+                                      _In_ char chOld, _In_ char chNew) throw()
+        {
+            const __m128i vold = _mm_set1_epi8(chOld);
+            const __m128i vnew = _mm_set1_epi8(chNew);
+            size_t nCount = 0;
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                __m128i m = _mm_cmpeq_epi8(v, vold);
+                unsigned int nMask = static_cast<unsigned int>(_mm_movemask_epi8(m));
+                if (nMask != 0)
+                {
+                    v = _mm_or_si128(_mm_andnot_si128(m, v), _mm_and_si128(m, vnew));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i), v);
+                    nCount += __builtin_popcount(nMask);
+                }
+            }
+            return nCount + ReplaceCharScalar(p + i, n - i, chOld, chNew);
+        }
+
+        __attribute__((target("avx2,popcnt"))) inline size_t ReplaceCharAvx2(
+            _Inout_updates_(n) char *p, _In_ size_t n, _In_ char chOld,
+            _In_ char chNew) throw()
+        {
+            const __m256i vold = _mm256_set1_epi8(chOld);
+            const __m256i vnew = _mm256_set1_epi8(chNew);
+            size_t nCount = 0;
+
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+                __m256i m = _mm256_cmpeq_epi8(v, vold);
+                unsigned int nMask = static_cast<unsigned int>(_mm256_movemask_epi8(m));
+                if (nMask != 0)
+                {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p + i),
+                                        _mm256_blendv_epi8(v, vnew, m));
+                    nCount += __builtin_popcount(nMask);
+                }
+            }
+            return nCount + ReplaceCharSse2(p + i, n - i, chOld, chNew);
+        }
+
+        // Each 16 chars are packed as two halves of 8 with PSHUFB.  Both halves
+        // are stored only after the load, and never past it, so it works in
+        // place.
+        __attribute__((target("ssse3,popcnt"))) inline size_t RemoveCharSsse3(
+            _Inout_updates_(n) char *p, _In_ size_t n, _In_ char ch) throw()
+        {
+            const CRemoveTable &table = GetRemoveTable();
+            const __m128i vch = _mm_set1_epi8(ch);
+            const __m128i eight = _mm_set1_epi8(8);
+            char *pDest = p;
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                unsigned int nMask =
+                    static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, vch)));
+                if (nMask == 0)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(pDest), v);
+                    pDest += 16;
+                    continue;
+                }
+
+                unsigned int nLo = nMask & 0xff;
+                unsigned int nHi = nMask >> 8;
+                __m128i lo = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(table.m_idx[nLo]));
+                __m128i hi = _mm_add_epi8(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i *>(table.m_idx[nHi])), eight);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(pDest), _mm_shuffle_epi8(v, lo));
+                pDest += 8 - __builtin_popcount(nLo);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(pDest), _mm_shuffle_epi8(v, hi));
+                pDest += 8 - __builtin_popcount(nHi);
+            }
+            size_t nTail = RemoveCharScalar(p + i, n - i, ch);
+            memmove(pDest, p + i, nTail);
+            return (pDest - p) + nTail;
+        }
+
+#elif defined(AMV_SIMD_NEON)
+
+        inline size_t SpanNeon(_In_reads_(n) const char *p, _In_ size_t n,
+                               _In_ const CAmvCharSet &set, _In_ bool bIn) throw()
+        {
+            static const uint8_t kBitSel[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                                1, 2, 4, 8, 16, 32, 64, 128};
+            const uint8x16_t lo = vld1q_u8(set.GetRows());
+            const uint8x16_t hi = vld1q_u8(set.GetRows() + 16);
+            const uint8x16_t bitsel = vld1q_u8(kBitSel);
+            const uint8x16_t nibble = vdupq_n_u8(0x0f);
+            const uint8x16_t top = vdupq_n_u8(0x80);
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p + i));
+                uint8x16_t l = vandq_u8(v, nibble);
+                uint8x16_t rows =
+                    vbslq_u8(vcltq_u8(v, top), vqtbl1q_u8(lo, l), vqtbl1q_u8(hi, l));
+                uint8x16_t m = vtstq_u8(rows, vqtbl1q_u8(bitsel, vshrq_n_u8(v, 4)));
+                if (bIn)
+                {
+                    m = vmvnq_u8(m);
+                }
+                // 4 bits per char
+                uint64_t nMask = vget_lane_u64(
+                    vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+                if (nMask != 0)
+                {
+                    return i + (__builtin_ctzll(nMask) >> 2);
+                }
+            }
+            return i + SpanScalar(p + i, n - i, set, bIn);
+        }
+
+        inline size_t ReplaceCharNeon(_Inout_updates_(n) char *p, _In_ size_t n,
+                                      _In_ char chOld, _In_ char chNew) throw()
+        {
+            const uint8x16_t vold = vdupq_n_u8(static_cast<uint8_t>(chOld));
+            const uint8x16_t vnew = vdupq_n_u8(static_cast<uint8_t>(chNew));
+            size_t nCount = 0;
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                uint8_t *q = reinterpret_cast<uint8_t *>(p + i);
+                uint8x16_t v = vld1q_u8(q);
+                uint8x16_t m = vceqq_u8(v, vold);
+                if (vmaxvq_u8(m) != 0)
+                {
+                    vst1q_u8(q, vbslq_u8(m, vnew, v));
+                    nCount += vaddvq_u8(vshrq_n_u8(m, 7));
+                }
+            }
+            return nCount + ReplaceCharScalar(p + i, n - i, chOld, chNew);
+        }
+
+        inline int CompareNoCaseNeon(_In_reads_(n1) const char *p1, _In_ size_t n1,
+                                     _In_reads_(n2) const char *p2, _In_ size_t n2) throw()
+        {
+            const uint8x16_t A = vdupq_n_u8('A');
+            const uint8x16_t n26 = vdupq_n_u8(26);
+            const uint8x16_t bit = vdupq_n_u8(0x20);
+            size_t n = (n1 < n2) ? n1 : n2;
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(p1 + i));
+                uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(p2 + i));
+                a = vorrq_u8(a, vandq_u8(vcltq_u8(vsubq_u8(a, A), n26), bit));
+                b = vorrq_u8(b, vandq_u8(vcltq_u8(vsubq_u8(b, A), n26), bit));
+                if (vminvq_u8(vceqq_u8(a, b)) == 0)
+                {
+                    return CompareNoCaseScalar(p1, n1, p2, n2, i);
+                }
+            }
+            return CompareNoCaseScalar(p1, n1, p2, n2, i);
+        }
+
+        // Same as FindStringSse2(); the match mask has 4 bits per position, of
+        // which the top one is kept
+        inline const char *FindStringNeon(_In_reads_(n) const char *p, _In_ size_t n,
+                                          _In_reads_(nSub) const char *pSub,
+                                          _In_ size_t nSub) throw()
+        {
+            const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(pSub[0]));
+            const uint8x16_t last = vdupq_n_u8(static_cast<uint8_t>(pSub[nSub - 1]));
+            const size_t nStarts = n - nSub + 1;
+            size_t nWasted = 0;
+
+            size_t i = 0;
+            for (; i + 16 <= nStarts; i += 16)
+            {
+                uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(p + i));
+                uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(p + i + nSub - 1));
+                uint8x16_t m = vandq_u8(vceqq_u8(a, first), vceqq_u8(b, last));
+                uint64_t nMask = vget_lane_u64(
+                                     vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0) &
+                                 0x8888888888888888ull;
+                for (; nMask != 0; nMask &= nMask - 1)
+                {
+                    size_t j = i + (__builtin_ctzll(nMask) >> 2);
+                    if (memcmp(p + j + 1, pSub + 1, nSub - 2) == 0)
+                    {
+                        return p + j;
+                    }
+                    nWasted += nSub;
+                }
+                if (nWasted > i + FIND_STRING_SLACK)
+                {
+                    return FindStringScalar(p + i + 16, n - i - 16, pSub, nSub);
+                }
+            }
+            return FindStringTail(p, n, pSub, nSub, i);
+        }
+
+        // Same as RemoveCharSsse3() with TBL on each half
+        inline size_t RemoveCharNeon(_Inout_updates_(n) char *p, _In_ size_t n,
+                                     _In_ char ch) throw()
+        {
+            static const uint8_t kBits[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+            const CRemoveTable &table = GetRemoveTable();
+            const uint8x8_t bits = vld1_u8(kBits);
+            const uint8x16_t vch = vdupq_n_u8(static_cast<uint8_t>(ch));
+            char *pDest = p;
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p + i));
+                uint8x16_t m = vceqq_u8(v, vch);
+                unsigned int nLo = vaddv_u8(vand_u8(vget_low_u8(m), bits));
+                unsigned int nHi = vaddv_u8(vand_u8(vget_high_u8(m), bits));
+                uint8x8_t lo = vtbl1_u8(vget_low_u8(v), vld1_u8(table.m_idx[nLo]));
+                uint8x8_t hi = vtbl1_u8(vget_high_u8(v), vld1_u8(table.m_idx[nHi]));
+                vst1_u8(reinterpret_cast<uint8_t *>(pDest), lo);
+                pDest += 8 - __builtin_popcount(nLo);
+                vst1_u8(reinterpret_cast<uint8_t *>(pDest), hi);
+                pDest += 8 - __builtin_popcount(nHi);
+            }
+            size_t nTail = RemoveCharScalar(p + i, n - i, ch);
+            memmove(pDest, p + i, nTail);
+            return (pDest - p) + nTail;
+        }
+
+#endif
+
+        inline size_t Span(_In_reads_(n) const char *p, _In_ size_t n,
+                           _In_ const CAmvCharSet &set, _In_ bool bIn) throw()
+        {
+#if defined(AMV_SIMD_X86)
+            switch (GetLevel())
+            {
+            case LEVEL_AVX512:
+            case LEVEL_AVX2:
+                return SpanAvx2(p, n, set, bIn);
+            case LEVEL_SSSE3:
+                return SpanSsse3(p, n, set, bIn);
+            default:
+                return SpanScalar(p, n, set, bIn);
+            }
+#elif defined(AMV_SIMD_NEON)
+            return SpanNeon(p, n, set, bIn);
+#else
+            return SpanScalar(p, n, set, bIn);
+#endif
+        }
+
+    } // namespace AmvSimd
+
+    // Length of the prefix of p[0, n) made of chars in set
+    inline size_t AmvSpanIncluding(_In_reads_(n) const char *p, _In_ size_t n,
+                                   _In_ const CAmvCharSet &set) throw()
+    {
+        return AmvSimd::Span(p, n, set, true);
+    }
+
+    // Length of the prefix of p[0, n) made of chars not in set
+    inline size_t AmvSpanExcluding(_In_reads_(n) const char *p, _In_ size_t n,
+                                   _In_ const CAmvCharSet &set) throw()
+    {
+        return AmvSimd::Span(p, n, set, false);
+    }
+
+    // First ch in p[0, n), or NULL.  The C library's memchr() is already
+    // vectorized for every target we build on.
+    inline const char *AmvFindChar(_In_reads_(n) const char *p, _In_ size_t n,
+                                   _In_ char ch) throw()
+    {
+        return static_cast<const char *>(memchr(p, ch, n));
+    }
+
+    // Last ch in p[0, n), or NULL
+    inline const char *AmvFindCharRev(_In_reads_(n) const char *p, _In_ size_t n,
+                                      _In_ char ch) throw()
+    {
+#if defined(__GLIBC__)
+        return static_cast<const char *>(memrchr(p, ch, n));
+#else
+        while (n > 0)
+        {
+            if (p[--n] == ch)
+            {
+                return p + n;
+            }
+        }
+        return NULL;
+#endif
+    }
+
+    // First pSub[0, nSub) in p[0, n), or NULL.  Embedded '\0' are ordinary chars.
+    inline const char *AmvFindString(_In_reads_(n) const char *p, _In_ size_t n,
+                                     _In_reads_(nSub) const char *pSub,
+                                     _In_ size_t nSub) throw()
+    {
+        if (nSub == 0)
+        {
+            return p;
+        }
+        if (nSub > n)
+        {
+            return NULL;
+        }
+        if (nSub == 1)
+        {
+            return AmvFindChar(p, n, *pSub);
+        }
+#if defined(AMV_SIMD_X86)
+        if (AmvSimd::GetLevel() >= AmvSimd::LEVEL_AVX2)
+        {
+            return AmvSimd::FindStringAvx2(p, n, pSub, nSub);
+        }
+        return AmvSimd::FindStringSse2(p, n, pSub, nSub);
+#elif defined(AMV_SIMD_NEON)
+        return AmvSimd::FindStringNeon(p, n, pSub, nSub);
+#else
+        return AmvSimd::FindStringScalar(p, n, pSub, nSub);
+#endif
+    }
+
+    // strcmp() over p1[0, n1) and p2[0, n2); a shorter prefix is less
+    inline int AmvCompare(_In_reads_(n1) const char *p1, _In_ size_t n1,
+                          _In_reads_(n2) const char *p2, _In_ size_t n2) throw()
+    {
+        int nRet = memcmp(p1, p2, (n1 < n2) ? n1 : n2);
+        if (nRet != 0)
+        {
+            return nRet;
+        }
+        return (n1 < n2) ? -1 : (n1 > n2) ? 1 : 0;
+    }
+
+    // Same as AmvCompare() with ASCII letters folded to lower case
+    inline int AmvCompareNoCase(_In_reads_(n1) const char *p1, _In_ size_t n1,
+                                _In_reads_(n2) const char *p2, _In_ size_t n2) throw()
+    {
+#if defined(AMV_SIMD_X86)
+        if (AmvSimd::GetLevel() == AmvSimd::LEVEL_AVX512)
+        {
+            return AmvSimd::CompareNoCaseAvx512(p1, n1, p2, n2);
+        }
+        if (AmvSimd::GetLevel() == AmvSimd::LEVEL_AVX2)
+        {
+            return AmvSimd::CompareNoCaseAvx2(p1, n1, p2, n2);
+        }
+        return AmvSimd::CompareNoCaseSse2(p1, n1, p2, n2);
+#elif defined(AMV_SIMD_NEON)
+        return AmvSimd::CompareNoCaseNeon(p1, n1, p2, n2);
+#else
+        return AmvSimd::CompareNoCaseScalar(p1, n1, p2, n2);
+#endif
+    }
+
+    // Replaces every chOld in p[0, n) with chNew and returns how many there were
+    inline size_t AmvReplaceChar(_Inout_updates_(n) char *p, _In_ size_t n,
+                                 _In_ char chOld, _In_ char chNew) throw()
+    {
+#if defined(AMV_SIMD_X86)
+        if (AmvSimd::GetLevel() >= AmvSimd::LEVEL_AVX2)
+        {
+            return AmvSimd::ReplaceCharAvx2(p, n, chOld, chNew);
+        }
+        return AmvSimd::ReplaceCharSse2(p, n, chOld, chNew);
+#elif defined(AMV_SIMD_NEON)
+        return AmvSimd::ReplaceCharNeon(p, n, chOld, chNew);
+#else
+        return AmvSimd::ReplaceCharScalar(p, n, chOld, chNew);
+#endif
+    }
+
+    // Removes every ch from p[0, n) and returns the new length
+    inline size_t AmvRemoveChar(_Inout_updates_(n) char *p, _In_ size_t n,
+                                _In_ char ch) throw()
+    {
+#if defined(AMV_SIMD_X86)
+        if (AmvSimd::GetLevel() >= AmvSimd::LEVEL_SSSE3)
+        {
+            return AmvSimd::RemoveCharSsse3(p, n, ch);
+        }
+        return AmvSimd::RemoveCharScalar(p, n, ch);
+#elif defined(AMV_SIMD_NEON)
+        return AmvSimd::RemoveCharNeon(p, n, ch);
+#else
+        return AmvSimd::RemoveCharScalar(p, n, ch);
+#endif
+    }
+
+    // The same for wider chars (char16_t, wchar_t).  The kernels above work
+    // on bytes, so these are plain loops; a char string always takes the
+    // non-template overload.
+
+    template <typename XCHAR>
+    inline const XCHAR *AmvFindChar(_In_reads_(n) const XCHAR *p, _In_ size_t n,
+                                    _In_ XCHAR ch) throw()
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (p[i] == ch)
+            {
+                return p + i;
+            }
+        }
+        return NULL;
+    }
+
+    template <typename XCHAR>
+    inline const XCHAR *AmvFindCharRev(_In_reads_(n) const XCHAR *p, _In_ size_t n,
+                                       _In_ XCHAR ch) throw()
+    {
+        while (n > 0)
+        {
+            if (p[--n] == ch)
+            {
+                return p + n;
+            }
+        }
+        return NULL;
+    }
+
+    template <typename XCHAR>
+    inline const XCHAR *AmvFindString(_In_reads_(n) const XCHAR *p, _In_ size_t n,
+                                      _In_reads_(nSub) const XCHAR *pSub,
+                                      _In_ size_t nSub) throw()
+    {
+        if (nSub == 0)
+        {
+            return p;
+        }
+        const XCHAR *pLast = p + n;
+        while (static_cast<size_t>(pLast - p) >= nSub)
+        {
+            p = AmvFindChar(p, (pLast - p) - nSub + 1, *pSub);
+            if (p == NULL)
+            {
+                return NULL;
+            }
+            if (memcmp(p + 1, pSub + 1, (nSub - 1) * sizeof(XCHAR)) == 0)
+            {
+                return p;
+            }
+            p++;
+        }
+        return NULL;
+    }
+
+    template <typename XCHAR>
+    inline int AmvCompare(_In_reads_(n1) const XCHAR *p1, _In_ size_t n1,
+                          _In_reads_(n2) const XCHAR *p2, _In_ size_t n2) throw()
+    {
+        size_t n = (n1 < n2) ? n1 : n2;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (p1[i] != p2[i])
+            {
+                return (p1[i] < p2[i]) ? -1 : 1;
+            }
+        }
+        return (n1 < n2) ? -1 : (n1 > n2) ? 1 : 0;
+    }
+
+    template <typename XCHAR>
+    inline int AmvCompareNoCase(_In_reads_(n1) const XCHAR *p1, _In_ size_t n1,
+                                _In_reads_(n2) const XCHAR *p2, _In_ size_t n2) throw()
+    {
+        size_t n = (n1 < n2) ? n1 : n2;
+        for (size_t i = 0; i < n; i++)
+        {
+            XCHAR ch1 = (p1[i] >= 'A' && p1[i] <= 'Z') ? p1[i] + ('a' - 'A') : p1[i];
+            XCHAR ch2 = (p2[i] >= 'A' && p2[i] <= 'Z') ? p2[i] + ('a' - 'A') : p2[i];
+            if (ch1 != ch2)
+            {
+                return (ch1 < ch2) ? -1 : 1;
+            }
+        }
+        return (n1 < n2) ? -1 : (n1 > n2) ? 1 : 0;
+    }
+
+    template <typename XCHAR>
+    inline size_t AmvReplaceChar(_Inout_updates_(n) XCHAR *p, _In_ size_t n,
+                                 _In_ XCHAR chOld, _In_ XCHAR chNew) throw()
+    {
+        size_t nCount = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (p[i] == chOld)
+            {
+                p[i] = chNew;
+                nCount++;
+            }
+        }
+        return nCount;
+    }
+
+    template <typename XCHAR>
+    inline size_t AmvRemoveChar(_Inout_updates_(n) XCHAR *p, _In_ size_t n,
+                                _In_ XCHAR ch) throw()
+    {
+        size_t nNew = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (p[i] != ch)
+            {
+                p[nNew++] = p[i];
+            }
+        }
+        return nNew;
+    }
+
+} // namespace AMV
+
+#endif // AMVSIMD_HPP_
@@ -7,467 +7,14 @@
 #include <climits>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 #include "include/amvdefine.hpp"
+#include "include/amvhash.hpp"
 #include "salieri-src/salieri.h"
 
-<<<<<<< HEAD:include/amvsimpstr.hpp
-namespace AMV {
-
-struct BStringData;
-
-__interface IAmvStringMgr {
- public:
-  // Allocate a new BStringData
-  virtual BStringData* Allocate(int nAllocLength, int nCharSize) throw() = 0;
-
-  // Free an existing BStringData
-  virtual void Free(BStringData * pData) throw() = 0;
-
-  // Change the size of an existing BStringData
-  virtual BStringData* Reallocate(BStringData * pData, int nAllocLength,
-                                  int nCharSize) throw() = 0;
-
-  // Get the BStringData for a Nil string
-  virtual BStringData* GetNilString() throw() = 0;
-
-  virtual IAmvStringMgr* Clone() throw() = 0;
-};
-
-struct BStringData {
-  // String manager for this BStringData
-  IAmvStringMgr* pStringMgr;
-  // Length of currently used data in chars (not including terminating null)
-  int nDataLength;
-  // Length of allocated data in chars (not including terminating null)
-  int nAllocLength;
-  // Reference count: negative == locked
-  int64_t nRefs;
-
-  void* data() throw() { return (this + 1); }
-
-  void AddRef() throw() {
-    AMVASSERT(nRefs > 0);
-
-    _InterlockedIncrement(&nRefs);
-  }
-
-  bool IsLocked() const throw() { return nRefs < 0; }
-
-  bool IsShared() const throw() { return (nRefs > 1); }
-
-  void Lock() throw() {
-    AMVASSERT(nRefs <= 1);
-
-    // Locked buffers can't be shared, so no interlocked operation necessary
-    nRefs--;
-    if (nRefs == 0) {
-      nRefs = -1;
-    }
-  }
-
-  void Release() throw() {
-    AMVASSERT(nRefs != 0);
-
-    if (_InterlockedDecrement(&nRefs) <= 0) {
-      pStringMgr->Free(this);
-    }
-  }
-
-  void Unlock() throw() {
-    AMVASSERT(IsLocked());
-
-    if (IsLocked()) {
-      // Locked buffers can't be shared, so no interlocked operation necessary
-      nRefs++;
-      if (nRefs == 0) {
-        nRefs = 1;
-      }
-    }
-  }
-};
-
-class CNilStringData : public BStringData {
- public:
-  CNilStringData() throw() {
-    pStringMgr = NULL;
-    // Never gets freed by IAmvStringMgr
-    nRefs = 2;
-    nDataLength = 0;
-    nAllocLength = 0;
-    achNil[0] = 0;
-    achNil[1] = 0;
-  }
-
-  void SetManager(_In_ IAmvStringMgr* pMgr) throw() {
-    AMVASSERT(pStringMgr == NULL);
-    pStringMgr = pMgr;
-  }
-
- private:
-  wchar_t achNil[2];
-};
-
-template <typename TCharType>
-class CStrBufT;
-template <typename BaseType, const int t_nSize>
-class CStaticString {
- public:
-  explicit CStaticString(_In_z_ const BaseType* psz) : m_psz(psz) {}
-
-  operator const BaseType*() const { return m_psz; }
-
-  static int __cdecl GetLength() { return (t_nSize / sizeof(BaseType)) - 1; }
-
- private:
-  const BaseType* m_psz;
-
- private:
-  explicit CStaticString(_In_ const CStaticString& str) throw();
-  CStaticString& operator=(_In_ const CStaticString& str) throw();
-};
-
-template <typename BaseType>
-class CSimpleStringT {
- public:
-  explicit CSimpleStringT(_Inout_ IAmvStringMgr* pStringMgr) {
-    AMVENSURE(pStringMgr != NULL);
-    Attach(pStringMgr->GetNilString());
-  }
-
-  explicit CSimpleStringT(_In_ const CSimpleStringT& strSrc) {
-    Attach(CloneData(strSrc.GetData()));
-  }
-
-  CSimpleStringT(_In_z_ const char* pszSrc, _Inout_ IAmvStringMgr* pStringMgr) {
-    AMVENSURE(pStringMgr != NULL);
-
-    int nLength = StringLength(pszSrc);
-    BStringData* pData = pStringMgr->Allocate(nLength, sizeof(char));
-    if (pData == NULL) {
-      ThrowMemoryException();
-    }
-    Attach(pData);
-    SetLength(nLength);
-    CopyChars(m_pszData, nLength, pszSrc, nLength);
-  }
-
-  CSimpleStringT(_In_reads_(nLength) const unsigned char* puchSrc,
-                 _In_ int nLength, _Inout_ IAmvStringMgr* pStringMgr) {
-    AMVENSURE(pStringMgr != NULL);
-
-    if (puchSrc == NULL && nLength != 0) AmvThrow("Invalid arguments");
-
-    BStringData* pData = pStringMgr->Allocate(nLength, sizeof(char));
-    if (pData == NULL) {
-      ThrowMemoryException();
-    }
-    Attach(pData);
-    SetLength(nLength);
-    CopyChars(m_pszData, nLength, reinterpret_cast<const char*>(puchSrc),
-              nLength);
-  }
-
-  ~CSimpleStringT() throw() {
-    BStringData* pData = GetData();
-    pData->Release();
-  }
-
-  // operator CSimpleStringT<BaseType>&() {
-  //   std::cout << __FILE__ << " | " << __LINE__ << std::endl;
-  //   return *(CSimpleStringT<BaseType>*)this;
-  // }
-
-  CSimpleStringT& operator=(_In_ const CSimpleStringT& strSrc) {
-    BStringData* pSrcData = strSrc.GetData();
-    BStringData* pOldData = GetData();
-    if (pSrcData != pOldData) {
-      if (pOldData->IsLocked() ||
-          pSrcData->pStringMgr != pOldData->pStringMgr) {
-        SetString(strSrc.GetString(), strSrc.GetLength());
-      } else {
-        BStringData* pNewData = CloneData(pSrcData);
-        pOldData->Release();
-        Attach(pNewData);
-      }
-    }
-
-    return (*this);
-  }
-
-  CSimpleStringT& operator=(_In_opt_z_ const char* pszSrc) {
-    SetString(pszSrc);
-
-    return (*this);
-  }
-
-  CSimpleStringT& operator+=(_In_ const CSimpleStringT& strSrc) {
-    Append(strSrc);
-
-    return (*this);
-  }
-
-  CSimpleStringT& operator+=(_In_z_ const char* pszSrc) {
-    Append(pszSrc);
-
-    return (*this);
-  }
-  template <int t_nSize>
-  CSimpleStringT& operator+=(_In_ const CStaticString<char, t_nSize>& strSrc) {
-    Append(static_cast<const char*>(strSrc), strSrc.GetLength());
-
-    return (*this);
-  }
-  CSimpleStringT& operator+=(_In_ char ch) {
-    AppendChar(static_cast<char>(ch));
-
-    return (*this);
-  }
-  CSimpleStringT& operator+=(_In_ unsigned char ch) {
-    AppendChar(static_cast<char>(ch));
-
-    return (*this);
-  }
-
-  char operator[](_In_ int iChar) const {
-    // Indexing the '\0' is OK
-    AMVASSERT((iChar >= 0) && (iChar <= GetLength()));
-
-    if ((iChar < 0) || (iChar > GetLength())) AmvThrow("Invalid arguments");
-
-    return (m_pszData[iChar]);
-  }
-
-  // Todo(jpk, 20220118): 아직도 이 부분 왜 다른지 전혀 모르겠음
-  // operator char*() const throw() {
-  //   return (m_pszData);
-  // }
-
-  operator const char*() const throw() {
-    return const_cast<const char *>(m_pszData);
-  }
-
-  // operator const void*() const throw() {
-  //   return reinterpret_cast<const void *>(m_pszData);
-  // }
-
-  void Append(_In_z_ const char* pszSrc) {
-    Append(pszSrc, StringLength(pszSrc));
-  }
-
-  void Append(_In_reads_(nLength) const char* pszSrc, _In_ int nLength) {
-    // See comment in SetString() about why we do this
-    UINT_PTR nOffset = pszSrc - GetString();
-
-    UINT nOldLength = GetLength();
-    // if (nOldLength < 0) {
-    //   // protects from underflow
-    //   nOldLength = 0;
-    // }
-
-    // Make sure the nLength is greater than zero
-    AMVENSURE_THROW(nLength >= 0, "Invalid arguments");
-
-    // Make sure we don't read pass end of the terminating NULL
-    nLength = StringLengthN(pszSrc, nLength);
-
-    // Make sure after the string doesn't exceed INT_MAX after appending
-    AMVENSURE_THROW(INT_MAX - nLength >= static_cast<int>(nOldLength),
-                    "Invalid arguments");
-
-    int nNewLength = nOldLength + nLength;
-    char* pszBuffer = GetBuffer(nNewLength);
-    if (nOffset <= nOldLength) {
-      pszSrc = pszBuffer + nOffset;
-      /* No need to call CopyCharsOverlapped, since the destination is beyond
-       * the end of the original buffer*/
-    }
-    CopyChars(pszBuffer + nOldLength, nLength, pszSrc, nLength);
-    ReleaseBufferSetLength(nNewLength);
-  }
-
-  void AppendChar(_In_ char ch) {
-    UINT nOldLength = GetLength();
-    int nNewLength = nOldLength + 1;
-    char* pszBuffer = GetBuffer(nNewLength);
-    pszBuffer[nOldLength] = ch;
-    ReleaseBufferSetLength(nNewLength);
-  }
-
-  void Append(_In_ const CSimpleStringT& strSrc) {
-    Append(strSrc.GetString(), strSrc.GetLength());
-  }
-
-  _AMV_INSECURE_DEPRECATE(
-      "CSimpleStringT::CopyChars must be passed a buffer size")
-  static void __cdecl CopyChars(_Out_writes_(nChars) char* pchDest,
-                                _In_reads_opt_(nChars) const char* pchSrc,
-                                _In_ int nChars) throw() {
-    if (pchSrc != NULL) {
-      memcpy(pchDest, pchSrc, nChars * sizeof(char));
-    }
-  }
-
-  static void __cdecl CopyChars(_Out_writes_to_(nDestLen, nChars) char* pchDest,
-                                _In_ size_t nDestLen,
-                                _In_reads_opt_(nChars) const char* pchSrc,
-                                _In_ int nChars) throw() {
-    memcpy_s(pchDest, nDestLen * sizeof(char), pchSrc, nChars * sizeof(char));
-  }
-
-  _AMV_INSECURE_DEPRECATE(
-      "CSimpleStringT::CopyCharsOverlapped must be passed a buffer size")
-  static void __cdecl CopyCharsOverlapped(_Out_writes_(nChars) char* pchDest,
-                                          _In_reads_(nChars) const char* pchSrc,
-                                          _In_ int nChars) throw() {
-    memmove(pchDest, pchSrc, nChars * sizeof(char));
-  }
-
-  static void __cdecl CopyCharsOverlapped(
-      _Out_writes_to_(nDestLen, nDestLen) char* pchDest, _In_ size_t nDestLen,
-      _In_reads_(nChars) const char* pchSrc, _In_ int nChars) throw() {
-    memmove_s(pchDest, nDestLen * sizeof(char), pchSrc, nChars * sizeof(char));
-  }
-
-  void Empty() throw() {
-    BStringData* pOldData = GetData();
-    if (pOldData->nDataLength == 0) {
-      return;
-    }
-
-    if (pOldData->IsLocked()) {
-      // Don't reallocate a locked buffer that's shrinking
-      SetLength(0);
-    } else {
-      pOldData->Release();
-      Attach(pOldData->pStringMgr->GetNilString());
-    }
-  }
-
-  void FreeExtra() {
-    BStringData* pOldData = GetData();
-    int nLength = pOldData->nDataLength;
-    if (pOldData->nAllocLength == nLength) {
-      return;
-    }
-
-    // Don't reallocate a locked buffer that's shrinking
-    if (!pOldData->IsLocked()) {
-      BStringData* pNewData =
-          pOldData->pStringMgr->Allocate(nLength, sizeof(char));
-      if (pNewData == NULL) {
-        SetLength(nLength);
-        return;
-      }
-
-      CopyChars(static_cast<char*>(pNewData->data()), nLength,
-                static_cast<const char*>(pOldData->data()), nLength);
-
-      pOldData->Release();
-      Attach(pNewData);
-      SetLength(nLength);
-    }
-  }
-
-  int GetAllocLength() const throw() { return (GetData()->nAllocLength); }
-
-  char GetAt(_In_ int iChar) const {
-    // Indexing the '\0' is OK
-    AMVASSERT((iChar >= 0) && (iChar <= GetLength()));
-    if ((iChar < 0) || (iChar > GetLength())) AmvThrow("Invalid arguments");
-
-    return (m_pszData[iChar]);
-  }
-
-  char* GetBuffer() {
-    BStringData* pData = GetData();
-    if (pData->IsShared()) {
-      Fork(pData->nDataLength);
-    }
-
-    return (m_pszData);
-  }
-
-  char* GetBuffer(_In_ int nMinBufferLength) {
-    return (PrepareWrite(nMinBufferLength));
-  }
-
-  char* GetBufferSetLength(_In_ int nLength) {
-    SetLength(nLength);
-
-    return (GetBuffer(nLength));
-  }
-
-  int GetLength() const throw() { return (GetData()->nDataLength); }
-
-  IAmvStringMgr* GetManager() const throw() {
-    IAmvStringMgr* pStringMgr = GetData()->pStringMgr;
-    return pStringMgr ? pStringMgr->Clone() : NULL;
-  }
-
-  const char* GetString() const throw() { return (m_pszData); }
-
-  bool IsEmpty() const throw() { return (GetLength() == 0); }
-
-  char* LockBuffer() {
-    BStringData* pData = GetData();
-    if (pData->IsShared()) {
-      Fork(pData->nDataLength);
-      // Do it again, because the fork might have changed it
-      pData = GetData();
-    }
-    pData->Lock();
-
-    return (m_pszData);
-  }
-
-  void UnlockBuffer() throw() { GetData()->Unlock(); }
-
-  void Preallocate(_In_ int nLength) { PrepareWrite(nLength); }
-
-  void ReleaseBuffer(_In_ int nNewLength = -1) {
-    if (nNewLength == -1) {
-      nNewLength = StringLengthN(m_pszData, GetData()->nAllocLength);
-    }
-    SetLength(nNewLength);
-  }
-
-  void ReleaseBufferSetLength(_In_ int nNewLength) {
-    AMVASSERT(nNewLength >= 0);
-    SetLength(nNewLength);
-  }
-
-  void Truncate(_In_ int nNewLength) {
-    AMVASSERT(nNewLength <= GetLength());
-    GetBuffer(nNewLength);
-    ReleaseBufferSetLength(nNewLength);
-  }
-
-  void SetAt(_In_ int iChar, _In_ char ch) {
-    AMVASSERT((iChar >= 0) && (iChar < GetLength()));
-
-    if ((iChar < 0) || (iChar >= GetLength())) AmvThrow("Invalid arguments");
-
-    int nLength = GetLength();
-    char* pszBuffer = GetBuffer();
-    pszBuffer[iChar] = ch;
-    ReleaseBufferSetLength(nLength);
-  }
-
-  void SetManager(_Inout_ IAmvStringMgr* pStringMgr) {
-log1;
-    AMVASSERT(IsEmpty());
-
-    BStringData* pData = GetData();
-    pData->Release();
-    pData = pStringMgr->GetNilString();
-    Attach(pData);
-  }
-
-  void SetString(_In_opt_z_ const char* pszSrc) {
-    SetString(pszSrc, StringLength(pszSrc));
-  }
-=======
 namespace AMV
 {
 
@@ -486,10 +33,24 @@ namespace AMV
         virtual BStringData *Reallocate(BStringData * pData, int nAllocLength,
                                         int nCharSize) throw() = 0;
 
+        // Get the allocation length a string of nAllocLength chars grows to
+        // when it needs room for nLength chars
+        virtual int GetGrowLength(int nAllocLength, int nLength) throw() = 0;
+
         // Get the BStringData for a Nil string
         virtual BStringData *GetNilString() throw() = 0;
 
         virtual IAmvStringMgr *Clone() throw() = 0;
+
+#ifdef AMV_STRING_STATS
+        // Events only CSimpleStringT sees, for CAmvStatsStringMgr
+
+        // A write to a shared string made a private copy of nLength chars
+        virtual void OnFork(int nLength) throw() { (void)nLength; }
+
+        // FreeExtra() gave back nSavedChars of capacity
+        virtual void OnFreeExtra(int nSavedChars) throw() { (void)nSavedChars; }
+#endif
     };
 
     struct BStringData
@@ -501,20 +62,53 @@ namespace AMV
         // Length of allocated data in chars (not including terminating null)
         int nAllocLength;
         // Reference count: negative == locked
-        int64_t nRefs;
+        int nRefs;
+        // THREAD_CONFINED or 0, set by the manager that allocated the data.  The
+        // bits from 8 up are left to that manager (CAmvStatsStringMgr).
+        int nFlags;
+#ifdef AMV_STRING_CACHE_HASH
+        // AmvHash() of the chars, 0 when not known yet.  Every writer drops it
+        // before touching the chars; a shared buffer is never written, so its
+        // copies compute the hash once between them.
+        uint64_t nHash;
+#endif
+
+        void ResetHash() throw()
+        {
+#ifdef AMV_STRING_CACHE_HASH
+            nHash = 0;
+#endif
+        }
+
+        // The strings never leave the thread that made them, so the reference
+        // count is a plain int
+        static const int THREAD_CONFINED = 0x1;
 
         void *data() throw() { return (this + 1); }
 
         void AddRef() throw()
         {
-            AMVASSERT(nRefs > 0);
+            AMVASSERT(__atomic_load_n(&nRefs, __ATOMIC_RELAXED) > 0);
 
-            _InterlockedIncrement(&nRefs);
+            if (nFlags & THREAD_CONFINED)
+            {
+                nRefs++;
+            }
+            else
+            {
+                // The caller holds a reference already, so nothing to order
+                __atomic_fetch_add(&nRefs, 1, __ATOMIC_RELAXED);
+            }
         }
 
-        bool IsLocked() const throw() { return nRefs < 0; }
+        bool IsLocked() const throw() { return (__atomic_load_n(&nRefs, __ATOMIC_RELAXED) < 0); }
 
-        bool IsShared() const throw() { return (nRefs > 1); }
+        // Acquire pairs with the release in Release(): once we are the only
+        // owner, the writes of the owners that left are visible
+        bool IsShared() const throw()
+        {
+            return (__atomic_load_n(&nRefs, __ATOMIC_ACQUIRE) > 1);
+        }
 
         void Lock() throw()
         {
@@ -530,10 +124,18 @@ namespace AMV
 
         void Release() throw()
         {
-            AMVASSERT(nRefs != 0);
+            AMVASSERT(__atomic_load_n(&nRefs, __ATOMIC_RELAXED) != 0);
 
-            if (_InterlockedDecrement(&nRefs) <= 0)
+            if (nFlags & THREAD_CONFINED)
             {
+                if (--nRefs <= 0)
+                {
+                    pStringMgr->Free(this);
+                }
+            }
+            else if (__atomic_sub_fetch(&nRefs, 1, __ATOMIC_ACQ_REL) <= 0)
+            {
+                // Acquire: the last owner sees the writes of all the others
                 pStringMgr->Free(this);
             }
         }
@@ -562,8 +164,10 @@ namespace AMV
             pStringMgr = NULL;
             // Never gets freed by IAmvStringMgr
             nRefs = 2;
+            nFlags = 0;
             nDataLength = 0;
             nAllocLength = 0;
+            ResetHash();
             achNil[0] = 0;
             achNil[1] = 0;
         }
@@ -578,6 +182,36 @@ namespace AMV
         wchar_t achNil[2];
     };
 
+#ifndef AMV_SSO_CAPACITY
+// Strings of up to AMV_SSO_CAPACITY chars are kept inside the CSimpleStringT
+// object instead of a BStringData allocated by the IAmvStringMgr.  Wider
+// chars get the same bytes, so fewer of them (CSimpleStringT::SSO_CAPACITY).
+#define AMV_SSO_CAPACITY 23
+#endif
+
+    // Small string storage embedded in CSimpleStringT.  The header is laid out
+    // like any other BStringData, so GetData() and the buffer functions work on
+    // it unchanged.  It is owned by one string: never shared and never freed.
+    template <int t_nChars, typename XCHAR = char>
+    class CInlineStringData : public BStringData
+    {
+    public:
+        void Init(_In_ IAmvStringMgr *pMgr) throw()
+        {
+            pStringMgr = pMgr;
+            nRefs = 1;
+            nFlags = 0;
+            nDataLength = 0;
+            nAllocLength = t_nChars;
+            ResetHash();
+            achData[0] = 0;
+            AMVASSERT(data() == achData);
+        }
+
+    private:
+        XCHAR achData[t_nChars + 1];
+    };
+
     template <typename TCharType>
     class CStrBufT;
     template <typename BaseType, const int t_nSize>
@@ -602,28 +236,43 @@ namespace AMV
     class CSimpleStringT
     {
     public:
+        typedef BaseType XCHAR;
+        typedef BaseType *PXSTR;
+        typedef const BaseType *PCXSTR;
+
+        // AMV_SSO_CAPACITY for char
+        static constexpr int SSO_CAPACITY =
+            static_cast<int>((AMV_SSO_CAPACITY + 1) / sizeof(XCHAR)) - 1;
+
         explicit CSimpleStringT(_Inout_ IAmvStringMgr *pStringMgr)
         {
             AMVENSURE(pStringMgr != NULL);
-            Attach(pStringMgr->GetNilString());
+            AttachInline(pStringMgr);
         }
 
         explicit CSimpleStringT(_In_ const CSimpleStringT &strSrc)
         {
-            Attach(CloneData(strSrc.GetData()));
+            AttachData(CloneData(strSrc.GetData()));
         }
 
-        CSimpleStringT(_In_z_ const char *pszSrc, _Inout_ IAmvStringMgr *pStringMgr)
+        // Takes the buffer of strSrc without touching its reference count.
+        // strSrc is left empty, with the same manager.
+        CSimpleStringT(_Inout_ CSimpleStringT &&strSrc) noexcept
+        {
+            TakeData(strSrc);
+        }
+
+        CSimpleStringT(_In_z_ const XCHAR *pszSrc, _Inout_ IAmvStringMgr *pStringMgr)
         {
             AMVENSURE(pStringMgr != NULL);
 
             int nLength = StringLength(pszSrc);
-            BStringData *pData = pStringMgr->Allocate(nLength, sizeof(char));
+            BStringData *pData = AllocateData(pStringMgr, nLength);
             if (pData == NULL)
             {
                 ThrowMemoryException();
             }
-            Attach(pData);
+            AttachData(pData);
             SetLength(nLength);
             CopyChars(m_pszData, nLength, pszSrc, nLength);
         }
@@ -637,22 +286,29 @@ namespace AMV
             if (puchSrc == NULL && nLength != 0)
                 AmvThrow("Invalid arguments");
 
-            BStringData *pData = pStringMgr->Allocate(nLength, sizeof(char));
+            BStringData *pData = AllocateData(pStringMgr, nLength);
             if (pData == NULL)
             {
                 ThrowMemoryException();
             }
-            Attach(pData);
+            AttachData(pData);
             SetLength(nLength);
-            CopyChars(m_pszData, nLength, reinterpret_cast<const char *>(puchSrc),
-                      nLength);
+            if constexpr (sizeof(XCHAR) == 1)
+            {
+                CopyChars(m_pszData, nLength, reinterpret_cast<const XCHAR *>(puchSrc),
+                          nLength);
+            }
+            else
+            {
+                // One char per byte
+                for (int i = 0; i < nLength; i++)
+                {
+                    m_pszData[i] = static_cast<XCHAR>(puchSrc[i]);
+                }
+            }
         }
 
-        ~CSimpleStringT() throw()
-        {
-            BStringData *pData = GetData();
-            pData->Release();
-        }
+        ~CSimpleStringT() throw() { ReleaseData(GetData()); }
 
         // operator CSimpleStringT<BaseType>&() {
         //   std::cout << __FILE__ << " | " << __LINE__ << std::endl;
@@ -674,15 +330,39 @@ namespace AMV
                 else
                 {
                     BStringData *pNewData = CloneData(pSrcData);
-                    pOldData->Release();
-                    Attach(pNewData);
+                    ReleaseData(pOldData);
+                    AttachData(pNewData);
                 }
             }
 
             return (*this);
         }
 
-        CSimpleStringT &operator=(_In_opt_z_ const char *pszSrc)
+        // Never allocates: the buffer of strSrc comes over with its manager,
+        // also from another manager.  A locked buffer of ours keeps its place
+        // when strSrc fits into it; otherwise the lock ends with the buffer.
+        CSimpleStringT &operator=(_Inout_ CSimpleStringT &&strSrc) noexcept
+        {
+            if (&strSrc != this)
+            {
+                BStringData *pOldData = GetData();
+                if (pOldData->IsLocked() &&
+                    strSrc.GetLength() <= pOldData->nAllocLength)
+                {
+                    SetString(strSrc.GetString(), strSrc.GetLength());
+                    strSrc.Empty();
+                }
+                else
+                {
+                    TakeData(strSrc);
+                    ReleaseData(pOldData);
+                }
+            }
+
+            return (*this);
+        }
+
+        CSimpleStringT &operator=(_In_opt_z_ const XCHAR *pszSrc)
         {
 
             SetString(pszSrc);
@@ -697,33 +377,33 @@ namespace AMV
             return (*this);
         }
 
-        CSimpleStringT &operator+=(_In_z_ const char *pszSrc)
+        CSimpleStringT &operator+=(_In_z_ const XCHAR *pszSrc)
         {
             Append(pszSrc);
 
             return (*this);
         }
         template <int t_nSize>
-        CSimpleStringT &operator+=(_In_ const CStaticString<char, t_nSize> &strSrc)
+        CSimpleStringT &operator+=(_In_ const CStaticString<XCHAR, t_nSize> &strSrc)
         {
-            Append(static_cast<const char *>(strSrc), strSrc.GetLength());
+            Append(static_cast<const XCHAR *>(strSrc), strSrc.GetLength());
 
             return (*this);
         }
-        CSimpleStringT &operator+=(_In_ char ch)
+        CSimpleStringT &operator+=(_In_ XCHAR ch)
         {
-            AppendChar(static_cast<char>(ch));
+            AppendChar(static_cast<XCHAR>(ch));
 
             return (*this);
         }
         CSimpleStringT &operator+=(_In_ unsigned char ch)
         {
-            AppendChar(static_cast<char>(ch));
+            AppendChar(static_cast<XCHAR>(ch));
 
             return (*this);
         }
 
-        char operator[](_In_ int iChar) const
+        XCHAR operator[](_In_ int iChar) const
         {
             // Indexing the '\0' is OK
             AMVASSERT((iChar >= 0) && (iChar <= GetLength()));
@@ -740,10 +420,10 @@ namespace AMV
         //   return (m_pszData);
         // }
 
-        operator const char *() const throw()
+        operator const XCHAR *() const throw()
         {
 
-            return const_cast<const char *>(m_pszData);
+            return const_cast<const XCHAR *>(m_pszData);
         }
 
         // operator const void*() const throw() {
@@ -751,12 +431,12 @@ namespace AMV
         //   return reinterpret_cast<const void *>(m_pszData);
         // }
 
-        void Append(_In_z_ const char *pszSrc)
+        void Append(_In_z_ const XCHAR *pszSrc)
         {
             Append(pszSrc, StringLength(pszSrc));
         }
 
-        void Append(_In_reads_(nLength) const char *pszSrc, _In_ int nLength)
+        void Append(_In_reads_(nLength) const XCHAR *pszSrc, _In_ int nLength)
         {
             // See comment in SetString() about why we do this
             UINT_PTR nOffset = pszSrc - GetString();
@@ -777,10 +457,9 @@ namespace AMV
             // Make sure after the string doesn't exceed INT_MAX after appending
             AMVENSURE_THROW(INT_MAX - nLength >= static_cast<int>(nOldLength),
                             "Invalid arguments");
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/amvsimpstr.h
 
             int nNewLength = nOldLength + nLength;
-            char *pszBuffer = GetBuffer(nNewLength);
+            XCHAR *pszBuffer = GetBuffer(nNewLength);
             if (nOffset <= nOldLength)
             {
                 pszSrc = pszBuffer + nOffset;
@@ -791,11 +470,11 @@ namespace AMV
             ReleaseBufferSetLength(nNewLength);
         }
 
-        void AppendChar(_In_ char ch)
+        void AppendChar(_In_ XCHAR ch)
         {
             UINT nOldLength = GetLength();
             int nNewLength = nOldLength + 1;
-            char *pszBuffer = GetBuffer(nNewLength);
+            XCHAR *pszBuffer = GetBuffer(nNewLength);
             pszBuffer[nOldLength] = ch;
             ReleaseBufferSetLength(nNewLength);
         }
@@ -807,38 +486,38 @@ namespace AMV
 
         _AMV_INSECURE_DEPRECATE(
             "CSimpleStringT::CopyChars must be passed a buffer size")
-        static void __cdecl CopyChars(_Out_writes_(nChars) char *pchDest,
-                                      _In_reads_opt_(nChars) const char *pchSrc,
+        static void __cdecl CopyChars(_Out_writes_(nChars) XCHAR *pchDest,
+                                      _In_reads_opt_(nChars) const XCHAR *pchSrc,
                                       _In_ int nChars) throw()
         {
             if (pchSrc != NULL)
             {
-                memcpy(pchDest, pchSrc, nChars * sizeof(char));
+                memcpy(pchDest, pchSrc, nChars * sizeof(XCHAR));
             }
         }
 
-        static void __cdecl CopyChars(_Out_writes_to_(nDestLen, nChars) char *pchDest,
+        static void __cdecl CopyChars(_Out_writes_to_(nDestLen, nChars) XCHAR *pchDest,
                                       _In_ size_t nDestLen,
-                                      _In_reads_opt_(nChars) const char *pchSrc,
+                                      _In_reads_opt_(nChars) const XCHAR *pchSrc,
                                       _In_ int nChars) throw()
         {
-            memcpy_s(pchDest, nDestLen * sizeof(char), pchSrc, nChars * sizeof(char));
+            memcpy_s(pchDest, nDestLen * sizeof(XCHAR), pchSrc, nChars * sizeof(XCHAR));
         }
 
         _AMV_INSECURE_DEPRECATE(
             "CSimpleStringT::CopyCharsOverlapped must be passed a buffer size")
-        static void __cdecl CopyCharsOverlapped(_Out_writes_(nChars) char *pchDest,
-                                                _In_reads_(nChars) const char *pchSrc,
+        static void __cdecl CopyCharsOverlapped(_Out_writes_(nChars) XCHAR *pchDest,
+                                                _In_reads_(nChars) const XCHAR *pchSrc,
                                                 _In_ int nChars) throw()
         {
-            memmove(pchDest, pchSrc, nChars * sizeof(char));
+            memmove(pchDest, pchSrc, nChars * sizeof(XCHAR));
         }
 
         static void __cdecl CopyCharsOverlapped(
-            _Out_writes_to_(nDestLen, nDestLen) char *pchDest, _In_ size_t nDestLen,
-            _In_reads_(nChars) const char *pchSrc, _In_ int nChars) throw()
+            _Out_writes_to_(nDestLen, nDestLen) XCHAR *pchDest, _In_ size_t nDestLen,
+            _In_reads_(nChars) const XCHAR *pchSrc, _In_ int nChars) throw()
         {
-            memmove_s(pchDest, nDestLen * sizeof(char), pchSrc, nChars * sizeof(char));
+            memmove_s(pchDest, nDestLen * sizeof(XCHAR), pchSrc, nChars * sizeof(XCHAR));
         }
 
         void Empty() throw()
@@ -856,8 +535,9 @@ namespace AMV
             }
             else
             {
-                pOldData->Release();
-                Attach(pOldData->pStringMgr->GetNilString());
+                IAmvStringMgr *pStringMgr = pOldData->pStringMgr;
+                ReleaseData(pOldData);
+                AttachInline(pStringMgr);
             }
         }
 
@@ -865,7 +545,7 @@ namespace AMV
         {
             BStringData *pOldData = GetData();
             int nLength = pOldData->nDataLength;
-            if (pOldData->nAllocLength == nLength)
+            if (pOldData->nAllocLength == nLength || IsInline())
             {
                 return;
             }
@@ -873,26 +553,31 @@ namespace AMV
             // Don't reallocate a locked buffer that's shrinking
             if (!pOldData->IsLocked())
             {
-                BStringData *pNewData =
-                    pOldData->pStringMgr->Allocate(nLength, sizeof(char));
+                BStringData *pNewData = AllocateData(pOldData->pStringMgr, nLength);
                 if (pNewData == NULL)
                 {
                     SetLength(nLength);
                     return;
                 }
 
-                CopyChars(static_cast<char *>(pNewData->data()), nLength,
-                          static_cast<const char *>(pOldData->data()), nLength);
+                CopyChars(static_cast<XCHAR *>(pNewData->data()), nLength,
+                          static_cast<const XCHAR *>(pOldData->data()), nLength);
+#ifdef AMV_STRING_STATS
+                // Inline storage gives back the whole block
+                int nNewAllocLength = (pNewData == &m_inline) ? 0 : pNewData->nAllocLength;
+                pNewData->pStringMgr->OnFreeExtra(pOldData->nAllocLength - nNewAllocLength);
+#endif
 
-                pOldData->Release();
-                Attach(pNewData);
+                ReleaseData(pOldData);
+                AttachData(pNewData);
                 SetLength(nLength);
             }
         }
 
+        // Capacity in chars (not including terminating null), inline or not
         int GetAllocLength() const throw() { return (GetData()->nAllocLength); }
 
-        char GetAt(_In_ int iChar) const
+        XCHAR GetAt(_In_ int iChar) const
         {
             // Indexing the '\0' is OK
             AMVASSERT((iChar >= 0) && (iChar <= GetLength()));
@@ -902,27 +587,29 @@ namespace AMV
             return (m_pszData[iChar]);
         }
 
-        char *GetBuffer()
+        XCHAR *GetBuffer()
         {
             BStringData *pData = GetData();
             if (pData->IsShared())
             {
                 Fork(pData->nDataLength);
             }
+            GetData()->ResetHash();
 
             return (m_pszData);
         }
 
-        char *GetBuffer(_In_ int nMinBufferLength)
+        XCHAR *GetBuffer(_In_ int nMinBufferLength)
         {
             return (PrepareWrite(nMinBufferLength));
         }
 
-        char *GetBufferSetLength(_In_ int nLength)
+        XCHAR *GetBufferSetLength(_In_ int nLength)
         {
+            XCHAR *pszBuffer = GetBuffer(nLength);
             SetLength(nLength);
 
-            return (GetBuffer(nLength));
+            return (pszBuffer);
         }
 
         int GetLength() const throw() { return (GetData()->nDataLength); }
@@ -933,11 +620,41 @@ namespace AMV
             return pStringMgr ? pStringMgr->Clone() : NULL;
         }
 
-        const char *GetString() const throw() { return (m_pszData); }
+        const XCHAR *GetString() const throw() { return (m_pszData); }
 
         bool IsEmpty() const throw() { return (GetLength() == 0); }
 
-        char *LockBuffer()
+        // true if the string is stored inside this object (small string)
+        bool IsInline() const throw() { return (GetData() == &m_inline); }
+
+        // true if other strings share the buffer, so a write makes a copy
+        bool IsShared() const throw() { return (GetData()->IsShared()); }
+
+        // AmvHash() of the chars.  With AMV_STRING_CACHE_HASH the value is kept
+        // in the buffer until the next write, and copies sharing the buffer
+        // share it.  A locked buffer may be written behind our back, so it is
+        // always hashed afresh.
+        uint64_t GetHash() const throw()
+        {
+#ifdef AMV_STRING_CACHE_HASH
+            BStringData *pData = GetData();
+            uint64_t nHash = __atomic_load_n(&pData->nHash, __ATOMIC_RELAXED);
+            if (nHash == 0)
+            {
+                nHash = AmvHash(m_pszData, pData->nDataLength);
+                if (!pData->IsLocked())
+                {
+                    // Racing readers store the same value
+                    __atomic_store_n(&pData->nHash, nHash, __ATOMIC_RELAXED);
+                }
+            }
+            return (nHash);
+#else
+            return (AmvHash(m_pszData, GetLength()));
+#endif
+        }
+
+        XCHAR *LockBuffer()
         {
             BStringData *pData = GetData();
             if (pData->IsShared())
@@ -947,14 +664,84 @@ namespace AMV
                 pData = GetData();
             }
             pData->Lock();
+            pData->ResetHash();
 
             return (m_pszData);
         }
 
         void UnlockBuffer() throw() { GetData()->Unlock(); }
 
+        /* Hands the buffer over to the caller, who then owns one reference and
+         * either passes it to Attach() or calls Release() on it.  The string is
+         * left empty.  Only small strings need an allocation here; an empty
+         * string returns the manager's Nil string. */
+        BStringData *Detach()
+        {
+            BStringData *pData = GetData();
+            IAmvStringMgr *pStringMgr = pData->pStringMgr;
+            AMVASSERT(!pData->IsLocked());
+
+            if (pData->nDataLength == 0)
+            {
+                ReleaseData(pData);
+                pData = pStringMgr->GetNilString();
+            }
+            else if (IsInline() || !IsSharable(pData))
+            {
+                BStringData *pNewData = pStringMgr->Clone()->Allocate(pData->nDataLength,
+                                                                      sizeof(XCHAR));
+                if (pNewData == NULL)
+                {
+                    ThrowMemoryException();
+                }
+                // Copy '\0'
+                CopyChars(static_cast<XCHAR *>(pNewData->data()),
+                          pData->nDataLength + 1,
+                          static_cast<const XCHAR *>(pData->data()),
+                          pData->nDataLength + 1);
+                pNewData->nDataLength = pData->nDataLength;
+                pNewData->ResetHash();
+                ReleaseData(pData);
+                pData = pNewData;
+            }
+            AttachInline(pStringMgr);
+
+            return (pData);
+        }
+
+        // Takes over one reference of pData, usually from Detach()
+        void Attach(_Inout_ BStringData *pData) throw()
+        {
+            AMVASSERT(pData != NULL && pData != GetData());
+
+            ReleaseData(GetData());
+            AttachData(pData);
+        }
+
         void Preallocate(_In_ int nLength) { PrepareWrite(nLength); }
 
+        // Makes room for exactly nLength chars, without the growth policy of
+        // Preallocate().  Never shrinks and leaves the content as it is.
+        void Reserve(_In_ int nLength)
+        {
+            if (nLength < 0)
+                AmvThrow("Invalid arguments");
+
+            BStringData *pData = GetData();
+            if (nLength < pData->nDataLength)
+            {
+                nLength = pData->nDataLength;
+            }
+            if (pData->IsShared())
+            {
+                Fork(nLength);
+            }
+            else if (pData->nAllocLength < nLength)
+            {
+                Reallocate(nLength);
+            }
+        }
+
         void ReleaseBuffer(_In_ int nNewLength = -1)
         {
             if (nNewLength == -1)
@@ -977,7 +764,7 @@ namespace AMV
             ReleaseBufferSetLength(nNewLength);
         }
 
-        void SetAt(_In_ int iChar, _In_ char ch)
+        void SetAt(_In_ int iChar, _In_ XCHAR ch)
         {
             AMVASSERT((iChar >= 0) && (iChar < GetLength()));
 
@@ -985,7 +772,7 @@ namespace AMV
                 AmvThrow("Invalid arguments");
 
             int nLength = GetLength();
-            char *pszBuffer = GetBuffer();
+            XCHAR *pszBuffer = GetBuffer();
             pszBuffer[iChar] = ch;
             ReleaseBufferSetLength(nLength);
         }
@@ -995,18 +782,16 @@ namespace AMV
             log1;
             AMVASSERT(IsEmpty());
 
-            BStringData *pData = GetData();
-            pData->Release();
-            pData = pStringMgr->GetNilString();
-            Attach(pData);
+            ReleaseData(GetData());
+            AttachInline(pStringMgr);
         }
 
-        void SetString(_In_opt_z_ const char *pszSrc)
+        void SetString(_In_opt_z_ const XCHAR *pszSrc)
         {
             SetString(pszSrc, StringLength(pszSrc));
         }
 
-        void SetString(_In_reads_opt_(nLength) const char *pszSrc, _In_ int nLength)
+        void SetString(_In_reads_opt_(nLength) const XCHAR *pszSrc, _In_ int nLength)
         {
             if (nLength == 0)
             {
@@ -1020,124 +805,6 @@ namespace AMV
        * aliasing, and modify pszSrc to point into the newly allocated buffer
        * instead.*/
 
-<<<<<<< HEAD:include/amvsimpstr.hpp
-      if (pszSrc == NULL) AmvThrow("Invalid arguments");
-
-      UINT nOldLength = GetLength();
-      UINT_PTR nOffset = pszSrc - GetString();
-      // If 0 <= nOffset <= nOldLength, then pszSrc points into our
-      // buffer
-
-      char* pszBuffer = GetBuffer(nLength);
-      if (nOffset <= nOldLength) {
-        CopyCharsOverlapped(pszBuffer, GetAllocLength(), pszBuffer + nOffset,
-                            nLength);
-      } else {
-        CopyChars(pszBuffer, GetAllocLength(), pszSrc, nLength);
-      }
-      ReleaseBufferSetLength(nLength);
-    }
-  }
-
- public:
-  friend CSimpleStringT operator+(_In_ const CSimpleStringT& str1,
-                                  _In_ const CSimpleStringT& str2) {
-    CSimpleStringT s(str1.GetManager());
-
-    Concatenate(s, str1, str1.GetLength(), str2, str2.GetLength());
-
-    return (s);
-  }
-
-  friend CSimpleStringT operator+(_In_ const CSimpleStringT& str1,
-                                  _In_z_ const char* psz2) {
-    CSimpleStringT s(str1.GetManager());
-
-    Concatenate(s, str1, str1.GetLength(), psz2, StringLength(psz2));
-
-    return (s);
-  }
-
-  friend CSimpleStringT operator+(_In_z_ const char* psz1,
-                                  _In_ const CSimpleStringT& str2) {
-    CSimpleStringT s(str2.GetManager());
-
-    Concatenate(s, psz1, StringLength(psz1), str2, str2.GetLength());
-
-    return (s);
-  }
-
-  static int __cdecl StringLength(_In_opt_z_ const char* psz) throw() {
-    if (psz == NULL) {
-      return (0);
-    }
-    return (static_cast<int>(strlen(psz)));
-  }
-
-  static int __cdecl StringLengthN(_In_reads_opt_z_(sizeInXChar)
-                                       const char* psz,
-                                   _In_ size_t sizeInXChar) throw() {
-    if (psz == NULL) {
-      return (0);
-    }
-    return (static_cast<int>(strnlen(psz, sizeInXChar)));
-  }
-
- protected:
-  // Todo(jpk, 20200118): strResult는 const가 붙으면 안됨? 뭘 수정하는 게 있나?
-  static void __cdecl Concatenate(_Inout_ CSimpleStringT& strResult,
-                                  _In_reads_(nLength1) const char* psz1,
-                                  _In_ int nLength1,
-                                  _In_reads_(nLength2) const char* psz2,
-                                  _In_ int nLength2) {
-    int nNewLength = nLength1 + nLength2;
-    char* pszBuffer = strResult.GetBuffer(nNewLength);
-    CopyChars(pszBuffer, nLength1, psz1, nLength1);
-    CopyChars(pszBuffer + nLength1, nLength2, psz2, nLength2);
-    strResult.ReleaseBufferSetLength(nNewLength);
-  }
-
-  AMV_NOINLINE __declspec(noreturn) static void __cdecl ThrowMemoryException() {
-    AmvThrow("Out of memory");
-  }
-
-  // Implementation
- private:
-  void Attach(_Inout_ BStringData* pData) throw() {
-    m_pszData = static_cast<char*>(pData->data());
-  }
-
-  AMV_NOINLINE void Fork(_In_ int nLength) {
-    BStringData* pOldData = GetData();
-    int nOldLength = pOldData->nDataLength;
-    BStringData* pNewData =
-        pOldData->pStringMgr->Clone()->Allocate(nLength, sizeof(char));
-    if (pNewData == NULL) {
-      ThrowMemoryException();
-    }
-    // Copy '\0'
-    int nCharsToCopy = ((nOldLength < nLength) ? nOldLength : nLength) + 1;
-    CopyChars(static_cast<char*>(pNewData->data()), nCharsToCopy,
-              static_cast<const char*>(pOldData->data()), nCharsToCopy);
-    pNewData->nDataLength = nOldLength;
-    pOldData->Release();
-    Attach(pNewData);
-  }
-
-  BStringData* GetData() const throw() {
-    return (reinterpret_cast<BStringData*>(m_pszData) - 1);
-  }
-
-  char* PrepareWrite(_In_ int nLength) {
-    if (nLength < 0) AmvThrow("Invalid arguments");
-
-    BStringData* pOldData = GetData();
-    // nShared < 0 means true, >= 0 means false
-    int nShared = 1 - pOldData->nRefs;
-    // nTooShort < 0 means true, >= 0 means false
-    int nTooShort = pOldData->nAllocLength - nLength;
-    /* If either sign bit is set (i.e. either is less than zero), we need to
-=======
                 if (pszSrc == NULL)
                     AmvThrow("Invalid arguments");
 
@@ -1146,7 +813,7 @@ namespace AMV
                 // If 0 <= nOffset <= nOldLength, then pszSrc points into our
                 // buffer
 
-                char *pszBuffer = GetBuffer(nLength);
+                XCHAR *pszBuffer = GetBuffer(nLength);
                 if (nOffset <= nOldLength)
                 {
                     CopyCharsOverlapped(pszBuffer, GetAllocLength(), pszBuffer + nOffset,
@@ -1172,7 +839,7 @@ namespace AMV
         }
 
         friend CSimpleStringT operator+(_In_ const CSimpleStringT &str1,
-                                        _In_z_ const char *psz2)
+                                        _In_z_ const XCHAR *psz2)
         {
             CSimpleStringT s(str1.GetManager());
 
@@ -1181,7 +848,7 @@ namespace AMV
             return (s);
         }
 
-        friend CSimpleStringT operator+(_In_z_ const char *psz1,
+        friend CSimpleStringT operator+(_In_z_ const XCHAR *psz1,
                                         _In_ const CSimpleStringT &str2)
         {
             CSimpleStringT s(str2.GetManager());
@@ -1191,41 +858,71 @@ namespace AMV
             return (s);
         }
 
-        static int __cdecl StringLength(_In_opt_z_ const char *psz) throw()
+        static int __cdecl StringLength(_In_opt_z_ const XCHAR *psz) throw()
         {
             if (psz == NULL)
             {
                 return (0);
             }
-            return (static_cast<int>(strlen(psz)));
+            return (static_cast<int>(std::char_traits<XCHAR>::length(psz)));
         }
 
         static int __cdecl StringLengthN(_In_reads_opt_z_(sizeInXChar)
-                                             const char *psz,
+                                             const XCHAR *psz,
                                          _In_ size_t sizeInXChar) throw()
         {
             if (psz == NULL)
             {
                 return (0);
             }
-            return (static_cast<int>(strnlen(psz, sizeInXChar)));
+            if constexpr (std::is_same<XCHAR, char>::value)
+            {
+                return (static_cast<int>(strnlen(psz, sizeInXChar)));
+            }
+            else
+            {
+                size_t nLength = 0;
+                while (nLength < sizeInXChar && psz[nLength] != 0)
+                {
+                    nLength++;
+                }
+                return (static_cast<int>(nLength));
+            }
         }
 
     protected:
         // Todo(jpk, 20200118): strResult는 const가 붙으면 안됨? 뭘 수정하는 게 있나?
         static void __cdecl Concatenate(_Inout_ CSimpleStringT &strResult,
-                                        _In_reads_(nLength1) const char *psz1,
+                                        _In_reads_(nLength1) const XCHAR *psz1,
                                         _In_ int nLength1,
-                                        _In_reads_(nLength2) const char *psz2,
+                                        _In_reads_(nLength2) const XCHAR *psz2,
                                         _In_ int nLength2)
         {
             int nNewLength = nLength1 + nLength2;
-            char *pszBuffer = strResult.GetBuffer(nNewLength);
+            XCHAR *pszBuffer = strResult.GetBuffer(nNewLength);
             CopyChars(pszBuffer, nLength1, psz1, nLength1);
             CopyChars(pszBuffer + nLength1, nLength2, psz2, nLength2);
             strResult.ReleaseBufferSetLength(nNewLength);
         }
 
+        /* For a string built from this one with GetManager(): takes its buffer
+         * when the move assignment would, but copies the chars into ours when
+         * ours is locked or our manager clones to another one
+         * (CAmvFixedStringMgr), so that those keep their buffer. */
+        void TakeString(_Inout_ CSimpleStringT &strSrc)
+        {
+            BStringData *pOldData = GetData();
+            if (pOldData->IsLocked() ||
+                strSrc.GetData()->pStringMgr != pOldData->pStringMgr)
+            {
+                SetString(strSrc.GetString(), strSrc.GetLength());
+            }
+            else
+            {
+                operator=(std::move(strSrc));
+            }
+        }
+
         AMV_NOINLINE __declspec(noreturn) static void __cdecl ThrowMemoryException()
         {
             AmvThrow("Out of memory");
@@ -1233,9 +930,76 @@ namespace AMV
 
         // Implementation
     private:
-        void Attach(_Inout_ BStringData *pData) throw()
+        void AttachData(_Inout_ BStringData *pData) throw()
+        {
+            m_pszData = static_cast<XCHAR *>(pData->data());
+        }
+
+        void AttachInline(_In_ IAmvStringMgr *pStringMgr) throw()
         {
-            m_pszData = static_cast<char *>(pData->data());
+            m_inline.Init(pStringMgr);
+            AttachData(&m_inline);
+        }
+
+        // Moves the data of strSrc here, replacing whatever we hold without
+        // releasing it
+        void TakeData(_Inout_ CSimpleStringT &strSrc) throw()
+        {
+            BStringData *pSrcData = strSrc.GetData();
+            IAmvStringMgr *pStringMgr = pSrcData->pStringMgr;
+            // CAmvFixedStringT never lets its buffer be moved from
+            AMVASSERT(strSrc.IsInline() || IsSharable(pSrcData));
+
+            if (strSrc.IsInline())
+            {
+                m_inline.Init(pStringMgr);
+                // Copy '\0'
+                CopyChars(static_cast<XCHAR *>(m_inline.data()), SSO_CAPACITY + 1,
+                          static_cast<const XCHAR *>(pSrcData->data()),
+                          pSrcData->nDataLength + 1);
+                m_inline.nDataLength = pSrcData->nDataLength;
+                m_inline.nRefs = pSrcData->nRefs;
+                AttachData(&m_inline);
+            }
+            else
+            {
+                AttachData(pSrcData);
+            }
+            strSrc.AttachInline(pStringMgr);
+        }
+
+        /* A manager that clones to another manager owns buffers tied to one
+         * string (CAmvFixedStringMgr): those are copied, never shared or
+         * handed over. */
+        static bool IsSharable(_In_ const BStringData *pData) throw()
+        {
+            return (pData->pStringMgr->Clone() == pData->pStringMgr);
+        }
+
+        /* Returns the inline storage for short strings and asks pStringMgr for
+         * the rest.  Whatever the inline storage held is discarded, so the
+         * caller must not need it any more. */
+        BStringData *AllocateData(_In_ IAmvStringMgr *pStringMgr, _In_ int nLength)
+        {
+            if (nLength <= SSO_CAPACITY)
+            {
+                m_inline.Init(pStringMgr);
+                return &m_inline;
+            }
+            BStringData *pData = pStringMgr->Allocate(nLength, sizeof(XCHAR));
+            if (pData != NULL)
+            {
+                pData->ResetHash();
+            }
+            return pData;
+        }
+
+        void ReleaseData(_Inout_ BStringData *pData) throw()
+        {
+            if (pData != &m_inline)
+            {
+                pData->Release();
+            }
         }
 
         AMV_NOINLINE void Fork(_In_ int nLength)
@@ -1243,18 +1007,21 @@ namespace AMV
             BStringData *pOldData = GetData();
             int nOldLength = pOldData->nDataLength;
             BStringData *pNewData =
-                pOldData->pStringMgr->Clone()->Allocate(nLength, sizeof(char));
+                AllocateData(pOldData->pStringMgr->Clone(), nLength);
             if (pNewData == NULL)
             {
                 ThrowMemoryException();
             }
             // Copy '\0'
             int nCharsToCopy = ((nOldLength < nLength) ? nOldLength : nLength) + 1;
-            CopyChars(static_cast<char *>(pNewData->data()), nCharsToCopy,
-                      static_cast<const char *>(pOldData->data()), nCharsToCopy);
+            CopyChars(static_cast<XCHAR *>(pNewData->data()), nCharsToCopy,
+                      static_cast<const XCHAR *>(pOldData->data()), nCharsToCopy);
             pNewData->nDataLength = nOldLength;
-            pOldData->Release();
-            Attach(pNewData);
+#ifdef AMV_STRING_STATS
+            pNewData->pStringMgr->OnFork(nLength);
+#endif
+            ReleaseData(pOldData);
+            AttachData(pNewData);
         }
 
         BStringData *GetData() const throw()
@@ -1262,7 +1029,7 @@ namespace AMV
             return (reinterpret_cast<BStringData *>(m_pszData) - 1);
         }
 
-        char *PrepareWrite(_In_ int nLength)
+        XCHAR *PrepareWrite(_In_ int nLength)
         {
             if (nLength < 0)
                 AmvThrow("Invalid arguments");
@@ -1273,12 +1040,12 @@ namespace AMV
             // nTooShort < 0 means true, >= 0 means false
             int nTooShort = pOldData->nAllocLength - nLength;
             /* If either sign bit is set (i.e. either is less than zero), we need to
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/amvsimpstr.h
      * copy data */
             if ((nShared | nTooShort) < 0)
             {
                 PrepareWrite2(nLength);
             }
+            GetData()->ResetHash();
 
             return (m_pszData);
         }
@@ -1296,17 +1063,9 @@ namespace AMV
             }
             else if (pOldData->nAllocLength < nLength)
             {
-                // Grow exponentially, until we hit 1G, then by 1M thereafter.
-                int nNewLength = pOldData->nAllocLength;
-                if (nNewLength > 1024 * 1024 * 1024)
-                {
-                    nNewLength += 1024 * 1024;
-                }
-                else
-                {
-                    // Exponential growth factor is 1.5.
-                    nNewLength = nNewLength + nNewLength / 2;
-                }
+                // The manager decides how much room to leave for later appends
+                int nNewLength =
+                    pOldData->pStringMgr->GetGrowLength(pOldData->nAllocLength, nLength);
                 if (nNewLength < nLength)
                 {
                     nNewLength = nLength;
@@ -1325,13 +1084,31 @@ namespace AMV
                 ThrowMemoryException();
                 return;
             }
-            BStringData *pNewData =
-                pStringMgr->Reallocate(pOldData, nLength, sizeof(char));
+            BStringData *pNewData;
+            if (IsInline())
+            {
+                // Leave the inline storage, keeping the lock state
+                pNewData = pStringMgr->Allocate(nLength, sizeof(XCHAR));
+                if (pNewData == NULL)
+                {
+                    ThrowMemoryException();
+                }
+                CopyChars(static_cast<XCHAR *>(pNewData->data()), nLength + 1,
+                          static_cast<const XCHAR *>(pOldData->data()),
+                          pOldData->nDataLength + 1);
+                pNewData->nDataLength = pOldData->nDataLength;
+                pNewData->nRefs = pOldData->nRefs;
+                pNewData->ResetHash();
+            }
+            else
+            {
+                pNewData = pStringMgr->Reallocate(pOldData, nLength, sizeof(XCHAR));
+            }
             if (pNewData == NULL)
             {
                 ThrowMemoryException();
             }
-            Attach(pNewData);
+            AttachData(pNewData);
         }
 
         void SetLength(_In_ int nLength)
@@ -1343,30 +1120,36 @@ namespace AMV
                 AmvThrow("Invalid arguments");
 
             GetData()->nDataLength = nLength;
+            GetData()->ResetHash();
             m_pszData[nLength] = 0;
         }
 
-        static BStringData *__cdecl CloneData(_Inout_ BStringData *pData)
+        /* Short strings are copied into the inline storage (see AllocateData()).
+         * Longer ones are shared when possible. */
+        BStringData *CloneData(_Inout_ BStringData *pData)
         {
             BStringData *pNewData = NULL;
 
             IAmvStringMgr *pNewStringMgr = pData->pStringMgr->Clone();
-            if (!pData->IsLocked() && (pNewStringMgr == pData->pStringMgr))
+            // A short buffer that is shared already (interned) stays shared, so
+            // that its copies keep the same chars pointer
+            if ((pData->nDataLength > SSO_CAPACITY || pData->IsShared()) &&
+                !pData->IsLocked() && (pNewStringMgr == pData->pStringMgr))
             {
                 pNewData = pData;
                 pNewData->AddRef();
             }
             else
             {
-                pNewData = pNewStringMgr->Allocate(pData->nDataLength, sizeof(char));
+                pNewData = AllocateData(pNewStringMgr, pData->nDataLength);
                 if (pNewData == NULL)
                 {
                     ThrowMemoryException();
                 }
                 pNewData->nDataLength = pData->nDataLength;
                 // Copy '\0'
-                CopyChars(static_cast<char *>(pNewData->data()), pData->nDataLength + 1,
-                          static_cast<const char *>(pData->data()),
+                CopyChars(static_cast<XCHAR *>(pNewData->data()), pData->nDataLength + 1,
+                          static_cast<const XCHAR *>(pData->data()),
                           pData->nDataLength + 1);
             }
 
@@ -1377,14 +1160,32 @@ namespace AMV
         typedef CStrBufT<BaseType> CStrBuf;
 
     private:
-        char *m_pszData;
+        XCHAR *m_pszData;
+        // A whole BStringData header in every string: the manager, the lock
+        // and the cached hash then work the same on inline and heap buffers,
+        // at the price of sizeof(BStringData) bytes per string (see below)
+        CInlineStringData<SSO_CAPACITY, XCHAR> m_inline;
     };
 
+    // 64-bit, default AMV_SSO_CAPACITY: 8 (m_pszData) + 24 (header) + 24
+    // (chars), and 8 more for the cached hash.  A change here changes the size
+    // of every string, so it has to be a deliberate one.
+#ifdef AMV_STRING_CACHE_HASH
+    static_assert(sizeof(void *) != 8 || AMV_SSO_CAPACITY != 23 ||
+                      sizeof(CSimpleStringT<char>) == 64,
+                  "CSimpleStringT<char> is 64 bytes");
+#else
+    static_assert(sizeof(void *) != 8 || AMV_SSO_CAPACITY != 23 ||
+                      sizeof(CSimpleStringT<char>) == 56,
+                  "CSimpleStringT<char> is 56 bytes");
+#endif
+
     template <typename TCharType>
     class CStrBufT
     {
     public:
         typedef CSimpleStringT<TCharType> StringType;
+        typedef TCharType XCHAR;
 
         /* Automatically determine the new length of the string at release. The string
    * must be null-terminated. */
@@ -1417,8 +1218,8 @@ namespace AMV
 
         ~CStrBufT() { m_str.ReleaseBuffer(m_nLength); }
 
-        operator char *() throw() { return (m_pszBuffer); }
-        operator const char *() const throw() { return (m_pszBuffer); }
+        operator XCHAR *() throw() { return (m_pszBuffer); }
+        operator const XCHAR *() const throw() { return (m_pszBuffer); }
 
         void SetLength(_In_ int nLength)
         {
@@ -1433,7 +1234,7 @@ namespace AMV
         // Implementation
     private:
         StringType &m_str;
-        char *m_pszBuffer;
+        XCHAR *m_pszBuffer;
         int m_nLength;
 
         /* Private copy constructor and copy assignment operator to prevent
@@ -1445,8 +1246,4 @@ namespace AMV
 
 } // namespace AMV
 
-<<<<<<< HEAD:include/amvsimpstr.hpp
-#endif  // AMVSIMPSTR_HPP_
-=======
-#endif // AMVSIMPSTR_H_
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/amvsimpstr.h
+#endif // AMVSIMPSTR_HPP_
@@ -0,0 +1,352 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVSTATS_HPP_
+#define AMVSTATS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "include/amvdefine.hpp"
+#include "include/amvsimpstr.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // Counters of a CAmvStatsStringMgr at one point in time.  Sizes are the
+    // bytes of whole blocks, header included.
+    struct CAmvStringStats
+    {
+        // Size class i holds blocks of up to (16 << i) bytes, the last one
+        // everything larger
+        static const int NUM_SIZE_CLASSES = 21;
+
+        uint64_t nAllocs;
+        uint64_t nReallocs;
+        uint64_t nFrees;
+        uint64_t nAllocBytes;
+        // Writes to a shared string that made a private copy
+        // (AMV_STRING_STATS builds only)
+        uint64_t nForks;
+        // Capacity given back by FreeExtra(), in chars (AMV_STRING_STATS only)
+        uint64_t nFreeExtraChars;
+        int64_t nLiveBytes;
+        int64_t nPeakBytes;
+        // Allocate() and the new size of Reallocate()
+        uint64_t anSizes[NUM_SIZE_CLASSES];
+
+        static int SizeClass(_In_ size_t nBytes) throw()
+        {
+            int iClass = 0;
+            while (iClass < NUM_SIZE_CLASSES - 1 &&
+                   nBytes > (static_cast<size_t>(16) << iClass))
+            {
+                iClass++;
+            }
+            return (iClass);
+        }
+
+        // One line of name=value pairs; the histogram lists non-empty classes
+        void Dump(_Inout_ FILE *pFile) const
+        {
+            fprintf(pFile,
+                    "allocs=%llu reallocs=%llu frees=%llu alloc_bytes=%llu forks=%llu "
+                    "free_extra_chars=%llu live_bytes=%lld peak_bytes=%lld sizes=",
+                    static_cast<unsigned long long>(nAllocs),
+                    static_cast<unsigned long long>(nReallocs),
+                    static_cast<unsigned long long>(nFrees),
+                    static_cast<unsigned long long>(nAllocBytes),
+                    static_cast<unsigned long long>(nForks),
+                    static_cast<unsigned long long>(nFreeExtraChars),
+                    static_cast<long long>(nLiveBytes), static_cast<long long>(nPeakBytes));
+            const char *pszSep = "";
+            for (int i = 0; i < NUM_SIZE_CLASSES; i++)
+            {
+                if (anSizes[i] != 0)
+                {
+                    bool bLast = (i == NUM_SIZE_CLASSES - 1);
+                    fprintf(pFile, "%s%s%zu:%llu", pszSep, bLast ? ">" : "<=",
+                            static_cast<size_t>(16) << (bLast ? i - 1 : i),
+                            static_cast<unsigned long long>(anSizes[i]));
+                    pszSep = ",";
+                }
+            }
+            fprintf(pFile, "\n");
+        }
+    };
+
+    // Decorator that counts what passes through another string manager.
+    //
+    // Data allocated here carries this manager, so Free() and Reallocate()
+    // come back here too; they are forwarded with the inner manager put back
+    // in place.  Counters are striped over NUM_SLOTS cache lines and every
+    // thread updates its own line, so threads do not contend on them.  Live
+    // and peak bytes are one shared pair.
+    //
+    // Forks and FreeExtra() savings are reported by CSimpleStringT itself,
+    // and only in builds with AMV_STRING_STATS; without it IAmvStringMgr has
+    // no hooks and strings pay nothing.  AMV_STRING_STATS also wraps the
+    // default BString manager, see CAmvStringMgr::GetStatsInstance().
+    class CAmvStatsStringMgr : public IAmvStringMgr
+    {
+    public:
+        static const int NUM_SLOTS = 16;
+
+        explicit CAmvStatsStringMgr(_Inout_ IAmvStringMgr *pStringMgr) throw()
+            : m_pStringMgr(pStringMgr), m_nLiveBytes(0), m_nPeakBytes(0), m_nDumpIntervalMs(0)
+        {
+            AMVASSERT(pStringMgr != NULL);
+            m_nil.SetManager(this);
+            memset(m_aSlots, 0, sizeof(m_aSlots));
+        }
+
+        virtual ~CAmvStatsStringMgr() throw() { StopDump(); }
+
+        IAmvStringMgr *GetInnerManager() const throw() { return (m_pStringMgr); }
+
+        CAmvStringStats GetSnapshot() const throw()
+        {
+            CAmvStringStats stats;
+            memset(&stats, 0, sizeof(stats));
+            for (int i = 0; i < NUM_SLOTS; i++)
+            {
+                const CSlot &slot = m_aSlots[i];
+                stats.nAllocs += Load(slot.nAllocs);
+                stats.nReallocs += Load(slot.nReallocs);
+                stats.nFrees += Load(slot.nFrees);
+                stats.nAllocBytes += Load(slot.nAllocBytes);
+                stats.nForks += Load(slot.nForks);
+                stats.nFreeExtraChars += Load(slot.nFreeExtraChars);
+                for (int j = 0; j < CAmvStringStats::NUM_SIZE_CLASSES; j++)
+                {
+                    stats.anSizes[j] += Load(slot.anSizes[j]);
+                }
+            }
+            stats.nLiveBytes = m_nLiveBytes.load(std::memory_order_relaxed);
+            stats.nPeakBytes = m_nPeakBytes.load(std::memory_order_relaxed);
+
+            return (stats);
+        }
+
+        // Zeroes the counters.  The peak restarts from the bytes live now.
+        void Reset() throw()
+        {
+            for (int i = 0; i < NUM_SLOTS; i++)
+            {
+                CSlot &slot = m_aSlots[i];
+                Store0(&slot.nAllocs);
+                Store0(&slot.nReallocs);
+                Store0(&slot.nFrees);
+                Store0(&slot.nAllocBytes);
+                Store0(&slot.nForks);
+                Store0(&slot.nFreeExtraChars);
+                for (int j = 0; j < CAmvStringStats::NUM_SIZE_CLASSES; j++)
+                {
+                    Store0(&slot.anSizes[j]);
+                }
+            }
+            m_nPeakBytes.store(m_nLiveBytes.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+        }
+
+        // Writes a snapshot to pFile every nIntervalMs from a background
+        // thread, until StopDump() or the destruction of the manager
+        void StartDump(_In_ int nIntervalMs, _Inout_ FILE *pFile = stderr)
+        {
+            AMVASSERT(nIntervalMs > 0);
+            StopDump();
+            m_nDumpIntervalMs = nIntervalMs;
+            m_dumpThread = std::thread([this, pFile]() {
+                std::unique_lock<std::mutex> lock(m_dumpMutex);
+                while (!m_dumpCond.wait_for(lock, std::chrono::milliseconds(m_nDumpIntervalMs),
+                                            [this]() { return (m_nDumpIntervalMs == 0); }))
+                {
+                    GetSnapshot().Dump(pFile);
+                    fflush(pFile);
+                }
+            });
+        }
+
+        void StopDump() throw()
+        {
+            if (m_dumpThread.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_dumpMutex);
+                    m_nDumpIntervalMs = 0;
+                }
+                m_dumpCond.notify_all();
+                m_dumpThread.join();
+            }
+        }
+
+        // IAmvStringMgr
+    public:
+        virtual BStringData *Allocate(_In_ int nChars, _In_ int nCharSize) throw()
+        {
+            BStringData *pData = m_pStringMgr->Allocate(nChars, nCharSize);
+            if (pData != NULL)
+            {
+                SetCharSize(pData, nCharSize);
+                size_t nBytes = GetBlockSize(pData);
+                CSlot &slot = GetSlot();
+                Add(&slot.nAllocs, 1);
+                Add(&slot.nAllocBytes, nBytes);
+                Add(&slot.anSizes[CAmvStringStats::SizeClass(nBytes)], 1);
+                AddLive(static_cast<int64_t>(nBytes));
+                pData->pStringMgr = this;
+            }
+
+            return (pData);
+        }
+
+        virtual void Free(_In_ BStringData *pData) throw()
+        {
+            AMVASSERT(pData->pStringMgr == this);
+
+            AddLive(-static_cast<int64_t>(GetBlockSize(pData)));
+            Add(&GetSlot().nFrees, 1);
+            pData->pStringMgr = m_pStringMgr;
+            pData->nFlags &= ~CHAR_SIZE_MASK;
+            m_pStringMgr->Free(pData);
+        }
+
+        virtual BStringData *Reallocate(_Inout_ BStringData *pData, _In_ int nChars,
+                                        _In_ int nCharSize) throw()
+        {
+            AMVASSERT(pData->pStringMgr == this);
+
+            size_t nOldBytes = GetBlockSize(pData);
+            pData->pStringMgr = m_pStringMgr;
+            BStringData *pNewData = m_pStringMgr->Reallocate(pData, nChars, nCharSize);
+            if (pNewData == NULL)
+            {
+                // The old block is still ours
+                pData->pStringMgr = this;
+                return (NULL);
+            }
+            pNewData->pStringMgr = this;
+            SetCharSize(pNewData, nCharSize);
+
+            size_t nBytes = GetBlockSize(pNewData);
+            CSlot &slot = GetSlot();
+            Add(&slot.nReallocs, 1);
+            Add(&slot.anSizes[CAmvStringStats::SizeClass(nBytes)], 1);
+            AddLive(static_cast<int64_t>(nBytes) - static_cast<int64_t>(nOldBytes));
+
+            return (pNewData);
+        }
+
+        virtual int GetGrowLength(_In_ int nAllocLength, _In_ int nLength) throw()
+        {
+            return (m_pStringMgr->GetGrowLength(nAllocLength, nLength));
+        }
+
+        virtual BStringData *GetNilString() throw()
+        {
+            m_nil.AddRef();
+            return &m_nil;
+        }
+
+        virtual IAmvStringMgr *Clone() throw() { return this; }
+
+#ifdef AMV_STRING_STATS
+        virtual void OnFork(_In_ int nLength) throw()
+        {
+            (void)nLength;
+            Add(&GetSlot().nForks, 1);
+        }
+
+        virtual void OnFreeExtra(_In_ int nSavedChars) throw()
+        {
+            Add(&GetSlot().nFreeExtraChars, static_cast<uint64_t>(nSavedChars));
+        }
+#endif
+
+    private:
+        struct alignas(64) CSlot
+        {
+            uint64_t nAllocs;
+            uint64_t nReallocs;
+            uint64_t nFrees;
+            uint64_t nAllocBytes;
+            uint64_t nForks;
+            uint64_t nFreeExtraChars;
+            uint64_t anSizes[CAmvStringStats::NUM_SIZE_CLASSES];
+        };
+
+        // Free() is not told the char size, so Allocate() and Reallocate() keep
+        // it in the bits of BStringData::nFlags above THREAD_CONFINED
+        static const int CHAR_SIZE_SHIFT = 8;
+        static const int CHAR_SIZE_MASK = 0xff << CHAR_SIZE_SHIFT;
+
+        static void SetCharSize(_Inout_ BStringData *pData, _In_ int nCharSize) throw()
+        {
+            AMVASSERT(nCharSize > 0 && nCharSize <= 0xff);
+            pData->nFlags =
+                (pData->nFlags & ~CHAR_SIZE_MASK) | (nCharSize << CHAR_SIZE_SHIFT);
+        }
+
+        static size_t GetBlockSize(_In_ const BStringData *pData) throw()
+        {
+            int nCharSize = (pData->nFlags & CHAR_SIZE_MASK) >> CHAR_SIZE_SHIFT;
+            return (sizeof(BStringData) +
+                    static_cast<size_t>(pData->nAllocLength + 1) * nCharSize);
+        }
+
+        static uint64_t Load(_In_ const uint64_t &n) throw()
+        {
+            return (__atomic_load_n(&n, __ATOMIC_RELAXED));
+        }
+
+        // Threads get slots round-robin on their first event
+        CSlot &GetSlot() throw()
+        {
+            static std::atomic<unsigned> s_nNextSlot(0);
+            thread_local unsigned t_iSlot =
+                s_nNextSlot.fetch_add(1, std::memory_order_relaxed) % NUM_SLOTS;
+            return (m_aSlots[t_iSlot]);
+        }
+
+        static void Add(_Inout_ uint64_t *pn, _In_ uint64_t n) throw()
+        {
+            __atomic_fetch_add(pn, n, __ATOMIC_RELAXED);
+        }
+
+        static void Store0(_Out_ uint64_t *pn) throw() { __atomic_store_n(pn, 0, __ATOMIC_RELAXED); }
+
+        void AddLive(_In_ int64_t nBytes) throw()
+        {
+            int64_t nLive = m_nLiveBytes.fetch_add(nBytes, std::memory_order_relaxed) + nBytes;
+            int64_t nPeak = m_nPeakBytes.load(std::memory_order_relaxed);
+            while (nLive > nPeak &&
+                   !m_nPeakBytes.compare_exchange_weak(nPeak, nLive, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        IAmvStringMgr *m_pStringMgr;
+        CNilStringData m_nil;
+        CSlot m_aSlots[NUM_SLOTS];
+        std::atomic<int64_t> m_nLiveBytes;
+        std::atomic<int64_t> m_nPeakBytes;
+
+        std::thread m_dumpThread;
+        std::mutex m_dumpMutex;
+        std::condition_variable m_dumpCond;
+        int m_nDumpIntervalMs;
+
+    private:
+        CAmvStatsStringMgr(_In_ const CAmvStatsStringMgr &) throw();
+        CAmvStatsStringMgr &operator=(_In_ const CAmvStatsStringMgr &) throw();
+    };
+
+} // namespace AMV
+
+#endif // AMVSTATS_HPP_
@@ -4,12 +4,19 @@
 #define AMVSTR_HPP_
 
 #include <cctype>
+#include <climits>
 #include <cstring>
 
 #include "include/BStringt.hpp"
+#include "include/amvalloc.hpp"
 #include "include/amvdefine.hpp"
+#include "include/amvfixedstr.hpp"
+#include "include/amvintern.hpp"
 #include "include/amvmem.hpp"
+#include "include/amvpool.hpp"
+#include "include/amvsimd.hpp"
 #include "include/amvsimpstr.hpp"
+#include "include/amvstats.hpp"
 
 namespace AMV
 {
@@ -18,7 +25,7 @@ namespace AMV
     {
     public:
         explicit CAmvStringMgr(_In_opt_ IAmvMemMgr *pMemMgr = NULL) throw()
-            : m_pMemMgr(pMemMgr)
+            : m_pMemMgr(pMemMgr), m_nGrowNumerator(3), m_nGrowDenominator(2), m_nDataFlags(0)
         {
             m_nil.SetManager(this);
         }
@@ -31,39 +38,77 @@ namespace AMV
             m_pMemMgr = pMemMgr;
         }
 
+        // Strings of this manager grow by nNumerator / nDenominator (1.5 by
+        // default) when they run out of room.  1 / 1 grows to the exact length.
+        void SetGrowthFactor(_In_ int nNumerator, _In_ int nDenominator) throw()
+        {
+            AMVASSERT(nDenominator > 0 && nNumerator >= nDenominator);
+            m_nGrowNumerator = nNumerator;
+            m_nGrowDenominator = nDenominator;
+        }
+
+        // Strings of a confined manager are made, copied and destroyed by one
+        // thread only, and their reference counts skip the atomic operations.
+        // Handing such a string to another thread needs a deep copy made
+        // through another manager.
+        void SetThreadConfined(_In_ bool bConfined) throw()
+        {
+            m_nDataFlags = bConfined ? BStringData::THREAD_CONFINED : 0;
+        }
+
+        bool IsThreadConfined() const throw()
+        {
+            return ((m_nDataFlags & BStringData::THREAD_CONFINED) != 0);
+        }
+
+        // Build with AMV_STRING_POOL_HEAP to put the default strings in the
+        // thread-local pool instead of malloc(), and with AMV_STRING_STATS to
+        // count what they do (see GetStatsInstance())
         static IAmvStringMgr *GetInstance()
         {
+#ifdef AMV_STRING_STATS
+            return GetStatsInstance();
+#else
+            return GetPlainInstance();
+#endif
+        }
+
+#ifdef AMV_STRING_STATS
+        // The counters of the default manager
+        static CAmvStatsStringMgr *GetStatsInstance()
+        {
+            static CAmvStatsStringMgr strMgr(GetPlainInstance());
+
+            return &strMgr;
+        }
+#endif
+
+    private:
+        static IAmvStringMgr *GetPlainInstance()
+        {
+#ifdef AMV_STRING_POOL_HEAP
+            static CAmvStringMgr strMgr(CAmvPoolHeap::GetInstance());
+#else
             static CAmvHeap strHeap;
             static CAmvStringMgr strMgr(&strHeap);
+#endif
 
             return &strMgr;
         }
 
+    public:
+
         // IAmvStringMgr
     public:
         virtual BStringData *Allocate(_In_ int nChars, _In_ int nCharSize) throw()
         {
             AMVENSURE_RETURN_VAL(nChars >= 0, NULL);
 
-            size_t nTotalSize;
+            size_t nTotalSize = 0;
             BStringData *pData;
-            size_t nDataBytes;
-
-            if (FAILED(::AMV::AmvAdd(&nChars, nChars, 1)))
-            {
-                return NULL;
-            }
+            int nAlignedChars = 0;
 
-            // Prevent excessive reallocation. The heap will usually round up anyway.
-            int nAlignedChars = ::AMV::AmvAlignUp(nChars, 8);
-            AMVENSURE_RETURN_VAL(nChars <= nAlignedChars, NULL);
-
-            if (FAILED(::AMV::AmvMultiply(&nDataBytes,
-                                          static_cast<size_t>(nAlignedChars),
-                                          static_cast<size_t>(nCharSize))) ||
-                FAILED(::AMV::AmvAdd(&nTotalSize,
-                                     static_cast<size_t>(sizeof(BStringData)),
-                                     nDataBytes)))
+            if (FAILED(GetAllocSize(&nAlignedChars, &nTotalSize, nChars, nCharSize)))
             {
                 return NULL;
             }
@@ -74,8 +119,10 @@ namespace AMV
             }
             pData->pStringMgr = this;
             pData->nRefs = 1;
+            pData->nFlags = m_nDataFlags;
             pData->nAllocLength = nAlignedChars - 1;
             pData->nDataLength = 0;
+            pData->ResetHash();
 
             return (pData);
         }
@@ -95,24 +142,10 @@ namespace AMV
             AMVASSERT(pData->pStringMgr == this);
 
             BStringData *pNewData;
-            ULONG nTotalSize;
-            ULONG nDataBytes;
+            size_t nTotalSize = 0;
+            int nAlignedChars = 0;
 
-            if (FAILED(::AMV::AmvAdd(&nChars, nChars, 1)))
-            {
-                return NULL;
-            }
-
-            // Prevent excessive reallocation. The heap will usually round up anyway.
-            int nAlignedChars = ::AMV::AmvAlignUp(nChars, 8);
-            AMVENSURE_RETURN_VAL(nChars <= nAlignedChars, NULL);
-
-            if (FAILED(::AMV::AmvMultiply(&nDataBytes,
-                                          static_cast<ULONG>(nAlignedChars),
-                                          static_cast<ULONG>(nCharSize))) ||
-                FAILED(::AMV::AmvAdd(&nTotalSize,
-                                     static_cast<ULONG>(sizeof(BStringData)),
-                                     nDataBytes)))
+            if (FAILED(GetAllocSize(&nAlignedChars, &nTotalSize, nChars, nCharSize)))
             {
                 return NULL;
             }
@@ -127,6 +160,25 @@ namespace AMV
             return pNewData;
         }
 
+        virtual int GetGrowLength(_In_ int nAllocLength, _In_ int nLength) throw()
+        {
+            // Grow geometrically until we hit 1G, then by 1M thereafter
+            int64_t nNewLength = nAllocLength;
+            if (nNewLength > 1024 * 1024 * 1024)
+            {
+                nNewLength += 1024 * 1024;
+            }
+            else
+            {
+                nNewLength = nNewLength * m_nGrowNumerator / m_nGrowDenominator;
+            }
+            if (nNewLength > INT_MAX - 8)
+            {
+                nNewLength = INT_MAX - 8;
+            }
+            return (nNewLength < nLength ? nLength : static_cast<int>(nNewLength));
+        }
+
         virtual BStringData *GetNilString() throw()
         {
             m_nil.AddRef();
@@ -138,33 +190,65 @@ namespace AMV
     protected:
         IAmvMemMgr *m_pMemMgr;
         CNilStringData m_nil;
+        int m_nGrowNumerator;
+        int m_nGrowDenominator;
+        int m_nDataFlags;
 
     private:
+        /* Room for nChars and the '\0', rounded up to 8 chars to prevent
+         * excessive reallocation (the heap will usually round up anyway), and
+         * the bytes of the block with the header */
+        static int64_t GetAllocSize(_Out_ int *pnAlignedChars, _Out_ size_t *pnTotalSize,
+                                    _In_ int nChars, _In_ int nCharSize) throw()
+        {
+            int nAlignedChars = 0;
+            size_t nTotalSize = 0;
+            // AmvAlignUp(nChars + 1, 8)
+            int64_t l = ::AMV::AmvAdd(&nAlignedChars, nChars, 8);
+            if (FAILED(l))
+            {
+                return l;
+            }
+            nAlignedChars &= ~7;
+            l = ::AMV::AmvMultiplyAdd(&nTotalSize, static_cast<size_t>(nAlignedChars),
+                                      static_cast<size_t>(nCharSize), sizeof(BStringData));
+            if (FAILED(l))
+            {
+                return l;
+            }
+            *pnAlignedChars = nAlignedChars;
+            *pnTotalSize = nTotalSize;
+
+            return S_OK;
+        }
     };
 
     template <class ChTraits>
     inline const char *strstrT(const char *pStr, const char *pCharSet);
 
+    // The C library and the SIMD kernels serve char; wider chars (char16_t,
+    // wchar_t) take the plain loops of amvsimd.hpp.  The CAmvCharSet functions
+    // are for char only.
     template <typename _CharType = char>
     class ChTraitsOS
     {
     public:
-        static int tclen(_In_z_ const char *p) throw()
+        static int tclen(_In_z_ const _CharType *p) throw()
         {
             AMVASSERT(p != NULL);
-            const char *pnext = CharNext(p);
+            const _CharType *pnext = CharNext(p);
             return ((pnext - p) > 1) ? 2 : 1;
         }
 
-        _Ret_maybenull_z_ static const char *strchr(_In_z_ const char *p,
-                                                    _In_ char ch) throw()
+        _Ret_maybenull_z_ static const _CharType *strchr(_In_z_ const _CharType *p,
+                                                         _In_ _CharType ch) throw()
         {
             return AmvstrchrT(p, ch);
         }
 
-        _Ret_maybenull_z_ static const char *strchr_db(_In_z_ const char *p,
-                                                       _In_ char ch1,
-                                                       _In_ char ch2) throw()
+        _Ret_maybenull_z_ static const _CharType *strchr_db(_In_z_ const _CharType *p,
+                                                            _In_ _CharType ch1,
+                                                            _In_ _CharType ch2) throw()
         {
             AMVASSERT(p != NULL);
             while (*p != 0)
@@ -182,56 +266,18 @@ namespace AMV
                           _In_z_ const _CharType *pCharSet) throw()
         {
             AMVASSERT(pStr != NULL);
-            int nRet = 0;
-            _CharType *p = const_cast<_CharType *>(pStr);
-            while (*p != 0)
-            {
-                _CharType *pNext = CharNext(p);
-                if (pNext > p + 1)
-                {
-                    if (strchr_db(pCharSet, *p, *(p + 1)) == NULL)
-                        break;
-                    nRet += 2;
-                }
-                else
-                {
-                    if (strchr(pCharSet, *p) == NULL)
-                        break;
-                    nRet++;
-                }
-                p = pNext;
-            }
-            return nRet;
+            return (StringSpanIncluding(pStr, SafeStringLen(pStr), pCharSet));
         }
 
         static int strcspn(_In_z_ const _CharType *pStr,
                            _In_z_ const _CharType *pCharSet) throw()
         {
             AMVASSERT(pStr != NULL);
-            int nRet = 0;
-            _CharType *p = const_cast<_CharType *>(pStr);
-            while (*p != 0)
-            {
-                _CharType *pNext = CharNext(p);
-                if (pNext > p + 1)
-                {
-                    if (strchr_db(pCharSet, *p, *(p + 1)) != NULL)
-                        break;
-                    nRet += 2;
-                }
-                else
-                {
-                    if (strchr(pCharSet, *p) != NULL)
-                        break;
-                    nRet++;
-                }
-                p = pNext;
-            }
-            return nRet;
+            return (StringSpanExcluding(pStr, SafeStringLen(pStr), pCharSet));
         }
 
-        static const char *strpbrk(_In_z_ const char *p,
-                                   _In_z_ const char *lpszCharSet) throw()
+        static const _CharType *strpbrk(_In_z_ const _CharType *p,
+                                        _In_z_ const _CharType *lpszCharSet) throw()
         {
             int nRet = 0;
             nRet = strcspn(p, lpszCharSet);
@@ -248,49 +294,222 @@ namespace AMV
             return AmvCharNext(p);
         }
 
-        static int IsDigit(_In_ _CharType ch) throw() { return isdigit(ch); }
+        // Only ASCII digits and spaces count for the wider chars
+        static int IsDigit(_In_ _CharType ch) throw()
+        {
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                return isdigit(ch);
+            }
+            else
+            {
+                return (ch >= '0' && ch <= '9');
+            }
+        }
 
-        static int IsSpace(_In_ _CharType ch) throw() { return isspace(ch); }
+        static int IsSpace(_In_ _CharType ch) throw()
+        {
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                return isspace(ch);
+            }
+            else
+            {
+                return ((ch >= '\t' && ch <= '\r') || ch == ' ');
+            }
+        }
 
         static int StringCompare(_In_z_ const _CharType *pstrOne,
                                  _In_z_ const _CharType *pstrOther) throw()
         {
-            return strcmp((const char *)pstrOne, (const char *)pstrOther);
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                return strcmp((const char *)pstrOne, (const char *)pstrOther);
+            }
+            else
+            {
+                return AmvCompare(pstrOne, SafeStringLen(pstrOne), pstrOther,
+                                  SafeStringLen(pstrOther));
+            }
         }
 
         static int StringCompareIgnore(_In_z_ const _CharType *pstrOne,
                                        _In_z_ const _CharType *pstrOther) throw()
         {
-            return strcasecmp((const char *)pstrOne, (const char *)pstrOther);
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                return strcasecmp((const char *)pstrOne, (const char *)pstrOther);
+            }
+            else
+            {
+                return AmvCompareNoCase(pstrOne, SafeStringLen(pstrOne), pstrOther,
+                                        SafeStringLen(pstrOther));
+            }
+        }
+
+        static const _CharType *StringFindString(_In_z_ const _CharType *pstrBlock,
+                                                 _In_z_ const _CharType *pstrMatch) throw()
+        {
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                return strstr(pstrBlock, pstrMatch);
+            }
+            else
+            {
+                return AmvFindString(pstrBlock, SafeStringLen(pstrBlock), pstrMatch,
+                                     SafeStringLen(pstrMatch));
+            }
+        }
+
+        static _CharType *StringFindString(_In_z_ _CharType *pszBlock,
+                                           _In_z_ const _CharType *pszMatch) throw()
+        {
+            return (const_cast<_CharType *>(
+                StringFindString(const_cast<const _CharType *>(pszBlock), pszMatch)));
+        }
+
+        static const _CharType *StringFindChar(_In_z_ const _CharType *pszBlock,
+                                               _In_ _CharType chMatch) throw()
+        {
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                return ::strchr(pszBlock, chMatch);
+            }
+            else
+            {
+                return AmvstrchrT(pszBlock, chMatch);
+            }
+        }
+
+        static const _CharType *StringFindCharRev(_In_z_ const _CharType *psz,
+                                                  _In_ _CharType ch) throw()
+        {
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                return strrchr(psz, ch);
+            }
+            else
+            {
+                // The '\0' at the end is found too
+                return AmvFindCharRev(psz, SafeStringLen(psz) + 1, ch);
+            }
+        }
+
+        // Length-aware versions for callers that know the length already
+
+        static const _CharType *StringFindChar(_In_reads_(nLength) const _CharType *pchBlock,
+                                               _In_ int nLength, _In_ _CharType chMatch) throw()
+        {
+            return AmvFindChar(pchBlock, nLength, chMatch);
         }
 
-        static const char *StringFindString(_In_z_ const char *pstrBlock,
-                                            _In_z_ const char *pstrMatch) throw()
+        static const _CharType *StringFindCharRev(_In_reads_(nLength) const _CharType *pch,
+                                                  _In_ int nLength, _In_ _CharType ch) throw()
         {
-            return strstr(pstrBlock, pstrMatch);
+            return AmvFindCharRev(pch, nLength, ch);
         }
 
-        static LPSTR StringFindString(_In_z_ LPSTR pszBlock,
-                                      _In_z_ const char *pszMatch) throw()
+        static int StringCompare(_In_reads_(nOne) const _CharType *pchOne, _In_ int nOne,
+                                 _In_reads_(nOther) const _CharType *pchOther,
+                                 _In_ int nOther) throw()
         {
-            return (const_cast<LPSTR>(
-                StringFindString(const_cast<const char *>(pszBlock), pszMatch)));
+            return AmvCompare(pchOne, nOne, pchOther, nOther);
         }
 
-        static const char *StringFindChar(_In_z_ const char *pszBlock,
-                                          _In_ char chMatch) throw()
+        static int StringCompareIgnore(_In_reads_(nOne) const _CharType *pchOne, _In_ int nOne,
+                                       _In_reads_(nOther) const _CharType *pchOther,
+                                       _In_ int nOther) throw()
         {
-            return strchr(pszBlock, chMatch);
+            return AmvCompareNoCase(pchOne, nOne, pchOther, nOther);
         }
 
-        static const char *StringFindCharRev(_In_z_ const char *psz,
-                                             _In_ char ch) throw()
+        static const _CharType *StringFindString(_In_reads_(nBlock) const _CharType *pchBlock,
+                                                 _In_ int nBlock,
+                                                 _In_reads_(nMatch) const _CharType *pchMatch,
+                                                 _In_ int nMatch) throw()
         {
-            return strrchr(psz, ch);
+            return AmvFindString(pchBlock, nBlock, pchMatch, nMatch);
         }
 
-        static const char *StringScanSet(_In_z_ const char *pszBlock,
-                                         _In_z_ const char *pszMatch) throw()
+        static int StringSpanIncluding(_In_reads_(nLength) const char *pchBlock,
+                                       _In_ int nLength,
+                                       _In_ const CAmvCharSet &set) throw()
+        {
+            return static_cast<int>(AmvSpanIncluding(pchBlock, nLength, set));
+        }
+
+        static int StringSpanExcluding(_In_reads_(nLength) const char *pchBlock,
+                                       _In_ int nLength,
+                                       _In_ const CAmvCharSet &set) throw()
+        {
+            return static_cast<int>(AmvSpanExcluding(pchBlock, nLength, set));
+        }
+
+        // Chars at the start of pchBlock[0, nLength) that are in pszSet
+        static int StringSpanIncluding(_In_reads_(nLength) const _CharType *pchBlock,
+                                       _In_ int nLength, _In_z_ const _CharType *pszSet) throw()
+        {
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                CAmvCharSet set(pszSet);
+                return (StringSpanIncluding(pchBlock, nLength, set));
+            }
+            else
+            {
+                int i = 0;
+                while (i < nLength && IsInSet(pszSet, pchBlock[i]))
+                {
+                    i++;
+                }
+                return (i);
+            }
+        }
+
+        // Chars at the start of pchBlock[0, nLength) that are not in pszSet
+        static int StringSpanExcluding(_In_reads_(nLength) const _CharType *pchBlock,
+                                       _In_ int nLength, _In_z_ const _CharType *pszSet) throw()
+        {
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                CAmvCharSet set(pszSet);
+                return (StringSpanExcluding(pchBlock, nLength, set));
+            }
+            else
+            {
+                int i = 0;
+                while (i < nLength && !IsInSet(pszSet, pchBlock[i]))
+                {
+                    i++;
+                }
+                return (i);
+            }
+        }
+
+        // Where the chars in pszSet at the end of pchBlock[0, nLength) start
+        static int StringSpanIncludingRev(_In_reads_(nLength) const _CharType *pchBlock,
+                                          _In_ int nLength,
+                                          _In_z_ const _CharType *pszSet) throw()
+        {
+            if constexpr (sizeof(_CharType) == 1)
+            {
+                CAmvCharSet set(pszSet);
+                while (nLength > 0 && set.Contains(pchBlock[nLength - 1]))
+                {
+                    nLength--;
+                }
+            }
+            else
+            {
+                while (nLength > 0 && IsInSet(pszSet, pchBlock[nLength - 1]))
+                {
+                    nLength--;
+                }
+            }
+            return (nLength);
+        }
+
+        static const _CharType *StringScanSet(_In_z_ const _CharType *pszBlock,
+                                              _In_z_ const _CharType *pszMatch) throw()
         {
             return strpbrk(pszBlock, pszMatch);
         }
@@ -307,15 +526,13 @@ namespace AMV
             return strcspn(pstrBlock, pstrSet);
         }
 
-        static int GetBaseTypeLength(_In_z_ const char *pszSrc) throw()
+        static int GetBaseTypeLength(_In_z_ const _CharType *pszSrc) throw()
         {
             // Returns required buffer length in XCHARs
-            if (pszSrc == NULL)
-                return 0;
-            return static_cast<int>(::strlen(pszSrc));
+            return (SafeStringLen(pszSrc));
         }
 
-        static int GetBaseTypeLength(_In_z_ const char *pszSrc,
+        static int GetBaseTypeLength(_In_z_ const _CharType *pszSrc,
                                      _In_ int nLength) throw()
         {
             (void)pszSrc;
@@ -325,7 +542,7 @@ namespace AMV
 
         static void ConvertToBaseType(_Out_writes_(nDestLength) _CharType *pszDest,
                                       _In_ int nDestLength,
-                                      _In_reads_(nSrcLength) const char *pszSrc,
+                                      _In_reads_(nSrcLength) const _CharType *pszSrc,
                                       _In_ int nSrcLength = -1) throw()
         {
             if (nSrcLength == -1)
@@ -336,10 +553,16 @@ namespace AMV
             memcpy(pszDest, pszSrc, nSrcLength * sizeof(_CharType));
         }
 
-        static int SafeStringLen(_In_opt_z_ const char *psz) throw()
+        static int SafeStringLen(_In_opt_z_ const _CharType *psz) throw()
+        {
+            // returns length in chars
+            return (CSimpleStringT<_CharType>::StringLength(psz));
+        }
+
+    private:
+        static bool IsInSet(_In_z_ const _CharType *pszSet, _In_ _CharType ch) throw()
         {
-            // returns length in bytes
-            return (psz != NULL) ? static_cast<int>(strlen(psz)) : 0;
+            return (ch != 0 && AmvstrchrT(pszSet, ch) != NULL);
         }
     };
 
@@ -385,13 +608,175 @@ namespace AMV
         }
     };
 
+    // Walks the chars as UTF-8: CharNext() steps over a whole sequence, so
+    // TrimLeft() and friends never split a code point, and the targets of
+    // TrimLeft(pszTargets) are whole code points too.  A sequence is a lead
+    // byte and the continuation bytes after it, so stray continuation bytes
+    // stick to the char before them.
+    class ChTraitsUtf8 : public ChTraitsOS<char>
+    {
+    public:
+        static int tclen(_In_z_ const char *p) throw()
+        {
+            AMVASSERT(p != NULL);
+            // The terminator counts as one char, as in ChTraitsOS
+            return ((*p == 0) ? 1 : static_cast<int>(CharNext(p) - p));
+        }
+
+        _Ret_maybenull_z_ static const char *strchr_db(_In_z_ const char *p,
+                                                       _In_ char ch1,
+                                                       _In_ char ch2) throw()
+        {
+            AMVASSERT(p != NULL);
+            while (*p != 0)
+            {
+                if (*p == ch1 && *(p + 1) == ch2)
+                {
+                    return p;
+                }
+                p = CharNext(p);
+            }
+            return NULL;
+        }
+
+        static char *CharNext(_In_ const char *p) throw()
+        {
+            AMVASSUME(p != NULL);
+            // Stays on the terminator, like CharNext() in ATL
+            if (*p == 0)
+            {
+                return const_cast<char *>(p);
+            }
+            // The terminator is not a continuation byte either
+            do
+            {
+                p++;
+            } while ((*p & 0xc0) == 0x80);
+            return const_cast<char *>(p);
+        }
+
+        // CharNext() nChars times, but within pch[0, nLength) and 16 bytes at a
+        // time: stops at pch + nLength
+        static char *CharAdvance(_In_reads_(nLength) const char *pch, _In_ int nLength,
+                                 _In_ int nChars) throw()
+        {
+            AMVASSERT(nLength >= 0 && nChars >= 0);
+            return (const_cast<char *>(pch) + AmvUtf8Advance(pch, nLength, nChars));
+        }
+
+        using ChTraitsOS<char>::StringSpanIncluding;
+
+        static int StringSpanIncluding(_In_reads_(nLength) const char *pchBlock,
+                                       _In_ int nLength, _In_z_ const char *pszSet) throw()
+        {
+            // ASCII bytes are never part of a longer sequence
+            if (IsAscii(pszSet))
+            {
+                return (ChTraitsOS<char>::StringSpanIncluding(pchBlock, nLength, pszSet));
+            }
+            int i = 0;
+            while (i < nLength)
+            {
+                int nChar = SequenceLength(pchBlock + i, nLength - i);
+                if (!SetContains(pszSet, pchBlock + i, nChar))
+                {
+                    break;
+                }
+                i += nChar;
+            }
+            return (i);
+        }
+
+        static int StringSpanIncludingRev(_In_reads_(nLength) const char *pchBlock,
+                                          _In_ int nLength, _In_z_ const char *pszSet) throw()
+        {
+            if (IsAscii(pszSet))
+            {
+                return (ChTraitsOS<char>::StringSpanIncludingRev(pchBlock, nLength, pszSet));
+            }
+            while (nLength > 0)
+            {
+                // back to the lead byte of the last sequence
+                int iChar = nLength - 1;
+                while (iChar > 0 && (pchBlock[iChar] & 0xc0) == 0x80)
+                {
+                    iChar--;
+                }
+                if (!SetContains(pszSet, pchBlock + iChar, nLength - iChar))
+                {
+                    break;
+                }
+                nLength = iChar;
+            }
+            return (nLength);
+        }
+
+    private:
+        static bool IsAscii(_In_z_ const char *psz) throw()
+        {
+            while (*psz != 0)
+            {
+                if ((*psz & 0x80) != 0)
+                {
+                    return (false);
+                }
+                psz++;
+            }
+            return (true);
+        }
+
+        // Bytes in the sequence at pch[0, nLength), nLength > 0
+        static int SequenceLength(_In_reads_(nLength) const char *pch, _In_ int nLength) throw()
+        {
+            int n = 1;
+            while (n < nLength && (pch[n] & 0xc0) == 0x80)
+            {
+                n++;
+            }
+            return (n);
+        }
+
+        // Whether the sequence pch[0, nChar) is one of the sequences of pszSet
+        static bool SetContains(_In_z_ const char *pszSet, _In_reads_(nChar) const char *pch,
+                                _In_ int nChar) throw()
+        {
+            while (*pszSet != 0)
+            {
+                const char *pszNext = CharNext(pszSet);
+                if (pszNext - pszSet == nChar && memcmp(pszSet, pch, nChar) == 0)
+                {
+                    return (true);
+                }
+                pszSet = pszNext;
+            }
+            return (false);
+        }
+    };
+
     typedef BStringT<char, StrTraitAMV<char>> CAmvString;
+    typedef BStringT<char, StrTraitAMV<char, ChTraitsUtf8>> CAmvStringUtf8;
+    typedef BStringT<char16_t, StrTraitAMV<char16_t>> CAmvString16;
+    typedef BStringT<wchar_t, StrTraitAMV<wchar_t>> CAmvStringW;
 
 } // namespace AMV
 typedef AMV::CAmvString BString;
-
-<<<<<<< HEAD:include/amvstr.hpp
-#endif  // AMVSTR_HPP_
-=======
-#endif // AMVSTR_H_
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:include/amvstr.h
+typedef AMV::CAmvStringUtf8 BStringUtf8;
+typedef AMV::CAmvString16 BString16;
+typedef AMV::CAmvStringW BStringW;
+typedef AMV::CAmvStringView BStringView;
+typedef AMV::CAmvStringViewT<char16_t> BStringView16;
+typedef AMV::CAmvStringViewT<wchar_t> BStringViewW;
+typedef AMV::CAmvTokenizer BStringTokenizer;
+typedef AMV::CAmvStringBuilderT<AMV::CAmvString> BStringBuilder;
+typedef AMV::CAmvStringHash BStringHash;
+typedef AMV::CAmvStringEqual BStringEqual;
+typedef AMV::CAmvStringPoolT<AMV::CAmvString> BStringPool;
+typedef AMV::CAmvStatsStringMgr BStringStatsMgr;
+template <int t_nChars>
+using BInlineString = AMV::CAmvFixedStringT<AMV::CAmvString, t_nChars>;
+
+// The size is that of CSimpleStringT (see the static_assert there)
+static_assert(sizeof(BString) == sizeof(AMV::CSimpleStringT<char>),
+              "BStringT adds no data members");
+
+#endif // AMVSTR_HPP_
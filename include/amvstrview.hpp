@@ -0,0 +1,422 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVSTRVIEW_HPP_
+#define AMVSTRVIEW_HPP_
+
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#include "include/amvdefine.hpp"
+#include "include/amvhash.hpp"
+#include "include/amvsimd.hpp"
+#include "include/amvsimpstr.hpp"
+#include "include/amvutf8.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // Non-owning view of chars: a pointer and a length.  Nothing is copied or
+    // allocated, so the viewed string must outlive the view and must not be
+    // modified while the view is in use.  The chars are not necessarily
+    // followed by '\0' and may contain '\0'.
+    //
+    // XCHAR is the char type of the strings viewed: CAmvStringView for char,
+    // CAmvStringViewT<char16_t> or CAmvStringViewT<wchar_t> for the wider
+    // strings.  Trimming by CAmvCharSet, ParseNumber() and the UTF-8 functions
+    // are for char only.
+    template <typename XCHAR>
+    class CAmvStringViewT
+    {
+    public:
+        CAmvStringViewT() throw() : m_pch(GetNil()), m_nLength(0) {}
+
+        CAmvStringViewT(_In_opt_z_ const XCHAR *psz) throw()
+            : m_pch(psz != NULL ? psz : GetNil()),
+              m_nLength(CSimpleStringT<XCHAR>::StringLength(psz))
+        {
+        }
+
+        CAmvStringViewT(_In_reads_(nLength) const XCHAR *pch, _In_ int nLength) throw()
+            : m_pch(pch), m_nLength(nLength)
+        {
+            AMVASSERT(nLength >= 0 && (pch != NULL || nLength == 0));
+        }
+
+        // Only for types that are publicly a CSimpleStringT; the fixed strings
+        // hide theirs and convert to a view by themselves
+        template <class TString,
+                  typename std::enable_if<std::is_convertible<
+                                              const TString *,
+                                              const CSimpleStringT<XCHAR> *>::value,
+                                          int>::type = 0>
+        CAmvStringViewT(_In_ const TString &str) throw()
+            : m_pch(str.GetString()), m_nLength(str.GetLength())
+        {
+        }
+
+        // explicit: CStaticString also converts to const XCHAR *, and an
+        // implicit conversion here would make Compare(psz) ambiguous
+        template <int t_nSize>
+        explicit CAmvStringViewT(_In_ const CStaticString<XCHAR, t_nSize> &str) throw()
+            : m_pch(str), m_nLength(str.GetLength())
+        {
+        }
+
+        const XCHAR *GetString() const throw() { return (m_pch); }
+        int GetLength() const throw() { return (m_nLength); }
+        bool IsEmpty() const throw() { return (m_nLength == 0); }
+
+        const XCHAR *begin() const throw() { return (m_pch); }
+        const XCHAR *end() const throw() { return (m_pch + m_nLength); }
+
+        XCHAR operator[](_In_ int iChar) const throw()
+        {
+            AMVASSERT(iChar >= 0 && iChar < m_nLength);
+            return (m_pch[iChar]);
+        }
+
+        XCHAR GetAt(_In_ int iChar) const throw() { return (operator[](iChar)); }
+
+        // sub-views, with the bounds clamped as in BStringT
+
+        CAmvStringViewT Mid(_In_ int iFirst) const throw() { return (Mid(iFirst, m_nLength)); }
+
+        CAmvStringViewT Mid(_In_ int iFirst, _In_ int nCount) const throw()
+        {
+            if (iFirst < 0)
+            {
+                iFirst = 0;
+            }
+            if (iFirst > m_nLength)
+            {
+                iFirst = m_nLength;
+            }
+            if (nCount < 0)
+            {
+                nCount = 0;
+            }
+            if (nCount > m_nLength - iFirst)
+            {
+                nCount = m_nLength - iFirst;
+            }
+            return (CAmvStringViewT(m_pch + iFirst, nCount));
+        }
+
+        CAmvStringViewT Left(_In_ int nCount) const throw() { return (Mid(0, nCount)); }
+
+        CAmvStringViewT Right(_In_ int nCount) const throw()
+        {
+            if (nCount < 0)
+            {
+                nCount = 0;
+            }
+            if (nCount > m_nLength)
+            {
+                nCount = m_nLength;
+            }
+            return (CAmvStringViewT(m_pch + m_nLength - nCount, nCount));
+        }
+
+        // Without the leading and trailing chars of 'set', whitespace by default
+        CAmvStringViewT Trim() const throw() { return (TrimLeft().TrimRight()); }
+
+        CAmvStringViewT Trim(_In_ const CAmvCharSet &set) const throw()
+        {
+            return (TrimLeft(set).TrimRight(set));
+        }
+
+        CAmvStringViewT TrimLeft() const throw() { return (TrimLeft(GetSpaceSet())); }
+
+        CAmvStringViewT TrimLeft(_In_ const CAmvCharSet &set) const throw()
+        {
+            int iFirst = static_cast<int>(AmvSpanIncluding(m_pch, m_nLength, set));
+            return (CAmvStringViewT(m_pch + iFirst, m_nLength - iFirst));
+        }
+
+        CAmvStringViewT TrimRight() const throw() { return (TrimRight(GetSpaceSet())); }
+
+        CAmvStringViewT TrimRight(_In_ const CAmvCharSet &set) const throw()
+        {
+            int nLength = m_nLength;
+            while (nLength > 0 && set.Contains(m_pch[nLength - 1]))
+            {
+                nLength--;
+            }
+            return (CAmvStringViewT(m_pch, nLength));
+        }
+
+        // searching; all return an index or -1
+
+        int Find(_In_ XCHAR ch, _In_ int iStart = 0) const throw()
+        {
+            if (iStart < 0 || iStart >= m_nLength)
+            {
+                return (-1);
+            }
+            return (IndexOf(AmvFindChar(m_pch + iStart, m_nLength - iStart, ch)));
+        }
+
+        int Find(_In_ const CAmvStringViewT &sub, _In_ int iStart = 0) const throw()
+        {
+            if (iStart < 0 || iStart > m_nLength)
+            {
+                return (-1);
+            }
+            return (IndexOf(AmvFindString(m_pch + iStart, m_nLength - iStart, sub.m_pch,
+                                          sub.m_nLength)));
+        }
+
+        int FindOneOf(_In_ const CAmvCharSet &set) const throw()
+        {
+            int iChar = static_cast<int>(AmvSpanExcluding(m_pch, m_nLength, set));
+            return ((iChar == m_nLength) ? -1 : iChar);
+        }
+
+        int ReverseFind(_In_ XCHAR ch) const throw()
+        {
+            return (IndexOf(AmvFindCharRev(m_pch, m_nLength, ch)));
+        }
+
+        bool StartsWith(_In_ const CAmvStringViewT &prefix) const throw()
+        {
+            return (prefix.m_nLength <= m_nLength &&
+                    memcmp(m_pch, prefix.m_pch, prefix.m_nLength * sizeof(XCHAR)) == 0);
+        }
+
+        bool EndsWith(_In_ const CAmvStringViewT &suffix) const throw()
+        {
+            return (suffix.m_nLength <= m_nLength &&
+                    memcmp(m_pch + m_nLength - suffix.m_nLength, suffix.m_pch,
+                           suffix.m_nLength * sizeof(XCHAR)) == 0);
+        }
+
+        // AmvHash() of the chars, the same as for a string with these chars
+        uint64_t GetHash() const throw() { return (AmvHash(m_pch, m_nLength)); }
+
+        // The whole view as a number, by std::from_chars(): no leading spaces,
+        // no '+' and no chars left over.  value is kept on failure.
+        template <typename T>
+        bool ParseNumber(_Inout_ T &value) const throw()
+        {
+            T n;
+            std::from_chars_result result = std::from_chars(m_pch, m_pch + m_nLength, n);
+            if (result.ec != std::errc() || result.ptr != m_pch + m_nLength)
+            {
+                return (false);
+            }
+            value = n;
+
+            return (true);
+        }
+
+        // UTF-8
+
+        bool IsValidUtf8() const throw() { return (AmvUtf8Validate(m_pch, m_nLength)); }
+
+        // Code points, not chars; the view should be valid UTF-8
+        int GetUtf8Length() const throw()
+        {
+            return (static_cast<int>(AmvUtf8Count(m_pch, m_nLength)));
+        }
+
+        // comparing
+
+        int Compare(_In_ const CAmvStringViewT &str) const throw()
+        {
+            return (AmvCompare(m_pch, m_nLength, str.m_pch, str.m_nLength));
+        }
+
+        int CompareNoCase(_In_ const CAmvStringViewT &str) const throw()
+        {
+            return (AmvCompareNoCase(m_pch, m_nLength, str.m_pch, str.m_nLength));
+        }
+
+        bool IsEqual(_In_ const CAmvStringViewT &str) const throw()
+        {
+            return (m_nLength == str.m_nLength &&
+                    (m_pch == str.m_pch ||
+                     memcmp(m_pch, str.m_pch, m_nLength * sizeof(XCHAR)) == 0));
+        }
+
+        friend bool operator==(_In_ const CAmvStringViewT &str1,
+                               _In_ const CAmvStringViewT &str2) throw()
+        {
+            return (str1.IsEqual(str2));
+        }
+
+        friend bool operator!=(_In_ const CAmvStringViewT &str1,
+                               _In_ const CAmvStringViewT &str2) throw()
+        {
+            return (!str1.IsEqual(str2));
+        }
+
+        friend bool operator<(_In_ const CAmvStringViewT &str1,
+                              _In_ const CAmvStringViewT &str2) throw()
+        {
+            return (str1.Compare(str2) < 0);
+        }
+
+    private:
+        int IndexOf(_In_opt_ const XCHAR *pch) const throw()
+        {
+            return ((pch == NULL) ? -1 : static_cast<int>(pch - m_pch));
+        }
+
+        static const XCHAR *GetNil() throw()
+        {
+            static const XCHAR chNil = 0;
+            return (&chNil);
+        }
+
+        static const CAmvCharSet &GetSpaceSet() throw()
+        {
+            static const CAmvCharSet set(" \t\n\v\f\r");
+            return (set);
+        }
+
+        const XCHAR *m_pch;
+        int m_nLength;
+    };
+
+    typedef CAmvStringViewT<char> CAmvStringView;
+
+    // Hash and equality for unordered containers keyed by strings.  Strings,
+    // views and C strings with the same chars hash alike, so with C++20 a
+    // BString key can be looked up with a view without making a string.
+    struct CAmvStringHash
+    {
+        typedef void is_transparent;
+
+        size_t operator()(_In_ const CSimpleStringT<char> &str) const throw()
+        {
+            return (static_cast<size_t>(str.GetHash()));
+        }
+
+        size_t operator()(_In_ const CAmvStringView &view) const throw()
+        {
+            return (static_cast<size_t>(view.GetHash()));
+        }
+    };
+
+    struct CAmvStringEqual
+    {
+        typedef void is_transparent;
+
+        bool operator()(_In_ const CAmvStringView &str1,
+                        _In_ const CAmvStringView &str2) const throw()
+        {
+            return (str1.IsEqual(str2));
+        }
+    };
+
+    // Splits a view into tokens without copying or allocating.  The tokens
+    // are views into the source.
+    //
+    // By default the tokens are separated by runs of delimiters and empty
+    // tokens are skipped, like strtok().  With bKeepEmpty every delimiter
+    // ends a field, so "a,,b," gives "a", "", "b" and "" as a CSV reader
+    // wants.
+    class CAmvTokenizer
+    {
+    public:
+        CAmvTokenizer(_In_ const CAmvStringView &str, _In_ char chDelimiter,
+                      _In_ bool bKeepEmpty = false) throw()
+            : m_str(str), m_iNext(0), m_bKeepEmpty(bKeepEmpty), m_bSingle(true),
+              m_chDelimiter(chDelimiter), m_set(&chDelimiter, 1), m_bDone(false)
+        {
+        }
+
+        CAmvTokenizer(_In_ const CAmvStringView &str, _In_z_ const char *pszDelimiters,
+                      _In_ bool bKeepEmpty = false) throw()
+            : m_str(str), m_iNext(0), m_bKeepEmpty(bKeepEmpty), m_bSingle(false),
+              m_chDelimiter(0), m_set(pszDelimiters), m_bDone(false)
+        {
+        }
+
+        // Next token in 'token'; false (and 'token' untouched) at the end
+        bool Next(_Out_ CAmvStringView &token) throw()
+        {
+            const char *pch = m_str.GetString();
+            int nLength = m_str.GetLength();
+
+            if (!m_bKeepEmpty)
+            {
+                m_iNext += static_cast<int>(
+                    AmvSpanIncluding(pch + m_iNext, nLength - m_iNext, m_set));
+                if (m_iNext == nLength)
+                {
+                    return false;
+                }
+            }
+            else if (m_bDone)
+            {
+                return false;
+            }
+
+            int iEnd = m_iNext + FindDelimiter(pch + m_iNext, nLength - m_iNext);
+            token = CAmvStringView(pch + m_iNext, iEnd - m_iNext);
+            if (iEnd == nLength)
+            {
+                m_bDone = true;
+                m_iNext = nLength;
+            }
+            else
+            {
+                m_iNext = iEnd + 1;
+            }
+            return true;
+        }
+
+        // What is left after the last token returned
+        CAmvStringView GetRemainder() const throw() { return (m_str.Mid(m_iNext)); }
+
+    private:
+        int FindDelimiter(_In_reads_(n) const char *pch, _In_ int n) const throw()
+        {
+            if (m_bSingle)
+            {
+                const char *pchFound = AmvFindChar(pch, n, m_chDelimiter);
+                return ((pchFound == NULL) ? n : static_cast<int>(pchFound - pch));
+            }
+            return (static_cast<int>(AmvSpanExcluding(pch, n, m_set)));
+        }
+
+        CAmvStringView m_str;
+        int m_iNext;
+        bool m_bKeepEmpty;
+        bool m_bSingle;
+        char m_chDelimiter;
+        CAmvCharSet m_set;
+        // bKeepEmpty: the last field has been returned
+        bool m_bDone;
+    };
+
+} // namespace AMV
+
+namespace std
+{
+
+    template <typename XCHAR>
+    struct hash<AMV::CAmvStringViewT<XCHAR>>
+    {
+        size_t operator()(_In_ const AMV::CAmvStringViewT<XCHAR> &view) const throw()
+        {
+            return (static_cast<size_t>(view.GetHash()));
+        }
+    };
+
+    template <int t_nSize>
+    struct hash<AMV::CStaticString<char, t_nSize>>
+    {
+        size_t operator()(_In_ const AMV::CStaticString<char, t_nSize> &str) const throw()
+        {
+            return (static_cast<size_t>(AMV::AmvHash(str, str.GetLength())));
+        }
+    };
+
+} // namespace std
+
+#endif // AMVSTRVIEW_HPP_
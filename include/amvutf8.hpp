@@ -0,0 +1,676 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef AMVUTF8_HPP_
+#define AMVUTF8_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "include/amvdefine.hpp"
+#include "include/amvsimd.hpp"
+#include "salieri-src/salieri.h"
+
+namespace AMV
+{
+
+    // UTF-8 kernels.  Validation follows the lookup algorithm of Keiser and
+    // Lemire ("Validating UTF-8 In Less Than One Instruction Per Byte"): every
+    // byte is classified with three nibble table lookups on itself and the
+    // byte before it, which catches all two-byte errors, and a saturated
+    // subtraction finds the continuation bytes that 3- and 4-byte sequences
+    // require.  Blocks of pure ASCII skip all of it.
+    namespace AmvSimd
+    {
+
+        inline bool Utf8ValidateScalar(_In_reads_(n) const char *pch, _In_ size_t n) throw()
+        {
+            const unsigned char *p = reinterpret_cast<const unsigned char *>(pch);
+            size_t i = 0;
+            while (i < n)
+            {
+                // Eight ASCII chars at a time
+                if (i + 8 <= n)
+                {
+                    uint64_t v;
+                    memcpy(&v, p + i, sizeof(v));
+                    if ((v & 0x8080808080808080ull) == 0)
+                    {
+                        i += 8;
+                        continue;
+                    }
+                }
+
+                unsigned int c = p[i];
+                if (c < 0x80)
+                {
+                    i++;
+                    continue;
+                }
+
+                size_t nLength;
+                unsigned int nMin = 0x80, nMax = 0xbf;
+                if (c >= 0xc2 && c <= 0xdf)
+                {
+                    nLength = 2;
+                }
+                else if (c >= 0xe0 && c <= 0xef)
+                {
+                    nLength = 3;
+                    // Overlong forms and UTF-16 surrogates
+                    nMin = (c == 0xe0) ? 0xa0 : 0x80;
+                    nMax = (c == 0xed) ? 0x9f : 0xbf;
+                }
+                else if (c >= 0xf0 && c <= 0xf4)
+                {
+                    nLength = 4;
+                    // Overlong forms and code points above U+10FFFF
+                    nMin = (c == 0xf0) ? 0x90 : 0x80;
+                    nMax = (c == 0xf4) ? 0x8f : 0xbf;
+                }
+                else
+                {
+                    return (false);
+                }
+
+                if (n - i < nLength || p[i + 1] < nMin || p[i + 1] > nMax)
+                {
+                    return (false);
+                }
+                for (size_t j = 2; j < nLength; j++)
+                {
+                    if ((p[i + j] & 0xc0) != 0x80)
+                    {
+                        return (false);
+                    }
+                }
+                i += nLength;
+            }
+
+            return (true);
+        }
+
+        // Code points in p[0, n): the bytes that are not continuation bytes
+        inline size_t Utf8CountScalar(_In_reads_(n) const char *p, _In_ size_t n) throw()
+        {
+            size_t nCount = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                nCount += (static_cast<signed char>(p[i]) > -65);
+            }
+            return (nCount);
+        }
+
+        // The offset of the nChars-th byte of p[i, n) that is not a
+        // continuation byte, or n.  0 < nChars.
+        inline size_t Utf8AdvanceTail(_In_reads_(n) const char *p, _In_ size_t n,
+                                      _In_ size_t nChars, _In_ size_t i) throw()
+        {
+            for (; i < n; i++)
+            {
+                if (static_cast<signed char>(p[i]) > -65 && --nChars == 0)
+                {
+                    return (i);
+                }
+            }
+            return (n);
+        }
+
+        // The offset of the code point nChars after the one at p[0], or n: the
+        // nChars-th byte of p[1, n) that is not a continuation byte
+        inline size_t Utf8AdvanceScalar(_In_reads_(n) const char *p, _In_ size_t n,
+                                        _In_ size_t nChars) throw()
+        {
+            return ((nChars == 0) ? 0 : Utf8AdvanceTail(p, n, nChars, 1));
+        }
+
+        // The error classes of the lookup tables; a pair of bytes is invalid
+        // when the three lookups share a bit
+        enum Utf8Error
+        {
+            UTF8_TOO_SHORT = 1 << 0,  // 11______ 0_______, 11______ 11______
+            UTF8_TOO_LONG = 1 << 1,   // 0_______ 10______
+            UTF8_OVERLONG_3 = 1 << 2, // 11100000 100_____
+            UTF8_TOO_LARGE = 1 << 3,  // 11110100 1001____, 11110100 101_____, 11110101+
+            UTF8_SURROGATE = 1 << 4,  // 11101101 101_____
+            UTF8_OVERLONG_2 = 1 << 5, // 1100000_ 10______
+            UTF8_TOO_LARGE_1000 = 1 << 6,
+            UTF8_OVERLONG_4 = 1 << 6, // 11110000 1000____
+            UTF8_TWO_CONTS = 1 << 7,  // 10______ 10______
+            UTF8_CARRY = UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS
+        };
+
+        // Indexed by the high nibble of the first byte
+        static const uint8_t UTF8_BYTE_1_HIGH[16] = {
+            UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+            UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+            UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+            UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+            UTF8_TOO_SHORT,
+            UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+            UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4};
+
+        // Indexed by the low nibble of the first byte
+        static const uint8_t UTF8_BYTE_1_LOW[16] = {
+            UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+            UTF8_CARRY | UTF8_OVERLONG_2,
+            UTF8_CARRY,
+            UTF8_CARRY,
+            UTF8_CARRY | UTF8_TOO_LARGE,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+            UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000};
+
+        // Indexed by the high nibble of the second byte
+        static const uint8_t UTF8_BYTE_2_HIGH[16] = {
+            UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+            UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+            UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+                UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+            UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+                UTF8_TOO_LARGE,
+            UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+                UTF8_TOO_LARGE,
+            UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+                UTF8_TOO_LARGE,
+            UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT};
+
+        // A block may end inside a sequence when its last 3 bytes exceed these
+        static const uint8_t UTF8_MAX_TAIL[32] = {
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1};
+
+#if defined(AMV_SIMD_X86)
+
+        struct CUtf8StateSsse3
+        {
+            __m128i prev;
+            __m128i prevIncomplete;
+            __m128i error;
+        };
+
+        __attribute__((target("ssse3"))) inline void Utf8BlockSsse3(
+            _Inout_ CUtf8StateSsse3 &state, _In_ __m128i input) throw()
+        {
+            if (_mm_movemask_epi8(input) == 0)
+            {
+                // ASCII: only a sequence cut by the previous block can be wrong
+                state.error = _mm_or_si128(state.error, state.prevIncomplete);
+            }
+            else
+            {
+                const __m128i nibble = _mm_set1_epi8(0x0f);
+                __m128i prev1 = _mm_alignr_epi8(input, state.prev, 15);
+                __m128i byte1High = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(UTF8_BYTE_1_HIGH)),
+                    _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+                __m128i byte1Low = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(UTF8_BYTE_1_LOW)),
+                    _mm_and_si128(prev1, nibble));
+                __m128i byte2High = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(UTF8_BYTE_2_HIGH)),
+                    _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+                __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+                // Only 111_____ two bytes back and 1111____ three bytes back
+                // keep their top bit: those positions must be continuations
+                __m128i prev2 = _mm_alignr_epi8(input, state.prev, 14);
+                __m128i prev3 = _mm_alignr_epi8(input, state.prev, 13);
+                __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xe0 - 0x80)),
+                                              _mm_subs_epu8(prev3, _mm_set1_epi8(0xf0 - 0x80)));
+                __m128i must23Top = _mm_and_si128(must23, _mm_set1_epi8(-128));
+                state.error = _mm_or_si128(state.error, _mm_xor_si128(must23Top, special));
+
+                state.prevIncomplete = _mm_subs_epu8(
+                    input, _mm_loadu_si128(reinterpret_cast<const __m128i *>(UTF8_MAX_TAIL + 16)));
+            }
+            state.prev = input;
+        }
+
+        __attribute__((target("ssse3"))) inline bool Utf8ValidateSsse3(
+            _In_reads_(n) const char *p, _In_ size_t n) throw()
+        {
+            CUtf8StateSsse3 state;
+            state.prev = _mm_setzero_si128();
+            state.prevIncomplete = _mm_setzero_si128();
+            state.error = _mm_setzero_si128();
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                Utf8BlockSsse3(state, _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)));
+            }
+            if (i < n)
+            {
+                // Zero padding is ASCII, so a cut sequence shows as TOO_SHORT
+                alignas(16) char achTail[16] = {0};
+                memcpy(achTail, p + i, n - i);
+                Utf8BlockSsse3(state, _mm_load_si128(reinterpret_cast<const __m128i *>(achTail)));
+            }
+            state.error = _mm_or_si128(state.error, state.prevIncomplete);
+
+            return (_mm_movemask_epi8(_mm_cmpeq_epi8(state.error, _mm_setzero_si128())) ==
+                    0xffff);
+        }
+
+        struct CUtf8StateAvx2
+        {
+            __m256i prev;
+            __m256i prevIncomplete;
+            __m256i error;
+        };
+
+        // The bytes of prev and input shifted so that lane i holds the byte N
+        // positions before input[i]
+        template <int N>
+        __attribute__((target("avx2"))) inline __m256i Utf8PrevAvx2(_In_ __m256i input,
+                                                                    _In_ __m256i prev) throw()
+        {
+            return (_mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21),
+                                       16 - N));
+        }
+
+        __attribute__((target("avx2"))) inline void Utf8BlockAvx2(
+            _Inout_ CUtf8StateAvx2 &state, _In_ __m256i input) throw()
+        {
+            if (_mm256_movemask_epi8(input) == 0)
+            {
+                state.error = _mm256_or_si256(state.error, state.prevIncomplete);
+            }
+            else
+            {
+                const __m256i nibble = _mm256_set1_epi8(0x0f);
+                const __m256i table1 = _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(UTF8_BYTE_1_HIGH)));
+                const __m256i table2 = _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(UTF8_BYTE_1_LOW)));
+                const __m256i table3 = _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(UTF8_BYTE_2_HIGH)));
+
+                __m256i prev1 = Utf8PrevAvx2<1>(input, state.prev);
+                __m256i byte1High = _mm256_shuffle_epi8(
+                    table1, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+                __m256i byte1Low = _mm256_shuffle_epi8(table2, _mm256_and_si256(prev1, nibble));
+                __m256i byte2High = _mm256_shuffle_epi8(
+                    table3, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+                __m256i special =
+                    _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+                __m256i must23 = _mm256_or_si256(
+                    _mm256_subs_epu8(Utf8PrevAvx2<2>(input, state.prev),
+                                     _mm256_set1_epi8(0xe0 - 0x80)),
+                    _mm256_subs_epu8(Utf8PrevAvx2<3>(input, state.prev),
+                                     _mm256_set1_epi8(0xf0 - 0x80)));
+                __m256i must23Top = _mm256_and_si256(must23, _mm256_set1_epi8(-128));
+                state.error =
+                    _mm256_or_si256(state.error, _mm256_xor_si256(must23Top, special));
+
+                state.prevIncomplete = _mm256_subs_epu8(
+                    input, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(UTF8_MAX_TAIL)));
+            }
+            state.prev = input;
+        }
+
+        __attribute__((target("avx2"))) inline bool Utf8ValidateAvx2(
+            _In_reads_(n) const char *p, _In_ size_t n) throw()
+        {
+            CUtf8StateAvx2 state;
+            state.prev = _mm256_setzero_si256();
+            state.prevIncomplete = _mm256_setzero_si256();
+            state.error = _mm256_setzero_si256();
+
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                Utf8BlockAvx2(state,
+                              _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)));
+            }
+            if (i < n)
+            {
+                alignas(32) char achTail[32] = {0};
+                memcpy(achTail, p + i, n - i);
+                Utf8BlockAvx2(state,
+                              _mm256_load_si256(reinterpret_cast<const __m256i *>(achTail)));
+            }
+            state.error = _mm256_or_si256(state.error, state.prevIncomplete);
+
+            return (_mm256_testz_si256(state.error, state.error) != 0);
+        }
+
+        inline size_t Utf8CountSse2(_In_reads_(n) const char *p, _In_ size_t n) throw()
+        {
+            const __m128i cont = _mm_set1_epi8(-65);
+            size_t nCount = 0;
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                nCount += __builtin_popcount(
+                    static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, cont))));
+            }
+            return (nCount + Utf8CountScalar(p + i, n - i));
+        }
+
+        // Counts the code points of whole blocks as Utf8CountSse2() does and
+        // only looks for the bit of the block that holds the last one
+        inline size_t Utf8AdvanceSse2(_In_reads_(n) const char *p, _In_ size_t n,
+                                      _In_ size_t nChars) throw()
+        {
+            if (nChars == 0)
+            {
+                return (0);
+            }
+            const __m128i cont = _mm_set1_epi8(-65);
+            size_t i = 1;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                unsigned int nMask =
+                    static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, cont)));
+                size_t nLeads = __builtin_popcount(nMask);
+                if (nLeads >= nChars)
+                {
+                    while (--nChars > 0)
+                    {
+                        nMask &= nMask - 1;
+                    }
+                    return (i + __builtin_ctz(nMask));
+                }
+                nChars -= nLeads;
+            }
+            return (Utf8AdvanceTail(p, n, nChars, i));
+        }
+
+#elif defined(AMV_SIMD_NEON)
+
+        struct CUtf8StateNeon
+        {
+            uint8x16_t prev;
+            uint8x16_t prevIncomplete;
+            uint8x16_t error;
+        };
+
+        inline void Utf8BlockNeon(_Inout_ CUtf8StateNeon &state, _In_ uint8x16_t input) throw()
+        {
+            if (vmaxvq_u8(input) < 0x80)
+            {
+                state.error = vorrq_u8(state.error, state.prevIncomplete);
+            }
+            else
+            {
+                const uint8x16_t nibble = vdupq_n_u8(0x0f);
+                uint8x16_t prev1 = vextq_u8(state.prev, input, 15);
+                uint8x16_t byte1High = vqtbl1q_u8(vld1q_u8(UTF8_BYTE_1_HIGH), vshrq_n_u8(prev1, 4));
+                uint8x16_t byte1Low = vqtbl1q_u8(vld1q_u8(UTF8_BYTE_1_LOW), vandq_u8(prev1, nibble));
+                uint8x16_t byte2High = vqtbl1q_u8(vld1q_u8(UTF8_BYTE_2_HIGH), vshrq_n_u8(input, 4));
+                uint8x16_t special = vandq_u8(vandq_u8(byte1High, byte1Low), byte2High);
+
+                uint8x16_t must23 =
+                    vorrq_u8(vqsubq_u8(vextq_u8(state.prev, input, 14), vdupq_n_u8(0xe0 - 0x80)),
+                             vqsubq_u8(vextq_u8(state.prev, input, 13), vdupq_n_u8(0xf0 - 0x80)));
+                uint8x16_t must23Top = vandq_u8(must23, vdupq_n_u8(0x80));
+                state.error = vorrq_u8(state.error, veorq_u8(must23Top, special));
+
+                state.prevIncomplete = vqsubq_u8(input, vld1q_u8(UTF8_MAX_TAIL + 16));
+            }
+            state.prev = input;
+        }
+
+        inline bool Utf8ValidateNeon(_In_reads_(n) const char *p, _In_ size_t n) throw()
+        {
+            CUtf8StateNeon state;
+            state.prev = vdupq_n_u8(0);
+            state.prevIncomplete = vdupq_n_u8(0);
+            state.error = vdupq_n_u8(0);
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                Utf8BlockNeon(state, vld1q_u8(reinterpret_cast<const uint8_t *>(p + i)));
+            }
+            if (i < n)
+            {
+                uint8_t achTail[16] = {0};
+                memcpy(achTail, p + i, n - i);
+                Utf8BlockNeon(state, vld1q_u8(achTail));
+            }
+            state.error = vorrq_u8(state.error, state.prevIncomplete);
+
+            return (vmaxvq_u8(state.error) == 0);
+        }
+
+        inline size_t Utf8CountNeon(_In_reads_(n) const char *p, _In_ size_t n) throw()
+        {
+            const int8x16_t cont = vdupq_n_s8(-65);
+            size_t nCount = 0;
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                int8x16_t v = vld1q_s8(reinterpret_cast<const int8_t *>(p + i));
+                nCount += vaddvq_u8(vshrq_n_u8(vcgtq_s8(v, cont), 7));
+            }
+            return (nCount + Utf8CountScalar(p + i, n - i));
+        }
+
+        inline size_t Utf8AdvanceNeon(_In_reads_(n) const char *p, _In_ size_t n,
+                                      _In_ size_t nChars) throw()
+        {
+            if (nChars == 0)
+            {
+                return (0);
+            }
+            const int8x16_t cont = vdupq_n_s8(-65);
+            size_t i = 1;
+            for (; i + 16 <= n; i += 16)
+            {
+                int8x16_t v = vld1q_s8(reinterpret_cast<const int8_t *>(p + i));
+                // 4 bits per byte; keep one of them so that each byte is one bit
+                uint64_t nMask =
+                    vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(
+                                      vreinterpretq_u16_u8(vcgtq_s8(v, cont)), 4)),
+                                  0) &
+                    0x8888888888888888ULL;
+                size_t nLeads = __builtin_popcountll(nMask);
+                if (nLeads >= nChars)
+                {
+                    while (--nChars > 0)
+                    {
+                        nMask &= nMask - 1;
+                    }
+                    return (i + (__builtin_ctzll(nMask) >> 2));
+                }
+                nChars -= nLeads;
+            }
+            return (Utf8AdvanceTail(p, n, nChars, i));
+        }
+
+#endif
+
+    } // namespace AmvSimd
+
+    // true if p[0, n) is well-formed UTF-8: no overlong forms, surrogates,
+    // code points above U+10FFFF or cut sequences
+    inline bool AmvUtf8Validate(_In_reads_(n) const char *p, _In_ size_t n) throw()
+    {
+        // The padded tail block costs more than the scalar loop below 16 chars
+        if (n < 16)
+        {
+            return AmvSimd::Utf8ValidateScalar(p, n);
+        }
+#if defined(AMV_SIMD_X86)
+        switch (AmvSimd::GetLevel())
+        {
+        case AmvSimd::LEVEL_AVX512:
+        case AmvSimd::LEVEL_AVX2:
+            return AmvSimd::Utf8ValidateAvx2(p, n);
+        case AmvSimd::LEVEL_SSSE3:
+            return AmvSimd::Utf8ValidateSsse3(p, n);
+        default:
+            return AmvSimd::Utf8ValidateScalar(p, n);
+        }
+#elif defined(AMV_SIMD_NEON)
+        return AmvSimd::Utf8ValidateNeon(p, n);
+#else
+        return AmvSimd::Utf8ValidateScalar(p, n);
+#endif
+    }
+
+    // Code points in p[0, n), which should be valid UTF-8
+    inline size_t AmvUtf8Count(_In_reads_(n) const char *p, _In_ size_t n) throw()
+    {
+#if defined(AMV_SIMD_X86)
+        return AmvSimd::Utf8CountSse2(p, n);
+#elif defined(AMV_SIMD_NEON)
+        return AmvSimd::Utf8CountNeon(p, n);
+#else
+        return AmvSimd::Utf8CountScalar(p, n);
+#endif
+    }
+
+    // The offset in p[0, n) of the code point nChars after the one at p[0], or
+    // n when the string ends first.  As in AmvUtf8Count(), a code point is a
+    // byte that is not a continuation byte and the continuation bytes after it.
+    inline size_t AmvUtf8Advance(_In_reads_(n) const char *p, _In_ size_t n,
+                                 _In_ size_t nChars) throw()
+    {
+#if defined(AMV_SIMD_X86)
+        return AmvSimd::Utf8AdvanceSse2(p, n, nChars);
+#elif defined(AMV_SIMD_NEON)
+        return AmvSimd::Utf8AdvanceNeon(p, n, nChars);
+#else
+        return AmvSimd::Utf8AdvanceScalar(p, n, nChars);
+#endif
+    }
+
+    // Converts the UTF-8 in p[0, n) to UTF-16.  Returns the number of char16_t
+    // written, or needed when pDest is NULL, and -1 for invalid input or a
+    // pDest shorter than nDest.
+    inline int AmvUtf8ToUtf16(_In_reads_(n) const char *p, _In_ int n,
+                              _Out_writes_opt_(nDest) char16_t *pDest, _In_ int nDest) throw()
+    {
+        if (!AmvUtf8Validate(p, n))
+        {
+            return (-1);
+        }
+
+        const unsigned char *pu = reinterpret_cast<const unsigned char *>(p);
+        int nOut = 0;
+        int i = 0;
+        while (i < n)
+        {
+            unsigned int c = pu[i];
+            uint32_t cp;
+            if (c < 0x80)
+            {
+                cp = c;
+                i += 1;
+            }
+            else if (c < 0xe0)
+            {
+                cp = ((c & 0x1f) << 6) | (pu[i + 1] & 0x3f);
+                i += 2;
+            }
+            else if (c < 0xf0)
+            {
+                cp = ((c & 0x0f) << 12) | ((pu[i + 1] & 0x3f) << 6) | (pu[i + 2] & 0x3f);
+                i += 3;
+            }
+            else
+            {
+                cp = ((c & 0x07) << 18) | ((pu[i + 1] & 0x3f) << 12) |
+                     ((pu[i + 2] & 0x3f) << 6) | (pu[i + 3] & 0x3f);
+                i += 4;
+            }
+
+            int nUnits = (cp >= 0x10000) ? 2 : 1;
+            if (pDest != NULL)
+            {
+                if (nOut + nUnits > nDest)
+                {
+                    return (-1);
+                }
+                if (nUnits == 2)
+                {
+                    cp -= 0x10000;
+                    pDest[nOut] = static_cast<char16_t>(0xd800 | (cp >> 10));
+                    pDest[nOut + 1] = static_cast<char16_t>(0xdc00 | (cp & 0x3ff));
+                }
+                else
+                {
+                    pDest[nOut] = static_cast<char16_t>(cp);
+                }
+            }
+            nOut += nUnits;
+        }
+
+        return (nOut);
+    }
+
+    // Converts the UTF-16 in p[0, n) to UTF-8.  Returns the number of chars
+    // written, or needed when pDest is NULL, and -1 for an unpaired surrogate
+    // or a pDest shorter than nDest.
+    inline int AmvUtf16ToUtf8(_In_reads_(n) const char16_t *p, _In_ int n,
+                              _Out_writes_opt_(nDest) char *pDest, _In_ int nDest) throw()
+    {
+        int nOut = 0;
+        int i = 0;
+        while (i < n)
+        {
+            uint32_t cp = p[i++];
+            if (cp >= 0xd800 && cp <= 0xdfff)
+            {
+                if (cp >= 0xdc00 || i == n || p[i] < 0xdc00 || p[i] > 0xdfff)
+                {
+                    return (-1);
+                }
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (p[i++] - 0xdc00);
+            }
+
+            int nUnits = (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+            if (pDest != NULL)
+            {
+                if (nOut + nUnits > nDest)
+                {
+                    return (-1);
+                }
+                char *pch = pDest + nOut;
+                switch (nUnits)
+                {
+                case 1:
+                    pch[0] = static_cast<char>(cp);
+                    break;
+                case 2:
+                    pch[0] = static_cast<char>(0xc0 | (cp >> 6));
+                    pch[1] = static_cast<char>(0x80 | (cp & 0x3f));
+                    break;
+                case 3:
+                    pch[0] = static_cast<char>(0xe0 | (cp >> 12));
+                    pch[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                    pch[2] = static_cast<char>(0x80 | (cp & 0x3f));
+                    break;
+                default:
+                    pch[0] = static_cast<char>(0xf0 | (cp >> 18));
+                    pch[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+                    pch[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                    pch[3] = static_cast<char>(0x80 | (cp & 0x3f));
+                    break;
+                }
+            }
+            nOut += nUnits;
+        }
+
+        return (nOut);
+    }
+
+} // namespace AMV
+
+#endif // AMVUTF8_HPP_
@@ -42,8 +42,13 @@
 
 #include <fmt/core.h>
 
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+
+#include "include/CAriaKey.hpp"
+#include "lib/CAria_backend.hpp"
 
 namespace Awesome_mix_vol_1 {
 
@@ -58,13 +63,15 @@ void CAria::printBlockOfLength(Byte *b, int len) {
 
 void CAria::printBlock(Byte *b) { printBlockOfLength(b, 16); }
 
-/* 암호화 함수.
+/* 라운드 수가 Nr(12, 14, 16)로 정해진 암호화 함수.
+ * 라운드 수에 따른 분기 없이 모든 라운드가 펼쳐진다.
  * const Byte *i: 입력
- * int Nr: 라운드 수
  * const Byte *rk: 라운드 키들
  * Byte *o: 출력
  */
-void CAria::Crypt(const Byte *i, int Nr, const Byte *rk, Byte *o) {
+template <int Nr>
+void CAria::Crypt(const Byte *i, const Byte *rk, Byte *o) {
+  static_assert(Nr == 12 || Nr == 14 || Nr == 16, "Nr must be 12, 14 or 16");
   Word t0, t1, t2, t3;
 
   WordLoad(WO(const_cast<Byte *>(i), 0), t0);
@@ -72,64 +79,414 @@ void CAria::Crypt(const Byte *i, int Nr, const Byte *rk, Byte *o) {
   WordLoad(WO(const_cast<Byte *>(i), 2), t2);
   WordLoad(WO(const_cast<Byte *>(i), 3), t3);
 
-  if (Nr > 12) {
+  if constexpr (Nr > 12) {
     KXL FO KXL FE
   }
-  if (Nr > 14) {
+  if constexpr (Nr > 14) {
     KXL FO KXL FE
   }
   KXL FO KXL FE KXL FO KXL FE KXL FO KXL FE KXL FO KXL FE KXL FO KXL FE KXL FO
       KXL
 
   /* 최종 라운드는 특별함 */
-#ifdef _LITTLE_ENDIAN_
-          o[0] = (Byte)(X1[BRF(t0, 24)]) ^ rk[3];
-  o[1] = (Byte)(X2[BRF(t0, 16)] >> 8) ^ rk[2];
-  o[2] = (Byte)(S1[BRF(t0, 8)]) ^ rk[1];
-  o[3] = (Byte)(S2[BRF(t0, 0)]) ^ rk[0];
-  o[4] = (Byte)(X1[BRF(t1, 24)]) ^ rk[7];
-  o[5] = (Byte)(X2[BRF(t1, 16)] >> 8) ^ rk[6];
-  o[6] = (Byte)(S1[BRF(t1, 8)]) ^ rk[5];
-  o[7] = (Byte)(S2[BRF(t1, 0)]) ^ rk[4];
-  o[8] = (Byte)(X1[BRF(t2, 24)]) ^ rk[11];
-  o[9] = (Byte)(X2[BRF(t2, 16)] >> 8) ^ rk[10];
-  o[10] = (Byte)(S1[BRF(t2, 8)]) ^ rk[9];
-  o[11] = (Byte)(S2[BRF(t2, 0)]) ^ rk[8];
-  o[12] = (Byte)(X1[BRF(t3, 24)]) ^ rk[15];
-  o[13] = (Byte)(X2[BRF(t3, 16)] >> 8) ^ rk[14];
-  o[14] = (Byte)(S1[BRF(t3, 8)]) ^ rk[13];
-  o[15] = (Byte)(S2[BRF(t3, 0)]) ^ rk[12];
-#else
-          o[0] = (Byte)(X1[BRF(t0, 24)]);
-  o[1] = (Byte)(X2[BRF(t0, 16)] >> 8);
-  o[2] = (Byte)(S1[BRF(t0, 8)]);
-  o[3] = (Byte)(S2[BRF(t0, 0)]);
-  o[4] = (Byte)(X1[BRF(t1, 24)]);
-  o[5] = (Byte)(X2[BRF(t1, 16)] >> 8);
-  o[6] = (Byte)(S1[BRF(t1, 8)]);
-  o[7] = (Byte)(S2[BRF(t1, 0)]);
-  o[8] = (Byte)(X1[BRF(t2, 24)]);
-  o[9] = (Byte)(X2[BRF(t2, 16)] >> 8);
-  o[10] = (Byte)(S1[BRF(t2, 8)]);
-  o[11] = (Byte)(S2[BRF(t2, 0)]);
-  o[12] = (Byte)(X1[BRF(t3, 24)]);
-  o[13] = (Byte)(X2[BRF(t3, 16)] >> 8);
-  o[14] = (Byte)(S1[BRF(t3, 8)]);
-  o[15] = (Byte)(S2[BRF(t3, 0)]);
-  WO(o, 0) ^= WO(const_cast<Byte *>(rk), 0);
-  WO(o, 1) ^= WO(const_cast<Byte *>(rk), 1);
-  WO(o, 2) ^= WO(const_cast<Byte *>(rk), 2);
-  WO(o, 3) ^= WO(const_cast<Byte *>(rk), 3);
-#endif
+  LAST_ROUND(t0, t1, t2, t3, rk, o)
+}
+
+template void CAria::Crypt<12>(const Byte *i, const Byte *rk, Byte *o);
+template void CAria::Crypt<14>(const Byte *i, const Byte *rk, Byte *o);
+template void CAria::Crypt<16>(const Byte *i, const Byte *rk, Byte *o);
+
+/* 암호화 함수.  라운드 수에 맞는 Crypt<Nr>()을 부른다.
+ * const Byte *i: 입력
+ * int Nr: 라운드 수
+ * const Byte *rk: 라운드 키들
+ * Byte *o: 출력
+ */
+void CAria::Crypt(const Byte *i, int Nr, const Byte *rk, Byte *o) {
+  if (Nr > 14) {
+    Crypt<16>(i, rk, o);
+  } else if (Nr > 12) {
+    Crypt<14>(i, rk, o);
+  } else {
+    Crypt<12>(i, rk, o);
+  }
+}
+
+/* 블록 4개를 한 번에 처리하는 KXL, FO, FE.
+ * 각 블록의 상태는 (a0..a3), (b0..b3), (c0..c3), (d0..d3)이다. */
+#define KXL4                  \
+  {                           \
+    KXL_N(a0, a1, a2, a3, rk) \
+    KXL_N(b0, b1, b2, b3, rk) \
+    KXL_N(c0, c1, c2, c3, rk) \
+    KXL_N(d0, d1, d2, d3, rk) \
+    rk += 16;                 \
+  }
+#define FO4              \
+  {                      \
+    FO_N(a0, a1, a2, a3) \
+    FO_N(b0, b1, b2, b3) \
+    FO_N(c0, c1, c2, c3) \
+    FO_N(d0, d1, d2, d3) \
+  }
+#define FE4              \
+  {                      \
+    FE_N(a0, a1, a2, a3) \
+    FE_N(b0, b1, b2, b3) \
+    FE_N(c0, c1, c2, c3) \
+    FE_N(d0, d1, d2, d3) \
+  }
+
+/* 연속된 블록 4개(64 Byte)를 암호화하는 함수.
+ * Crypt()와 결과는 같지만, 서로 독립인 네 블록의 라운드를 한데 섞어서
+ * S1/S2/X1/X2 테이블 참조의 지연 시간이 겹치도록 한다.
+ * const Byte *i: 입력 (64 Byte)
+ * const Byte *rk: 라운드 키들
+ * Byte *o: 출력 (64 Byte)
+ */
+template <int Nr>
+static void Crypt4(const Byte *i, const Byte *rk, Byte *o) {
+  Word a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3, d0, d1, d2, d3;
+
+  WordLoad(WO(const_cast<Byte *>(i), 0), a0);
+  WordLoad(WO(const_cast<Byte *>(i), 1), a1);
+  WordLoad(WO(const_cast<Byte *>(i), 2), a2);
+  WordLoad(WO(const_cast<Byte *>(i), 3), a3);
+  WordLoad(WO(const_cast<Byte *>(i), 4), b0);
+  WordLoad(WO(const_cast<Byte *>(i), 5), b1);
+  WordLoad(WO(const_cast<Byte *>(i), 6), b2);
+  WordLoad(WO(const_cast<Byte *>(i), 7), b3);
+  WordLoad(WO(const_cast<Byte *>(i), 8), c0);
+  WordLoad(WO(const_cast<Byte *>(i), 9), c1);
+  WordLoad(WO(const_cast<Byte *>(i), 10), c2);
+  WordLoad(WO(const_cast<Byte *>(i), 11), c3);
+  WordLoad(WO(const_cast<Byte *>(i), 12), d0);
+  WordLoad(WO(const_cast<Byte *>(i), 13), d1);
+  WordLoad(WO(const_cast<Byte *>(i), 14), d2);
+  WordLoad(WO(const_cast<Byte *>(i), 15), d3);
+
+  if constexpr (Nr > 12) {
+    KXL4 FO4 KXL4 FE4
+  }
+  if constexpr (Nr > 14) {
+    KXL4 FO4 KXL4 FE4
+  }
+  KXL4 FO4 KXL4 FE4 KXL4 FO4 KXL4 FE4 KXL4 FO4 KXL4 FE4 KXL4 FO4 KXL4 FE4
+  KXL4 FO4 KXL4 FE4 KXL4 FO4 KXL4
+
+  LAST_ROUND(a0, a1, a2, a3, rk, o)
+  LAST_ROUND(b0, b1, b2, b3, rk, o + 16)
+  LAST_ROUND(c0, c1, c2, c3, rk, o + 32)
+  LAST_ROUND(d0, d1, d2, d3, rk, o + 48)
+}
+
+/* 테이블 백엔드: 블록 4개씩 Crypt4()로, 남은 블록은 Crypt()로 처리한다. */
+template <int Nr>
+static void TableCryptBlocks(const Byte *i, size_t nBlocks, const Byte *rk,
+                             Byte *o) {
+  CAria aria;
+
+  for (; nBlocks >= 4; i += 64, o += 64, nBlocks -= 4) Crypt4<Nr>(i, rk, o);
+  for (; nBlocks > 0; i += 16, o += 16, nBlocks--) aria.Crypt<Nr>(i, rk, o);
+}
+
+/* 라운드 수에 맞는 TableCryptBlocks<Nr>()을 버퍼마다 한 번 고른다 */
+static void TableCryptBlocks(const Byte *i, size_t nBlocks, int Nr,
+                             const Byte *rk, Byte *o) {
+  if (Nr > 14) {
+    TableCryptBlocks<16>(i, nBlocks, rk, o);
+  } else if (Nr > 12) {
+    TableCryptBlocks<14>(i, nBlocks, rk, o);
+  } else {
+    TableCryptBlocks<12>(i, nBlocks, rk, o);
+  }
+}
+
+/* 테이블 백엔드는 라운드 키를 그대로 쓴다 */
+static void TablePrepareKey(const Byte *rk, int Nr, Byte *prepared) {
+  memcpy(prepared, rk, 16 * (Nr + 1));
+}
+
+static const CAriaBackend kTableBackend = {"table", 4, TableCryptBlocks,
+                                           TablePrepareKey, TableCryptBlocks};
+
+/* 선택된 백엔드. NULL이면 아직 선택하지 않은 것이다. */
+static std::atomic<const CAriaBackend *> g_backend(NULL);
+
+const CAriaBackend *const *CAria::GetBackends() {
+  /* 함수 안의 static 변수는 처음 호출될 때 한 번만 초기화된다 */
+  static const CAriaBackend *const *backends = []() {
+    static const CAriaBackend *list[6];
+    const CAriaBackend *candidates[] = {
+        AriaAvx512GfniBackend(), AriaAvx2GfniBackend(), AriaAesniBackend(),
+        AriaNeonBackend(), &kTableBackend};
+    size_t n = 0;
+
+    for (const CAriaBackend *b : candidates) {
+      if (b != NULL) list[n++] = b;
+    }
+    list[n] = NULL;
+    return list;
+  }();
+
+  return backends;
+}
+
+const CAriaBackend *CAria::GetBackend() {
+  const CAriaBackend *b = g_backend.load(std::memory_order_acquire);
+
+  if (b == NULL) {
+    b = GetBackends()[0];
+    g_backend.store(b, std::memory_order_release);
+  }
+  return b;
+}
+
+int CAria::SetBackend(const char *name) {
+  const CAriaBackend *const *b = GetBackends();
+
+  if (name == NULL) {
+    g_backend.store(b[0], std::memory_order_release);
+    return 0;
+  }
+  for (; *b != NULL; b++) {
+    if (strcmp((*b)->name, name) == 0) {
+      g_backend.store(*b, std::memory_order_release);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/* 모드 함수들이 백엔드에 한 번에 넘기는 최대 블록 수 (스택 버퍼 크기) */
+#define ARIA_CHUNK_BLOCKS 64
+
+namespace {
+
+/* 모드 함수들이 여러 블록을 처리할 때 쓰는 백엔드와 라운드 키.
+ * CAriaKey를 만들 때의 백엔드가 지금도 선택되어 있으면 미리 바꿔 둔 형식의
+ * 라운드 키를 쓰고, 아니면 라운드 키를 그대로 CryptBlocks()에 넘긴다. */
+class BlockCipher {
+ public:
+  BlockCipher(const Byte *rk, int Nr)
+      : backend_(CAria::GetBackend()), rk_(rk), Nr_(Nr), prepared_(false) {}
+  BlockCipher(const CAriaKey &key, bool dec)
+      : backend_(CAria::GetBackend()), Nr_(key.Nr()) {
+    prepared_ = (key.Backend() == backend_);
+    if (prepared_) {
+      rk_ = dec ? key.PreparedDecRoundKeys() : key.PreparedEncRoundKeys();
+    } else {
+      rk_ = dec ? key.DecRoundKeys() : key.EncRoundKeys();
+    }
+  }
+
+  void operator()(const Byte *i, size_t nBlocks, Byte *o) const {
+    if (prepared_) {
+      backend_->CryptBlocksPrepared(i, nBlocks, Nr_, rk_, o);
+    } else {
+      backend_->CryptBlocks(i, nBlocks, Nr_, rk_, o);
+    }
+  }
+
+ private:
+  const CAriaBackend *backend_;
+  const Byte *rk_;
+  int Nr_;
+  bool prepared_;
+};
+
+/* 128-bit big endian 카운터를 1 증가시키는 함수 */
+void IncCounter(Byte *ctr) {
+  for (int n = 15; n >= 0; n--) {
+    if (++ctr[n] != 0) break;
+  }
+}
+
+void CtrCryptBlocks(const BlockCipher &cipher, const Byte *in, size_t len,
+                    const Byte *iv, Byte *out) {
+  Byte ctr[16], cb[ARIA_CHUNK_BLOCKS * 16], ks[ARIA_CHUNK_BLOCKS * 16];
+  size_t n, nBlocks, b;
+  int j;
+
+  for (j = 0; j < 16; j++) ctr[j] = iv[j];
+
+  while (len > 0) {
+    n = (len < sizeof(ks)) ? len : sizeof(ks);
+    nBlocks = (n + 15) / 16;
+    for (b = 0; b < nBlocks; b++) {
+      for (j = 0; j < 16; j++) cb[16 * b + j] = ctr[j];
+      IncCounter(ctr);
+    }
+    cipher(cb, nBlocks, ks);
+
+    for (size_t k = 0; k < n; k++) out[k] = in[k] ^ ks[k];
+    in += n;
+    out += n;
+    len -= n;
+  }
+}
+
+int EcbCryptBlocks(const BlockCipher &cipher, const Byte *in, size_t len,
+                   Byte *out) {
+  if (len % 16 != 0) return -1;
+
+  if (len > 0) cipher(in, len / 16, out);
+
+  return 0;
+}
+
+int CbcDecryptBlocks(const BlockCipher &cipher, const Byte *in, size_t len,
+                     const Byte *iv, Byte *out) {
+  Byte prev[16], cb[ARIA_CHUNK_BLOCKS * 16];
+  size_t n, k;
+  int j;
+
+  if (len % 16 != 0) return -1;
+
+  for (j = 0; j < 16; j++) prev[j] = iv[j];
+
+  while (len > 0) {
+    n = (len < sizeof(cb)) ? len : sizeof(cb);
+    memcpy(cb, in, n);
+    cipher(cb, n / 16, out);
+    for (j = 0; j < 16; j++) out[j] ^= prev[j];
+    for (k = 16; k < n; k++) out[k] ^= cb[k - 16];
+    for (j = 0; j < 16; j++) prev[j] = cb[n - 16 + j];
+    in += n;
+    out += n;
+    len -= n;
+  }
+
+  return 0;
+}
+
+}  // namespace
+
+/* CTR 모드 암호화/복호화 함수.
+ * 최대 ARIA_CHUNK_BLOCKS개 분량의 카운터를 만들어 백엔드로 한 번에 키
+ * 스트림을 생성하고, 길이가 16의 배수가 아니면 마지막 블록의 키 스트림은
+ * 필요한 만큼만 쓴다.
+ * CTR 모드는 암호화와 복호화가 같으므로 둘 다 EncKeySetup()의 라운드 키를
+ * 사용한다.  in과 out은 같은 버퍼여도 된다.
+ * const Byte *in: 입력
+ * size_t len: 입력의 길이 (Byte)
+ * const Byte *iv: 초기 카운터 블록 (16 Byte, big endian)
+ * const Byte *rk: 라운드 키들
+ * int Nr: 라운드 수
+ * Byte *out: 출력
+ */
+void CAria::CtrCrypt(const Byte *in, size_t len, const Byte *iv,
+                     const Byte *rk, int Nr, Byte *out) {
+  CtrCryptBlocks(BlockCipher(rk, Nr), in, len, iv, out);
+}
+
+void CAria::CtrCrypt(const Byte *in, size_t len, const Byte *iv,
+                     const CAriaKey &key, Byte *out) {
+  CtrCryptBlocks(BlockCipher(key, false), in, len, iv, out);
+}
+
+/* ECB 모드 암호화/복호화 함수.
+ * EncKeySetup()의 라운드 키를 주면 암호화, DecKeySetup()의 라운드 키를 주면
+ * 복호화가 된다.  블록 사이에 의존성이 없으므로 전체를 백엔드에 넘긴다.
+ * const Byte *in: 입력
+ * size_t len: 입력의 길이 (Byte, 16의 배수)
+ * const Byte *rk: 라운드 키들
+ * int Nr: 라운드 수
+ * Byte *out: 출력
+ * return: 성공하면 0, len이 16의 배수가 아니면 -1
+ */
+int CAria::EcbCrypt(const Byte *in, size_t len, const Byte *rk, int Nr,
+                    Byte *out) {
+  return EcbCryptBlocks(BlockCipher(rk, Nr), in, len, out);
+}
+
+int CAria::EcbEncrypt(const Byte *in, size_t len, const CAriaKey &key,
+                      Byte *out) {
+  return EcbCryptBlocks(BlockCipher(key, false), in, len, out);
+}
+
+int CAria::EcbDecrypt(const Byte *in, size_t len, const CAriaKey &key,
+                      Byte *out) {
+  return EcbCryptBlocks(BlockCipher(key, true), in, len, out);
 }
 
-/* 암호화 라운드 키 생성
+/* CBC 암호화의 블록 루프.  라운드 수는 CbcEncrypt()가 버퍼마다 한 번 고른다. */
+template <int Nr>
+static void CbcEncryptBlocks(const Byte *in, size_t len, const Byte *iv,
+                             const Byte *rk, Byte *out) {
+  CAria aria;
+  Byte x[16];
+  const Byte *prev = iv;
+  int j;
+
+  for (; len > 0; in += 16, out += 16, len -= 16) {
+    for (j = 0; j < 16; j++) x[j] = in[j] ^ prev[j];
+    aria.Crypt<Nr>(x, rk, out);
+    prev = out;
+  }
+}
+
+/* CBC 모드 암호화 함수.
+ * 앞 블록의 암호문이 다음 블록의 입력이 되므로 한 블록씩 처리한다.
+ * const Byte *in: 평문
+ * size_t len: 평문의 길이 (Byte, 16의 배수)
+ * const Byte *iv: 초기 벡터 (16 Byte)
+ * const Byte *rk: EncKeySetup()의 라운드 키들
+ * int Nr: 라운드 수
+ * Byte *out: 암호문
+ * return: 성공하면 0, len이 16의 배수가 아니면 -1
+ */
+int CAria::CbcEncrypt(const Byte *in, size_t len, const Byte *iv,
+                      const Byte *rk, int Nr, Byte *out) {
+  if (len % 16 != 0) return -1;
+
+  if (Nr > 14) {
+    CbcEncryptBlocks<16>(in, len, iv, rk, out);
+  } else if (Nr > 12) {
+    CbcEncryptBlocks<14>(in, len, iv, rk, out);
+  } else {
+    CbcEncryptBlocks<12>(in, len, iv, rk, out);
+  }
+
+  return 0;
+}
+
+int CAria::CbcEncrypt(const Byte *in, size_t len, const Byte *iv,
+                      const CAriaKey &key, Byte *out) {
+  return CbcEncrypt(in, len, iv, key.EncRoundKeys(), key.Nr(), out);
+}
+
+/* CBC 모드 복호화 함수.
+ * 복호화는 블록 사이에 의존성이 없으므로 최대 ARIA_CHUNK_BLOCKS개씩 묶어서
+ * 백엔드로 처리한 뒤 앞 블록의 암호문과 XOR 한다.  in과 out이 같은 버퍼여도
+ * 되도록 암호문은 미리 복사해 둔다.
+ * const Byte *in: 암호문
+ * size_t len: 암호문의 길이 (Byte, 16의 배수)
+ * const Byte *iv: 초기 벡터 (16 Byte)
+ * const Byte *rk: DecKeySetup()의 라운드 키들
+ * int Nr: 라운드 수
+ * Byte *out: 평문
+ * return: 성공하면 0, len이 16의 배수가 아니면 -1
+ */
+int CAria::CbcDecrypt(const Byte *in, size_t len, const Byte *iv,
+                      const Byte *rk, int Nr, Byte *out) {
+  return CbcDecryptBlocks(BlockCipher(rk, Nr), in, len, iv, out);
+}
+
+int CAria::CbcDecrypt(const Byte *in, size_t len, const Byte *iv,
+                      const CAriaKey &key, Byte *out) {
+  return CbcDecryptBlocks(BlockCipher(key, true), in, len, iv, out);
+}
+
+/* 마스터 키의 길이가 KeyBits(128, 192, 256)로 정해진 암호화 라운드 키 생성
  * const Byte *mk: 마스터 키
  * Byte *rk: 라운드 키
- * int keyBits: 마스터 키의 길이
  * return: 라운드 수
  */
-int CAria::EncKeySetup(const Byte *mk, Byte *rk, int keyBits) {
+template <int KeyBits>
+int CAria::EncKeySetup(const Byte *mk, Byte *rk) {
+  static_assert(KeyBits == 128 || KeyBits == 192 || KeyBits == 256,
+                "KeyBits must be 128, 192 or 256");
   Word t0, t1, t2, t3;
   Word w0[4], w1[4], w2[4], w3[4];
   int q, r;
@@ -139,16 +496,16 @@ int CAria::EncKeySetup(const Byte *mk, Byte *rk, int keyBits) {
   WordLoad(WO(const_cast<Byte *>(mk), 2), w0[2]);
   WordLoad(WO(const_cast<Byte *>(mk), 3), w0[3]);
 
-  q = (keyBits - 128) / 64;
+  q = (KeyBits - 128) / 64;
   t0 = w0[0] ^ KRK[q][0];
   t1 = w0[1] ^ KRK[q][1];
   t2 = w0[2] ^ KRK[q][2];
   t3 = w0[3] ^ KRK[q][3];
   FO;
-  if (keyBits > 128) {
+  if constexpr (KeyBits > 128) {
     WordLoad(WO(const_cast<Byte *>(mk), 4), w1[0]);
     WordLoad(WO(const_cast<Byte *>(mk), 5), w1[1]);
-    if (keyBits > 192) {
+    if constexpr (KeyBits > 192) {
       WordLoad(WO(const_cast<Byte *>(mk), 6), w1[2]);
       WordLoad(WO(const_cast<Byte *>(mk), 7), w1[3]);
     } else {
@@ -205,25 +562,42 @@ int CAria::EncKeySetup(const Byte *mk, Byte *rk, int keyBits) {
   GSRK(w2, w3, 67);
   GSRK(w3, w0, 67);
   GSRK(w0, w1, 97);
-  if (keyBits > 128) {
+  if constexpr (KeyBits > 128) {
     GSRK(w1, w2, 97);
     GSRK(w2, w3, 97);
   }
-  if (keyBits > 192) {
+  if constexpr (KeyBits > 192) {
     GSRK(w3, w0, 97);
     GSRK(w0, w1, 109);
   }
 
-  return (keyBits + 256) / 32;
+  return RoundsOf(KeyBits);
 }
 
-/* 복호화 라운드 키 생성
+template int CAria::EncKeySetup<128>(const Byte *mk, Byte *rk);
+template int CAria::EncKeySetup<192>(const Byte *mk, Byte *rk);
+template int CAria::EncKeySetup<256>(const Byte *mk, Byte *rk);
+
+/* 암호화 라운드 키 생성.  키 길이에 맞는 EncKeySetup<KeyBits>()를 부른다.
  * const Byte *mk: 마스터 키
  * Byte *rk: 라운드 키
  * int keyBits: 마스터 키의 길이
+ * return: 라운드 수
  */
-int CAria::DecKeySetup(const Byte *mk, Byte *rk, int keyBits) {
-  int rValue = EncKeySetup(mk, rk, keyBits);
+int CAria::EncKeySetup(const Byte *mk, Byte *rk, int keyBits) {
+  if (keyBits > 192) return EncKeySetup<256>(mk, rk);
+  if (keyBits > 128) return EncKeySetup<192>(mk, rk);
+  return EncKeySetup<128>(mk, rk);
+}
+
+/* 마스터 키의 길이가 KeyBits로 정해진 복호화 라운드 키 생성
+ * const Byte *mk: 마스터 키
+ * Byte *rk: 라운드 키
+ * return: 라운드 수
+ */
+template <int KeyBits>
+int CAria::DecKeySetup(const Byte *mk, Byte *rk) {
+  int rValue = EncKeySetup<KeyBits>(mk, rk);
   Word *a = reinterpret_cast<Word *>((rk));
   Word *z = a + rValue * 4;
 
@@ -285,6 +659,22 @@ int CAria::DecKeySetup(const Byte *mk, Byte *rk, int keyBits) {
   return rValue;
 }
 
+template int CAria::DecKeySetup<128>(const Byte *mk, Byte *rk);
+template int CAria::DecKeySetup<192>(const Byte *mk, Byte *rk);
+template int CAria::DecKeySetup<256>(const Byte *mk, Byte *rk);
+
+/* 복호화 라운드 키 생성
+ * const Byte *mk: 마스터 키
+ * Byte *rk: 라운드 키
+ * int keyBits: 마스터 키의 길이
+ * return: 라운드 수
+ */
+int CAria::DecKeySetup(const Byte *mk, Byte *rk, int keyBits) {
+  if (keyBits > 192) return DecKeySetup<256>(mk, rk);
+  if (keyBits > 128) return DecKeySetup<192>(mk, rk);
+  return DecKeySetup<128>(mk, rk);
+}
+
 void CAria::CHECK_ENDIAN() {
   const Word NUMBER = 0x00000042;
   Byte *b = reinterpret_cast<Byte *>(const_cast<Word *>(&NUMBER));
@@ -0,0 +1,301 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include "include/CAriaGcm.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#include "lib/CAria_ghash.hpp"
+
+namespace Awesome_mix_vol_1 {
+
+/* 키 스트림과 GHASH를 함께 처리하는 단위 (블록 수) */
+#define GCM_CHUNK_BLOCKS 64
+
+/* 4-bit 테이블 GHASH (Shoup의 방법).
+ * key->data에는 H * i (i = 0 .. 15)의 상위/하위 64-bit를 넣어 둔다. */
+static void GhashInitTable(CAriaGhashKey *key, const Byte *h) {
+  uint64_t *hl = reinterpret_cast<uint64_t *>(key->data);
+  uint64_t *hh = hl + 16;
+  uint64_t vh = 0, vl = 0;
+  int i, j;
+
+  for (i = 0; i < 8; i++) {
+    vh = (vh << 8) | h[i];
+    vl = (vl << 8) | h[8 + i];
+  }
+
+  /* 8 = H, 4 = H * x, 2 = H * x^2, 1 = H * x^3 (bit 순서가 뒤집혀 있다) */
+  hl[8] = vl;
+  hh[8] = vh;
+  hl[0] = hh[0] = 0;
+  for (i = 4; i > 0; i >>= 1) {
+    uint64_t t = (vl & 1) ? 0xe100000000000000ULL : 0;
+    vl = (vh << 63) | (vl >> 1);
+    vh = (vh >> 1) ^ t;
+    hl[i] = vl;
+    hh[i] = vh;
+  }
+  for (i = 2; i <= 8; i *= 2) {
+    for (j = 1; j < i; j++) {
+      hh[i + j] = hh[i] ^ hh[j];
+      hl[i + j] = hl[i] ^ hl[j];
+    }
+  }
+}
+
+static void GhashUpdateTable(const CAriaGhashKey *key, Byte *y,
+                             const Byte *in, size_t nBlocks) {
+  /* 4 bit를 밀어낼 때 x^128의 reduction 값 */
+  static const uint64_t last4[16] = {
+      0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+      0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+  const uint64_t *hl = reinterpret_cast<const uint64_t *>(key->data);
+  const uint64_t *hh = hl + 16;
+  Byte x[16];
+  int i;
+
+  for (; nBlocks > 0; in += 16, nBlocks--) {
+    uint64_t zh, zl, rem;
+    Byte lo, hi;
+
+    for (i = 0; i < 16; i++) x[i] = y[i] ^ in[i];
+
+    lo = x[15] & 0xf;
+    zh = hh[lo];
+    zl = hl[lo];
+    for (i = 15; i >= 0; i--) {
+      lo = x[i] & 0xf;
+      hi = x[i] >> 4;
+      if (i != 15) {
+        rem = zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (last4[rem] << 48);
+        zh ^= hh[lo];
+        zl ^= hl[lo];
+      }
+      rem = zl & 0xf;
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ (last4[rem] << 48);
+      zh ^= hh[hi];
+      zl ^= hl[hi];
+    }
+
+    for (i = 0; i < 8; i++) {
+      y[i] = static_cast<Byte>(zh >> (56 - 8 * i));
+      y[8 + i] = static_cast<Byte>(zl >> (56 - 8 * i));
+    }
+  }
+}
+
+const CAriaGhash *AriaGhashTable() {
+  static const CAriaGhash ghash = {"table", GhashInitTable, GhashUpdateTable};
+
+  return &ghash;
+}
+
+/* 사용할 수 있는 GHASH 구현.  빠른 순서이며 NULL로 끝난다. */
+static const CAriaGhash *const *GhashList() {
+  static const CAriaGhash *const *list = []() {
+    static const CAriaGhash *l[4];
+    const CAriaGhash *candidates[] = {AriaGhashPclmul(), AriaGhashPmull(),
+                                      AriaGhashTable()};
+    size_t n = 0;
+
+    for (const CAriaGhash *g : candidates) {
+      if (g != NULL) l[n++] = g;
+    }
+    l[n] = NULL;
+    return l;
+  }();
+
+  return list;
+}
+
+static void SecureZero(void *p, size_t len) {
+  volatile Byte *b = reinterpret_cast<volatile Byte *>(p);
+
+  while (len-- > 0) *b++ = 0;
+}
+
+/* 카운터 블록의 하위 32-bit만 1 증가시킨다 (GCM의 inc32) */
+static void Inc32(Byte *ctr) {
+  for (int n = 15; n >= 12; n--) {
+    if (++ctr[n] != 0) break;
+  }
+}
+
+/* 64-bit 값을 big endian으로 쓴다 */
+static void PutBe64(Byte *p, uint64_t v) {
+  for (int n = 7; n >= 0; n--, v >>= 8) p[n] = static_cast<Byte>(v);
+}
+
+CAriaGcm::CAriaGcm()
+    : ghash_(GhashList()[0]), ghashKey_(new CAriaGhashKey) {
+  memset(ghashKey_->data, 0, sizeof(ghashKey_->data));
+  memset(h_, 0, sizeof(h_));
+}
+
+CAriaGcm::~CAriaGcm() {
+  SecureZero(ghashKey_->data, sizeof(ghashKey_->data));
+  SecureZero(h_, sizeof(h_));
+}
+
+int CAriaGcm::SetKey(const Byte *mk, int keyBits) {
+  std::shared_ptr<CAriaKey> key = std::make_shared<CAriaKey>();
+
+  if (key->Setup(mk, keyBits) < 0) return -1;
+  return SetKey(key);
+}
+
+int CAriaGcm::SetKey(std::shared_ptr<const CAriaKey> key) {
+  CAria aria;
+  Byte zero[16] = {0};
+
+  if (!key || key->Nr() == 0) return -1;
+
+  key_ = key;
+  aria.EcbEncrypt(zero, 16, *key_, h_);
+  InitGhashKey();
+  return key_->Nr();
+}
+
+const char *CAriaGcm::GhashName() const { return ghash_->name; }
+
+int CAriaGcm::SetGhash(const char *name) {
+  const CAriaGhash *const *g = GhashList();
+
+  if (name != NULL) {
+    for (; *g != NULL; g++) {
+      if (strcmp((*g)->name, name) == 0) break;
+    }
+    if (*g == NULL) return -1;
+  }
+  ghash_ = *g;
+  if (key_) InitGhashKey();
+  return 0;
+}
+
+void CAriaGcm::InitGhashKey() { ghash_->Init(ghashKey_.get(), h_); }
+
+/* 길이가 16의 배수가 아니면 마지막 블록은 0을 채워서 GHASH에 넣는다 */
+void CAriaGcm::GhashPadded(Byte *y, const Byte *in, size_t len) const {
+  Byte last[16] = {0};
+
+  if (len >= 16) ghash_->Update(ghashKey_.get(), y, in, len / 16);
+  if (len % 16 != 0) {
+    memcpy(last, in + len / 16 * 16, len % 16);
+    ghash_->Update(ghashKey_.get(), y, last, 1);
+  }
+}
+
+/* 첫 카운터 블록 J0.  IV가 96-bit이면 IV || 0^31 || 1이고, 아니면 IV의
+ * GHASH이다. */
+void CAriaGcm::Counter0(const Byte *iv, size_t ivLen, Byte *j0) const {
+  Byte lenBlock[16] = {0};
+
+  if (ivLen == 12) {
+    memcpy(j0, iv, 12);
+    j0[12] = j0[13] = j0[14] = 0;
+    j0[15] = 1;
+    return;
+  }
+
+  memset(j0, 0, 16);
+  GhashPadded(j0, iv, ivLen);
+  PutBe64(lenBlock + 8, static_cast<uint64_t>(ivLen) * 8);
+  ghash_->Update(ghashKey_.get(), j0, lenBlock, 1);
+}
+
+/* J0 + 1부터의 카운터로 키 스트림을 만들어 XOR 하면서 암호문의 GHASH를
+ * 계산한다.  chunk 하나의 키 스트림을 만든 다음, 그 chunk의 암호문이
+ * cache에 있는 동안 바로 GHASH에 넣는다. */
+void CAriaGcm::CtrGhash(const Byte *j0, const Byte *in, size_t len,
+                        Byte *out, Byte *y, bool dec) const {
+  CAria aria;
+  Byte ctr[16], cb[GCM_CHUNK_BLOCKS * 16], ks[GCM_CHUNK_BLOCKS * 16];
+  size_t n, nBlocks, b, k;
+
+  memcpy(ctr, j0, 16);
+  Inc32(ctr);
+
+  while (len > 0) {
+    n = (len < sizeof(ks)) ? len : sizeof(ks);
+    nBlocks = (n + 15) / 16;
+    for (b = 0; b < nBlocks; b++) {
+      memcpy(cb + 16 * b, ctr, 16);
+      Inc32(ctr);
+    }
+    aria.EcbEncrypt(cb, nBlocks * 16, *key_, ks);
+
+    /* 복호화는 in과 out이 같을 수 있으므로 XOR 하기 전에 GHASH를 한다 */
+    if (dec) GhashPadded(y, in, n);
+    for (k = 0; k < n; k++) out[k] = in[k] ^ ks[k];
+    if (!dec) GhashPadded(y, out, n);
+
+    in += n;
+    out += n;
+    len -= n;
+  }
+
+  SecureZero(ks, sizeof(ks));
+}
+
+/* 길이 블록을 GHASH에 넣고 E(K, J0)와 XOR 해서 태그를 만든다 */
+void CAriaGcm::Tag(Byte *y, const Byte *j0, size_t aadLen, size_t len) const {
+  CAria aria;
+  Byte lenBlock[16], ek[16];
+
+  PutBe64(lenBlock, static_cast<uint64_t>(aadLen) * 8);
+  PutBe64(lenBlock + 8, static_cast<uint64_t>(len) * 8);
+  ghash_->Update(ghashKey_.get(), y, lenBlock, 1);
+
+  aria.EcbEncrypt(j0, 16, *key_, ek);
+  for (int j = 0; j < 16; j++) y[j] ^= ek[j];
+}
+
+/* GCM은 평문 길이를 2^39 - 256 bit로 제한한다 */
+static bool ValidArgs(size_t ivLen, size_t len, size_t tagLen) {
+  return ivLen > 0 && tagLen >= 4 && tagLen <= 16 &&
+         static_cast<uint64_t>(len) <= (1ULL << 36) - 32;
+}
+
+int CAriaGcm::Encrypt(const Byte *iv, size_t ivLen, const Byte *aad,
+                      size_t aadLen, const Byte *in, size_t len, Byte *out,
+                      Byte *tag, size_t tagLen) const {
+  Byte j0[16], y[16] = {0};
+
+  if (!key_ || !ValidArgs(ivLen, len, tagLen)) return -1;
+
+  Counter0(iv, ivLen, j0);
+  GhashPadded(y, aad, aadLen);
+  CtrGhash(j0, in, len, out, y, false);
+  Tag(y, j0, aadLen, len);
+  memcpy(tag, y, tagLen);
+
+  return 0;
+}
+
+int CAriaGcm::Decrypt(const Byte *iv, size_t ivLen, const Byte *aad,
+                      size_t aadLen, const Byte *in, size_t len, Byte *out,
+                      const Byte *tag, size_t tagLen) const {
+  Byte j0[16], y[16] = {0}, diff = 0;
+
+  if (!key_ || !ValidArgs(ivLen, len, tagLen)) return -1;
+
+  Counter0(iv, ivLen, j0);
+  GhashPadded(y, aad, aadLen);
+  CtrGhash(j0, in, len, out, y, true);
+  Tag(y, j0, aadLen, len);
+
+  /* 걸린 시간으로 태그가 드러나지 않도록 모든 Byte를 비교한다 */
+  for (size_t j = 0; j < tagLen; j++) diff |= y[j] ^ tag[j];
+  if (diff != 0) {
+    if (len > 0) memset(out, 0, len);
+    return -2;
+  }
+
+  return 0;
+}
+
+}  // namespace Awesome_mix_vol_1
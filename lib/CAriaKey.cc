@@ -0,0 +1,148 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include "include/CAriaKey.hpp"
+
+#include <cstring>
+#include <iterator>
+
+namespace Awesome_mix_vol_1 {
+
+/* 키가 들어 있던 메모리를 지운다.  volatile을 통해 쓰므로 컴파일러가 지우는
+ * 코드를 없애지 않는다. */
+static void SecureZero(void *p, size_t len) {
+  volatile Byte *b = reinterpret_cast<volatile Byte *>(p);
+
+  while (len-- > 0) *b++ = 0;
+}
+
+CAriaKey::CAriaKey() : backend_(NULL), nr_(0), keyBits_(0) {
+  memset(enc_, 0, sizeof(enc_));
+  memset(dec_, 0, sizeof(dec_));
+  memset(preparedEnc_, 0, sizeof(preparedEnc_));
+  memset(preparedDec_, 0, sizeof(preparedDec_));
+}
+
+CAriaKey::~CAriaKey() {
+  SecureZero(enc_, sizeof(enc_));
+  SecureZero(dec_, sizeof(dec_));
+  SecureZero(preparedEnc_, sizeof(preparedEnc_));
+  SecureZero(preparedDec_, sizeof(preparedDec_));
+}
+
+int CAriaKey::Setup(const Byte *mk, int keyBits) {
+  CAria aria;
+
+  if (keyBits != 128 && keyBits != 192 && keyBits != 256) return -1;
+
+  nr_ = aria.EncKeySetup(mk, enc_, keyBits);
+  aria.DecKeySetup(mk, dec_, keyBits);
+  keyBits_ = keyBits;
+
+  backend_ = CAria::GetBackend();
+  backend_->PrepareKey(enc_, nr_, preparedEnc_);
+  backend_->PrepareKey(dec_, nr_, preparedDec_);
+
+  return nr_;
+}
+
+CAriaKeyCache::CAriaKeyCache(size_t capacity)
+    : capacity_(capacity), hits_(0), misses_(0) {}
+
+CAriaKeyCache::~CAriaKeyCache() { Clear(); }
+
+uint64_t CAriaKeyCache::Fingerprint(const Byte *mk, int keyBits) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+
+  h = (h ^ static_cast<uint64_t>(keyBits)) * 0x100000001b3ULL;
+  for (int j = 0; j < keyBits / 8; j++) {
+    h = (h ^ mk[j]) * 0x100000001b3ULL;
+  }
+  return h;
+}
+
+/* mutex_를 잡은 상태에서 호출한다 */
+void CAriaKeyCache::Erase(EntryList::iterator it) {
+  map_.erase(it->fingerprint);
+  SecureZero(it->mk, sizeof(it->mk));
+  lru_.erase(it);
+}
+
+std::shared_ptr<const CAriaKey> CAriaKeyCache::Get(const Byte *mk,
+                                                   int keyBits) {
+  if (keyBits != 128 && keyBits != 192 && keyBits != 256) return nullptr;
+
+  const uint64_t fp = Fingerprint(mk, keyBits);
+  const size_t mkLen = keyBits / 8;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = map_.find(fp);
+    if (found != map_.end()) {
+      EntryList::iterator it = found->second;
+      if (it->keyBits == keyBits && memcmp(it->mk, mk, mkLen) == 0) {
+        lru_.splice(lru_.begin(), lru_, it);
+        hits_++;
+        return it->key;
+      }
+    }
+    misses_++;
+  }
+
+  /* 키 스케줄 생성은 lock 밖에서 한다 */
+  std::shared_ptr<CAriaKey> key = std::make_shared<CAriaKey>();
+  key->Setup(mk, keyBits);
+  if (capacity_ == 0) return key;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = map_.find(fp);
+  if (found != map_.end()) {
+    EntryList::iterator it = found->second;
+    if (it->keyBits == keyBits && memcmp(it->mk, mk, mkLen) == 0) {
+      /* 다른 thread가 먼저 넣었다 */
+      lru_.splice(lru_.begin(), lru_, it);
+      return it->key;
+    }
+    /* fingerprint 충돌: 예전 키를 버린다 */
+    Erase(it);
+  }
+
+  Entry e;
+  e.fingerprint = fp;
+  e.keyBits = keyBits;
+  memset(e.mk, 0, sizeof(e.mk));
+  memcpy(e.mk, mk, mkLen);
+  e.key = key;
+  lru_.push_front(e);
+  SecureZero(e.mk, sizeof(e.mk));
+  map_[fp] = lru_.begin();
+
+  while (lru_.size() > capacity_) Erase(std::prev(lru_.end()));
+
+  return key;
+}
+
+void CAriaKeyCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  while (!lru_.empty()) Erase(lru_.begin());
+}
+
+size_t CAriaKeyCache::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return lru_.size();
+}
+
+uint64_t CAriaKeyCache::Hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return hits_;
+}
+
+uint64_t CAriaKeyCache::Misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return misses_;
+}
+
+}  // namespace Awesome_mix_vol_1
@@ -0,0 +1,270 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include "include/CAriaParallel.hpp"
+
+#include <cstring>
+
+namespace Awesome_mix_vol_1 {
+
+/* 지금 thread가 속한 pool과 그 안에서의 번호 */
+static thread_local const CAriaThreadPool *tlsPool = NULL;
+static thread_local size_t tlsIndex = 0;
+
+CAriaThreadPool::CAriaThreadPool(size_t nThreads)
+    : pending_(0), next_(0), stop_(false) {
+  if (nThreads == 0) nThreads = std::thread::hardware_concurrency();
+  if (nThreads == 0) nThreads = 1;
+
+  for (size_t n = 0; n < nThreads; n++) {
+    queues_.push_back(std::unique_ptr<Queue>(new Queue));
+  }
+  for (size_t n = 0; n < nThreads; n++) {
+    threads_.push_back(std::thread(&CAriaThreadPool::Worker, this, n));
+  }
+}
+
+CAriaThreadPool::~CAriaThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    stop_ = true;
+  }
+  sleepCv_.notify_all();
+  for (std::thread &t : threads_) t.join();
+}
+
+CAriaThreadPool &CAriaThreadPool::Default() {
+  static CAriaThreadPool pool(0);
+
+  return pool;
+}
+
+void CAriaThreadPool::Submit(std::function<void()> task) {
+  size_t q = (tlsPool == this) ? tlsIndex : next_++ % queues_.size();
+
+  {
+    std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+    queues_[q]->tasks.push_back(std::move(task));
+  }
+  pending_++;
+
+  /* 잠들려는 thread가 pending_을 본 다음 잠들도록 mutex를 거친다 */
+  { std::lock_guard<std::mutex> lock(sleepMutex_); }
+  sleepCv_.notify_one();
+}
+
+bool CAriaThreadPool::Pop(size_t self, std::function<void()> *task) {
+  const size_t n = queues_.size();
+
+  for (size_t k = 0; k < n; k++) {
+    Queue *q = queues_[(self + k) % n].get();
+    std::lock_guard<std::mutex> lock(q->mutex);
+
+    if (q->tasks.empty()) continue;
+    /* 자기 queue는 최근에 넣은 것부터, 남의 queue는 오래된 것부터 꺼낸다 */
+    if (k == 0) {
+      *task = std::move(q->tasks.back());
+      q->tasks.pop_back();
+    } else {
+      *task = std::move(q->tasks.front());
+      q->tasks.pop_front();
+    }
+    pending_--;
+    return true;
+  }
+  return false;
+}
+
+bool CAriaThreadPool::RunPending() {
+  std::function<void()> task;
+  size_t self = (tlsPool == this) ? tlsIndex : next_ % queues_.size();
+
+  if (!Pop(self, &task)) return false;
+  task();
+  return true;
+}
+
+void CAriaThreadPool::Worker(size_t self) {
+  tlsPool = this;
+  tlsIndex = self;
+
+  for (;;) {
+    std::function<void()> task;
+
+    if (Pop(self, &task)) {
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    sleepCv_.wait(lock, [this]() { return stop_ || pending_ > 0; });
+    if (stop_ && pending_ == 0) return;
+  }
+}
+
+/* 128-bit big endian 카운터에 n을 더하는 함수 */
+static void AddCounter(Byte *ctr, size_t n) {
+  unsigned long long carry = n;
+
+  for (int j = 15; j >= 0 && carry != 0; j--) {
+    carry += ctr[j];
+    ctr[j] = static_cast<Byte>(carry);
+    carry >>= 8;
+  }
+}
+
+CAriaParallel::CAriaParallel(CAriaThreadPool *pool, size_t chunkSize)
+    : pool_(pool != NULL ? pool : &CAriaThreadPool::Default()),
+      chunkSize_(chunkSize < 16 ? 16 : chunkSize / 16 * 16) {}
+
+void CAriaParallel::RunSync(size_t len, const ChunkFn &fn) {
+  struct State {
+    std::atomic<size_t> remaining;
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+  const size_t n = (len + chunkSize_ - 1) / chunkSize_;
+
+  if (n <= 1) {
+    if (len > 0) fn(0, len);
+    return;
+  }
+
+  std::shared_ptr<State> st = std::make_shared<State>();
+  st->remaining = n - 1;
+  for (size_t k = 1; k < n; k++) {
+    size_t off = k * chunkSize_;
+    size_t l = (len - off < chunkSize_) ? len - off : chunkSize_;
+    const ChunkFn *f = &fn;
+    pool_->Submit([st, f, off, l]() {
+      (*f)(off, l);
+      if (--st->remaining == 0) {
+        std::lock_guard<std::mutex> lock(st->mutex);
+        st->cv.notify_all();
+      }
+    });
+  }
+
+  /* 첫 chunk는 부른 thread에서 처리하고, 남은 작업을 같이 처리한다 */
+  fn(0, chunkSize_);
+  while (st->remaining > 0) {
+    if (pool_->RunPending()) continue;
+    std::unique_lock<std::mutex> lock(st->mutex);
+    st->cv.wait(lock, [&st]() { return st->remaining == 0; });
+  }
+}
+
+void CAriaParallel::RunAsync(size_t len, const ChunkFn &fn, Callback done) {
+  struct State {
+    std::atomic<size_t> remaining;
+    ChunkFn fn;
+    Callback done;
+  };
+  const size_t n = (len + chunkSize_ - 1) / chunkSize_;
+
+  if (n <= 1) {
+    if (len > 0) fn(0, len);
+    if (done) done(0);
+    return;
+  }
+
+  std::shared_ptr<State> st = std::make_shared<State>();
+  st->remaining = n;
+  st->fn = fn;
+  st->done = std::move(done);
+  for (size_t k = 0; k < n; k++) {
+    size_t off = k * chunkSize_;
+    size_t l = (len - off < chunkSize_) ? len - off : chunkSize_;
+    pool_->Submit([st, off, l]() {
+      st->fn(off, l);
+      if (--st->remaining == 0 && st->done) st->done(0);
+    });
+  }
+}
+
+/* chunk마다 시작 블록 번호만큼 카운터를 더해서 CAria::CtrCrypt()를 부른다 */
+struct CtrChunk {
+  const Byte *in;
+  Byte *out;
+  const CAriaKey *key;
+  Byte iv[16];
+
+  void operator()(size_t off, size_t len) const {
+    CAria aria;
+    Byte ctr[16];
+
+    memcpy(ctr, iv, 16);
+    AddCounter(ctr, off / 16);
+    aria.CtrCrypt(in + off, len, ctr, *key, out + off);
+  }
+};
+
+struct EcbChunk {
+  const Byte *in;
+  Byte *out;
+  const CAriaKey *key;
+  bool dec;
+
+  void operator()(size_t off, size_t len) const {
+    CAria aria;
+
+    if (dec) {
+      aria.EcbDecrypt(in + off, len, *key, out + off);
+    } else {
+      aria.EcbEncrypt(in + off, len, *key, out + off);
+    }
+  }
+};
+
+void CAriaParallel::CtrCrypt(const Byte *in, size_t len, const Byte *iv,
+                             const CAriaKey &key, Byte *out) {
+  CtrChunk c = {in, out, &key, {0}};
+
+  memcpy(c.iv, iv, 16);
+  RunSync(len, c);
+}
+
+int CAriaParallel::EcbEncrypt(const Byte *in, size_t len, const CAriaKey &key,
+                              Byte *out) {
+  if (len % 16 != 0) return -1;
+
+  RunSync(len, EcbChunk{in, out, &key, false});
+  return 0;
+}
+
+int CAriaParallel::EcbDecrypt(const Byte *in, size_t len, const CAriaKey &key,
+                              Byte *out) {
+  if (len % 16 != 0) return -1;
+
+  RunSync(len, EcbChunk{in, out, &key, true});
+  return 0;
+}
+
+int CAriaParallel::CtrCryptAsync(const Byte *in, size_t len, const Byte *iv,
+                                 const CAriaKey &key, Byte *out,
+                                 Callback done) {
+  CtrChunk c = {in, out, &key, {0}};
+
+  memcpy(c.iv, iv, 16);
+  RunAsync(len, c, std::move(done));
+  return 0;
+}
+
+int CAriaParallel::EcbEncryptAsync(const Byte *in, size_t len,
+                                   const CAriaKey &key, Byte *out,
+                                   Callback done) {
+  if (len % 16 != 0) return -1;
+
+  RunAsync(len, EcbChunk{in, out, &key, false}, std::move(done));
+  return 0;
+}
+
+int CAriaParallel::EcbDecryptAsync(const Byte *in, size_t len,
+                                   const CAriaKey &key, Byte *out,
+                                   Callback done) {
+  if (len % 16 != 0) return -1;
+
+  RunAsync(len, EcbChunk{in, out, &key, true}, std::move(done));
+  return 0;
+}
+
+}  // namespace Awesome_mix_vol_1
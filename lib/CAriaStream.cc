@@ -0,0 +1,252 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include "include/CAriaStream.hpp"
+
+#include <cstring>
+
+namespace Awesome_mix_vol_1 {
+
+static void SecureZero(void *p, size_t len) {
+  volatile Byte *b = reinterpret_cast<volatile Byte *>(p);
+
+  while (len-- > 0) *b++ = 0;
+}
+
+/* 128-bit big endian 카운터에 n을 더하는 함수 */
+static void AddCounter(Byte *ctr, size_t n) {
+  unsigned long long carry = n;
+
+  for (int j = 15; j >= 0 && carry != 0; j--) {
+    carry += ctr[j];
+    ctr[j] = static_cast<Byte>(carry);
+    carry >>= 8;
+  }
+}
+
+CAriaStream::CAriaStream()
+    : mode_(kCtr), padding_(false), active_(false), bufLen_(0) {
+  memset(iv_, 0, sizeof(iv_));
+  memset(buf_, 0, sizeof(buf_));
+}
+
+CAriaStream::~CAriaStream() { Reset(); }
+
+void CAriaStream::Reset() {
+  SecureZero(iv_, sizeof(iv_));
+  SecureZero(buf_, sizeof(buf_));
+  bufLen_ = 0;
+  active_ = false;
+}
+
+int CAriaStream::Init(Mode mode, std::shared_ptr<const CAriaKey> key,
+                      const Byte *iv, bool padding) {
+  if (!key || key->Nr() == 0) return -1;
+
+  Reset();
+  key_ = key;
+  mode_ = mode;
+  padding_ = (mode != kCtr) && padding;
+  memcpy(iv_, iv, 16);
+  active_ = true;
+
+  return 0;
+}
+
+/* CTR: 남은 키 스트림을 먼저 쓰고, 블록 단위 부분은 CAria::CtrCrypt()로
+ * 바로 처리한 다음, 끝의 부분 블록은 키 스트림 한 블록을 만들어 쓰고 남은
+ * 것을 보관한다.  buf_의 뒤쪽 bufLen_ Byte가 아직 쓰지 않은 키 스트림이다. */
+void CAriaStream::CtrUpdate(const Byte *in, size_t len, Byte *out) {
+  CAria aria;
+  size_t n, k;
+
+  n = (len < bufLen_) ? len : bufLen_;
+  for (k = 0; k < n; k++) out[k] = in[k] ^ buf_[16 - bufLen_ + k];
+  bufLen_ -= n;
+  in += n;
+  out += n;
+  len -= n;
+
+  n = len / 16 * 16;
+  if (n > 0) {
+    aria.CtrCrypt(in, n, iv_, *key_, out);
+    AddCounter(iv_, n / 16);
+    in += n;
+    out += n;
+    len -= n;
+  }
+
+  if (len > 0) {
+    aria.EcbEncrypt(iv_, 16, *key_, buf_);
+    AddCounter(iv_, 1);
+    for (k = 0; k < len; k++) out[k] = in[k] ^ buf_[k];
+    bufLen_ = 16 - len;
+  }
+}
+
+/* CBC 암호화: buf_에 모자란 만큼 채워서 한 블록을 처리하고, 블록 단위
+ * 부분은 CAria::CbcEncrypt()로 바로 처리한 다음, 나머지를 buf_에 보관한다. */
+size_t CAriaStream::CbcEncryptUpdate(const Byte *in, size_t len, Byte *out) {
+  CAria aria;
+  size_t n, written = 0;
+
+  if (bufLen_ > 0) {
+    n = (len < 16 - bufLen_) ? len : 16 - bufLen_;
+    memcpy(buf_ + bufLen_, in, n);
+    bufLen_ += n;
+    in += n;
+    len -= n;
+    if (bufLen_ < 16) return 0;
+
+    aria.CbcEncrypt(buf_, 16, iv_, *key_, out);
+    memcpy(iv_, out, 16);
+    bufLen_ = 0;
+    out += 16;
+    written += 16;
+  }
+
+  n = len / 16 * 16;
+  if (n > 0) {
+    aria.CbcEncrypt(in, n, iv_, *key_, out);
+    memcpy(iv_, out + n - 16, 16);
+    in += n;
+    out += n;
+    len -= n;
+    written += n;
+  }
+
+  memcpy(buf_, in, len);
+  bufLen_ = len;
+  return written;
+}
+
+/* CBC 복호화: padding을 쓰면 마지막 블록을 Final()에서 처리해야 하므로 입력이
+ * 블록 단위로 끝나더라도 마지막 블록 하나는 buf_에 남겨 둔다. */
+size_t CAriaStream::CbcDecryptUpdate(const Byte *in, size_t len, Byte *out) {
+  CAria aria;
+  Byte next[16];
+  size_t n, written = 0;
+
+  if (bufLen_ > 0) {
+    n = (len < 16 - bufLen_) ? len : 16 - bufLen_;
+    memcpy(buf_ + bufLen_, in, n);
+    bufLen_ += n;
+    in += n;
+    len -= n;
+    if (bufLen_ < 16 || (padding_ && len == 0)) return 0;
+
+    aria.CbcDecrypt(buf_, 16, iv_, *key_, out);
+    memcpy(iv_, buf_, 16);
+    bufLen_ = 0;
+    out += 16;
+    written += 16;
+  }
+
+  n = len / 16 * 16;
+  if (padding_ && n > 0 && n == len) n -= 16;
+  if (n > 0) {
+    /* in과 out이 같을 수 있으므로 다음 IV를 먼저 복사한다 */
+    memcpy(next, in + n - 16, 16);
+    aria.CbcDecrypt(in, n, iv_, *key_, out);
+    memcpy(iv_, next, 16);
+    in += n;
+    len -= n;
+    written += n;
+  }
+
+  memcpy(buf_, in, len);
+  bufLen_ = len;
+  return written;
+}
+
+int CAriaStream::Update(const Byte *in, size_t len, Byte *out,
+                        size_t *outLen) {
+  if (!active_) return -1;
+
+  switch (mode_) {
+    case kCtr:
+      CtrUpdate(in, len, out);
+      *outLen = len;
+      break;
+    case kCbcEncrypt:
+      *outLen = CbcEncryptUpdate(in, len, out);
+      break;
+    case kCbcDecrypt:
+      *outLen = CbcDecryptUpdate(in, len, out);
+      break;
+  }
+  return 0;
+}
+
+int CAriaStream::Update(const struct iovec *iov, int iovcnt, Byte *out,
+                        size_t *outLen) {
+  int ret;
+
+  *outLen = 0;
+  if (!active_) return -1;
+
+  for (int v = 0; v < iovcnt; v++) {
+    size_t n = 0;
+    ret = Update(static_cast<const Byte *>(iov[v].iov_base), iov[v].iov_len,
+                 out + *outLen, &n);
+    /* *outLen은 실패한 조각 앞까지 출력한 길이로 남는다 */
+    if (ret != 0) return ret;
+    *outLen += n;
+  }
+  return 0;
+}
+
+int CAriaStream::UpdateInPlace(const struct iovec *iov, int iovcnt) {
+  if (!active_ || mode_ != kCtr) return -1;
+
+  for (int v = 0; v < iovcnt; v++) {
+    Byte *p = static_cast<Byte *>(iov[v].iov_base);
+    CtrUpdate(p, iov[v].iov_len, p);
+  }
+  return 0;
+}
+
+int CAriaStream::Final(Byte *out, size_t *outLen) {
+  CAria aria;
+  int ret = 0;
+
+  if (!active_) return -1;
+
+  *outLen = 0;
+  if (mode_ == kCbcEncrypt) {
+    if (padding_) {
+      Byte pad = static_cast<Byte>(16 - bufLen_);
+      memset(buf_ + bufLen_, pad, pad);
+      aria.CbcEncrypt(buf_, 16, iv_, *key_, out);
+      *outLen = 16;
+    } else if (bufLen_ != 0) {
+      ret = -1;
+    }
+  } else if (mode_ == kCbcDecrypt) {
+    if (padding_) {
+      Byte last[16];
+      Byte pad;
+      if (bufLen_ != 16) {
+        ret = -1;
+      } else {
+        aria.CbcDecrypt(buf_, 16, iv_, *key_, last);
+        pad = last[15];
+        if (pad == 0 || pad > 16) ret = -1;
+        for (int j = 16 - pad; ret == 0 && j < 16; j++) {
+          if (last[j] != pad) ret = -1;
+        }
+        if (ret == 0) {
+          memcpy(out, last, 16 - pad);
+          *outLen = 16 - pad;
+        }
+        SecureZero(last, sizeof(last));
+      }
+    } else if (bufLen_ != 0) {
+      ret = -1;
+    }
+  }
+
+  Reset();
+  return ret;
+}
+
+}  // namespace Awesome_mix_vol_1
@@ -0,0 +1,133 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/*
+ * SSSE3 + AES-NI를 사용하는 ARIA 백엔드
+ *
+ * ARIA의 SB1은 AES의 S-Box와 같고 SB3는 그 역이다.  AESENCLAST/AESDECLAST의
+ * ShiftRows를 PSHUFB로 미리 되돌려 놓으면 SB1/SB3만 남는다.
+ * SB2와 SB4는 각각 SB1의 뒤, SB3의 앞에 GF(2)의 affine 변환을 하나 붙이면
+ * 되고, affine 변환은 상하위 4-bit에 대한 PSHUFB 두 번으로 계산한다.
+ * 블록 16개를 lib/CAria_sliced.hpp의 방식으로 처리한다.
+ */
+
+#include <cstring>
+
+#include "lib/CAria_backend.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("ssse3,aes"))), \
+                             apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("ssse3,aes")
+#endif
+
+#include <immintrin.h>
+
+#include "lib/CAria_sliced.hpp"
+
+namespace Awesome_mix_vol_1 {
+namespace {
+
+struct VAesni {
+  typedef __m128i Reg;
+  static const size_t kBlocks = 16;
+
+  static Reg Load(const Byte *p, int r) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * r));
+  }
+  static void Store(Byte *p, int r, Reg x) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 16 * r), x);
+  }
+  static Reg Set1(Byte b) { return _mm_set1_epi8(static_cast<char>(b)); }
+  static Reg Unpacklo8(Reg a, Reg b) { return _mm_unpacklo_epi8(a, b); }
+  static Reg Unpackhi8(Reg a, Reg b) { return _mm_unpackhi_epi8(a, b); }
+
+  /* y = lo[x & 0x0f] ^ hi[x >> 4] */
+  static Reg Affine(Reg x, Reg lo, Reg hi) {
+    const Reg mask = _mm_set1_epi8(0x0f);
+    return _mm_shuffle_epi8(lo, _mm_and_si128(x, mask)) ^
+           _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+  }
+
+  static Reg Sb1(Reg x) {
+    /* InvShiftRows */
+    const Reg isr = _mm_setr_epi8(0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12,
+                                  9, 6, 3);
+    return _mm_aesenclast_si128(_mm_shuffle_epi8(x, isr),
+                                _mm_setzero_si128());
+  }
+  static Reg Sb3(Reg x) {
+    /* ShiftRows */
+    const Reg sr = _mm_setr_epi8(0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1,
+                                 6, 11);
+    return _mm_aesdeclast_si128(_mm_shuffle_epi8(x, sr), _mm_setzero_si128());
+  }
+  /* SB2(x) = N * SB1(x) + 0x88 */
+  static Reg Sb2(Reg x) {
+    const Reg lo = _mm_setr_epi8(0x88, 0x0d, 0x37, 0xb2, 0x00, 0x85, 0xbf,
+                                 0x3a, 0xa8, 0x2d, 0x17, 0x92, 0x20, 0xa5,
+                                 0x9f, 0x1a);
+    const Reg hi = _mm_setr_epi8(0x00, 0x3e, 0xd4, 0xea, 0x84, 0xba, 0x50,
+                                 0x6e, 0xcd, 0xf3, 0x19, 0x27, 0x49, 0x77,
+                                 0x9d, 0xa3);
+    return Affine(Sb1(x), lo, hi);
+  }
+  /* SB4(x) = SB3(N' * x + 0x04) */
+  static Reg Sb4(Reg x) {
+    const Reg lo = _mm_setr_epi8(0x04, 0x45, 0xee, 0xaf, 0x17, 0x56, 0xfd,
+                                 0xbc, 0x53, 0x12, 0xb9, 0xf8, 0x40, 0x01,
+                                 0xaa, 0xeb);
+    const Reg hi = _mm_setr_epi8(0x00, 0xb6, 0x08, 0xbe, 0xd6, 0x60, 0xde,
+                                 0x68, 0x53, 0xe5, 0x5b, 0xed, 0x85, 0x33,
+                                 0x8d, 0x3b);
+    return Sb3(Affine(x, lo, hi));
+  }
+};
+
+void CryptBlocksAesni(const Byte *i, size_t nBlocks, int Nr, const Byte *rk,
+                      Byte *o) {
+  CryptSliced<VAesni>(i, nBlocks, Nr, rk, o);
+}
+
+void CryptBlocksAesniPrepared(const Byte *i, size_t nBlocks, int Nr,
+                              const Byte *kb, Byte *o) {
+  CryptSlicedPrepared<VAesni>(i, nBlocks, Nr, kb, o);
+}
+
+}  // namespace
+}  // namespace Awesome_mix_vol_1
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaBackend *AriaAesniBackend() {
+  static const CAriaBackend backend = {
+      "aesni", VAesni::kBlocks, CryptBlocksAesni, PrepareSliced,
+      CryptBlocksAesniPrepared};
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("aes")) {
+    return &backend;
+  }
+  return NULL;
+}
+
+}  // namespace Awesome_mix_vol_1
+
+#else
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaBackend *AriaAesniBackend() { return NULL; }
+
+}  // namespace Awesome_mix_vol_1
+
+#endif
@@ -0,0 +1,123 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/*
+ * AVX2 + GFNI를 사용하는 ARIA 백엔드
+ *
+ * GF2P8AFFINEINVQB는 GF(2^8)의 역원에 affine 변환을 한 결과를 계산하므로
+ * SB1(AES S-Box)과 SB2는 명령어 한 개, 그 역인 SB3와 SB4는 역 affine 변환
+ * (GF2P8AFFINEQB) 뒤에 역원을 구하는 명령어 두 개로 계산된다.
+ * 256-bit 레지스터의 lane 두 개에 블록 16개씩, 모두 32개의 블록을
+ * lib/CAria_sliced.hpp의 방식으로 처리한다.
+ */
+
+#include <cstring>
+
+#include "lib/CAria_backend.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,gfni"))), \
+                             apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,gfni")
+#endif
+
+#include <immintrin.h>
+
+#include "lib/CAria_gfni.hpp"
+#include "lib/CAria_sliced.hpp"
+
+namespace Awesome_mix_vol_1 {
+namespace {
+
+struct VAvx2Gfni {
+  typedef __m256i Reg;
+  static const size_t kBlocks = 32;
+
+  static Reg Load(const Byte *p, int r) {
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * r))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * (r + 16))),
+        1);
+  }
+  static void Store(Byte *p, int r, Reg x) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 16 * r),
+                     _mm256_castsi256_si128(x));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 16 * (r + 16)),
+                     _mm256_extracti128_si256(x, 1));
+  }
+  static Reg Set1(Byte b) { return _mm256_set1_epi8(static_cast<char>(b)); }
+  static Reg Unpacklo8(Reg a, Reg b) { return _mm256_unpacklo_epi8(a, b); }
+  static Reg Unpackhi8(Reg a, Reg b) { return _mm256_unpackhi_epi8(a, b); }
+
+  static Reg Sb1(Reg x) {
+    return _mm256_gf2p8affineinv_epi64_epi8(
+        x, _mm256_set1_epi64x(ARIA_GFNI_SB1_MATRIX), ARIA_GFNI_SB1_CONST);
+  }
+  static Reg Sb2(Reg x) {
+    return _mm256_gf2p8affineinv_epi64_epi8(
+        x, _mm256_set1_epi64x(ARIA_GFNI_SB2_MATRIX), ARIA_GFNI_SB2_CONST);
+  }
+  static Reg Sb3(Reg x) {
+    x = _mm256_gf2p8affine_epi64_epi8(
+        x, _mm256_set1_epi64x(ARIA_GFNI_SB1_INV_MATRIX),
+        ARIA_GFNI_SB1_INV_CONST);
+    return _mm256_gf2p8affineinv_epi64_epi8(
+        x, _mm256_set1_epi64x(ARIA_GFNI_IDENTITY), 0);
+  }
+  static Reg Sb4(Reg x) {
+    x = _mm256_gf2p8affine_epi64_epi8(
+        x, _mm256_set1_epi64x(ARIA_GFNI_SB2_INV_MATRIX),
+        ARIA_GFNI_SB2_INV_CONST);
+    return _mm256_gf2p8affineinv_epi64_epi8(
+        x, _mm256_set1_epi64x(ARIA_GFNI_IDENTITY), 0);
+  }
+};
+
+void CryptBlocksAvx2Gfni(const Byte *i, size_t nBlocks, int Nr,
+                         const Byte *rk, Byte *o) {
+  CryptSliced<VAvx2Gfni>(i, nBlocks, Nr, rk, o);
+}
+
+void CryptBlocksAvx2GfniPrepared(const Byte *i, size_t nBlocks, int Nr,
+                                 const Byte *kb, Byte *o) {
+  CryptSlicedPrepared<VAvx2Gfni>(i, nBlocks, Nr, kb, o);
+}
+
+}  // namespace
+}  // namespace Awesome_mix_vol_1
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaBackend *AriaAvx2GfniBackend() {
+  static const CAriaBackend backend = {
+      "avx2-gfni", VAvx2Gfni::kBlocks, CryptBlocksAvx2Gfni, PrepareSliced,
+      CryptBlocksAvx2GfniPrepared};
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("gfni")) {
+    return &backend;
+  }
+  return NULL;
+}
+
+}  // namespace Awesome_mix_vol_1
+
+#else
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaBackend *AriaAvx2GfniBackend() { return NULL; }
+
+}  // namespace Awesome_mix_vol_1
+
+#endif
@@ -0,0 +1,132 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/*
+ * AVX-512 + GFNI를 사용하는 ARIA 백엔드
+ *
+ * S-Box 계산은 lib/CAria_avx2.cc와 같고, 512-bit 레지스터의 lane 네 개에
+ * 블록 16개씩, 모두 64개의 블록을 lib/CAria_sliced.hpp의 방식으로 처리한다.
+ */
+
+#include <cstring>
+
+#include "lib/CAria_backend.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#if defined(__clang__)
+#pragma clang attribute push(                                 \
+    __attribute__((target("avx512f,avx512bw,gfni"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,gfni")
+#endif
+
+#include <immintrin.h>
+
+#include "lib/CAria_gfni.hpp"
+#include "lib/CAria_sliced.hpp"
+
+namespace Awesome_mix_vol_1 {
+namespace {
+
+struct VAvx512Gfni {
+  typedef __m512i Reg;
+  static const size_t kBlocks = 64;
+
+  static __m128i Load128(const Byte *p, int r) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * r));
+  }
+  static void Store128(Byte *p, int r, __m128i x) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 16 * r), x);
+  }
+  static Reg Load(const Byte *p, int r) {
+    Reg x = _mm512_castsi128_si512(Load128(p, r));
+    x = _mm512_inserti32x4(x, Load128(p, r + 16), 1);
+    x = _mm512_inserti32x4(x, Load128(p, r + 32), 2);
+    return _mm512_inserti32x4(x, Load128(p, r + 48), 3);
+  }
+  /* GCC 12의 _mm512_extracti32x4_epi32()와 _mm512_castsi512_si128()은
+   * -Wmaybe-uninitialized 경고를 내므로 mask가 모두 1인 mask 버전을 쓴다 */
+  template <int n>
+  static __m128i Lane(Reg x) {
+    return _mm512_mask_extracti32x4_epi32(_mm_setzero_si128(), 0xff, x, n);
+  }
+  static void Store(Byte *p, int r, Reg x) {
+    Store128(p, r, Lane<0>(x));
+    Store128(p, r + 16, Lane<1>(x));
+    Store128(p, r + 32, Lane<2>(x));
+    Store128(p, r + 48, Lane<3>(x));
+  }
+  static Reg Set1(Byte b) { return _mm512_set1_epi8(static_cast<char>(b)); }
+  static Reg Unpacklo8(Reg a, Reg b) { return _mm512_unpacklo_epi8(a, b); }
+  static Reg Unpackhi8(Reg a, Reg b) { return _mm512_unpackhi_epi8(a, b); }
+
+  static Reg Sb1(Reg x) {
+    return _mm512_gf2p8affineinv_epi64_epi8(
+        x, _mm512_set1_epi64(ARIA_GFNI_SB1_MATRIX), ARIA_GFNI_SB1_CONST);
+  }
+  static Reg Sb2(Reg x) {
+    return _mm512_gf2p8affineinv_epi64_epi8(
+        x, _mm512_set1_epi64(ARIA_GFNI_SB2_MATRIX), ARIA_GFNI_SB2_CONST);
+  }
+  static Reg Sb3(Reg x) {
+    x = _mm512_gf2p8affine_epi64_epi8(
+        x, _mm512_set1_epi64(ARIA_GFNI_SB1_INV_MATRIX),
+        ARIA_GFNI_SB1_INV_CONST);
+    return _mm512_gf2p8affineinv_epi64_epi8(
+        x, _mm512_set1_epi64(ARIA_GFNI_IDENTITY), 0);
+  }
+  static Reg Sb4(Reg x) {
+    x = _mm512_gf2p8affine_epi64_epi8(
+        x, _mm512_set1_epi64(ARIA_GFNI_SB2_INV_MATRIX),
+        ARIA_GFNI_SB2_INV_CONST);
+    return _mm512_gf2p8affineinv_epi64_epi8(
+        x, _mm512_set1_epi64(ARIA_GFNI_IDENTITY), 0);
+  }
+};
+
+void CryptBlocksAvx512Gfni(const Byte *i, size_t nBlocks, int Nr,
+                           const Byte *rk, Byte *o) {
+  CryptSliced<VAvx512Gfni>(i, nBlocks, Nr, rk, o);
+}
+
+void CryptBlocksAvx512GfniPrepared(const Byte *i, size_t nBlocks, int Nr,
+                                   const Byte *kb, Byte *o) {
+  CryptSlicedPrepared<VAvx512Gfni>(i, nBlocks, Nr, kb, o);
+}
+
+}  // namespace
+}  // namespace Awesome_mix_vol_1
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaBackend *AriaAvx512GfniBackend() {
+  static const CAriaBackend backend = {
+      "avx512-gfni", VAvx512Gfni::kBlocks, CryptBlocksAvx512Gfni, PrepareSliced,
+      CryptBlocksAvx512GfniPrepared};
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") &&
+      __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("gfni")) {
+    return &backend;
+  }
+  return NULL;
+}
+
+}  // namespace Awesome_mix_vol_1
+
+#else
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaBackend *AriaAvx512GfniBackend() { return NULL; }
+
+}  // namespace Awesome_mix_vol_1
+
+#endif
@@ -0,0 +1,25 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* CAria 내부에서만 사용하는 백엔드 선언.
+ * 각 백엔드 파일은 자신이 빌드되지 않았거나 현재 CPU에서 사용할 수 없으면
+ * NULL을 돌려준다. */
+
+#ifndef LIB_CARIA_BACKEND_HPP_
+#define LIB_CARIA_BACKEND_HPP_
+
+#include "include/CAria.hpp"
+
+namespace Awesome_mix_vol_1 {
+
+/* lib/CAria_aesni.cc: SSSE3 + AES-NI, 블록 16개 */
+const CAriaBackend *AriaAesniBackend();
+/* lib/CAria_avx2.cc: AVX2 + GFNI, 블록 32개 */
+const CAriaBackend *AriaAvx2GfniBackend();
+/* lib/CAria_avx512.cc: AVX-512 + GFNI, 블록 64개 */
+const CAriaBackend *AriaAvx512GfniBackend();
+/* lib/CAria_neon.cc: aarch64 NEON, 블록 16개 */
+const CAriaBackend *AriaNeonBackend();
+
+}  // namespace Awesome_mix_vol_1
+
+#endif  // LIB_CARIA_BACKEND_HPP_
@@ -0,0 +1,121 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/*
+ * carry-less 곱셈을 사용하는 GHASH
+ *
+ * GCM의 블록은 bit 순서가 뒤집힌 GF(2^128)의 원소이므로 Byte 순서를 뒤집어
+ * 레지스터에 싣고, 곱셈 결과를 1 bit 왼쪽으로 민 다음 x^128 + x^7 + x^2 +
+ * x + 1로 reduction 한다 (Intel, "Intel Carry-Less Multiplication
+ * Instruction and its Usage for Computing the GCM Mode").
+ * shift와 reduction은 XOR에 대해 선형이므로, 블록 8개를 각각 H^8 .. H^1과
+ * 곱한 256-bit 결과를 XOR 한 다음 reduction은 한 번만 한다.
+ *
+ * C는 명령어 집합별 연산을 제공한다.
+ *   C::Reg               : 128-bit 레지스터
+ *   C::Load(p), Store(p) : Byte 순서를 뒤집어서 읽기/쓰기
+ *   C::Mul00, Mul01, Mul10, Mul11(a, b)
+ *                        : a, b의 하위(0)/상위(1) 64-bit의 carry-less 곱
+ *                          (Mul01은 a의 하위와 b의 상위)
+ *   C::ShlBytes<n>(x), ShrBytes<n>(x) : 128-bit 전체를 Byte 단위로 shift
+ *   C::Shl32<n>(x), Shr32<n>(x)       : 32-bit lane 별로 bit 단위 shift
+ *   C::Zero()
+ * 레지스터끼리의 XOR, OR은 ^, | 연산자를 사용한다.
+ *
+ * 이 파일은 lib/CAria_ghash.hpp를 include 한 다음, 명령어 집합을 지정한
+ * 상태에서 include 한다.
+ */
+
+#ifndef LIB_CARIA_CLMUL_HPP_
+#define LIB_CARIA_CLMUL_HPP_
+
+namespace Awesome_mix_vol_1 {
+namespace {
+
+/* 한 번에 모아서 reduction 하는 블록 수 */
+const int kClmulBlocks = 8;
+
+/* a * b의 256-bit 결과를 (lo, hi)에 XOR 한다 */
+template <class C>
+inline void ClmulMulAcc(typename C::Reg a, typename C::Reg b,
+                        typename C::Reg *lo, typename C::Reg *hi) {
+  typename C::Reg t0 = C::Mul00(a, b), t1 = C::Mul01(a, b) ^ C::Mul10(a, b),
+                  t2 = C::Mul11(a, b);
+
+  *lo = *lo ^ t0 ^ C::template ShlBytes<8>(t1);
+  *hi = *hi ^ t2 ^ C::template ShrBytes<8>(t1);
+}
+
+/* 256-bit 값 (lo, hi)를 1 bit 왼쪽으로 민 다음 reduction 한다 */
+template <class C>
+inline typename C::Reg ClmulReduce(typename C::Reg lo, typename C::Reg hi) {
+  typedef typename C::Reg Reg;
+  Reg t7, t8, t9;
+
+  t7 = C::template Shr32<31>(lo);
+  t8 = C::template Shr32<31>(hi);
+  lo = C::template Shl32<1>(lo);
+  hi = C::template Shl32<1>(hi);
+  t9 = C::template ShrBytes<12>(t7);
+  t8 = C::template ShlBytes<4>(t8);
+  t7 = C::template ShlBytes<4>(t7);
+  lo = lo | t7;
+  hi = hi | t8 | t9;
+
+  t7 = C::template Shl32<31>(lo) ^ C::template Shl32<30>(lo) ^
+       C::template Shl32<25>(lo);
+  t8 = C::template ShrBytes<4>(t7);
+  t7 = C::template ShlBytes<12>(t7);
+  lo = lo ^ t7;
+
+  t9 = C::template Shr32<1>(lo) ^ C::template Shr32<2>(lo) ^
+       C::template Shr32<7>(lo) ^ t8;
+  lo = lo ^ t9;
+  return hi ^ lo;
+}
+
+/* key->data에 H, H^2, .., H^8을 (Byte 순서를 뒤집어서) 넣는다 */
+template <class C>
+void ClmulInit(CAriaGhashKey *key, const Byte *h) {
+  typedef typename C::Reg Reg;
+  Reg p = C::Load(h), x = p;
+
+  C::Store(key->data, p);
+  for (int n = 1; n < kClmulBlocks; n++) {
+    Reg lo = C::Zero(), hi = C::Zero();
+    ClmulMulAcc<C>(x, p, &lo, &hi);
+    x = ClmulReduce<C>(lo, hi);
+    C::Store(key->data + 16 * n, x);
+  }
+}
+
+template <class C>
+void ClmulUpdate(const CAriaGhashKey *key, Byte *y, const Byte *in,
+                 size_t nBlocks) {
+  typedef typename C::Reg Reg;
+  Reg h[kClmulBlocks], acc = C::Load(y);
+
+  for (int n = 0; n < kClmulBlocks; n++) h[n] = C::Load(key->data + 16 * n);
+
+  /* Y = ((Y ^ X0) * H^8) ^ (X1 * H^7) ^ .. ^ (X7 * H) */
+  for (; nBlocks >= kClmulBlocks;
+       in += 16 * kClmulBlocks, nBlocks -= kClmulBlocks) {
+    Reg lo = C::Zero(), hi = C::Zero();
+    ClmulMulAcc<C>(acc ^ C::Load(in), h[kClmulBlocks - 1], &lo, &hi);
+    for (int n = 1; n < kClmulBlocks; n++) {
+      ClmulMulAcc<C>(C::Load(in + 16 * n), h[kClmulBlocks - 1 - n], &lo, &hi);
+    }
+    acc = ClmulReduce<C>(lo, hi);
+  }
+  for (; nBlocks > 0; in += 16, nBlocks--) {
+    Reg lo = C::Zero(), hi = C::Zero();
+    ClmulMulAcc<C>(acc ^ C::Load(in), h[0], &lo, &hi);
+    acc = ClmulReduce<C>(lo, hi);
+  }
+
+  C::Store(y, acc);
+}
+
+}  // namespace
+}  // namespace Awesome_mix_vol_1
+
+#endif  // LIB_CARIA_CLMUL_HPP_
@@ -0,0 +1,25 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* GFNI 백엔드가 사용하는 affine 변환 상수.
+ * GF2P8AFFINEQB/GF2P8AFFINEINVQB의 8x8 bit 행렬은 64-bit 값으로 나타내며,
+ * 출력의 i번째 bit를 만드는 행이 상위에서 i번째 Byte에 들어간다.
+ *   SB1(x) = A * x^-1 + 0x63 (AES S-Box)
+ *   SB2(x) = B * x^-1 + 0xe2
+ *   SB3(x) = (A^-1 * x + 0x05)^-1
+ *   SB4(x) = (B^-1 * x + 0x2c)^-1
+ */
+
+#ifndef LIB_CARIA_GFNI_HPP_
+#define LIB_CARIA_GFNI_HPP_
+
+#define ARIA_GFNI_SB1_MATRIX 0xf1e3c78f1f3e7cf8LL
+#define ARIA_GFNI_SB1_CONST 0x63
+#define ARIA_GFNI_SB2_MATRIX 0xeafcb7c3c273c66fLL
+#define ARIA_GFNI_SB2_CONST 0xe2
+#define ARIA_GFNI_SB1_INV_MATRIX 0xa44992254a942952LL
+#define ARIA_GFNI_SB1_INV_CONST 0x05
+#define ARIA_GFNI_SB2_INV_MATRIX 0x186450c737d6bdc9LL
+#define ARIA_GFNI_SB2_INV_CONST 0x2c
+#define ARIA_GFNI_IDENTITY 0x0102040810204080LL
+
+#endif  // LIB_CARIA_GFNI_HPP_
@@ -0,0 +1,41 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* CAriaGcm 내부에서만 사용하는 GHASH 구현 선언.
+ *
+ * GHASH는 GF(2^128)에서 Y = (Y ^ X) * H를 블록마다 반복한다.  각 구현은
+ * Init()에서 H로부터 자신이 쓸 테이블(H의 거듭제곱 등)을 만들고,
+ * Update()에서 블록 여러 개를 한 번에 처리한다.
+ */
+
+#ifndef LIB_CARIA_GHASH_HPP_
+#define LIB_CARIA_GHASH_HPP_
+
+#include "include/CAria.hpp"
+
+namespace Awesome_mix_vol_1 {
+
+/* 구현별로 H에서 미리 계산해 둔 값 */
+struct CAriaGhashKey {
+  alignas(16) Byte data[256];
+};
+
+struct CAriaGhash {
+  const char *name;
+  /* const Byte *h: H = E(K, 0^128) (16 Byte) */
+  void (*Init)(CAriaGhashKey *key, const Byte *h);
+  /* Byte *y: GHASH 상태 (16 Byte, GCM의 Byte 순서)
+   * const Byte *in: 입력 블록들 (nBlocks * 16 Byte) */
+  void (*Update)(const CAriaGhashKey *key, Byte *y, const Byte *in,
+                 size_t nBlocks);
+};
+
+/* lib/CAriaGcm.cc: 4-bit 테이블 (항상 사용할 수 있다) */
+const CAriaGhash *AriaGhashTable();
+/* lib/CAria_ghash_pclmul.cc: x86 PCLMULQDQ, 블록 8개씩 모아서 reduction */
+const CAriaGhash *AriaGhashPclmul();
+/* lib/CAria_ghash_pmull.cc: aarch64 PMULL, 블록 8개씩 모아서 reduction */
+const CAriaGhash *AriaGhashPmull();
+
+}  // namespace Awesome_mix_vol_1
+
+#endif  // LIB_CARIA_GHASH_HPP_
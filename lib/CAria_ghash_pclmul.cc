@@ -0,0 +1,103 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* x86 PCLMULQDQ를 사용하는 GHASH.  알고리즘은 lib/CAria_clmul.hpp를 본다. */
+
+#include "lib/CAria_ghash.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("ssse3,pclmul"))), \
+                             apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("ssse3,pclmul")
+#endif
+
+#include <immintrin.h>
+
+#include "lib/CAria_clmul.hpp"
+
+namespace Awesome_mix_vol_1 {
+namespace {
+
+struct CPclmul {
+  typedef __m128i Reg;
+
+  static Reg Reverse(Reg x) {
+    return _mm_shuffle_epi8(
+        x, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+  }
+  static Reg Load(const Byte *p) {
+    return Reverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+  }
+  static void Store(Byte *p, Reg x) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), Reverse(x));
+  }
+  static Reg Zero() { return _mm_setzero_si128(); }
+
+  static Reg Mul00(Reg a, Reg b) { return _mm_clmulepi64_si128(a, b, 0x00); }
+  static Reg Mul01(Reg a, Reg b) { return _mm_clmulepi64_si128(a, b, 0x10); }
+  static Reg Mul10(Reg a, Reg b) { return _mm_clmulepi64_si128(a, b, 0x01); }
+  static Reg Mul11(Reg a, Reg b) { return _mm_clmulepi64_si128(a, b, 0x11); }
+
+  template <int n>
+  static Reg ShlBytes(Reg x) {
+    return _mm_slli_si128(x, n);
+  }
+  template <int n>
+  static Reg ShrBytes(Reg x) {
+    return _mm_srli_si128(x, n);
+  }
+  template <int n>
+  static Reg Shl32(Reg x) {
+    return _mm_slli_epi32(x, n);
+  }
+  template <int n>
+  static Reg Shr32(Reg x) {
+    return _mm_srli_epi32(x, n);
+  }
+};
+
+void GhashInitPclmul(CAriaGhashKey *key, const Byte *h) {
+  ClmulInit<CPclmul>(key, h);
+}
+
+void GhashUpdatePclmul(const CAriaGhashKey *key, Byte *y, const Byte *in,
+                       size_t nBlocks) {
+  ClmulUpdate<CPclmul>(key, y, in, nBlocks);
+}
+
+}  // namespace
+}  // namespace Awesome_mix_vol_1
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaGhash *AriaGhashPclmul() {
+  static const CAriaGhash ghash = {"pclmul", GhashInitPclmul,
+                                   GhashUpdatePclmul};
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("pclmul")) {
+    return &ghash;
+  }
+  return NULL;
+}
+
+}  // namespace Awesome_mix_vol_1
+
+#else
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaGhash *AriaGhashPclmul() { return NULL; }
+
+}  // namespace Awesome_mix_vol_1
+
+#endif
@@ -0,0 +1,118 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/* aarch64 PMULL을 사용하는 GHASH.  알고리즘은 lib/CAria_clmul.hpp를 본다.
+ * 레지스터 배치는 x86과 같은 little endian이므로 PCLMULQDQ 버전의 연산을
+ * 그대로 옮긴다. */
+
+#include "lib/CAria_ghash.hpp"
+
+#if defined(__aarch64__) && defined(__linux__)
+
+#include <sys/auxv.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("aes"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("+crypto")
+#endif
+
+#include <arm_neon.h>
+
+#include "lib/CAria_clmul.hpp"
+
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+
+namespace Awesome_mix_vol_1 {
+namespace {
+
+struct CPmull {
+  typedef uint8x16_t Reg;
+
+  static Reg Reverse(Reg x) {
+    x = vrev64q_u8(x);
+    return vextq_u8(x, x, 8);
+  }
+  static Reg Load(const Byte *p) { return Reverse(vld1q_u8(p)); }
+  static void Store(Byte *p, Reg x) { vst1q_u8(p, Reverse(x)); }
+  static Reg Zero() { return vdupq_n_u8(0); }
+
+  static Reg Mul00(Reg a, Reg b) {
+    return vreinterpretq_u8_p128(
+        vmull_p64(vgetq_lane_p64(vreinterpretq_p64_u8(a), 0),
+                  vgetq_lane_p64(vreinterpretq_p64_u8(b), 0)));
+  }
+  static Reg Mul01(Reg a, Reg b) {
+    return vreinterpretq_u8_p128(
+        vmull_p64(vgetq_lane_p64(vreinterpretq_p64_u8(a), 0),
+                  vgetq_lane_p64(vreinterpretq_p64_u8(b), 1)));
+  }
+  static Reg Mul10(Reg a, Reg b) {
+    return vreinterpretq_u8_p128(
+        vmull_p64(vgetq_lane_p64(vreinterpretq_p64_u8(a), 1),
+                  vgetq_lane_p64(vreinterpretq_p64_u8(b), 0)));
+  }
+  static Reg Mul11(Reg a, Reg b) {
+    return vreinterpretq_u8_p128(vmull_high_p64(vreinterpretq_p64_u8(a),
+                                                vreinterpretq_p64_u8(b)));
+  }
+
+  /* x86의 _mm_slli_si128/_mm_srli_si128과 같은 Byte 단위 shift */
+  template <int n>
+  static Reg ShlBytes(Reg x) {
+    return vextq_u8(Zero(), x, 16 - n);
+  }
+  template <int n>
+  static Reg ShrBytes(Reg x) {
+    return vextq_u8(x, Zero(), n);
+  }
+  template <int n>
+  static Reg Shl32(Reg x) {
+    return vreinterpretq_u8_u32(vshlq_n_u32(vreinterpretq_u32_u8(x), n));
+  }
+  template <int n>
+  static Reg Shr32(Reg x) {
+    return vreinterpretq_u8_u32(vshrq_n_u32(vreinterpretq_u32_u8(x), n));
+  }
+};
+
+void GhashInitPmull(CAriaGhashKey *key, const Byte *h) {
+  ClmulInit<CPmull>(key, h);
+}
+
+void GhashUpdatePmull(const CAriaGhashKey *key, Byte *y, const Byte *in,
+                      size_t nBlocks) {
+  ClmulUpdate<CPmull>(key, y, in, nBlocks);
+}
+
+}  // namespace
+}  // namespace Awesome_mix_vol_1
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaGhash *AriaGhashPmull() {
+  static const CAriaGhash ghash = {"pmull", GhashInitPmull, GhashUpdatePmull};
+
+  if (getauxval(AT_HWCAP) & HWCAP_PMULL) return &ghash;
+  return NULL;
+}
+
+}  // namespace Awesome_mix_vol_1
+
+#else
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaGhash *AriaGhashPmull() { return NULL; }
+
+}  // namespace Awesome_mix_vol_1
+
+#endif
@@ -0,0 +1,107 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/*
+ * aarch64 NEON을 사용하는 ARIA 백엔드
+ *
+ * S-Box는 256 Byte 테이블을 64 Byte씩 네 조각으로 나누어 TBL/TBX(
+ * vqtbl4q_u8, vqtbx4q_u8)로 찾는다.  TBX는 범위를 벗어난 index의 Byte를
+ * 그대로 두므로 index에서 64씩 빼 가며 네 번 찾으면 256 Byte 테이블 참조가
+ * 된다.  블록 16개를 lib/CAria_sliced.hpp의 방식으로 처리하므로 WordLoad()의
+ * 엔디안 변환도 필요 없다.
+ */
+
+#include <cstring>
+
+#include "lib/CAria_backend.hpp"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+#include "lib/CAria_sliced.hpp"
+
+namespace Awesome_mix_vol_1 {
+namespace {
+
+/* SB1, SB2, SB3, SB4의 Byte 테이블.  AriaNeonBackend()에서 한 번 채운다. */
+alignas(16) Byte g_sbox[4][256];
+
+void InitSBoxes() {
+  for (int x = 0; x < 256; x++) {
+    g_sbox[0][x] = (Byte)(S1[x]);
+    g_sbox[1][x] = (Byte)(S2[x]);
+    g_sbox[2][x] = (Byte)(X1[x]);
+    g_sbox[3][x] = (Byte)(X2[x] >> 8);
+  }
+}
+
+struct VNeon {
+  typedef uint8x16_t Reg;
+  static const size_t kBlocks = 16;
+
+  static Reg Load(const Byte *p, int r) { return vld1q_u8(p + 16 * r); }
+  static void Store(Byte *p, int r, Reg x) { vst1q_u8(p + 16 * r, x); }
+  static Reg Set1(Byte b) { return vdupq_n_u8(b); }
+  static Reg Unpacklo8(Reg a, Reg b) { return vzip1q_u8(a, b); }
+  static Reg Unpackhi8(Reg a, Reg b) { return vzip2q_u8(a, b); }
+
+  static uint8x16x4_t Table(const Byte *t) {
+    uint8x16x4_t v;
+    v.val[0] = vld1q_u8(t);
+    v.val[1] = vld1q_u8(t + 16);
+    v.val[2] = vld1q_u8(t + 32);
+    v.val[3] = vld1q_u8(t + 48);
+    return v;
+  }
+  static Reg Lookup(const Byte *t, Reg x) {
+    const Reg c64 = vdupq_n_u8(64);
+    Reg y = vqtbl4q_u8(Table(t), x);
+
+    x = vsubq_u8(x, c64);
+    y = vqtbx4q_u8(y, Table(t + 64), x);
+    x = vsubq_u8(x, c64);
+    y = vqtbx4q_u8(y, Table(t + 128), x);
+    x = vsubq_u8(x, c64);
+    return vqtbx4q_u8(y, Table(t + 192), x);
+  }
+
+  static Reg Sb1(Reg x) { return Lookup(g_sbox[0], x); }
+  static Reg Sb2(Reg x) { return Lookup(g_sbox[1], x); }
+  static Reg Sb3(Reg x) { return Lookup(g_sbox[2], x); }
+  static Reg Sb4(Reg x) { return Lookup(g_sbox[3], x); }
+};
+
+void CryptBlocksNeon(const Byte *i, size_t nBlocks, int Nr, const Byte *rk,
+                     Byte *o) {
+  CryptSliced<VNeon>(i, nBlocks, Nr, rk, o);
+}
+
+void CryptBlocksNeonPrepared(const Byte *i, size_t nBlocks, int Nr,
+                             const Byte *kb, Byte *o) {
+  CryptSlicedPrepared<VNeon>(i, nBlocks, Nr, kb, o);
+}
+
+}  // namespace
+
+const CAriaBackend *AriaNeonBackend() {
+  static const CAriaBackend backend = {
+      "neon", VNeon::kBlocks, CryptBlocksNeon, PrepareSliced,
+      CryptBlocksNeonPrepared};
+  /* 함수 안의 static 변수는 처음 호출될 때 한 번만 초기화된다 */
+  static const bool initialized = (InitSBoxes(), true);
+
+  /* aarch64에서 NEON(Advanced SIMD)은 항상 사용할 수 있다 */
+  return initialized ? &backend : NULL;
+}
+
+}  // namespace Awesome_mix_vol_1
+
+#else
+
+namespace Awesome_mix_vol_1 {
+
+const CAriaBackend *AriaNeonBackend() { return NULL; }
+
+}  // namespace Awesome_mix_vol_1
+
+#endif
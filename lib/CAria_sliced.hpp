@@ -0,0 +1,214 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+/*
+ * 바이트 슬라이스(byte-sliced) 방식의 ARIA 구현
+ *
+ * 블록 W개의 j번째 Byte들을 레지스터 x[j] 하나에 모아 두면(16x16 Byte 전치),
+ * S-Box 계층은 레지스터마다 한 종류의 S-Box를 적용하는 것이 되고 확산 계층은
+ * 레지스터 사이의 XOR만으로 계산된다.  S-Box는 테이블 대신 AES-NI, GFNI,
+ * NEON 등의 명령어로 계산하므로 메모리 참조가 없다.
+ *
+ * V는 명령어 집합별 레지스터 타입과 연산을 제공한다.
+ *   V::Reg                 : 레지스터 타입 (128-bit lane 한 개 이상)
+ *   V::kBlocks             : 한 번에 처리하는 블록 수 (16 * lane 수)
+ *   V::Load(p, r)          : r, r + 16, r + 32, ...번째 블록을 lane 별로 읽기
+ *   V::Store(p, r, x)      : Load()의 반대
+ *   V::Set1(b)             : 모든 Byte가 b인 레지스터
+ *   V::Unpacklo8(a, b)     : lane 단위로 a, b의 하위 8 Byte를 번갈아 배치
+ *   V::Unpackhi8(a, b)     : lane 단위로 a, b의 상위 8 Byte를 번갈아 배치
+ *   V::Sb1, Sb2, Sb3, Sb4  : Byte 단위 S-Box (SB1 = S1, SB2 = S2, SB3 = X1,
+ *                            SB4 = X2)
+ * 레지스터끼리의 XOR은 ^ 연산자를 사용한다.
+ *
+ * 이 파일은 필요한 표준 헤더와 include/CAria.hpp를 include 한 다음, 백엔드가
+ * 사용할 명령어 집합을 #pragma GCC target 등으로 지정한 상태에서 include 한다.
+ */
+
+#ifndef LIB_CARIA_SLICED_HPP_
+#define LIB_CARIA_SLICED_HPP_
+
+namespace Awesome_mix_vol_1 {
+namespace {
+
+/* r번째 라운드 키의 j번째 Byte (ARIA spec의 Byte 순서) */
+inline Byte RoundKeyByte(const Byte *rk, int r, int j) {
+  return BRF(WO(const_cast<Byte *>(rk), 4 * r + j / 4), 24 - 8 * (j % 4));
+}
+
+/* 레지스터 16개를 16x16 Byte 행렬로 보고 lane 별로 전치한다.
+ * Byte interleave를 네 번 반복하면 전치가 되고, 전치는 자기 자신이 역이다. */
+template <class V>
+inline void Transpose(typename V::Reg *x) {
+  typename V::Reg t[16];
+
+  for (int s = 0; s < 4; s++) {
+    for (int n = 0; n < 8; n++) {
+      t[2 * n] = V::Unpacklo8(x[n], x[n + 8]);
+      t[2 * n + 1] = V::Unpackhi8(x[n], x[n + 8]);
+    }
+    for (int n = 0; n < 16; n++) x[n] = t[n];
+  }
+}
+
+template <class V>
+inline void KeyXor(typename V::Reg *x, const typename V::Reg *k) {
+  for (int j = 0; j < 16; j++) x[j] = x[j] ^ k[j];
+}
+
+/* 홀수번째 라운드의 S-Box 계층: SB1, SB2, SB3, SB4 */
+template <class V>
+inline void SubstLayer1(typename V::Reg *x) {
+  for (int j = 0; j < 16; j += 4) {
+    x[j] = V::Sb1(x[j]);
+    x[j + 1] = V::Sb2(x[j + 1]);
+    x[j + 2] = V::Sb3(x[j + 2]);
+    x[j + 3] = V::Sb4(x[j + 3]);
+  }
+}
+
+/* 짝수번째 라운드의 S-Box 계층: SB3, SB4, SB1, SB2 */
+template <class V>
+inline void SubstLayer2(typename V::Reg *x) {
+  for (int j = 0; j < 16; j += 4) {
+    x[j] = V::Sb3(x[j]);
+    x[j + 1] = V::Sb4(x[j + 1]);
+    x[j + 2] = V::Sb1(x[j + 2]);
+    x[j + 3] = V::Sb2(x[j + 3]);
+  }
+}
+
+/* Word 단위 XOR: Word a ^= Word b.  Word Ti는 x[4i]..x[4i+3]이다. */
+template <class V>
+inline void WordXor(typename V::Reg *x, int a, int b) {
+  for (int j = 0; j < 4; j++) x[4 * a + j] = x[4 * a + j] ^ x[4 * b + j];
+}
+
+/* CAria.hpp의 MM과 같은 Word 단위의 변환 */
+template <class V>
+inline void SlicedMM(typename V::Reg *x) {
+  WordXor<V>(x, 1, 2);
+  WordXor<V>(x, 2, 3);
+  WordXor<V>(x, 0, 1);
+  WordXor<V>(x, 3, 1);
+  WordXor<V>(x, 2, 0);
+  WordXor<V>(x, 1, 2);
+}
+
+/* 확산 계층.  CAria.hpp의 FO와 같이 M, MM, P, MM 순서로 계산한다.
+ * M은 각 Word 안에서 자기 자신을 제외한 세 Byte의 XOR이고,
+ * P는 레지스터의 순서만 바꾸는 변환이다. */
+template <class V>
+inline void Diffuse(typename V::Reg *x) {
+  typedef typename V::Reg Reg;
+  Reg t;
+
+  for (int w = 0; w < 16; w += 4) {
+    t = x[w] ^ x[w + 1] ^ x[w + 2] ^ x[w + 3];
+    x[w] = x[w] ^ t;
+    x[w + 1] = x[w + 1] ^ t;
+    x[w + 2] = x[w + 2] ^ t;
+    x[w + 3] = x[w + 3] ^ t;
+  }
+
+  SlicedMM<V>(x);
+
+  /* P: T1은 두 Byte씩 자리 바꿈, T2는 16-bit 회전, T3은 Byte 순서 뒤집기 */
+  t = x[4], x[4] = x[5], x[5] = t;
+  t = x[6], x[6] = x[7], x[7] = t;
+  t = x[8], x[8] = x[10], x[10] = t;
+  t = x[9], x[9] = x[11], x[11] = t;
+  t = x[12], x[12] = x[15], x[15] = t;
+  t = x[13], x[13] = x[14], x[14] = t;
+
+  SlicedMM<V>(x);
+}
+
+/* 라운드 키를 백엔드 전용 형식으로 바꾼다.
+ * Word 단위로 엔디안이 바뀌어 있는 라운드 키를 spec의 Byte 순서로 펼쳐 두면
+ * CryptSlicedPrepared()는 Byte를 그대로 레지스터에 broadcast 하면 된다. */
+inline void PrepareSliced(const Byte *rk, int Nr, Byte *kb) {
+  for (int r = 0; r <= Nr; r++) {
+    for (int j = 0; j < 16; j++) kb[16 * r + j] = RoundKeyByte(rk, r, j);
+  }
+}
+
+/* nBlocks개의 연속된 블록을 PrepareSliced()로 변환한 라운드 키로 처리한다.
+ * 라운드 수 Nr은 컴파일 시간에 정해진다.
+ * 블록 수가 V::kBlocks로 나누어 떨어지지 않으면 마지막 묶음은 임시 버퍼에서
+ * 처리한다. */
+template <class V, int Nr>
+void CryptSlicedRounds(const Byte *i, size_t nBlocks, const Byte *kb,
+                       Byte *o) {
+  typedef typename V::Reg Reg;
+  Reg k[17 * 16], x[16];
+  Byte buf[V::kBlocks * 16];
+  int r, j;
+
+  for (r = 0; r < 16 * (Nr + 1); r++) k[r] = V::Set1(kb[r]);
+
+  while (nBlocks > 0) {
+    size_t n = (nBlocks < V::kBlocks) ? nBlocks : V::kBlocks;
+    const Byte *src = i;
+    Byte *dst = o;
+    if (n < V::kBlocks) {
+      memcpy(buf, i, n * 16);
+      src = dst = buf;
+    }
+
+    for (j = 0; j < 16; j++) x[j] = V::Load(src, j);
+    Transpose<V>(x);
+
+    for (r = 0; r < Nr - 2; r += 2) {
+      KeyXor<V>(x, k + 16 * r);
+      SubstLayer1<V>(x);
+      Diffuse<V>(x);
+      KeyXor<V>(x, k + 16 * (r + 1));
+      SubstLayer2<V>(x);
+      Diffuse<V>(x);
+    }
+    KeyXor<V>(x, k + 16 * r);
+    SubstLayer1<V>(x);
+    Diffuse<V>(x);
+
+    /* 최종 라운드는 확산 계층 없이 키를 한 번 더 XOR 한다 */
+    KeyXor<V>(x, k + 16 * (r + 1));
+    SubstLayer2<V>(x);
+    KeyXor<V>(x, k + 16 * (r + 2));
+
+    Transpose<V>(x);
+    for (j = 0; j < 16; j++) V::Store(dst, j, x[j]);
+
+    if (n < V::kBlocks) memcpy(o, buf, n * 16);
+    i += n * 16;
+    o += n * 16;
+    nBlocks -= n;
+  }
+}
+
+/* 라운드 수에 맞는 CryptSlicedRounds<V, Nr>()을 한 번 고른다 */
+template <class V>
+void CryptSlicedPrepared(const Byte *i, size_t nBlocks, int Nr,
+                         const Byte *kb, Byte *o) {
+  if (Nr > 14) {
+    CryptSlicedRounds<V, 16>(i, nBlocks, kb, o);
+  } else if (Nr > 12) {
+    CryptSlicedRounds<V, 14>(i, nBlocks, kb, o);
+  } else {
+    CryptSlicedRounds<V, 12>(i, nBlocks, kb, o);
+  }
+}
+
+/* CAria::Crypt()와 같은 라운드 키로 처리한다 */
+template <class V>
+void CryptSliced(const Byte *i, size_t nBlocks, int Nr, const Byte *rk,
+                 Byte *o) {
+  Byte kb[ARIA_PREPARED_KEY_SIZE];
+
+  PrepareSliced(rk, Nr, kb);
+  CryptSlicedPrepared<V>(i, nBlocks, Nr, kb, o);
+}
+
+}  // namespace
+}  // namespace Awesome_mix_vol_1
+
+#endif  // LIB_CARIA_SLICED_HPP_
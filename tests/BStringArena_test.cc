@@ -0,0 +1,72 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "include/amvarena.hpp"
+
+TEST(BStringArena, heap_test)
+{
+    AMV::CAmvArenaHeap heap(1024);
+
+    // 연속으로 잘라서 주고, 마지막 블록만 제자리에서 늘린다
+    char *p1 = static_cast<char *>(heap.Allocate(10));
+    char *p2 = static_cast<char *>(heap.Allocate(16));
+    ASSERT_EQ(heap.GetChunkCount(), 1u);
+    ASSERT_EQ(heap.GetSize(p1), 16u);
+    ASSERT_GT(p2, p1);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(p2) % 8, 0u);
+
+    memset(p2, 'x', 16);
+    ASSERT_EQ(heap.Reallocate(p2, 100), p2);
+    ASSERT_EQ(heap.GetSize(p2), 104u);
+
+    // 마지막이 아닌 블록은 옮겨서 늘린다
+    memcpy(p1, "0123456789", 10);
+    char *p3 = static_cast<char *>(heap.Reallocate(p1, 40));
+    ASSERT_NE(p3, p1);
+    ASSERT_EQ(memcmp(p3, "0123456789", 10), 0);
+
+    // 마지막 블록을 돌려주면 그 자리를 다시 쓴다
+    heap.Free(p3);
+    ASSERT_EQ(heap.Allocate(8), p3);
+
+    // chunk보다 큰 요청은 따로 할당하고 Reset()은 기본 크기 chunk 하나만 남긴다
+    void *pBig = heap.Allocate(4000);
+    ASSERT_NE(pBig, nullptr);
+    ASSERT_EQ(heap.GetSize(pBig), 4000u);
+    heap.Allocate(1000);
+    ASSERT_EQ(heap.GetChunkCount(), 3u);
+    heap.Reset();
+    ASSERT_EQ(heap.GetChunkCount(), 1u);
+}
+
+TEST(BStringArena, string_test)
+{
+    AMV::CAmvArenaStringMgr mgr(4096);
+    const std::string sLong(100, 'a');
+
+    for (int round = 0; round < 3; round++)
+    {
+        {
+            BString a(sLong.c_str(), &mgr);
+            BString b("short", &mgr);
+            BString c(a);
+            c += b;
+            a += "tail";
+            ASSERT_EQ(a.GetManager(), &mgr);
+            ASSERT_EQ(c, (sLong + "short").c_str());
+            ASSERT_EQ(a, (sLong + "tail").c_str());
+            ASSERT_EQ(mgr.GetStringCount(), 2u);
+            for (int i = 0; i < 100; i++)
+                a += sLong.c_str();
+            ASSERT_EQ(a.GetLength(), 101 * 100 + 4);
+        }
+        ASSERT_EQ(mgr.GetStringCount(), 0u);
+        mgr.Reset();
+        ASSERT_EQ(mgr.GetHeap().GetChunkCount(), 1u);
+    }
+}
@@ -0,0 +1,143 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include "include/amvstr.hpp"
+#include "tests/counting_heap.hpp"
+
+TEST(BStringConcat, concat_test)
+{
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+    BString method("GET", &mgr);
+    BString path("/api/v1/users/12345/profile", &mgr);
+    BStringView query("?fields=name,email");
+
+    // Concat()은 길이를 먼저 더하고 한 번만 할당한다
+    heap.nAllocs = 0;
+    BString line = BString::Concat(method, ' ', path, query, " status=", "200", ' ', method);
+    ASSERT_EQ(heap.nAllocs, 1);
+    ASSERT_EQ(line, "GET /api/v1/users/12345/profile?fields=name,email status=200 GET");
+    ASSERT_EQ(BString::Concat(query, '&').GetManager(), AMV::CAmvStringMgr::GetInstance());
+
+    // operator+는 문자열을 돌려주고, 왼쪽의 임시 문자열에 이어 붙인다
+    heap.nAllocs = 0;
+    BString chained = method + ' ' + path + query + " status=" + "200" + ' ' + method;
+    ASSERT_EQ(chained, line);
+    ASSERT_LT(heap.nAllocs, 4);
+
+    // 왼쪽이 문자열이 아니어도 되고, 결과는 문자열의 manager를 쓴다
+    BString s = "[" + (method + "] ") + ('<' + path + '>');
+    ASSERT_EQ(s, "[GET] </api/v1/users/12345/profile>");
+    ASSERT_EQ(s.GetManager(), &mgr);
+    BString t = query + path;
+    ASSERT_EQ(t, "?fields=name,email/api/v1/users/12345/profile");
+    ASSERT_EQ(t.GetManager(), &mgr);
+
+    // 짧으면 할당 없이 객체 안에 들어간다
+    heap.nAllocs = 0;
+    BString shortLine = method + ' ' + "OK";
+    ASSERT_TRUE(shortLine.IsInline());
+    ASSERT_EQ(heap.nAllocs, 0);
+    ASSERT_EQ((method + "!").GetLength(), 4);
+
+    // 비교와 출력은 문자열처럼 된다
+    ASSERT_TRUE(method + "/" + method == "GET/GET");
+    ASSERT_FALSE(method + "/" != "GET/");
+    std::ostringstream os;
+    os << method + ':' + path;
+    ASSERT_EQ(os.str(), "GET:/api/v1/users/12345/profile");
+}
+
+TEST(BStringConcat, assign_test)
+{
+    BString s("0123456789_0123456789_0123456789");
+
+    // 자기 자신을 가리키는 조각이 있어도 된다
+    s = s + "|" + s;
+    ASSERT_EQ(s, "0123456789_0123456789_0123456789|0123456789_0123456789_0123456789");
+    BString u("0123456789");
+    u = BStringView(u).Left(3) + u + BStringView(u).Right(2);
+    ASSERT_EQ(u, "012012345678989");
+    u += u + "+" + u;
+    ASSERT_EQ(u, "012012345678989012012345678989+012012345678989");
+
+    // 공유하던 문자열은 바뀌지 않는다
+    BString a("this string is longer than the inline buffer");
+    BString b(a);
+    b += "[" + a + "]";
+    ASSERT_EQ(a, "this string is longer than the inline buffer");
+    ASSERT_EQ(b, "this string is longer than the inline buffer"
+                 "[this string is longer than the inline buffer]");
+
+    BString c;
+    c += a + "";
+    ASSERT_EQ(c, a);
+    c = BString() + "";
+    ASSERT_TRUE(c.IsEmpty());
+
+    // 결과는 피연산자를 가리키지 않는 문자열이라 auto에 담아도 된다
+    static_assert(std::is_same<decltype(a + b), BString>::value, "operator+ returns a string");
+    auto joined = BString("this temporary string is gone after this line") + "!";
+    auto copy = a + "|" + b;
+    a = "x";
+    b.Empty();
+    ASSERT_EQ(joined, "this temporary string is gone after this line!");
+    ASSERT_EQ(copy, "this string is longer than the inline buffer|"
+                    "this string is longer than the inline buffer"
+                    "[this string is longer than the inline buffer]");
+}
+
+TEST(BStringConcat, builder_test)
+{
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+    std::string sExpect;
+
+    {
+        BStringBuilder builder(&mgr);
+        BString key("key", &mgr);
+        ASSERT_TRUE(builder.IsEmpty());
+        ASSERT_EQ(builder.ToString(), "");
+
+        for (int i = 0; i < 20000; i++)
+        {
+            builder += key + '=';
+            builder.Append("value, ");
+            builder += BStringView("0123456789").Mid(i % 10);
+            builder += '\n';
+            sExpect += "key=value, " + std::string("0123456789").substr(i % 10) + "\n";
+        }
+        ASSERT_EQ(builder.GetLength(), static_cast<int>(sExpect.size()));
+
+        // 덧붙이는 동안에는 chunk만 할당하고, 옮기지 않는다
+        int nChunks = heap.nAllocs;
+        ASSERT_LT(nChunks, 20);
+        BString s = builder.ToString();
+        ASSERT_EQ(heap.nAllocs, nChunks + 1);
+        ASSERT_EQ(std::string(s.GetString(), s.GetLength()), sExpect);
+
+        BString prefix("> ", &mgr);
+        builder.AppendTo(prefix);
+        ASSERT_EQ(std::string(prefix.GetString(), prefix.GetLength()), "> " + sExpect);
+
+        // Empty()는 chunk를 남겨 다시 쓴다
+        builder.Empty();
+        heap.nAllocs = 0;
+        builder.Append(sExpect.c_str(), static_cast<int>(sExpect.size()));
+        ASSERT_EQ(heap.nAllocs, 0);
+        ASSERT_EQ(builder.GetLength(), static_cast<int>(sExpect.size()));
+
+        builder.Empty();
+        std::string sBig(3 * 1024 * 1024, 'x');
+        builder.Append(sBig.c_str(), static_cast<int>(sBig.size()));
+        builder += "end";
+        ASSERT_EQ(builder.ToString(), (sBig + "end").c_str());
+        ASSERT_EQ(builder.GetLength(), static_cast<int>(sBig.size()) + 3);
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "include/amvstr.hpp"
+
+namespace
+{
+// 할당과 해제 횟수를 세고, 해제한 메모리를 덮어써 해제 후 사용을 드러낸다
+class CCountingHeap : public AMV::CAmvHeap
+{
+public:
+    virtual void *Allocate(_In_ size_t nBytes) throw()
+    {
+        nAlloc++;
+        return AMV::CAmvHeap::Allocate(nBytes);
+    }
+
+    virtual void Free(_In_opt_ void *p) throw()
+    {
+        if (p != NULL)
+        {
+            nFree++;
+            memset(p, 0xdd, GetSize(p));
+        }
+        AMV::CAmvHeap::Free(p);
+    }
+
+    int nAlloc = 0;
+    int nFree = 0;
+};
+} // namespace
+
+TEST(BStringData, release_test)
+{
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+
+    {
+        BString str("reference counted heap buffer", &mgr);
+        ASSERT_EQ(heap.nAlloc, 1);
+        {
+            // 공유는 할당하지 않고, 마지막 참조가 사라질 때만 해제한다
+            BString copy(str);
+            ASSERT_EQ(copy.GetString(), str.GetString());
+            ASSERT_EQ(heap.nAlloc, 1);
+        }
+        ASSERT_EQ(heap.nFree, 0);
+        ASSERT_EQ(str, "reference counted heap buffer");
+    }
+    ASSERT_EQ(heap.nFree, 1);
+
+    // 쓰기 전에 복사한 버퍼도 각각 해제된다
+    {
+        BString str("copy on write heap buffer", &mgr);
+        BString copy(str);
+        copy.SetAt(0, 'C');
+        ASSERT_EQ(str, "copy on write heap buffer");
+        ASSERT_EQ(copy, "Copy on write heap buffer");
+    }
+    ASSERT_EQ(heap.nAlloc, 3);
+    ASSERT_EQ(heap.nFree, 3);
+}
+
+TEST(BStringData, empty_after_release_test)
+{
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+
+    // 마지막 참조를 놓은 뒤에 해제된 버퍼에서 manager를 읽으면 안 된다
+    BString str("released by Empty() on the heap", &mgr);
+    str.Empty();
+    ASSERT_EQ(heap.nFree, 1);
+    ASSERT_TRUE(str.IsEmpty());
+    ASSERT_EQ(str.GetManager(), &mgr);
+
+    str = "allocated again after Empty()";
+    ASSERT_EQ(str, "allocated again after Empty()");
+    str.Empty();
+    ASSERT_EQ(heap.nAlloc, heap.nFree);
+}
@@ -0,0 +1,87 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fuzz/fuzz_diff.hpp"
+#include "include/amvsimd.hpp"
+
+namespace
+{
+// StringDiff()의 입력 형식에 맞춘 임의의 경우 하나
+std::vector<uint8_t> StringCase(std::mt19937 &rng, int iter)
+{
+    // 글자 종류가 적어야 집합, 찾을 문자열, 바꿀 문자가 본문에 자주 나온다
+    static const char *const apszChars[] = {
+        "a", "ab", "aA zZ\t", "\x80\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80", NULL};
+    const char *pszChars = apszChars[iter % 5];
+    auto Char = [&]()
+    {
+        return pszChars ? static_cast<uint8_t>(pszChars[rng() % strlen(pszChars)])
+                        : static_cast<uint8_t>(rng());
+    };
+
+    std::vector<uint8_t> v;
+    v.push_back(static_cast<uint8_t>(rng()));
+    v.push_back(static_cast<uint8_t>(rng()));
+    v.push_back(Char());
+    v.push_back(Char());
+    v.push_back(static_cast<uint8_t>(rng()));
+    for (int i = 0; i < v[4] % 9; i++)
+        v.push_back(Char());
+    v.push_back(static_cast<uint8_t>(rng()));
+    for (int i = 0; i < v.back() % 17; i++)
+        v.push_back(Char());
+    v.push_back(static_cast<uint8_t>(rng()));
+    v.push_back(Char());
+    size_t n = (rng() % 4 == 0) ? rng() % 2000 : rng() % 130;
+    for (size_t i = 0; i < n; i++)
+        v.push_back(Char());
+    return v;
+}
+} // namespace
+
+TEST(BStringDiff, random_test)
+{
+    std::mt19937 rng(30);
+    std::string strError;
+
+    // 모든 커널 x 정렬 x 길이
+    for (int iter = 0; iter < 3000; iter++)
+    {
+        std::vector<uint8_t> v = StringCase(rng, iter);
+        ASSERT_TRUE(AmvFuzz::StringDiff(v.data(), v.size(), &strError)) << strError;
+    }
+
+    for (size_t n = 0; n < 40; n++)
+    {
+        std::vector<uint8_t> v(n, static_cast<uint8_t>(n * 37));
+        ASSERT_TRUE(AmvFuzz::StringDiff(v.data(), v.size(), &strError)) << strError;
+    }
+}
+
+TEST(BStringDiff, dispatch_test)
+{
+    // 자동 선택이 CPU가 지원하는 가장 높은 단계를 써야 한다
+#if defined(AMV_SIMD_X86)
+    __builtin_cpu_init();
+    AMV::AmvSimd::Level expect = AMV::AmvSimd::LEVEL_SCALAR;
+    if (__builtin_cpu_supports("avx512bw"))
+        expect = AMV::AmvSimd::LEVEL_AVX512;
+    else if (__builtin_cpu_supports("avx2"))
+        expect = AMV::AmvSimd::LEVEL_AVX2;
+    else if (__builtin_cpu_supports("ssse3"))
+        expect = AMV::AmvSimd::LEVEL_SSSE3;
+    ASSERT_EQ(AMV::AmvSimd::GetLevel(), expect);
+#elif defined(AMV_SIMD_NEON)
+    ASSERT_EQ(AMV::AmvSimd::GetLevel(), AMV::AmvSimd::LEVEL_NEON);
+#else
+    ASSERT_EQ(AMV::AmvSimd::GetLevel(), AMV::AmvSimd::LEVEL_SCALAR);
+#endif
+}
@@ -0,0 +1,154 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "include/amvstr.hpp"
+
+namespace
+{
+// 문자가 객체 안에 있는지
+template <class TString>
+bool IsInside(const TString &s)
+{
+    const char *p = reinterpret_cast<const char *>(&s);
+    return s.GetString() >= p && s.GetString() + s.GetLength() < p + sizeof(s);
+}
+} // namespace
+
+TEST(BStringFixed, fixed_test)
+{
+    BInlineString<64> s;
+    ASSERT_EQ(BInlineString<64>::GetCapacity(), 64);
+    ASSERT_EQ(BInlineString<8>::GetCapacity(), AMV_SSO_CAPACITY);
+    ASSERT_TRUE(s.IsEmpty());
+
+    // inline 용량을 넘어도 객체 안의 버퍼를 쓴다
+    s = "2022-01-01T00:00:00.000000Z";
+    ASSERT_TRUE(IsInside(s));
+    s += " id=0123456789abcdef";
+    ASSERT_EQ(s, "2022-01-01T00:00:00.000000Z id=0123456789abcdef");
+    ASSERT_TRUE(IsInside(s));
+
+    // BStringT의 기능을 그대로 쓴다
+    ASSERT_EQ(s.Find("id="), 28);
+    s.Replace('-', '/');
+    ASSERT_TRUE(BStringView(s).Left(10) == BStringView("2022/01/01"));
+    s.TrimRight("0123456789abcdef");
+    ASSERT_EQ(s, "2022/01/01T00:00:00.000000Z id=");
+    ASSERT_EQ(s.Compare("2022/01/01T00:00:00.000000Z id="), 0);
+    ASSERT_TRUE(IsInside(s));
+
+    char *pszBuffer = s.GetBuffer(64);
+    memset(pszBuffer, 'x', 64);
+    s.ReleaseBufferSetLength(64);
+    ASSERT_TRUE(IsInside(s));
+
+    // 용량을 넘으면 할당하지 않고 던진다
+    ASSERT_ANY_THROW(s += "y");
+    ASSERT_EQ(s.GetLength(), 64);
+    ASSERT_ANY_THROW(s.GetBuffer(65));
+
+    // 줄이면 다시 inline으로 간다
+    s.Truncate(4);
+    s.FreeExtra();
+    ASSERT_TRUE(s.IsInline());
+    s = "this string is longer than the inline buffer";
+    ASSERT_TRUE(IsInside(s));
+    s.Empty();
+    ASSERT_TRUE(s.IsEmpty());
+    s = "this string is longer than the inline buffer, again";
+    ASSERT_TRUE(IsInside(s));
+}
+
+TEST(BStringFixed, convert_test)
+{
+    const char *pszLong = "this string is longer than the inline buffer";
+    BString str(pszLong);
+    BInlineString<64> s(str);
+    ASSERT_EQ(s, pszLong);
+    ASSERT_TRUE(IsInside(s));
+    ASSERT_NE(s.GetString(), str.GetString());
+
+    // BString으로는 명시적으로만 바꾸고, 복사본이 생긴다
+    BString copy(s.ToString());
+    ASSERT_EQ(copy, pszLong);
+    ASSERT_NE(copy.GetString(), s.GetString());
+    ASSERT_EQ(copy.GetManager(), AMV::CAmvStringMgr::GetInstance());
+    BString assigned;
+    assigned = s.GetView();
+    ASSERT_EQ(assigned, s);
+    ASSERT_NE(assigned.GetString(), s.GetString());
+    ASSERT_EQ(BString("x") + s, BString("x") + pszLong);
+    ASSERT_EQ(s + "!", BString(pszLong) + "!");
+
+    AMV::BStringData *pData = s.Detach();
+    ASSERT_EQ(strcmp(static_cast<char *>(pData->data()), pszLong), 0);
+    ASSERT_EQ(pData->pStringMgr, AMV::CAmvStringMgr::GetInstance());
+    pData->Release();
+    ASSERT_TRUE(s.IsEmpty());
+
+    // 다른 고정 문자열끼리는 내용만 복사한다
+    s = pszLong;
+    BInlineString<64> other(s);
+    BInlineString<64> assignedFixed;
+    assignedFixed = s;
+    ASSERT_EQ(other, s);
+    ASSERT_EQ(assignedFixed, s);
+    ASSERT_TRUE(IsInside(other));
+    ASSERT_TRUE(IsInside(assignedFixed));
+    s.SetAt(0, 'T');
+    ASSERT_EQ(other, pszLong);
+}
+
+TEST(BStringFixed, move_test)
+{
+    const char *pszLong = "this string is longer than the inline buffer";
+
+    // BString으로 묶이지 않으므로 BString&&가 고정 버퍼를 가리킬 일이 없다
+    static_assert(!std::is_convertible<BInlineString<48> &, BString &>::value,
+                  "a fixed string is not a BString");
+    static_assert(!std::is_constructible<BString, BInlineString<48> &&>::value,
+                  "a fixed string is not moved into a BString");
+    static_assert(!std::is_assignable<BString &, BInlineString<48> &&>::value,
+                  "a fixed string is not moved into a BString");
+
+    // 옮기면 새 객체의 버퍼로 복사하고, 원래 문자열은 그대로 남는다
+    BInlineString<48> s(pszLong);
+    BInlineString<48> moved(std::move(s));
+    ASSERT_EQ(moved, pszLong);
+    ASSERT_TRUE(IsInside(moved));
+    ASSERT_EQ(s, pszLong);
+
+    BInlineString<48> assigned("short");
+    assigned = std::move(moved);
+    ASSERT_EQ(assigned, pszLong);
+    ASSERT_TRUE(IsInside(assigned));
+
+    // BString에서 옮겨 넣으면 내용만 복사하고, 용량을 넘으면 던진다
+    std::string strBig(100, 'x');
+    BString big(strBig.c_str());
+    ASSERT_ANY_THROW(s = std::move(big));
+    ASSERT_EQ(s, pszLong);
+    ASSERT_EQ(big, strBig.c_str());
+
+    BString fits("fits into the fixed buffer of s, too");
+    s = std::move(fits);
+    ASSERT_EQ(s, "fits into the fixed buffer of s, too");
+    ASSERT_TRUE(IsInside(s));
+    ASSERT_EQ(fits, s);
+
+    // 길어지는 Replace도 새 문자열을 고정 버퍼로 복사하고, 넘치면 던진다
+    s = pszLong;
+    ASSERT_EQ(s.Replace("the", "THE!"), 1);
+    ASSERT_EQ(s, "this string is longer than THE! inline buffer");
+    ASSERT_TRUE(IsInside(s));
+    ASSERT_ANY_THROW(s.Replace(" ", "__"));
+    ASSERT_EQ(s, "this string is longer than THE! inline buffer");
+    ASSERT_TRUE(IsInside(s));
+}
@@ -0,0 +1,109 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "include/amvstr.hpp"
+
+TEST(BStringFormat, format_test)
+{
+    BString s;
+    s.Format("{} {:>4} {:.2f} {}", 42, "ab", 3.14159, 'c');
+    ASSERT_EQ(s, "42   ab 3.14 c");
+
+    // 이어 붙이기
+    s.AppendFormat("|{:x}", 255);
+    ASSERT_EQ(s, "42   ab 3.14 c|ff");
+
+    // BString과 view를 인자로 받는다
+    BString name("user");
+    BStringView view("xyz");
+    s.Format("{}={}", name, view);
+    ASSERT_EQ(s, "user=xyz");
+    s.Format("[{:>6}]", name);
+    ASSERT_EQ(s, "[  user]");
+
+    // 여유 공간을 넘으면 늘린 뒤 다시 쓴다
+    std::string expected;
+    BString line;
+    for (int i = 0; i < 200; i++)
+    {
+        line.AppendFormat("{},", i);
+        expected += std::to_string(i) + ",";
+    }
+    ASSERT_EQ(line, expected.c_str());
+    ASSERT_EQ(line.GetLength(), static_cast<int>(expected.size()));
+
+    // 공유된 버퍼는 건드리지 않는다
+    BString copy(line);
+    line.Format("{}", "new");
+    ASSERT_EQ(line, "new");
+    ASSERT_EQ(copy, expected.c_str());
+
+    // 자기 버퍼를 그대로 다시 쓴다
+    BString reused;
+    reused.Format("{:>100}", "x");
+    const char *pszBuffer = reused.GetString();
+    reused.Format("{}", 123);
+    ASSERT_EQ(reused, "123");
+    ASSERT_EQ(reused.GetString(), pszBuffer);
+
+    // 고정 문자열에도 바로 쓴다
+    BInlineString<64> fixed;
+    fixed.Format("{:04}-{:02}-{:02}T{:02}:{:02}:{:02}.{:06}Z id={:016x}", 2022, 1, 2, 3, 4, 5,
+                 6, 0x1234u);
+    ASSERT_EQ(fixed, "2022-01-02T03:04:05.000006Z id=0000000000001234");
+    ASSERT_ANY_THROW(fixed.AppendFormat("{:>64}", "x"));
+    ASSERT_EQ(fixed, "2022-01-02T03:04:05.000006Z id=0000000000001234");
+    ASSERT_EQ(strlen(fixed.GetString()), 47u);
+}
+
+TEST(BStringFormat, number_test)
+{
+    BString s;
+    s.AppendNumber(INT64_MIN);
+    ASSERT_EQ(s, "-9223372036854775808");
+    s.Empty();
+    s.AppendNumber(UINT64_MAX).Append(",");
+    s.AppendNumber(-1.5).Append(",");
+    s.AppendNumber(0.1).Append(",");
+    s.AppendNumber(-DBL_MAX);
+    ASSERT_EQ(s, "18446744073709551615,-1.5,0.1,-1.7976931348623157e+308");
+
+    int n = 7;
+    ASSERT_TRUE(BStringView("-123").ParseNumber(n));
+    ASSERT_EQ(n, -123);
+    // 실패하면 값을 바꾸지 않는다
+    ASSERT_FALSE(BStringView("12x").ParseNumber(n));
+    ASSERT_FALSE(BStringView(" 12").ParseNumber(n));
+    ASSERT_FALSE(BStringView("+12").ParseNumber(n));
+    ASSERT_FALSE(BStringView("").ParseNumber(n));
+    ASSERT_FALSE(BStringView("99999999999").ParseNumber(n));
+    ASSERT_EQ(n, -123);
+
+    uint64_t u = 0;
+    ASSERT_TRUE(BString("18446744073709551615").ParseNumber(u));
+    ASSERT_EQ(u, UINT64_MAX);
+
+    double d = 0;
+    ASSERT_TRUE(BString("0.1").ParseNumber(d));
+    ASSERT_EQ(d, 0.1);
+    ASSERT_TRUE(BStringView("1e-5x").Left(4).ParseNumber(d));
+    ASSERT_EQ(d, 1e-5);
+
+    // 왕복
+    for (double v : {0.0, -0.0, 1.0 / 3, 123456789.125, 5e-324})
+    {
+        BString text;
+        text.AppendNumber(v);
+        double back;
+        ASSERT_TRUE(text.ParseNumber(back)) << text.GetString();
+        ASSERT_EQ(back, v);
+    }
+}
@@ -0,0 +1,109 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "include/amvstr.hpp"
+
+TEST(BStringHash, hash_test)
+{
+    // 같은 글자면 BString, view, C 문자열, CStaticString 모두 같은 값이다
+    BString s("request-id");
+    AMV::CStaticString<char, sizeof("request-id")> str("request-id");
+    ASSERT_EQ(s.GetHash(), AMV::AmvHash("request-id", 10));
+    ASSERT_EQ(s.GetHash(), BStringView("request-id").GetHash());
+    ASSERT_EQ(std::hash<BString>()(s), std::hash<BStringView>()(BStringView(s)));
+    ASSERT_EQ(std::hash<BString>()(s), (std::hash<AMV::CStaticString<char, 11>>()(str)));
+    ASSERT_EQ(BStringHash()(s), BStringHash()("request-id"));
+    ASSERT_NE(s.GetHash(), BStringView(s).Left(9).GetHash());
+    ASSERT_NE(AMV::AmvHash("", 0), AMV::AmvHash("\0", 1));
+    ASSERT_NE(AMV::AmvHash("abc", 3, 1), AMV::AmvHash("abc", 3, 2));
+
+    // 길이마다 모든 byte가 값에 들어간다
+    std::string sKey(200, 'k');
+    for (size_t nLength = 1; nLength <= sKey.size(); nLength++)
+    {
+        uint64_t nHash = AMV::AmvHash(sKey.data(), nLength);
+        for (size_t i = 0; i < nLength; i++)
+        {
+            std::string sFlip = sKey.substr(0, nLength);
+            sFlip[i] ^= 1;
+            ASSERT_NE(AMV::AmvHash(sFlip.data(), nLength), nHash) << nLength << " " << i;
+        }
+    }
+
+    // 비슷한 key 100000개에서 64 bit 값은 겹치지 않고, 하위 32 bit도 거의 겹치지 않는다
+    std::set<uint64_t> hashes;
+    std::set<uint32_t> lowHashes;
+    char ach[32];
+    for (int i = 0; i < 100000; i++)
+    {
+        int nLength = snprintf(ach, sizeof(ach), "user:%d", i);
+        uint64_t nHash = AMV::AmvHash(ach, nLength);
+        hashes.insert(nHash);
+        lowHashes.insert(static_cast<uint32_t>(nHash));
+    }
+    ASSERT_EQ(hashes.size(), 100000u);
+    ASSERT_GT(lowHashes.size(), 100000u - 10);
+}
+
+TEST(BStringHash, cached_hash_test)
+{
+    // AMV_STRING_CACHE_HASH와 상관없이 값은 언제나 지금의 글자에 맞는다
+    BString s("this string is longer than the inline buffer");
+    BString copy(s);
+    uint64_t nHash = s.GetHash();
+    ASSERT_EQ(copy.GetHash(), nHash);
+
+    copy.SetAt(0, 'T');
+    ASSERT_EQ(copy.GetHash(), AMV::AmvHash(copy, copy.GetLength()));
+    ASSERT_NE(copy.GetHash(), nHash);
+    ASSERT_EQ(s.GetHash(), nHash);
+
+    s += "!";
+    ASSERT_EQ(s.GetHash(), AMV::AmvHash(s, s.GetLength()));
+    s.Truncate(s.GetLength() - 1);
+    ASSERT_EQ(s.GetHash(), nHash);
+    s.Replace('s', 'S');
+    ASSERT_EQ(s.GetHash(), AMV::AmvHash(s, s.GetLength()));
+
+    char *p = s.GetBuffer();
+    p[1] = 'x';
+    s.ReleaseBuffer();
+    ASSERT_EQ(s.GetHash(), AMV::AmvHash(s, s.GetLength()));
+
+    // 잠긴 버퍼는 직접 고쳐도 된다
+    p = s.LockBuffer();
+    ASSERT_EQ(s.GetHash(), AMV::AmvHash(s, s.GetLength()));
+    p[2] = 'y';
+    ASSERT_EQ(s.GetHash(), AMV::AmvHash(s, s.GetLength()));
+    s.UnlockBuffer();
+
+    BString empty;
+    ASSERT_EQ(empty.GetHash(), AMV::AmvHash("", 0));
+}
+
+TEST(BStringHash, unordered_map_test)
+{
+    std::unordered_map<BString, int> counts;
+    std::unordered_map<BString, int, BStringHash, BStringEqual> views;
+    BStringTokenizer tokenizer("get put get delete get put", ' ');
+    BStringView token;
+    while (tokenizer.Next(token))
+    {
+        counts[BString(token)]++;
+        views[BString(token)]++;
+    }
+
+    ASSERT_EQ(counts.size(), 3u);
+    ASSERT_EQ(counts[BString("get")], 3);
+    ASSERT_EQ(counts[BString("put")], 2);
+    ASSERT_EQ(views.size(), 3u);
+    ASSERT_EQ(views.find(BString("delete"))->second, 1);
+    ASSERT_TRUE(views.find(BString("post")) == views.end());
+}
@@ -0,0 +1,122 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "include/amvstr.hpp"
+
+TEST(BStringIntern, intern_test)
+{
+    BStringPool pool;
+
+    // 같은 내용은 버퍼 하나를 공유한다.  짧은 문자열도 마찬가지다
+    BString a = pool.Intern("Content-Type");
+    BString b = pool.Intern(BStringView("xContent-Type").Mid(1));
+    ASSERT_EQ(a, "Content-Type");
+    ASSERT_FALSE(a.IsInline());
+    ASSERT_TRUE(BStringPool::IsSame(a, b));
+    ASSERT_TRUE(pool.IsInterned(a));
+    ASSERT_EQ(pool.GetCount(), 1u);
+    ASSERT_EQ(a.Compare(b), 0);
+
+    // 복사해도 같은 버퍼를 가리킨다
+    BString copy(a);
+    BString assigned("other");
+    assigned = b;
+    ASSERT_TRUE(BStringPool::IsSame(copy, a));
+    ASSERT_TRUE(BStringPool::IsSame(assigned, a));
+    ASSERT_TRUE(BStringPool::IsSame(pool.Intern(copy), a));
+
+    // 내용이 같아도 pool 밖의 문자열은 다른 버퍼다
+    BString plain("Content-Type");
+    ASSERT_FALSE(pool.IsInterned(plain));
+    ASSERT_FALSE(BStringPool::IsSame(plain, a));
+    ASSERT_EQ(plain, a);
+    ASSERT_TRUE(BStringPool::IsSame(pool.Intern(plain), a));
+
+    // 고치면 자기 복사본이 생기고 pool의 내용은 그대로다
+    copy.SetAt(0, 'c');
+    ASSERT_EQ(copy, "content-Type");
+    ASSERT_EQ(a, "Content-Type");
+    ASSERT_FALSE(pool.IsInterned(copy));
+    ASSERT_TRUE(copy.IsInline());
+
+    BString c = pool.Intern("Accept");
+    ASSERT_FALSE(BStringPool::IsSame(a, c));
+    ASSERT_EQ(pool.GetCount(), 2u);
+
+    ASSERT_TRUE(pool.Intern("").IsEmpty());
+    ASSERT_EQ(pool.GetCount(), 2u);
+}
+
+TEST(BStringIntern, purge_test)
+{
+    BStringPool pool;
+    BString kept = pool.Intern("kept");
+    {
+        BString dropped = pool.Intern("dropped");
+    }
+    ASSERT_EQ(pool.GetCount(), 2u);
+    ASSERT_EQ(pool.Purge(), 1u);
+    ASSERT_EQ(pool.GetCount(), 1u);
+    ASSERT_TRUE(pool.IsInterned(kept));
+
+    // pool이 없어져도 받은 문자열은 그대로 쓸 수 있다
+    BString copy;
+    {
+        BStringPool other;
+        copy = other.Intern("this string is longer than the inline buffer");
+    }
+    ASSERT_EQ(copy, "this string is longer than the inline buffer");
+    pool.Clear();
+    ASSERT_EQ(pool.GetCount(), 0u);
+    ASSERT_EQ(kept, "kept");
+}
+
+TEST(BStringIntern, thread_test)
+{
+    BStringPool pool;
+    const int nThreads = 4;
+    const int nKeys = 1000;
+    std::vector<std::vector<BString>> results(nThreads);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.emplace_back([&pool, &results, t]() {
+            char ach[32];
+            for (int i = 0; i < nKeys; i++)
+            {
+                int nLength = snprintf(ach, sizeof(ach), "header-%d", (i * 7 + t) % nKeys);
+                results[t].push_back(pool.Intern(BStringView(ach, nLength)));
+            }
+        });
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+    {
+        threads[t].join();
+    }
+
+    // 모든 thread가 key마다 같은 버퍼를 받는다
+    ASSERT_EQ(pool.GetCount(), static_cast<size_t>(nKeys));
+    std::vector<const char *> buffers(nKeys);
+    for (int t = 0; t < nThreads; t++)
+    {
+        for (int i = 0; i < nKeys; i++)
+        {
+            int iKey = (i * 7 + t) % nKeys;
+            if (t == 0)
+            {
+                buffers[iKey] = results[t][i].GetString();
+            }
+            else
+            {
+                ASSERT_EQ(results[t][i].GetString(), buffers[iKey]);
+            }
+        }
+    }
+}
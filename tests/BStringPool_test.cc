@@ -0,0 +1,134 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/amvpool.hpp"
+#include "include/amvstr.hpp"
+
+TEST(BStringPool, heap_test)
+{
+    AMV::CAmvPoolHeap heap;
+
+    // 2의 거듭제곱 크기 class로 올림하고 16 Byte 단위로 정렬한다
+    ASSERT_EQ(AMV::CAmvPoolHeap::SizeClass(1), 0);
+    ASSERT_EQ(AMV::CAmvPoolHeap::SizeClass(16), 0);
+    ASSERT_EQ(AMV::CAmvPoolHeap::SizeClass(17), 1);
+    ASSERT_EQ(AMV::CAmvPoolHeap::SizeClass(4096), AMV::CAmvPoolHeap::NUM_CLASSES - 1);
+
+    char *p1 = static_cast<char *>(heap.Allocate(10));
+    char *p2 = static_cast<char *>(heap.Allocate(100));
+    ASSERT_EQ(heap.GetSize(p1), 16u);
+    ASSERT_EQ(heap.GetSize(p2), 128u);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(p2) % 16, 0u);
+
+    // 같은 class 안에서는 제자리, 넘어가면 옮겨서 늘린다
+    memcpy(p1, "0123456789", 10);
+    ASSERT_EQ(heap.Reallocate(p1, 16), p1);
+    char *p3 = static_cast<char *>(heap.Reallocate(p1, 40));
+    ASSERT_NE(p3, p1);
+    ASSERT_EQ(heap.GetSize(p3), 64u);
+    ASSERT_EQ(memcmp(p3, "0123456789", 10), 0);
+
+    // 돌려준 block은 같은 class의 다음 요청에 다시 쓴다
+    heap.Free(p2);
+    ASSERT_EQ(heap.Allocate(128), p2);
+
+    // 큰 요청은 malloc()으로 가고 크기는 header에 적어 둔다
+    void *pBig = heap.Allocate(10000);
+    ASSERT_NE(pBig, nullptr);
+    ASSERT_EQ(heap.GetSize(pBig), 10000u);
+    pBig = heap.Reallocate(pBig, 20000);
+    ASSERT_EQ(heap.GetSize(pBig), 20000u);
+    heap.Free(pBig);
+
+    heap.Free(p2);
+    heap.Free(p3);
+    heap.Free(NULL);
+}
+
+TEST(BStringPool, remote_free_test)
+{
+    AMV::CAmvPoolHeap heap;
+    const int N = 1000;
+    std::vector<void *> blocks;
+
+    for (int i = 0; i < N; i++)
+        blocks.push_back(heap.Allocate(48));
+
+    // 다른 thread가 돌려준 block은 원래 thread의 free list로 돌아온다
+    std::thread t([&]() {
+        for (void *p : blocks)
+            heap.Free(p);
+    });
+    t.join();
+
+    std::vector<void *> again;
+    for (int i = 0; i < N; i++)
+        again.push_back(heap.Allocate(48));
+    std::sort(blocks.begin(), blocks.end());
+    std::sort(again.begin(), again.end());
+    ASSERT_EQ(again, blocks);
+
+    for (void *p : again)
+        heap.Free(p);
+}
+
+TEST(BStringPool, thread_exit_test)
+{
+    AMV::CAmvPoolHeap heap;
+    void *p = NULL;
+
+    std::thread([&]() { p = heap.Allocate(200); }).join();
+    size_t nCaches = AMV::CAmvPoolHeap::GetCacheCount();
+
+    // 끝난 thread의 block도 그대로 쓰고 돌려줄 수 있다
+    memset(p, 'x', 200);
+    heap.Free(p);
+
+    // 끝난 thread의 cache는 새 thread가 물려받는다
+    std::thread([&]() { heap.Free(heap.Allocate(200)); }).join();
+    ASSERT_EQ(AMV::CAmvPoolHeap::GetCacheCount(), nCaches);
+}
+
+TEST(BStringPool, string_test)
+{
+    AMV::CAmvStringMgr mgr;
+    mgr.SetMemoryManager(AMV::CAmvPoolHeap::GetInstance());
+    const std::string sLong(100, 'a');
+    std::vector<BString> strings;
+
+    for (int i = 0; i < 64; i++)
+    {
+        strings.push_back(BString(sLong.c_str(), &mgr));
+    }
+
+    // 여러 thread에서 만들고 고치고 지운다
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.push_back(std::thread([&, t]() {
+            for (int i = t; i < 64; i += 4)
+            {
+                BString s(strings[i]);
+                for (int j = 0; j < 50; j++)
+                    s += "0123456789";
+                ASSERT_EQ(s.GetLength(), 600);
+                s.Truncate(100);
+                strings[i] = s;
+            }
+        }));
+    }
+    for (std::thread &t : threads)
+        t.join();
+
+    for (const BString &s : strings)
+        ASSERT_EQ(s, sLong.c_str());
+    strings.clear();
+}
@@ -0,0 +1,215 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "include/amvaho.hpp"
+#include "include/amvstr.hpp"
+
+namespace
+{
+// 비교용: 앞에서부터 찾아 바꾸는 std::string 구현
+int NaiveReplace(std::string &s, const std::string &sOld, const std::string &sNew)
+{
+    int nCount = 0;
+    for (size_t i = s.find(sOld); i != std::string::npos; i = s.find(sOld, i + sNew.size()))
+    {
+        s.replace(i, sOld.size(), sNew);
+        nCount++;
+    }
+    return nCount;
+}
+
+// 비교용: 각 위치에서 가장 긴 패턴을 바꾸는 구현
+int NaiveReplaceAll(std::string &s, const std::vector<std::pair<std::string, std::string>> &pairs)
+{
+    std::string sOut;
+    int nCount = 0;
+    for (size_t i = 0; i < s.size();)
+    {
+        int iBest = -1;
+        for (size_t k = 0; k < pairs.size(); k++)
+        {
+            const std::string &sOld = pairs[k].first;
+            if (!sOld.empty() && s.compare(i, sOld.size(), sOld) == 0 &&
+                (iBest < 0 || sOld.size() > pairs[iBest].first.size()))
+                iBest = static_cast<int>(k);
+        }
+        if (iBest < 0)
+        {
+            sOut += s[i++];
+            continue;
+        }
+        sOut += pairs[iBest].second;
+        i += pairs[iBest].first.size();
+        nCount++;
+    }
+    s = sOut;
+    return nCount;
+}
+} // namespace
+
+TEST(BStringReplace, replace_test)
+{
+    BString s("a-b--c---d");
+
+    ASSERT_EQ(s.Replace("--", "="), 2);
+    ASSERT_EQ(s, "a-b=c=-d");
+    ASSERT_EQ(s.Replace("-", "<->"), 2);
+    ASSERT_EQ(s, "a<->b=c=<->d");
+    ASSERT_EQ(s.Replace("<->", "_"), 2);
+    ASSERT_EQ(s, "a_b=c=_d");
+    ASSERT_EQ(s.Replace("=", ""), 2);
+    ASSERT_EQ(s, "a_bc_d");
+    ASSERT_EQ(s.Replace("", "x"), 0);
+    ASSERT_EQ(s.Replace("#", "x"), 0);
+
+    // 바꿀 것이 없으면 공유를 깨지 않고, 있으면 사본만 바뀐다
+    // (짧은 문자열은 공유하지 않으므로 긴 문자열로 본다)
+    BString shared("0123456789_0123456789_0123456789");
+    BString copy(shared);
+    ASSERT_EQ(copy.Replace("#", "x"), 0);
+    ASSERT_EQ(copy.GetString(), shared.GetString());
+    ASSERT_EQ(copy.Replace("_", "__"), 2);
+    ASSERT_EQ(copy, "0123456789__0123456789__0123456789");
+    ASSERT_EQ(shared, "0123456789_0123456789_0123456789");
+    copy = shared;
+    ASSERT_EQ(copy.Replace("_", "-"), 2);
+    ASSERT_EQ(copy, "0123456789-0123456789-0123456789");
+    ASSERT_EQ(shared, "0123456789_0123456789_0123456789");
+
+    // 일치가 객체 안에 저장할 수 있는 수(64)보다 많으면 힙으로 늘린다
+    std::string sLong;
+    for (int i = 0; i < 500; i++)
+        sLong += "ab ";
+    BString big(sLong.c_str());
+    std::string sExpect = sLong;
+    NaiveReplace(sExpect, "ab", "[ab]");
+    ASSERT_EQ(big.Replace("ab", "[ab]"), 500);
+    ASSERT_EQ(big, sExpect.c_str());
+}
+
+TEST(BStringReplace, replace_random_test)
+{
+    std::mt19937 rng(18);
+
+    for (int round = 0; round < 500; round++)
+    {
+        std::string sText(rng() % 80, 0);
+        for (char &ch : sText)
+            ch = "aab"[rng() % 3];
+        std::string sOld(1 + rng() % 3, 0), sNew(rng() % 5, 0);
+        for (char &ch : sOld)
+            ch = "ab"[rng() % 2];
+        for (char &ch : sNew)
+            ch = "abx"[rng() % 3];
+
+        BString s(sText.c_str());
+        std::string sExpect = sText;
+        int nExpect = NaiveReplace(sExpect, sOld, sNew);
+        ASSERT_EQ(s.Replace(sOld.c_str(), sNew.c_str()), nExpect);
+        ASSERT_EQ(s, sExpect.c_str()) << sText << " " << sOld << " " << sNew;
+    }
+}
+
+TEST(BStringReplace, replace_all_test)
+{
+    BString s("Dear {name}, your order {id} ships {when}. {name}!");
+
+    ASSERT_EQ(s.ReplaceAll({{"{name}", "Kim"}, {"{id}", "#1234"}, {"{when}", "today"}}), 4);
+    ASSERT_EQ(s, "Dear Kim, your order #1234 ships today. Kim!");
+
+    // 같은 위치에서는 긴 패턴, 바꾼 결과는 다시 찾지 않는다
+    BString t("aaaa abc ab");
+    ASSERT_EQ(t.ReplaceAll({{"a", "1"}, {"aa", "2"}, {"abc", "ab"}, {"b", "a"}}), 5);
+    ASSERT_EQ(t, "22 ab 1a");
+
+    BString shared("0123456789_0123456789_0123456789");
+    BString copy(shared);
+    ASSERT_EQ(copy.ReplaceAll({{"#", "x"}, {"", "y"}}), 0);
+    ASSERT_EQ(copy.GetString(), shared.GetString());
+
+    // 한 번 만든 set은 여러 문자열에 쓸 수 있다
+    AMV::CAmvReplaceSet set;
+    set.Add("he", "HE");
+    set.Add("she", "SHE");
+    set.Add("his", "HIS");
+    set.Add("hers", "HERS");
+    set.Add("he", "ignored");
+    set.Build();
+    ASSERT_EQ(set.GetMatcher().GetPatternCount(), 4);
+    BString u("ushers his she"), v("hehe");
+    ASSERT_EQ(u.ReplaceAll(set), 3);
+    ASSERT_EQ(u, "uSHErs HIS SHE");
+    ASSERT_EQ(v.ReplaceAll(set), 2);
+    ASSERT_EQ(v, "HEHE");
+
+    // 일치가 많아도 Replace()와 같은 버퍼로 모은다
+    std::string sLong;
+    for (int i = 0; i < 500; i++)
+        sLong += "he she ";
+    BString big(sLong.c_str());
+    ASSERT_EQ(big.ReplaceAll(set), 1000);
+    std::string sExpect;
+    for (int i = 0; i < 500; i++)
+        sExpect += "HE SHE ";
+    ASSERT_EQ(big, sExpect.c_str());
+}
+
+TEST(BStringReplace, match_buffer_test)
+{
+    AMV::CAmvMatchBuffer<int, 4> matches;
+    ASSERT_EQ(matches.GetCount(), 0);
+    ASSERT_EQ(matches.begin(), matches.end());
+
+    // 객체 안의 4개를 넘으면 힙으로 옮겨도 순서와 값이 그대로다
+    for (int i = 0; i < 100; i++)
+        matches.Add(i * 3);
+    ASSERT_EQ(matches.GetCount(), 100);
+    int nExpect = 0;
+    for (int iMatch : matches)
+    {
+        ASSERT_EQ(iMatch, nExpect);
+        nExpect += 3;
+    }
+}
+
+TEST(BStringReplace, replace_all_random_test)
+{
+    std::mt19937 rng(1818);
+
+    for (int round = 0; round < 300; round++)
+    {
+        std::vector<std::pair<std::string, std::string>> pairs;
+        AMV::CAmvReplaceSet set;
+        for (int k = 0; k < 1 + round % 6; k++)
+        {
+            std::string sOld(1 + rng() % 4, 0), sNew(rng() % 3, 0);
+            for (char &ch : sOld)
+                ch = "abc"[rng() % 3];
+            for (char &ch : sNew)
+                ch = "xy"[rng() % 2];
+            bool bNew = true;
+            for (const std::pair<std::string, std::string> &pair : pairs)
+                bNew = bNew && pair.first != sOld;
+            if (bNew)
+                pairs.push_back(std::make_pair(sOld, sNew));
+            set.Add(sOld.c_str(), sNew.c_str());
+        }
+        set.Build();
+
+        std::string sText(rng() % 100, 0);
+        for (char &ch : sText)
+            ch = "abcd"[rng() % 4];
+        BString s(sText.c_str());
+        std::string sExpect = sText;
+        int nExpect = NaiveReplaceAll(sExpect, pairs);
+        ASSERT_EQ(s.ReplaceAll(set), nExpect) << sText;
+        ASSERT_EQ(s, sExpect.c_str()) << sText;
+    }
+}
@@ -0,0 +1,278 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/amvsimd.hpp"
+#include "include/amvstr.hpp"
+
+namespace
+{
+typedef size_t (*SpanFunc)(const char *, size_t, const AMV::CAmvCharSet &, bool);
+typedef size_t (*ReplaceFunc)(char *, size_t, char, char);
+typedef size_t (*RemoveFunc)(char *, size_t, char);
+typedef const char *(*FindStringFunc)(const char *, size_t, const char *, size_t);
+
+// 이 CPU에서 돌릴 수 있는 커널들
+std::vector<SpanFunc> SpanKernels()
+{
+    std::vector<SpanFunc> v;
+#if defined(AMV_SIMD_X86)
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_SSSE3)
+        v.push_back(AMV::AmvSimd::SpanSsse3);
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back(AMV::AmvSimd::SpanAvx2);
+#elif defined(AMV_SIMD_NEON)
+    v.push_back(AMV::AmvSimd::SpanNeon);
+#endif
+    return v;
+}
+
+std::vector<ReplaceFunc> ReplaceKernels()
+{
+    std::vector<ReplaceFunc> v;
+#if defined(AMV_SIMD_X86)
+    v.push_back(AMV::AmvSimd::ReplaceCharSse2);
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back(AMV::AmvSimd::ReplaceCharAvx2);
+#elif defined(AMV_SIMD_NEON)
+    v.push_back(AMV::AmvSimd::ReplaceCharNeon);
+#endif
+    return v;
+}
+
+std::vector<RemoveFunc> RemoveKernels()
+{
+    std::vector<RemoveFunc> v;
+#if defined(AMV_SIMD_X86)
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_SSSE3)
+        v.push_back(AMV::AmvSimd::RemoveCharSsse3);
+#elif defined(AMV_SIMD_NEON)
+    v.push_back(AMV::AmvSimd::RemoveCharNeon);
+#endif
+    return v;
+}
+
+std::vector<FindStringFunc> FindStringKernels()
+{
+    std::vector<FindStringFunc> v;
+    v.push_back(AMV::AmvSimd::FindStringScalar);
+#if defined(AMV_SIMD_X86)
+    v.push_back(AMV::AmvSimd::FindStringSse2);
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back(AMV::AmvSimd::FindStringAvx2);
+#elif defined(AMV_SIMD_NEON)
+    v.push_back(AMV::AmvSimd::FindStringNeon);
+#endif
+    return v;
+}
+} // namespace
+
+TEST(BStringSimd, charset_test)
+{
+    AMV::CAmvCharSet set("\t a\x7f\x80\xff");
+
+    for (int c = 0; c < 256; c++)
+    {
+        bool bIn = (c == '\t' || c == ' ' || c == 'a' || c == 0x7f || c == 0x80 ||
+                    c == 0xff);
+        ASSERT_EQ(set.Contains(static_cast<char>(c)), bIn) << c;
+    }
+    ASSERT_FALSE(AMV::CAmvCharSet().Contains(0));
+    ASSERT_TRUE(AMV::CAmvCharSet("\0x", 2).Contains(0));
+}
+
+TEST(BStringSimd, span_kernel_test)
+{
+    std::mt19937 rng(1234);
+    const std::vector<SpanFunc> kernels = SpanKernels();
+    std::string data(300, 0);
+
+    for (int round = 0; round < 200; round++)
+    {
+        // 모든 Byte 값과 모든 길이, 시작 위치에서 스칼라 결과와 비교한다
+        AMV::CAmvCharSet set;
+        for (int k = 0; k < 1 + round % 40; k++)
+            set.Add(static_cast<char>(rng()));
+        for (char &ch : data)
+        {
+            // 집합 안의 문자가 길게 이어지도록 섞는다
+            ch = static_cast<char>(rng());
+            if (rng() % 4 != 0)
+                ch = ' ';
+        }
+        set.Add(' ');
+
+        for (size_t n = 0; n < 100; n += 1 + rng() % 3)
+        {
+            size_t off = rng() % 64;
+            for (int bIn = 0; bIn < 2; bIn++)
+            {
+                size_t nExpect = AMV::AmvSimd::SpanScalar(data.data() + off, n, set, bIn);
+                for (SpanFunc f : kernels)
+                    ASSERT_EQ(f(data.data() + off, n, set, bIn), nExpect)
+                        << "n=" << n << " off=" << off << " in=" << bIn;
+            }
+        }
+    }
+}
+
+TEST(BStringSimd, replace_kernel_test)
+{
+    std::mt19937 rng(99);
+
+    for (ReplaceFunc f : ReplaceKernels())
+    {
+        for (size_t n = 0; n < 200; n += 7)
+        {
+            std::string a(n + 8, 0), b;
+            for (char &ch : a)
+                ch = "ab\x80"[rng() % 3];
+            b = a;
+            size_t nExpect = AMV::AmvSimd::ReplaceCharScalar(&a[1], n, '\x80', 'z');
+            ASSERT_EQ(f(&b[1], n, '\x80', 'z'), nExpect);
+            ASSERT_EQ(a, b);
+        }
+    }
+}
+
+TEST(BStringSimd, remove_kernel_test)
+{
+    std::mt19937 rng(7);
+
+    for (RemoveFunc f : RemoveKernels())
+    {
+        for (size_t n = 0; n < 200; n += 3)
+        {
+            // 지울 문자가 드문 경우부터 대부분인 경우까지
+            std::string a(n, 0);
+            for (char &ch : a)
+                ch = (rng() % 8 < n % 9) ? '\x80' : static_cast<char>('a' + rng() % 26);
+            std::string b = a;
+            std::string sExpect = a;
+            sExpect.erase(std::remove(sExpect.begin(), sExpect.end(), '\x80'), sExpect.end());
+            ASSERT_EQ(AMV::AmvSimd::RemoveCharScalar(&a[0], n, '\x80'), sExpect.size());
+            ASSERT_EQ(a.substr(0, sExpect.size()), sExpect);
+            ASSERT_EQ(f(&b[0], n, '\x80'), sExpect.size()) << n;
+            ASSERT_EQ(b.substr(0, sExpect.size()), sExpect) << n;
+        }
+    }
+}
+
+TEST(BStringSimd, find_string_kernel_test)
+{
+    std::mt19937 rng(17);
+    const std::vector<FindStringFunc> kernels = FindStringKernels();
+
+    for (int round = 0; round < 2000; round++)
+    {
+        // 글자 종류가 적으면 첫 글자와 끝 글자만 맞는 후보가 많아진다
+        const char *pszChars = (round % 3 == 0) ? "a" : (round % 3 == 1) ? "ab" : "abc\0";
+        size_t nChars = strlen(pszChars) + (round % 3 == 2);
+        std::string sText(rng() % 400, 0), sSub(2 + rng() % 6, 0);
+        for (char &ch : sText)
+            ch = pszChars[rng() % nChars];
+        for (char &ch : sSub)
+            ch = pszChars[rng() % nChars];
+        if (round % 3 == 0 && !sSub.empty())
+            sSub.back() = 'b';
+
+        size_t iExpect = sText.find(sSub);
+        for (FindStringFunc f : kernels)
+        {
+            if (sSub.size() > sText.size())
+                continue;
+            const char *p = f(sText.data(), sText.size(), sSub.data(), sSub.size());
+            size_t iGot = (p == NULL) ? std::string::npos : p - sText.data();
+            ASSERT_EQ(iGot, iExpect) << round << " " << sSub.size() << " " << sText.size();
+        }
+        const char *p = AMV::AmvFindString(sText.data(), sText.size(), sSub.data(), 1);
+        ASSERT_EQ((p == NULL) ? std::string::npos : p - sText.data(), sText.find(sSub[0]));
+    }
+}
+
+TEST(BStringSimd, compare_nocase_kernel_test)
+{
+    std::mt19937 rng(5);
+    const char kChars[] = "aAzZ@[`{\x80\xc1\xe1\x00";
+
+    for (size_t n = 0; n < 100; n++)
+    {
+        std::string a(n, 0), b;
+        for (char &ch : a)
+            ch = kChars[rng() % (sizeof(kChars) - 1)];
+        b = a;
+        // 대소문자를 섞고, 가끔 한 글자를 바꾸고, 길이를 바꾼다
+        for (char &ch : b)
+            if (rng() % 2 && ch >= 'a' && ch <= 'z')
+                ch -= 'a' - 'A';
+        if (n > 0 && rng() % 2)
+            b[rng() % n] = kChars[rng() % (sizeof(kChars) - 1)];
+        size_t nb = (rng() % 4 == 0 && n > 0) ? n - 1 : n;
+
+        int nExpect = AMV::AmvSimd::CompareNoCaseScalar(a.data(), n, b.data(), nb);
+        int nGot = AMV::AmvCompareNoCase(a.data(), n, b.data(), nb);
+        ASSERT_EQ((nGot > 0) - (nGot < 0), (nExpect > 0) - (nExpect < 0)) << n;
+#if defined(AMV_SIMD_X86)
+        if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        {
+            nGot = AMV::AmvSimd::CompareNoCaseAvx2(a.data(), n, b.data(), nb);
+            ASSERT_EQ((nGot > 0) - (nGot < 0), (nExpect > 0) - (nExpect < 0)) << n;
+        }
+#endif
+        ASSERT_EQ(AMV::AmvCompareNoCase(a.data(), n, a.data(), n), 0);
+    }
+}
+
+TEST(BStringSimd, string_test)
+{
+    const std::string sText =
+        "2022-01-05 12:00:01 user=anothel password=hunter2 token=abc\t\n";
+    BString s(sText.c_str());
+
+    // Find, ReverseFind는 끝의 '\0'도 찾는다
+    ASSERT_EQ(s.Find('='), static_cast<int>(sText.find('=')));
+    ASSERT_EQ(s.Find('=', 30), static_cast<int>(sText.find('=', 30)));
+    ASSERT_EQ(s.Find('#'), -1);
+    ASSERT_EQ(s.Find('\0'), s.GetLength());
+    ASSERT_EQ(s.ReverseFind('='), static_cast<int>(sText.rfind('=')));
+    ASSERT_EQ(s.ReverseFind('#'), -1);
+    ASSERT_EQ(s.ReverseFind('\0'), s.GetLength());
+    ASSERT_EQ(s.FindOneOf("=:"), static_cast<int>(sText.find_first_of("=:")));
+    ASSERT_EQ(s.FindOneOf("#@"), -1);
+
+    // 바꿀 것이 없으면 공유를 깨지 않는다
+    BString copy(s);
+    ASSERT_EQ(copy.Replace('#', '_'), 0);
+    ASSERT_EQ(copy.Remove('#'), 0);
+    ASSERT_EQ(copy.GetString(), s.GetString());
+
+    ASSERT_EQ(copy.Replace('=', ':'), 3);
+    ASSERT_EQ(copy.Find('='), -1);
+    ASSERT_EQ(s.Find('='), static_cast<int>(sText.find('=')));
+    ASSERT_EQ(copy.Remove(':'), 5);
+    ASSERT_EQ(copy.GetLength(), s.GetLength() - 5);
+    ASSERT_EQ(copy.Find(':'), -1);
+
+    std::string sExpect = sText;
+    sExpect.erase(std::remove(sExpect.begin(), sExpect.end(), '0'), sExpect.end());
+    BString removed(s);
+    ASSERT_EQ(removed.Remove('0'), static_cast<int>(sText.size() - sExpect.size()));
+    ASSERT_EQ(removed, sExpect.c_str());
+
+    BString trimmed(" \t\txx yy\t \n");
+    trimmed.TrimRight(" \t\n");
+    ASSERT_EQ(trimmed, " \t\txx yy");
+    trimmed.TrimLeft("\t ");
+    ASSERT_EQ(trimmed, "xx yy");
+    trimmed.TrimRight('y');
+    ASSERT_EQ(trimmed, "xx ");
+    trimmed.TrimRight("");
+    ASSERT_EQ(trimmed, "xx ");
+}
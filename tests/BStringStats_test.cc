@@ -0,0 +1,144 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "include/amvstr.hpp"
+
+TEST(BStringStats, count_test)
+{
+    AMV::CAmvHeap heap;
+    AMV::CAmvStringMgr inner(&heap);
+    BStringStatsMgr mgr(&inner);
+    const char *pszLong = "this string is longer than the inline buffer";
+
+    {
+        // 짧은 문자열은 관리자까지 오지 않는다
+        BString small("small", &mgr);
+        ASSERT_EQ(mgr.GetSnapshot().nAllocs, 0u);
+
+        BString a(pszLong, &mgr);
+        AMV::CAmvStringStats stats = mgr.GetSnapshot();
+        ASSERT_EQ(stats.nAllocs, 1u);
+        ASSERT_EQ(stats.nLiveBytes, static_cast<int64_t>(stats.nAllocBytes));
+        ASSERT_EQ(stats.anSizes[AMV::CAmvStringStats::SizeClass(stats.nAllocBytes)], 1u);
+
+        // 커지면 Reallocate, 최고치는 줄어들지 않는다
+        a.Reserve(10000);
+        stats = mgr.GetSnapshot();
+        ASSERT_EQ(stats.nReallocs, 1u);
+        ASSERT_GT(stats.nLiveBytes, 10000);
+        ASSERT_EQ(stats.nPeakBytes, stats.nLiveBytes);
+
+        BString copy(a);
+        copy.SetAt(0, 'T');
+        a.FreeExtra();
+        stats = mgr.GetSnapshot();
+        ASSERT_LT(stats.nLiveBytes, stats.nPeakBytes);
+#ifdef AMV_STRING_STATS
+        ASSERT_EQ(stats.nForks, 1u);
+        ASSERT_GE(stats.nFreeExtraChars, 10000u - strlen(pszLong));
+#else
+        ASSERT_EQ(stats.nForks, 0u);
+#endif
+    }
+
+    // 모두 놓으면 살아 있는 byte가 없다
+    AMV::CAmvStringStats stats = mgr.GetSnapshot();
+    ASSERT_EQ(stats.nFrees, stats.nAllocs);
+    ASSERT_EQ(stats.nLiveBytes, 0);
+    ASSERT_GT(stats.nPeakBytes, 10000);
+
+    mgr.Reset();
+    stats = mgr.GetSnapshot();
+    ASSERT_EQ(stats.nAllocs, 0u);
+    ASSERT_EQ(stats.nPeakBytes, 0);
+
+    // 여러 thread의 수를 합친다
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&mgr, pszLong]() {
+            for (int i = 0; i < 1000; i++)
+            {
+                BString s(pszLong, &mgr);
+            }
+        });
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+    {
+        threads[t].join();
+    }
+    stats = mgr.GetSnapshot();
+    ASSERT_EQ(stats.nAllocs, 4000u);
+    ASSERT_EQ(stats.nFrees, 4000u);
+    ASSERT_EQ(stats.nLiveBytes, 0);
+}
+
+TEST(BStringStats, wide_test)
+{
+    AMV::CAmvHeap heap;
+    AMV::CAmvStringMgr inner(&heap);
+    BStringStatsMgr mgr(&inner);
+
+    {
+        // char16_t, wchar_t 문자열도 할당한 만큼 돌려받는다
+        BString16 s16(u"this string is longer than the inline buffer", &mgr);
+        BStringW w(L"this string is longer than the inline buffer", &mgr);
+        AMV::CAmvStringStats stats = mgr.GetSnapshot();
+        ASSERT_EQ(stats.nAllocs, 2u);
+        ASSERT_EQ(stats.nLiveBytes, static_cast<int64_t>(stats.nAllocBytes));
+        ASSERT_GE(stats.nLiveBytes,
+                  static_cast<int64_t>(2 * sizeof(AMV::BStringData) + 46 * (2 + sizeof(wchar_t))));
+
+        w.Reserve(1000);
+        s16.Reserve(1000);
+        ASSERT_GT(mgr.GetSnapshot().nLiveBytes, static_cast<int64_t>(1000 * (2 + sizeof(wchar_t))));
+        BString16 copy(s16);
+        copy.SetAt(0, u'T');
+        s16.FreeExtra();
+    }
+
+    AMV::CAmvStringStats stats = mgr.GetSnapshot();
+    ASSERT_EQ(stats.nFrees, stats.nAllocs);
+    ASSERT_EQ(stats.nLiveBytes, 0);
+}
+
+TEST(BStringStats, dump_test)
+{
+    AMV::CAmvHeap heap;
+    AMV::CAmvStringMgr inner(&heap);
+    BStringStatsMgr mgr(&inner);
+    BString s("this string is longer than the inline buffer", &mgr);
+
+    char ach[512];
+    FILE *pFile = tmpfile();
+    ASSERT_TRUE(pFile != NULL);
+    mgr.GetSnapshot().Dump(pFile);
+    rewind(pFile);
+    ASSERT_TRUE(fgets(ach, sizeof(ach), pFile) != NULL);
+    ASSERT_TRUE(strstr(ach, "allocs=1 reallocs=0 frees=0") != NULL) << ach;
+    ASSERT_TRUE(strstr(ach, "sizes=<=128:1") != NULL) << ach;
+    fclose(pFile);
+
+    // 주기적으로 한 줄씩 쓴다
+    pFile = tmpfile();
+    ASSERT_TRUE(pFile != NULL);
+    mgr.StartDump(1, pFile);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    mgr.StopDump();
+    rewind(pFile);
+    int nLines = 0;
+    while (fgets(ach, sizeof(ach), pFile) != NULL)
+    {
+        nLines++;
+    }
+    ASSERT_GT(nLines, 1);
+    fclose(pFile);
+}
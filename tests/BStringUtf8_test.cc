@@ -0,0 +1,309 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/amvstr.hpp"
+#include "include/amvutf8.hpp"
+
+namespace
+{
+typedef bool (*ValidateFunc)(const char *, size_t);
+
+// 이 CPU에서 돌릴 수 있는 커널들
+std::vector<ValidateFunc> ValidateKernels()
+{
+    std::vector<ValidateFunc> v;
+    v.push_back(AMV::AmvSimd::Utf8ValidateScalar);
+#if defined(AMV_SIMD_X86)
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_SSSE3)
+        v.push_back(AMV::AmvSimd::Utf8ValidateSsse3);
+    if (AMV::AmvSimd::GetLevel() >= AMV::AmvSimd::LEVEL_AVX2)
+        v.push_back(AMV::AmvSimd::Utf8ValidateAvx2);
+#elif defined(AMV_SIMD_NEON)
+    v.push_back(AMV::AmvSimd::Utf8ValidateNeon);
+#endif
+    return v;
+}
+
+// 하나씩 디코딩하는 느리지만 확실한 검사
+bool ValidateReference(const std::string &s)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(s.data());
+    size_t n = s.size();
+    size_t i = 0;
+    while (i < n)
+    {
+        uint32_t cp = p[i];
+        size_t nLength = (cp < 0x80) ? 1 : ((cp >> 5) == 6) ? 2 : ((cp >> 4) == 14) ? 3 : ((cp >> 3) == 30) ? 4 : 0;
+        if (nLength == 0 || n - i < nLength)
+            return false;
+        if (nLength > 1)
+            cp &= (0x7f >> nLength);
+        for (size_t j = 1; j < nLength; j++)
+        {
+            if ((p[i + j] & 0xc0) != 0x80)
+                return false;
+            cp = (cp << 6) | (p[i + j] & 0x3f);
+        }
+        static const uint32_t anMin[5] = {0, 0, 0x80, 0x800, 0x10000};
+        if (cp < anMin[nLength] || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+            return false;
+        i += nLength;
+    }
+    return true;
+}
+} // namespace
+
+TEST(BStringUtf8, validate_test)
+{
+    const char *apszValid[] = {
+        "",
+        "hello",
+        "안녕하세요",
+        "\xc2\x80",          // U+0080
+        "\xdf\xbf",          // U+07FF
+        "\xe0\xa0\x80",      // U+0800
+        "\xed\x9f\xbf",      // U+D7FF
+        "\xee\x80\x80",      // U+E000
+        "\xef\xbf\xbf",      // U+FFFF
+        "\xf0\x90\x80\x80",  // U+10000
+        "\xf0\x9f\x98\x80",  // 😀
+        "\xf4\x8f\xbf\xbf",  // U+10FFFF
+    };
+    const char *apszInvalid[] = {
+        "\x80",              // 이어지는 byte만
+        "a\xbf",
+        "\xc0\xaf",          // overlong '/'
+        "\xc1\xbf",
+        "\xe0\x9f\xbf",      // overlong 3 byte
+        "\xf0\x8f\xbf\xbf",  // overlong 4 byte
+        "\xed\xa0\x80",      // surrogate
+        "\xed\xbf\xbf",
+        "\xf4\x90\x80\x80",  // U+10FFFF 초과
+        "\xf5\x80\x80\x80",
+        "\xff",
+        "\xc3",              // 잘린 sequence
+        "\xe4\xb8",
+        "\xf0\x9f\x98",
+        "\xe4\x41\x80",      // 중간에 ASCII
+        "\xc3\xa9\xa9",      // 남는 continuation
+    };
+
+    std::vector<ValidateFunc> kernels = ValidateKernels();
+    for (size_t k = 0; k < kernels.size(); k++)
+    {
+        // 블록 경계 앞뒤 어디에 있어도 같은 답이어야 한다
+        for (size_t nPad = 0; nPad < 40; nPad++)
+        {
+            std::string pad(nPad, 'x');
+            for (size_t i = 0; i < sizeof(apszValid) / sizeof(apszValid[0]); i++)
+            {
+                std::string s = pad + apszValid[i];
+                ASSERT_TRUE(kernels[k](s.data(), s.size())) << k << " " << nPad << " " << i;
+                s += pad;
+                ASSERT_TRUE(kernels[k](s.data(), s.size())) << k << " " << nPad << " " << i;
+            }
+            for (size_t i = 0; i < sizeof(apszInvalid) / sizeof(apszInvalid[0]); i++)
+            {
+                std::string s = pad + apszInvalid[i];
+                ASSERT_FALSE(kernels[k](s.data(), s.size())) << k << " " << nPad << " " << i;
+                s += pad;
+                ASSERT_FALSE(kernels[k](s.data(), s.size())) << k << " " << nPad << " " << i;
+            }
+        }
+    }
+}
+
+TEST(BStringUtf8, validate_kernel_test)
+{
+    std::vector<ValidateFunc> kernels = ValidateKernels();
+    std::mt19937 rng(25);
+    const std::string valid = "a\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80 한글";
+
+    for (int iter = 0; iter < 20000; iter++)
+    {
+        // 올바른 조각을 이어 붙이고 가끔 byte 하나를 망가뜨린다
+        std::string s;
+        size_t nLength = rng() % 100;
+        while (s.size() < nLength)
+        {
+            s += valid.substr(rng() % valid.size(), rng() % 8);
+        }
+        if (rng() % 2 && !s.empty())
+        {
+            s[rng() % s.size()] = static_cast<char>(rng());
+        }
+
+        bool bExpected = ValidateReference(s);
+        for (size_t k = 0; k < kernels.size(); k++)
+        {
+            ASSERT_EQ(kernels[k](s.data(), s.size()), bExpected) << k << " " << iter;
+        }
+        ASSERT_EQ(AMV::AmvUtf8Validate(s.data(), s.size()), bExpected);
+    }
+}
+
+TEST(BStringUtf8, count_test)
+{
+    std::string s;
+    size_t nExpected = 0;
+    for (int i = 0; i < 50; i++)
+    {
+        ASSERT_EQ(AMV::AmvUtf8Count(s.data(), s.size()), nExpected);
+        ASSERT_EQ(AMV::AmvSimd::Utf8CountScalar(s.data(), s.size()), nExpected);
+        s += (i % 3 == 0) ? "가" : (i % 3 == 1) ? "a" : "\xf0\x9f\x98\x80";
+        nExpected++;
+    }
+}
+
+TEST(BStringUtf8, advance_test)
+{
+    // CharNext()를 nChars번 부른 것과 같아야 한다. 떨어진 continuation byte도 섞는다
+    std::mt19937 rng(25);
+    const std::string pieces[] = {"a", "가", "\xf0\x9f\x98\x80", "\xc3\xa9", "\x80", "\xbf\xbf"};
+    for (int iter = 0; iter < 2000; iter++)
+    {
+        std::string s;
+        size_t nLength = rng() % 120;
+        while (s.size() < nLength)
+        {
+            s += pieces[rng() % 6];
+        }
+        size_t nChars = rng() % 80;
+        const char *p = s.c_str();
+        for (size_t k = 0; k < nChars; k++)
+        {
+            p = AMV::ChTraitsUtf8::CharNext(p);
+        }
+        size_t nExpected = p - s.c_str();
+        ASSERT_EQ(AMV::AmvUtf8Advance(s.data(), s.size(), nChars), nExpected) << iter;
+        ASSERT_EQ(AMV::AmvSimd::Utf8AdvanceScalar(s.data(), s.size(), nChars), nExpected)
+            << iter;
+    }
+    ASSERT_EQ(AMV::AmvUtf8Advance("", 0, 3), 0u);
+    ASSERT_EQ(AMV::AmvUtf8Advance("가", 3, 0), 0u);
+}
+
+TEST(BStringUtf8, convert_test)
+{
+    const char *psz = "a\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80";
+    int n = static_cast<int>(strlen(psz));
+    char16_t ach16[8];
+
+    ASSERT_EQ(AMV::AmvUtf8ToUtf16(psz, n, NULL, 0), 5);
+    ASSERT_EQ(AMV::AmvUtf8ToUtf16(psz, n, ach16, 8), 5);
+    ASSERT_EQ(ach16[0], u'a');
+    ASSERT_EQ(ach16[1], u'é');
+    ASSERT_EQ(ach16[2], u'中');
+    ASSERT_EQ(ach16[3], 0xd83d);
+    ASSERT_EQ(ach16[4], 0xde00);
+    // 자리가 모자라거나 올바르지 않으면 -1
+    ASSERT_EQ(AMV::AmvUtf8ToUtf16(psz, n, ach16, 4), -1);
+    ASSERT_EQ(AMV::AmvUtf8ToUtf16("\xed\xa0\x80", 3, NULL, 0), -1);
+
+    char ach[16];
+    ASSERT_EQ(AMV::AmvUtf16ToUtf8(ach16, 5, NULL, 0), n);
+    ASSERT_EQ(AMV::AmvUtf16ToUtf8(ach16, 5, ach, sizeof(ach)), n);
+    ASSERT_EQ(memcmp(ach, psz, n), 0);
+    ASSERT_EQ(AMV::AmvUtf16ToUtf8(ach16, 4, NULL, 0), -1);
+    ASSERT_EQ(AMV::AmvUtf16ToUtf8(ach16 + 4, 1, NULL, 0), -1);
+}
+
+TEST(BStringUtf8, string_test)
+{
+    BString s("한글 text 😀");
+    ASSERT_TRUE(s.IsValidUtf8());
+    ASSERT_EQ(s.GetUtf8Length(), 9);
+    ASSERT_TRUE(BStringView(s).IsValidUtf8());
+    ASSERT_EQ(BStringView(s).GetUtf8Length(), 9);
+    ASSERT_FALSE(BStringView(s).Left(2).IsValidUtf8());
+
+    std::u16string s16 = s.GetUtf16();
+    ASSERT_EQ(s16, u"한글 text 😀");
+    BString copy;
+    copy.SetUtf16(s16.data(), static_cast<int>(s16.size()));
+    ASSERT_EQ(copy, s);
+
+    BString bad("\xff");
+    ASSERT_FALSE(bad.IsValidUtf8());
+    ASSERT_ANY_THROW(bad.GetUtf16());
+    char16_t chLone = 0xd800;
+    ASSERT_ANY_THROW(copy.SetUtf16(&chLone, 1));
+}
+
+TEST(BStringUtf8, traits_test)
+{
+    // code point 단위로 넘어간다
+    ASSERT_EQ(AMV::ChTraitsUtf8::tclen("a"), 1);
+    ASSERT_EQ(AMV::ChTraitsUtf8::tclen("한"), 3);
+    ASSERT_EQ(AMV::ChTraitsUtf8::tclen("😀"), 4);
+    ASSERT_EQ(AMV::ChTraitsUtf8::tclen("\xe4"), 1);
+    ASSERT_EQ(AMV::ChTraitsUtf8::tclen("a\x80" "b"), 2);
+
+    // 끝의 '\0'에서는 더 나아가지 않는다
+    const char *psz = "a한";
+    ASSERT_EQ(AMV::ChTraitsUtf8::CharNext(psz), psz + 1);
+    ASSERT_EQ(AMV::ChTraitsUtf8::CharNext(psz + 1), psz + 4);
+    ASSERT_EQ(AMV::ChTraitsUtf8::CharNext(psz + 4), psz + 4);
+    const char *pszEmpty = "";
+    ASSERT_EQ(AMV::ChTraitsUtf8::CharNext(pszEmpty), pszEmpty);
+    ASSERT_EQ(*AMV::ChTraitsUtf8::CharNext("\xe4"), '\0');
+    ASSERT_EQ(AMV::ChTraitsUtf8::tclen(""), 1);
+
+    // 여러 code point를 한 번에 넘고, 길이를 넘지 않는다
+    BStringUtf8 text("한글 text 😀 끝");
+    const char *pch = text.GetString();
+    ASSERT_STREQ(AMV::ChTraitsUtf8::CharAdvance(pch, text.GetLength(), 3), "text 😀 끝");
+    ASSERT_STREQ(AMV::ChTraitsUtf8::CharAdvance(pch, text.GetLength(), 9), " 끝");
+    ASSERT_EQ(AMV::ChTraitsUtf8::CharAdvance(pch, text.GetLength(), 100), pch + text.GetLength());
+    ASSERT_EQ(AMV::ChTraitsUtf8::CharAdvance(pch, 4, 2), pch + 4);
+
+    // 잘라도 code point가 쪼개지지 않는다
+    BStringUtf8 s("한한abc");
+    s.TrimLeft('\xed');
+    ASSERT_EQ(s, "abc");
+    ASSERT_TRUE(s.IsValidUtf8());
+    BString plain("한한abc");
+    plain.TrimLeft('\xed');
+    ASSERT_FALSE(plain.IsValidUtf8());
+
+    BStringUtf8 t("xx한");
+    ASSERT_STREQ(AMV::ChTraitsUtf8::strchr_db(t.GetString(), '\xed', '\x95'), "한");
+}
+
+TEST(BStringUtf8, trim_set_test)
+{
+    // "谀"(e8 b0 80)와 "가"(ea b0 80)는 뒤의 두 byte가 같다
+    BStringUtf8 s("a谀");
+    s.TrimRight("가");
+    ASSERT_EQ(s, "a谀");
+    s.TrimLeft("가");
+    ASSERT_EQ(s, "a谀");
+    s.TrimRight("가谀");
+    ASSERT_EQ(s, "a");
+
+    // code point 단위로 앞뒤를 자른다
+    BStringUtf8 t("가나a가나b나가");
+    t.Trim("나가");
+    ASSERT_EQ(t, "a가나b");
+    ASSERT_TRUE(t.IsValidUtf8());
+    t = "\xb0\x80 가x";
+    t.TrimLeft("가 ");
+    ASSERT_EQ(t, "\xb0\x80 가x");
+
+    // ASCII만 자를 때는 byte 단위와 같다
+    BStringUtf8 u("  한글 \t");
+    u.Trim(" \t");
+    ASSERT_EQ(u, "한글");
+
+    // BString은 여전히 byte 단위로 자른다
+    BString plain("a谀");
+    plain.TrimRight("가");
+    ASSERT_EQ(plain, "a\xe8");
+}
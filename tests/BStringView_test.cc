@@ -0,0 +1,159 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "include/amvstr.hpp"
+
+namespace
+{
+std::vector<std::string> Split(const BStringView &view, const char *pszDelimiters,
+                               bool bKeepEmpty)
+{
+    std::vector<std::string> tokens;
+    BStringTokenizer tokenizer(view, pszDelimiters, bKeepEmpty);
+    BStringView token;
+    while (tokenizer.Next(token))
+        tokens.push_back(std::string(token.GetString(), token.GetLength()));
+    return tokens;
+}
+} // namespace
+
+TEST(BStringView, view_test)
+{
+    BString s("  key = value\t");
+    BStringView v(s);
+
+    // 복사하지 않고 원래 문자열을 가리킨다
+    ASSERT_EQ(v.GetString(), s.GetString());
+    ASSERT_EQ(v.GetLength(), s.GetLength());
+
+    ASSERT_EQ(v.Mid(2, 3), "key");
+    ASSERT_EQ(v.Mid(8), "value\t");
+    ASSERT_EQ(v.Mid(100), "");
+    ASSERT_EQ(v.Mid(-1, 4), "  ke");
+    ASSERT_EQ(v.Left(5), "  key");
+    ASSERT_EQ(v.Left(100), v);
+    ASSERT_EQ(v.Right(6), "value\t");
+    ASSERT_EQ(v.Right(-1), "");
+    ASSERT_EQ(v.Trim(), "key = value");
+    ASSERT_EQ(v.TrimLeft(), "key = value\t");
+    ASSERT_EQ(v.Trim(AMV::CAmvCharSet(" \tkue")), "y = val");
+
+    ASSERT_EQ(v.Find('='), 6);
+    ASSERT_EQ(v.Find('=', 7), -1);
+    ASSERT_EQ(v.Find("value"), 8);
+    ASSERT_EQ(v.Find("value", 9), -1);
+    ASSERT_EQ(v.Find(""), 0);
+    ASSERT_EQ(v.ReverseFind(' '), 7);
+    ASSERT_EQ(v.FindOneOf(AMV::CAmvCharSet("=\t")), 6);
+    ASSERT_TRUE(v.Trim().StartsWith("key"));
+    ASSERT_TRUE(v.Trim().EndsWith("value"));
+    ASSERT_FALSE(v.EndsWith("value"));
+
+    ASSERT_LT(BStringView("abc").Compare("abd"), 0);
+    ASSERT_GT(BStringView("abc").Compare("ab"), 0);
+    ASSERT_EQ(BStringView("ABC").CompareNoCase("abc"), 0);
+    ASSERT_TRUE(BStringView("ab") < BStringView("abc"));
+    ASSERT_TRUE(BStringView("ab") != "abc");
+
+    // '\0'으로 끝나지 않아도, 중간에 '\0'이 있어도 된다
+    const char ach[] = {'a', '\0', 'b', 'c'};
+    BStringView bin(ach, 4);
+    ASSERT_EQ(bin.Find("bc"), 2);
+    ASSERT_EQ(bin.Find('\0'), 1);
+    ASSERT_NE(bin, "a");
+    ASSERT_EQ(bin.Left(1), "a");
+}
+
+TEST(BStringView, bstring_test)
+{
+    BString s("name,age,city");
+    BStringView v(s);
+
+    // BString의 검색, 비교 API는 view도 받는다
+    ASSERT_EQ(s.Find(v.Mid(5, 3)), 5);
+    ASSERT_EQ(s.Compare(v), 0);
+    ASSERT_EQ(s.CompareNoCase(BStringView("NAME,AGE,CITY")), 0);
+    ASSERT_TRUE(s.IsEqual(v));
+    ASSERT_FALSE(s.IsEqual(v.Left(4)));
+    ASSERT_TRUE(s == v);
+    ASSERT_TRUE(v.Left(4) != s);
+    ASSERT_EQ(s.FindOneOf(AMV::CAmvCharSet(",")), 4);
+
+    // 필요할 때만 BString으로 만든다
+    BString field(v.Mid(9));
+    ASSERT_EQ(field, "city");
+    field = v.Left(4);
+    ASSERT_EQ(field, "name");
+    field += v.Mid(4, 4);
+    ASSERT_EQ(field, "name,age");
+
+    AMV::CStaticString<char, sizeof("static")> str("static");
+    ASSERT_EQ(BStringView(str), "static");
+}
+
+TEST(BStringView, tokenizer_test)
+{
+    // 기본은 구분자가 이어져도 빈 token을 만들지 않는다
+    ASSERT_EQ(Split("  a b\t\tc  ", " \t", false), std::vector<std::string>({"a", "b", "c"}));
+    ASSERT_EQ(Split("", " ", false), std::vector<std::string>());
+    ASSERT_EQ(Split("   ", " ", false), std::vector<std::string>());
+
+    // bKeepEmpty면 구분자마다 field가 끝난다
+    ASSERT_EQ(Split("a,,b,", ",", true), std::vector<std::string>({"a", "", "b", ""}));
+    ASSERT_EQ(Split("a;b|c", ";|", true), std::vector<std::string>({"a", "b", "c"}));
+    ASSERT_EQ(Split("", ",", true), std::vector<std::string>({""}));
+
+    // 한 글자 구분자, 남은 부분
+    BStringTokenizer tokenizer("k1=v1&k2=v2&rest", '&');
+    BStringView token;
+    ASSERT_TRUE(tokenizer.Next(token));
+    ASSERT_EQ(token, "k1=v1");
+    ASSERT_EQ(tokenizer.GetRemainder(), "k2=v2&rest");
+    ASSERT_TRUE(tokenizer.Next(token));
+    ASSERT_TRUE(tokenizer.Next(token));
+    ASSERT_EQ(token, "rest");
+    ASSERT_FALSE(tokenizer.Next(token));
+    ASSERT_EQ(token, "rest");
+    ASSERT_EQ(tokenizer.GetRemainder(), "");
+}
+
+TEST(BStringView, csv_test)
+{
+    BString csv("id,name,score\n1,kim,90\n2,,75\n3,lee,\n");
+    int nRows = 0;
+    int nScore = 0;
+
+    // 줄과 field 모두 원래 문자열을 가리키는 view다
+    BStringTokenizer lines(csv, '\n');
+    BStringView line;
+    while (lines.Next(line))
+    {
+        std::vector<BStringView> fields;
+        BStringTokenizer tokenizer(line, ',', true);
+        BStringView field;
+        while (tokenizer.Next(field))
+        {
+            ASSERT_GE(field.GetString(), csv.GetString());
+            ASSERT_LE(field.end(), csv.GetString() + csv.GetLength());
+            fields.push_back(field);
+        }
+        ASSERT_EQ(fields.size(), 3u);
+        if (nRows++ == 0)
+        {
+            ASSERT_EQ(fields[2], "score");
+            continue;
+        }
+        int n = 0;
+        for (char ch : fields[2])
+            n = n * 10 + (ch - '0');
+        nScore += n;
+        ASSERT_EQ(fields[1].IsEmpty(), fields[0] == "2");
+    }
+    ASSERT_EQ(nRows, 4);
+    ASSERT_EQ(nScore, 165);
+}
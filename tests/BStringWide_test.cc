@@ -0,0 +1,131 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include "include/amvstr.hpp"
+
+TEST(BStringWide, basic_test)
+{
+    // 객체 크기는 char 문자열과 같고, 그만큼의 byte에 들어가는 만큼만 inline
+    ASSERT_EQ(sizeof(BString16), sizeof(BString));
+    ASSERT_EQ(sizeof(BStringW), sizeof(BString));
+    ASSERT_EQ(BString16::SSO_CAPACITY, (AMV_SSO_CAPACITY + 1) / 2 - 1);
+    ASSERT_EQ(BStringW::SSO_CAPACITY, (AMV_SSO_CAPACITY + 1) / 4 - 1);
+
+    BString16 s(u"한글");
+    ASSERT_EQ(s.GetLength(), 2);
+    ASSERT_TRUE(s.IsInline());
+    ASSERT_EQ(s, u"한글");
+    ASSERT_EQ(s[2], u'\0');
+
+    // inline 용량을 넘으면 manager가 char16_t 크기로 할당한다
+    s += u" text that no longer fits";
+    ASSERT_FALSE(s.IsInline());
+    ASSERT_EQ(s.GetLength(), 27);
+    ASSERT_EQ(std::u16string(s.GetString()), u"한글 text that no longer fits");
+
+    // 복사는 버퍼를 공유하고, 쓰면 갈라진다
+    BString16 copy(s);
+    ASSERT_EQ(copy.GetString(), s.GetString());
+    copy.SetAt(0, u'韓');
+    ASSERT_EQ(s[0], u'한');
+    ASSERT_EQ(copy[0], u'韓');
+
+    BString16 moved(std::move(copy));
+    ASSERT_TRUE(copy.IsEmpty());
+    ASSERT_EQ(moved.GetLength(), 27);
+
+    const unsigned char auch[] = {'a', 0xe9, 'b'};
+    BStringW bytes(auch, 3);
+    ASSERT_EQ(bytes, L"aéb");
+
+    BStringW w(L"wide");
+    w.AppendChar(L'!');
+    ASSERT_EQ(w, L"wide!");
+    ASSERT_EQ(w.GetHash(), BStringViewW(L"wide!").GetHash());
+    w.Empty();
+    ASSERT_TRUE(w.IsEmpty());
+    ASSERT_EQ(w.GetString()[0], L'\0');
+}
+
+TEST(BStringWide, manipulate_test)
+{
+    BString16 s(u"a,b,,c,한,d");
+    ASSERT_EQ(s.Find(u','), 1);
+    ASSERT_EQ(s.Find(u",,"), 3);
+    ASSERT_EQ(s.Find(u"한"), 7);
+    ASSERT_EQ(s.ReverseFind(u','), 8);
+    ASSERT_EQ(s.FindOneOf(u"한d"), 7);
+    ASSERT_EQ(s.Find(u"없음"), -1);
+
+    ASSERT_EQ(s.Replace(u',', u';'), 5);
+    ASSERT_EQ(s, u"a;b;;c;한;d");
+    ASSERT_EQ(s.Replace(u";;", u";"), 1);
+    ASSERT_EQ(s.Replace(u";", u" - "), 4);
+    ASSERT_EQ(s, u"a - b - c - 한 - d");
+    ASSERT_EQ(s.Remove(u' '), 8);
+    ASSERT_EQ(s, u"a-b-c-한-d");
+
+    s.Insert(0, u"[");
+    s.Insert(s.GetLength(), u']');
+    ASSERT_EQ(s, u"[a-b-c-한-d]");
+    s.Delete(1, 6);
+    ASSERT_EQ(s, u"[한-d]");
+
+    BStringW w(L" \t가 나\r\n");
+    w.Trim();
+    ASSERT_EQ(w, L"가 나");
+    w.TrimLeft(L"가");
+    w.TrimRight(L'나');
+    ASSERT_EQ(w, L" ");
+
+    // 비교는 char 단위, 대소문자 무시는 ASCII만
+    BStringW a(L"Apple"), b(L"apple");
+    ASSERT_LT(a, b);
+    ASSERT_EQ(a.CompareNoCase(b), 0);
+    ASSERT_EQ(a.CompareNoCase(L"APPLE"), 0);
+    ASSERT_NE(BStringW(L"Ä").CompareNoCase(L"ä"), 0);
+    ASSERT_FALSE(BStringW(L"ab") == BStringW(L"ac"));
+    ASSERT_FALSE(BString16(u"ab") == BStringView16(u"ac"));
+    ASSERT_TRUE(a == L"Apple");
+    ASSERT_TRUE(L"Apple" != b);
+}
+
+TEST(BStringWide, concat_test)
+{
+    // operator+와 builder도 char16_t 단위로 이어 붙인다
+    BString16 s(u"가나");
+    BString16 joined = s + u", " + BStringView16(u"다라마바사아자차카타파하") + u'!';
+    ASSERT_EQ(joined, u"가나, 다라마바사아자차카타파하!");
+    s += s + u"다";
+    ASSERT_EQ(s, u"가나가나다");
+
+    AMV::CAmvStringBuilderT<BString16> builder;
+    for (int i = 0; i < 300; i++)
+    {
+        builder += u"가";
+        builder += u'나';
+    }
+    BString16 built = builder.ToString();
+    ASSERT_EQ(built.GetLength(), 600);
+    ASSERT_EQ(built.Find(u"나가"), 1);
+
+    // view
+    BStringView16 view(built);
+    ASSERT_TRUE(view.StartsWith(u"가나가"));
+    ASSERT_TRUE(view.EndsWith(u"나가나"));
+    ASSERT_EQ(view.Mid(1, 2), BStringView16(u"나가"));
+    ASSERT_EQ(view.Find(u'나', 2), 3);
+    ASSERT_EQ(view.Right(2), BStringView16(u"가나"));
+
+    std::unordered_set<BStringW> set;
+    set.insert(BStringW(L"one"));
+    set.insert(BStringW(L"two"));
+    ASSERT_EQ(set.count(BStringW(L"one")), 1u);
+    ASSERT_EQ(set.count(BStringW(L"three")), 0u);
+}
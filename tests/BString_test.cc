@@ -5,8 +5,13 @@
 
 #include <iostream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "include/amvstr.hpp"
+#include "tests/counting_heap.hpp"
 
 char szDest[100];
 const char *szSrc = "This is source";
@@ -15,26 +20,11 @@ char szTestStr[] = "This is test | This is test | ";
 char szTestStrDel[] = "Thistest | This is test | ";
 const char *szTestStrAA = "This is test | This is test | AA";
 char sztestStringAA[] = "this is test | This is test | AA";
-<<<<<<< HEAD:tests/BString_test.cc
 
-TEST(BString, construct_test) {
-  BString bstring1;
-=======
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:tests/Awesome_mix_vol_1_test.cc
-
-TEST(BStringT, construct)
+TEST(BString, construct_test)
 {
     BString bstring1;
 
-<<<<<<< HEAD:tests/BString_test.cc
-  unsigned char uszTest[] = {0x00, 0x01, 0x02, 0x02};
-  BString bstring3(uszTest, sizeof(uszTest));
-}
-
-TEST(BString, func_test) {
-  try {
-=======
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:tests/Awesome_mix_vol_1_test.cc
     std::string sTest("This is test | This is test | AA");
     BString bstring2(sTest.c_str());
     bstring1 = bstring2;
@@ -43,7 +33,7 @@ TEST(BString, func_test) {
     BString bstring3(uszTest, sizeof(uszTest));
 }
 
-TEST(BStringT, func)
+TEST(BString, func_test)
 {
     try
     {
@@ -107,16 +97,6 @@ TEST(BStringT, func)
         ASSERT_EQ(bstring_1.GetAt(0), 'a');
         ASSERT_EQ(bstring_1.GetAt(bstring_1.GetLength() - 1), 'd');
 
-<<<<<<< HEAD:tests/BString_test.cc
-    bstring_1.Print();
-  } catch (...) {
-  }
-}
-
-TEST(BString, CSimpleStringT_test) {
-  try {
-    BString bstring;
-=======
         bstring_1.Trim('a');
         ASSERT_EQ(bstring_1, " b c e d");
         bstring_1.Trim(" bd");
@@ -129,12 +109,11 @@ TEST(BString, CSimpleStringT_test) {
     }
 }
 
-TEST(_Func_UnitTest, CSimpleStringT)
+TEST(BString, CSimpleStringT_test)
 {
     try
     {
         BString bstring;
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:tests/Awesome_mix_vol_1_test.cc
 
         bstring.Append(pszTestStr);
         bstring.Append(pszTestStr, strlen(pszTestStr));
@@ -156,13 +135,15 @@ TEST(_Func_UnitTest, CSimpleStringT)
         bstring.Empty();
         ASSERT_EQ(bstring.GetLength(), 0);
 
-        bstring = "01234567";
+        // 짧은 문자열은 heap 버퍼를 반납하고 객체 안으로 들어간다
+        bstring = "0123456789012345678901234567890123456789";
         int before = bstring.GetAllocLength();
         bstring = "A";
         bstring.FreeExtra();
         ASSERT_TRUE(bstring.GetAllocLength() < before);
 
-        ASSERT_EQ(bstring.GetAllocLength(), 7);
+        ASSERT_EQ(bstring.GetAllocLength(), AMV_SSO_CAPACITY);
+        ASSERT_TRUE(bstring.IsInline());
 
         ASSERT_EQ(bstring.GetAt(0), 'A');
 
@@ -193,19 +174,12 @@ TEST(_Func_UnitTest, CSimpleStringT)
         // static AMV::CAmvHeap strHeap;
         // bstring.SetManager(bstring.GetManager());
 
-<<<<<<< HEAD:tests/BString_test.cc
-    bstring.SetString("CAAA");
-    ASSERT_EQ(memcmp(bstring.GetBuffer(), "CAAA", strlen("CAAA")), S_OK);
-  } catch (...) {
-  }
-=======
         bstring.SetString("AAA");
         ASSERT_EQ(memcmp(bstring.GetBuffer(), "AAA", strlen("AAA")), S_OK);
     }
     catch (...)
     {
     }
->>>>>>> ade53ee0c3a75665892909aca4de84a626eb6dd1:tests/Awesome_mix_vol_1_test.cc
 }
 
 TEST(BString, operator_plus_test) {
@@ -214,3 +188,377 @@ TEST(BString, operator_plus_test) {
   std::cout << bstring2 + 'A' << " \n";
   std::cout << 'A' + bstring1 << " \n";
 }
+
+TEST(BString, sso_test)
+{
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+    const char *pszLong = "this string is longer than the inline buffer";
+
+    {
+        // 짧은 문자열은 할당하지 않는다
+        BString key("key", &mgr);
+        BString copy(key);
+        copy += "=value";
+        ASSERT_TRUE(key.IsInline());
+        ASSERT_TRUE(copy.IsInline());
+        ASSERT_EQ(key, "key");
+        ASSERT_EQ(copy, "key=value");
+        ASSERT_EQ(heap.nAllocs, 0);
+
+        // 한계를 넘으면 heap으로 옮겨 가고, 긴 문자열의 복사는 버퍼를 공유한다
+        copy += pszLong;
+        ASSERT_FALSE(copy.IsInline());
+        ASSERT_EQ(heap.nAllocs, 1);
+        BString shared(copy);
+        ASSERT_EQ(heap.nAllocs, 1);
+        ASSERT_EQ(shared.GetString(), copy.GetString());
+
+        // 짧게 줄여서 복사하면 다시 객체 안에 들어간다
+        shared.Truncate(3);
+        ASSERT_EQ(heap.nAllocs, 2);
+        BString small(shared);
+        ASSERT_TRUE(small.IsInline());
+        ASSERT_EQ(small, "key");
+
+        shared = key;
+        ASSERT_EQ(shared, "key");
+        key.Empty();
+        ASSERT_TRUE(key.IsInline());
+        ASSERT_TRUE(key.IsEmpty());
+    }
+
+    {
+        // GetBuffer / ReleaseBuffer
+        BString s(&mgr);
+        char *p = s.GetBuffer(10);
+        ASSERT_TRUE(s.IsInline());
+        strcpy(p, "abc");
+        s.ReleaseBuffer();
+        ASSERT_EQ(s.GetLength(), 3);
+        ASSERT_EQ(s, "abc");
+
+        p = s.GetBufferSetLength(AMV_SSO_CAPACITY + 1);
+        ASSERT_FALSE(s.IsInline());
+        ASSERT_EQ(memcmp(p, "abc", 3), 0);
+        s.ReleaseBufferSetLength(3);
+        s.FreeExtra();
+        ASSERT_TRUE(s.IsInline());
+        ASSERT_EQ(s, "abc");
+
+        // 잠근 버퍼는 복사할 때 공유하지 않고, 커져도 잠긴 상태를 유지한다
+        p = s.LockBuffer();
+        BString t(s);
+        ASSERT_NE(t.GetString(), s.GetString());
+        s += pszLong;
+        ASSERT_FALSE(s.IsInline());
+        BString u(s);
+        ASSERT_NE(u.GetString(), s.GetString());
+        s.UnlockBuffer();
+        BString v(s);
+        ASSERT_EQ(v.GetString(), s.GetString());
+        ASSERT_EQ(v, u);
+    }
+}
+
+TEST(BString, move_test)
+{
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+    const char *pszLong = "this string is longer than the inline buffer";
+
+    // 긴 문자열은 버퍼를 그대로 넘겨받고 원본은 비워진다
+    BString a(pszLong, &mgr);
+    const char *p = a.GetString();
+    BString b(std::move(a));
+    ASSERT_EQ(b.GetString(), p);
+    ASSERT_TRUE(a.IsEmpty());
+    ASSERT_EQ(a.GetManager(), &mgr);
+
+    BString c("short", &mgr);
+    c = std::move(b);
+    ASSERT_EQ(c.GetString(), p);
+    ASSERT_TRUE(b.IsEmpty());
+
+    // 짧은 문자열은 객체 안에서 복사된다
+    BString d("short", &mgr);
+    BString e(std::move(d));
+    ASSERT_EQ(e, "short");
+    ASSERT_TRUE(d.IsEmpty());
+    e = std::move(e);
+    ASSERT_EQ(e, "short");
+    ASSERT_EQ(heap.nAllocs, 1);
+
+    // move가 noexcept라서 vector가 커질 때 복사 대신 옮기고, 버퍼도 그대로다
+    std::vector<BString> v;
+    for (int i = 0; i < 100; i++)
+        v.push_back(BString(pszLong, &mgr));
+    int nAllocs = heap.nAllocs;
+    std::vector<BString> w(std::move(v));
+    const char *p99 = w[99].GetString();
+    w.reserve(w.capacity() * 2);
+    ASSERT_EQ(heap.nAllocs, nAllocs);
+    ASSERT_EQ(w[99], pszLong);
+    ASSERT_EQ(w[99].GetString(), p99);
+}
+
+TEST(BString, move_copy_test)
+{
+    CCountingHeap heap, otherHeap;
+    AMV::CAmvStringMgr mgr(&heap), otherMgr(&otherHeap);
+    const char *pszLong = "this string is longer than the inline buffer";
+
+    // move는 할당하지 않으므로 던지지 않는다
+    ASSERT_TRUE(std::is_nothrow_move_constructible<BString>::value);
+    ASSERT_TRUE(std::is_nothrow_move_assignable<BString>::value);
+
+    // 잠긴 버퍼에 들어가면 그 자리에 내용만 옮긴다
+    BString locked("locked buffer that is longer than the string moved into it", &mgr);
+    char *pszLocked = locked.LockBuffer();
+    BString src(pszLong, &mgr);
+    locked = std::move(src);
+    ASSERT_EQ(locked, pszLong);
+    ASSERT_EQ(locked.GetString(), pszLocked);
+    ASSERT_TRUE(src.IsEmpty());
+    locked.UnlockBuffer();
+
+    // 잠긴 버퍼보다 길면 버퍼를 넘겨받고, 잠금은 옛 버퍼와 함께 끝난다
+    BString lockedShort("locked", &mgr);
+    lockedShort.LockBuffer();
+    BString srcLong(pszLong, &mgr);
+    const char *pszSrc = srcLong.GetString();
+    int nAllocs = heap.nAllocs;
+    lockedShort = std::move(srcLong);
+    ASSERT_EQ(lockedShort.GetString(), pszSrc);
+    ASSERT_TRUE(srcLong.IsEmpty());
+    ASSERT_EQ(heap.nAllocs, nAllocs);
+    lockedShort += "!";
+    ASSERT_EQ(lockedShort, BString(pszLong) + "!");
+
+    // manager가 달라도 버퍼를 manager와 함께 넘겨받는다
+    BString other("other manager", &otherMgr);
+    BString fromMgr(pszLong, &mgr);
+    const char *pszFrom = fromMgr.GetString();
+    other = std::move(fromMgr);
+    ASSERT_EQ(other, pszLong);
+    ASSERT_EQ(other.GetString(), pszFrom);
+    ASSERT_EQ(other.GetManager(), &mgr);
+    ASSERT_TRUE(fromMgr.IsEmpty());
+    ASSERT_EQ(fromMgr.GetManager(), &mgr);
+    ASSERT_EQ(otherHeap.nAllocs, 0);
+}
+
+TEST(BString, detach_attach_test)
+{
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+    const char *pszLong = "this string is longer than the inline buffer";
+
+    BString a(pszLong, &mgr);
+    AMV::BStringData *pData = a.Detach();
+    ASSERT_TRUE(a.IsEmpty());
+    ASSERT_EQ(pData->nRefs, 1);
+    ASSERT_EQ(pData->nDataLength, static_cast<int>(strlen(pszLong)));
+
+    BString b("short", &mgr);
+    b.Attach(pData);
+    ASSERT_EQ(b, pszLong);
+    ASSERT_EQ(heap.nAllocs, 1);
+
+    // 짧은 문자열은 넘겨줄 버퍼를 하나 할당한다
+    BString c("short", &mgr);
+    pData = c.Detach();
+    ASSERT_EQ(heap.nAllocs, 2);
+    ASSERT_EQ(memcmp(pData->data(), "short", 6), 0);
+    pData->Release();
+
+    // 빈 문자열은 Nil 문자열을 넘긴다
+    BString d(&mgr);
+    pData = d.Detach();
+    d.Attach(pData);
+    ASSERT_TRUE(d.IsEmpty());
+    d += "x";
+    ASSERT_EQ(d, "x");
+    ASSERT_EQ(heap.nAllocs, 2);
+}
+
+TEST(BString, growth_test)
+{
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+    const int N = 1 << 20;
+
+    // 한 글자씩 붙여도 할당 횟수는 길이의 로그에 비례한다
+    {
+        BString s(&mgr);
+        for (int i = 0; i < N; i++)
+            s.AppendChar('a' + i % 26);
+        ASSERT_EQ(s.GetLength(), N);
+        ASSERT_GE(s.GetAllocLength(), N);
+        ASSERT_LT(heap.nAllocs, 40);
+    }
+
+    // 1 / 1이면 필요한 만큼만 늘린다
+    AMV::CAmvStringMgr exact(&heap);
+    exact.SetGrowthFactor(1, 1);
+    {
+        BString s(&exact);
+        heap.nAllocs = 0;
+        for (int i = 0; i < 1000; i++)
+            s.AppendChar('a');
+        ASSERT_GT(heap.nAllocs, 100);
+    }
+
+    // Reserve()는 (8 글자 단위로) 그만큼만 잡고, 그 안에서는 다시 할당하지 않는다
+    {
+        BString s("head", &mgr);
+        s.Reserve(N);
+        ASSERT_GE(s.GetAllocLength(), N);
+        ASSERT_LT(s.GetAllocLength(), N + 8);
+        ASSERT_EQ(s, "head");
+        heap.nAllocs = 0;
+        while (s.GetLength() < N)
+            s += "0123456789abcdef";
+        ASSERT_EQ(heap.nAllocs, 0);
+
+        // 공유 중이면 떼어 내고, 줄이지는 않는다
+        BString copy(s);
+        copy.Reserve(10);
+        ASSERT_EQ(copy, s);
+        ASSERT_NE(copy.GetString(), s.GetString());
+        ASSERT_GE(copy.GetAllocLength(), N);
+    }
+}
+
+TEST(BString, nul_safe_test)
+{
+    const unsigned char uszA[] = {'k', 0x00, 'e', 'y', 0x00, '=', 'v'};
+    const unsigned char uszB[] = {'k', 0x00, 'e', 'y', 0x00, '=', 'w'};
+    BString a(uszA, sizeof(uszA));
+    BString b(uszB, sizeof(uszB));
+    BString key(uszA, 4);
+
+    // '\0' 뒤까지 비교한다
+    ASSERT_EQ(a.GetLength(), 7);
+    ASSERT_FALSE(a == b);
+    ASSERT_TRUE(a != b);
+    ASSERT_LT(a.Compare(b), 0);
+    ASSERT_GT(b.Compare(a), 0);
+    ASSERT_EQ(a.Compare(BString(uszA, sizeof(uszA))), 0);
+    ASSERT_TRUE(a == BString(uszA, sizeof(uszA)));
+
+    // C 문자열은 첫 '\0'에서 끝나므로 "k"보다 길다
+    ASSERT_GT(a.Compare("k"), 0);
+    ASSERT_FALSE(a == "k");
+    ASSERT_GT(key.Compare(BString("k")), 0);
+    ASSERT_LT(key.Compare(a), 0);
+
+    // 부분 문자열도 '\0'을 넘어 찾는다
+    ASSERT_EQ(a.Find("=v"), 5);
+    ASSERT_EQ(a.Find(BString(uszA + 3, 3)), 3);
+    ASSERT_EQ(a.Find(BString(uszA + 3, 3), 4), -1);
+    ASSERT_EQ(a.Find(""), 0);
+    ASSERT_EQ(a.Find("zz"), -1);
+
+    BString upper("Content-Type: TEXT/plain");
+    ASSERT_EQ(upper.CompareNoCase("content-type: text/PLAIN"), 0);
+    ASSERT_LT(upper.CompareNoCase("content-type: text/plainx"), 0);
+    ASSERT_GT(upper.CompareNoCase("content-type: text/plaiM"), 0);
+    ASSERT_EQ(BString(uszA, 7).CompareNoCase(BString(uszA, 7)), 0);
+    ASSERT_NE(a.CompareNoCase(b), 0);
+
+    // 공백 제거도 '\0'에서 멈추지 않는다
+    const unsigned char uszPad[] = {' ', 'x', 0x00, 'y', ' ', '\t'};
+    BString pad(uszPad, sizeof(uszPad));
+    pad.Trim();
+    ASSERT_EQ(pad.GetLength(), 3);
+    ASSERT_EQ(pad.Compare(BString(uszPad + 1, 3)), 0);
+
+    BString zeros(uszA + 4, 1);
+    zeros.TrimLeft('\0');
+    ASSERT_TRUE(zeros.IsEmpty());
+}
+
+TEST(BString, refcount_test)
+{
+    const char *pszLong = "this string is longer than the inline buffer";
+
+    // 한 thread에서만 쓰는 관리자: 참조 계수를 원자 연산 없이 센다
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+    mgr.SetThreadConfined(true);
+    ASSERT_TRUE(mgr.IsThreadConfined());
+    {
+        BString a(pszLong, &mgr);
+        std::vector<BString> copies(100, a);
+        ASSERT_EQ(heap.nAllocs, 1);
+        ASSERT_EQ(copies[99].GetString(), a.GetString());
+        copies.clear();
+        a.SetAt(0, 'T');
+        ASSERT_EQ(heap.nAllocs, 1);
+    }
+
+    // 기본 관리자는 여러 thread가 같은 버퍼를 복사하고 놓아도 계수가 맞는다
+    BString shared(pszLong);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&shared]() {
+            for (int i = 0; i < 10000; i++)
+            {
+                BString copy(shared);
+                ASSERT_EQ(copy.GetString(), shared.GetString());
+            }
+        });
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+    {
+        threads[t].join();
+    }
+    AMV::BStringData *pData = shared.Detach();
+    ASSERT_EQ(pData->nRefs, 1);
+    pData->Release();
+}
+
+TEST(BString, checked_arith_test)
+{
+    // 컴파일 시간에도 계산된다
+    static_assert(AMV::AmvAddThrow(2, 3) == 5, "constexpr AmvAdd");
+
+    int n = 7;
+    ASSERT_EQ(AMV::AmvAdd(&n, INT_MAX - 1, 1), S_OK);
+    ASSERT_EQ(n, INT_MAX);
+    // 넘치면 FAILED이고 결과는 그대로다
+    ASSERT_TRUE(FAILED(AMV::AmvAdd(&n, INT_MAX, 1)));
+    ASSERT_TRUE(FAILED(AMV::AmvAdd(&n, INT_MIN, -1)));
+    ASSERT_EQ(n, INT_MAX);
+    ASSERT_ANY_THROW(AMV::AmvAddThrow(INT_MAX, 1));
+
+    // 64 bit 곱도 넘침을 잡는다
+    uint64_t u = 0;
+    ASSERT_TRUE(FAILED(AMV::AmvMultiply(&u, uint64_t(1) << 32, uint64_t(1) << 32)));
+    ASSERT_EQ(AMV::AmvMultiply(&u, uint64_t(1) << 31, uint64_t(1) << 32), S_OK);
+    ASSERT_EQ(u, uint64_t(1) << 63);
+    int64_t i = 0;
+    ASSERT_TRUE(FAILED(AMV::AmvMultiply(&i, INT64_MIN, int64_t(-1))));
+    ASSERT_EQ(AMV::AmvMultiply(&i, int64_t(-3), int64_t(4)), S_OK);
+    ASSERT_EQ(i, -12);
+
+    size_t nSize = 0;
+    ASSERT_EQ(AMV::AmvMultiplyAdd(&nSize, size_t(10), size_t(4), size_t(32)), S_OK);
+    ASSERT_EQ(nSize, 72u);
+    ASSERT_TRUE(FAILED(AMV::AmvMultiplyAdd(&nSize, SIZE_MAX / 2, size_t(2), size_t(2))));
+    ASSERT_TRUE(FAILED(AMV::AmvMultiplyAdd(&nSize, SIZE_MAX / 2 + 1, size_t(2), size_t(0))));
+
+    // 너무 큰 요청은 감싸 돌지 않고 NULL이다
+    CCountingHeap heap;
+    AMV::CAmvStringMgr mgr(&heap);
+    ASSERT_TRUE(mgr.Allocate(INT_MAX, 1) == NULL);
+    ASSERT_TRUE(mgr.Allocate(INT_MAX - 7, 1) == NULL);
+    ASSERT_EQ(heap.nAllocs, 0);
+    AMV::BStringData *pData = mgr.Allocate(100, 1);
+    ASSERT_TRUE(pData != NULL);
+    ASSERT_EQ(pData->nAllocLength, 103);
+    ASSERT_TRUE(mgr.Reallocate(pData, INT_MAX, 1) == NULL);
+    mgr.Free(pData);
+}
@@ -0,0 +1,72 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fuzz/fuzz_diff.hpp"
+#include "include/CAria.hpp"
+
+namespace
+{
+// AriaDiff()의 입력 형식에 맞춘 임의의 경우 하나
+std::vector<uint8_t> AriaCase(std::mt19937 &rng, int iter)
+{
+    // 블록 경계 근처와 백엔드의 한 번 처리량(16, 32, 64 블록) 근처를 자주 고른다
+    static const size_t lens[] = {0,   1,   15,  16,  17,   31,   255,  256,
+                                  257, 511, 512, 513, 1023, 1024, 1025, 4096};
+    std::vector<uint8_t> v(52);
+    v[0] = static_cast<uint8_t>(iter);
+    for (size_t i = 1; i < v.size(); i++)
+        v[i] = static_cast<uint8_t>(rng());
+    size_t len = (rng() % 2) ? lens[rng() % (sizeof(lens) / sizeof(lens[0]))] : rng() % 1100;
+    for (size_t i = 0; i < len; i++)
+        v.push_back(static_cast<uint8_t>(rng()));
+    return v;
+}
+} // namespace
+
+TEST(CAriaDiff, random_test)
+{
+    std::mt19937 rng(30);
+    std::string strError;
+
+    // 모든 백엔드 x 키 길이 x 정렬 x 길이 x in-place
+    for (int iter = 0; iter < 300; iter++)
+    {
+        std::vector<uint8_t> v = AriaCase(rng, iter);
+        ASSERT_TRUE(AmvFuzz::AriaDiff(v.data(), v.size(), &strError)) << strError;
+    }
+
+    // 짧거나 빈 입력도 받는다
+    for (size_t n = 0; n < 60; n++)
+    {
+        std::vector<uint8_t> v(n, static_cast<uint8_t>(n));
+        ASSERT_TRUE(AmvFuzz::AriaDiff(v.data(), v.size(), &strError)) << strError;
+    }
+}
+
+TEST(CAriaDiff, dispatch_test)
+{
+    // CPU가 지원하는 가장 빠른 백엔드가 선택되어야 한다.  목록에서 빠지거나
+    // 순서가 바뀌면 느린 백엔드가 조용히 선택된다.
+    const char *pszExpect = "table";
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("gfni"))
+        pszExpect = "avx512-gfni";
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("gfni"))
+        pszExpect = "avx2-gfni";
+    else if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("aes"))
+        pszExpect = "aesni";
+#elif defined(__aarch64__)
+    pszExpect = "neon";
+#endif
+    ASSERT_STREQ(Awesome_mix_vol_1::CAria::GetBackends()[0]->name, pszExpect);
+    ASSERT_STREQ(Awesome_mix_vol_1::CAria::GetBackend()->name, pszExpect);
+}
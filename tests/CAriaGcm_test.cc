@@ -0,0 +1,162 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include "include/CAriaGcm.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using Awesome_mix_vol_1::CAriaGcm;
+using Awesome_mix_vol_1::CAriaKey;
+
+namespace
+{
+// OpenSSL의 EVP_aria_*_gcm()으로 만든 값
+// key[i] = i * 3 + n, iv[i] = 0xa0 + i + n, aad[i] = i * 5 + n,
+// pt[i] = i * 7 + n (n은 case 번호)
+struct GcmVector
+{
+    int keyBits;
+    size_t ivLen, aadLen, len;
+    const char *tag;
+    const char *ct32;  // 암호문의 앞 32 Byte
+};
+
+const GcmVector kVectors[] = {
+    {128, 12, 0, 0, "8cefc777d92494700a810e9a3d00a8cc", ""},
+    {128, 12, 16, 64, "60a16fe6d61631ad43a5b76db88a90ce",
+     "f5666b70551d6c5ae8feb3311f8457f9aed31be2d2294a981b0c894945e4a2da"},
+    {192, 12, 13, 61, "df90ce44a784a500ce57ee29e9ec6411",
+     "d17288a0f222bd92beb1824f7f5c831f6b31a59dd99a36958935ce90af839089"},
+    {256, 12, 20, 257, "da8b5f534cdba2544411df945f483dfd",
+     "ebfdc538a9ff3fe2b84428cd9f22bc2cb916d437ba63c07d64e48aa71c060126"},
+    {256, 8, 0, 33, "fa0b2433b9e2e276bb4eab515be83e81",
+     "73d1fdd1ac65de4c1342c74f9912639efb87bc2acb99c83d33f1f6f62782b44c"},
+    {128, 60, 17, 100, "60ec211cae669d914e6485340caa8253",
+     "7e9077149f86fbcbe1b0f718dccafd53323a5cc482507b45e4826b2c1222cb93"},
+};
+
+std::string Hex(const Byte *b, size_t len)
+{
+    std::string s;
+    char buf[3];
+    for (size_t i = 0; i < len; i++)
+    {
+        snprintf(buf, sizeof(buf), "%02x", b[i]);
+        s += buf;
+    }
+    return s;
+}
+}  // namespace
+
+TEST(CAriaGcm, vector_test)
+{
+    const char *ghashes[] = {"pclmul", "pmull", "table"};
+
+    for (const char *name : ghashes)
+    {
+        CAriaGcm gcm;
+        if (gcm.SetGhash(name) != 0)
+            continue;
+        ASSERT_STREQ(gcm.GhashName(), name);
+
+        for (int n = 0; n < 6; n++)
+        {
+            const GcmVector &v = kVectors[n];
+            Byte key[32], iv[64], aad[64], pt[512], ct[512], dt[512];
+            Byte tag[16];
+            for (int i = 0; i < 32; i++)
+                key[i] = i * 3 + n;
+            for (int i = 0; i < 64; i++)
+                iv[i] = 0xa0 + i + n;
+            for (int i = 0; i < 64; i++)
+                aad[i] = i * 5 + n;
+            for (int i = 0; i < 512; i++)
+                pt[i] = i * 7 + n;
+
+            ASSERT_GT(gcm.SetKey(key, v.keyBits), 0);
+            ASSERT_EQ(gcm.Encrypt(iv, v.ivLen, aad, v.aadLen, pt, v.len, ct,
+                                  tag, 16),
+                      0);
+            ASSERT_EQ(Hex(tag, 16), v.tag) << name << " case " << n;
+            ASSERT_EQ(Hex(ct, v.len < 32 ? v.len : 32), v.ct32);
+
+            ASSERT_EQ(gcm.Decrypt(iv, v.ivLen, aad, v.aadLen, ct, v.len, dt,
+                                  tag, 16),
+                      0);
+            ASSERT_EQ(memcmp(dt, pt, v.len), 0);
+
+            // in-place
+            memcpy(dt, ct, v.len);
+            ASSERT_EQ(gcm.Decrypt(iv, v.ivLen, aad, v.aadLen, dt, v.len, dt,
+                                  tag, 16),
+                      0);
+            ASSERT_EQ(memcmp(dt, pt, v.len), 0);
+
+            // 잘린 태그
+            ASSERT_EQ(gcm.Decrypt(iv, v.ivLen, aad, v.aadLen, ct, v.len, dt,
+                                  tag, 12),
+                      0);
+        }
+    }
+}
+
+TEST(CAriaGcm, auth_test)
+{
+    CAriaGcm gcm;
+    Byte key[16] = {0}, iv[12] = {0}, aad[5] = {1, 2, 3, 4, 5};
+    Byte pt[100], ct[100], dt[100], tag[16];
+    for (int i = 0; i < 100; i++)
+        pt[i] = i;
+
+    // 키가 없으면 -1
+    ASSERT_EQ(gcm.Encrypt(iv, 12, aad, 5, pt, 100, ct, tag, 16), -1);
+    ASSERT_EQ(gcm.SetKey(key, 100), -1);
+    ASSERT_EQ(gcm.SetKey(key, 128), 12);
+
+    ASSERT_EQ(gcm.Encrypt(iv, 0, aad, 5, pt, 100, ct, tag, 16), -1);
+    ASSERT_EQ(gcm.Encrypt(iv, 12, aad, 5, pt, 100, ct, tag, 3), -1);
+    ASSERT_EQ(gcm.Encrypt(iv, 12, aad, 5, pt, 100, ct, tag, 17), -1);
+    ASSERT_EQ(gcm.Encrypt(iv, 12, aad, 5, pt, 100, ct, tag, 16), 0);
+
+    // 암호문, 추가 인증 데이터, 태그 중 하나라도 바뀌면 -2이고 out은 지운다
+    ct[50] ^= 1;
+    memset(dt, 0xaa, sizeof(dt));
+    ASSERT_EQ(gcm.Decrypt(iv, 12, aad, 5, ct, 100, dt, tag, 16), -2);
+    for (int i = 0; i < 100; i++)
+        ASSERT_EQ(dt[i], 0);
+    ct[50] ^= 1;
+
+    aad[0] ^= 1;
+    ASSERT_EQ(gcm.Decrypt(iv, 12, aad, 5, ct, 100, dt, tag, 16), -2);
+    aad[0] ^= 1;
+
+    tag[15] ^= 0x80;
+    ASSERT_EQ(gcm.Decrypt(iv, 12, aad, 5, ct, 100, dt, tag, 16), -2);
+    tag[15] ^= 0x80;
+
+    ASSERT_EQ(gcm.Decrypt(iv, 12, aad, 5, ct, 100, dt, tag, 16), 0);
+    ASSERT_EQ(memcmp(dt, pt, 100), 0);
+
+    // CAriaKey를 같이 쓰는 경우
+    std::shared_ptr<CAriaKey> shared = std::make_shared<CAriaKey>();
+    shared->Setup(key, 128);
+    CAriaGcm other;
+    ASSERT_EQ(other.SetKey(shared), 12);
+    ASSERT_EQ(other.Decrypt(iv, 12, aad, 5, ct, 100, dt, tag, 16), 0);
+    ASSERT_EQ(memcmp(dt, pt, 100), 0);
+
+    // 모든 GHASH 구현의 결과가 같다
+    Byte big[4000], bigCt[4000], bigTag[16], t2[16];
+    for (int i = 0; i < 4000; i++)
+        big[i] = i * 11;
+    ASSERT_EQ(gcm.SetGhash("table"), 0);
+    ASSERT_EQ(gcm.Encrypt(iv, 12, big, 333, big, 3999, bigCt, bigTag, 16), 0);
+    ASSERT_EQ(gcm.SetGhash(nullptr), 0);
+    ASSERT_EQ(gcm.Encrypt(iv, 12, big, 333, big, 3999, bigCt, t2, 16), 0);
+    ASSERT_EQ(memcmp(bigTag, t2, 16), 0);
+    ASSERT_EQ(gcm.SetGhash("no-such-ghash"), -1);
+}
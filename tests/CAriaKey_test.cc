@@ -0,0 +1,153 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include "include/CAriaKey.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using Awesome_mix_vol_1::CAria;
+using Awesome_mix_vol_1::CAriaBackend;
+using Awesome_mix_vol_1::CAriaKey;
+using Awesome_mix_vol_1::CAriaKeyCache;
+
+TEST(CAriaKey, setup_test)
+{
+    CAria aria;
+    Byte mk[32], erk[16 * 17] = {0}, drk[16 * 17] = {0};
+    for (int i = 0; i < 32; i++)
+        mk[i] = i;
+
+    CAriaKey key;
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(&key) % 64, 0u);
+    ASSERT_EQ(key.Setup(mk, 100), -1);
+
+    for (int keyBits = 128; keyBits <= 256; keyBits += 64)
+    {
+        int Nr = aria.EncKeySetup(mk, erk, keyBits);
+        aria.DecKeySetup(mk, drk, keyBits);
+
+        ASSERT_EQ(key.Setup(mk, keyBits), Nr);
+        ASSERT_EQ(key.Nr(), Nr);
+        ASSERT_EQ(key.KeyBits(), keyBits);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(key.EncRoundKeys()) % 64, 0u);
+        ASSERT_EQ(memcmp(key.EncRoundKeys(), erk, 16 * (Nr + 1)), 0);
+        ASSERT_EQ(memcmp(key.DecRoundKeys(), drk, 16 * (Nr + 1)), 0);
+        ASSERT_EQ(key.Backend(), CAria::GetBackend());
+    }
+}
+
+TEST(CAriaKey, mode_test)
+{
+    CAria aria;
+    Byte mk[32], erk[16 * 17] = {0}, drk[16 * 17] = {0}, iv[16];
+    Byte p[16 * 100], c[16 * 100], ref[16 * 100];
+    for (int i = 0; i < 32; i++)
+        mk[i] = 0xa5 ^ i;
+    for (int i = 0; i < 16; i++)
+        iv[i] = i;
+    for (int i = 0; i < 16 * 100; i++)
+        p[i] = i * 5;
+
+    const CAriaBackend *const *backends = CAria::GetBackends();
+    for (int kb = 0; backends[kb] != nullptr; kb++)
+    {
+        // 키를 만들 때와 쓸 때의 백엔드가 달라도 결과는 같아야 한다
+        ASSERT_EQ(CAria::SetBackend(backends[kb]->name), 0);
+        CAriaKey key;
+        int Nr = key.Setup(mk, 192);
+        aria.EncKeySetup(mk, erk, 192);
+        aria.DecKeySetup(mk, drk, 192);
+
+        for (int ub = 0; backends[ub] != nullptr; ub++)
+        {
+            ASSERT_EQ(CAria::SetBackend(backends[ub]->name), 0);
+
+            ASSERT_EQ(aria.EcbCrypt(p, sizeof(p), erk, Nr, ref), 0);
+            ASSERT_EQ(aria.EcbEncrypt(p, sizeof(p), key, c), 0);
+            ASSERT_EQ(memcmp(c, ref, sizeof(p)), 0);
+            ASSERT_EQ(aria.EcbDecrypt(ref, sizeof(p), key, c), 0);
+            ASSERT_EQ(memcmp(c, p, sizeof(p)), 0);
+
+            aria.CtrCrypt(p, sizeof(p) - 7, iv, erk, Nr, ref);
+            aria.CtrCrypt(p, sizeof(p) - 7, iv, key, c);
+            ASSERT_EQ(memcmp(c, ref, sizeof(p) - 7), 0);
+
+            ASSERT_EQ(aria.CbcEncrypt(p, sizeof(p), iv, erk, Nr, ref), 0);
+            ASSERT_EQ(aria.CbcEncrypt(p, sizeof(p), iv, key, c), 0);
+            ASSERT_EQ(memcmp(c, ref, sizeof(p)), 0);
+            ASSERT_EQ(aria.CbcDecrypt(ref, sizeof(p), iv, key, c), 0);
+            ASSERT_EQ(memcmp(c, p, sizeof(p)), 0);
+        }
+    }
+    ASSERT_EQ(CAria::SetBackend(nullptr), 0);
+}
+
+TEST(CAriaKey, cache_test)
+{
+    CAriaKeyCache cache(2);
+    Byte mk1[32] = {1}, mk2[32] = {2}, mk3[32] = {3};
+
+    ASSERT_EQ(cache.Get(mk1, 64), nullptr);
+
+    std::shared_ptr<const CAriaKey> k1 = cache.Get(mk1, 128);
+    ASSERT_NE(k1, nullptr);
+    ASSERT_EQ(k1->KeyBits(), 128);
+    ASSERT_EQ(cache.Get(mk1, 128), k1);
+    ASSERT_EQ(cache.Hits(), 1u);
+    ASSERT_EQ(cache.Misses(), 1u);
+
+    // 같은 마스터 키라도 길이가 다르면 다른 키이다
+    std::shared_ptr<const CAriaKey> k1_256 = cache.Get(mk1, 256);
+    ASSERT_NE(k1_256, k1);
+    ASSERT_EQ(cache.Size(), 2u);
+
+    // k1을 최근에 사용했으므로 k1_256이 버려진다
+    ASSERT_EQ(cache.Get(mk1, 128), k1);
+    std::shared_ptr<const CAriaKey> k2 = cache.Get(mk2, 128);
+    ASSERT_EQ(cache.Size(), 2u);
+    ASSERT_EQ(cache.Get(mk1, 128), k1);
+    ASSERT_EQ(cache.Get(mk2, 128), k2);
+    ASSERT_NE(cache.Get(mk1, 256), k1_256);
+
+    // 버려진 키도 가지고 있는 동안에는 유효하다
+    ASSERT_EQ(k1_256->Nr(), 16);
+
+    cache.Get(mk3, 192);
+    cache.Clear();
+    ASSERT_EQ(cache.Size(), 0u);
+
+    CAriaKeyCache none(0);
+    ASSERT_NE(none.Get(mk1, 128), nullptr);
+    ASSERT_EQ(none.Size(), 0u);
+}
+
+TEST(CAriaKey, cache_thread_test)
+{
+    CAriaKeyCache cache(8);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, t]() {
+            CAria aria;
+            Byte mk[32] = {0}, rk[16 * 17];
+            for (int n = 0; n < 200; n++)
+            {
+                mk[0] = (n + t) % 12;
+                std::shared_ptr<const CAriaKey> key = cache.Get(mk, 128);
+                aria.EncKeySetup(mk, rk, 128);
+                ASSERT_EQ(memcmp(key->EncRoundKeys(), rk, 16 * 13), 0);
+            }
+        });
+    }
+    for (std::thread &t : threads)
+        t.join();
+
+    ASSERT_LE(cache.Size(), 8u);
+    ASSERT_EQ(cache.Hits() + cache.Misses(), 800u);
+}
@@ -0,0 +1,120 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include "include/CAriaParallel.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <vector>
+
+using Awesome_mix_vol_1::CAria;
+using Awesome_mix_vol_1::CAriaKey;
+using Awesome_mix_vol_1::CAriaParallel;
+using Awesome_mix_vol_1::CAriaThreadPool;
+
+TEST(CAriaParallel, pool_test)
+{
+    std::atomic<int> count(0);
+    {
+        CAriaThreadPool pool(3);
+        ASSERT_EQ(pool.Size(), 3u);
+        for (int n = 0; n < 1000; n++)
+            pool.Submit([&count]() { count++; });
+        while (pool.RunPending())
+        {
+        }
+    }
+    // 소멸자는 남은 작업을 모두 처리한다
+    ASSERT_EQ(count, 1000);
+}
+
+TEST(CAriaParallel, ctr_ecb_test)
+{
+    CAria aria;
+    CAriaThreadPool pool(4);
+    CAriaParallel parallel(&pool, 100);  // 96 Byte로 내림
+    ASSERT_EQ(parallel.ChunkSize(), 96u);
+
+    Byte mk[32], iv[16];
+    for (int i = 0; i < 32; i++)
+        mk[i] = i * 3;
+    for (int i = 0; i < 16; i++)
+        iv[i] = 0xff;  // chunk 사이에서 카운터가 넘친다
+    iv[0] = 0x12;
+    CAriaKey key;
+    key.Setup(mk, 256);
+
+    std::vector<Byte> p(10000), c(10000), ref(10000);
+    for (size_t i = 0; i < p.size(); i++)
+        p[i] = i * 7 + 1;
+
+    const size_t lens[] = {0, 1, 95, 96, 97, 1000, 4096, 9999, 10000};
+    for (size_t len : lens)
+    {
+        aria.CtrCrypt(p.data(), len, iv, key, ref.data());
+        parallel.CtrCrypt(p.data(), len, iv, key, c.data());
+        ASSERT_EQ(memcmp(c.data(), ref.data(), len), 0) << len;
+
+        // in-place
+        memcpy(c.data(), p.data(), len);
+        parallel.CtrCrypt(c.data(), len, iv, key, c.data());
+        ASSERT_EQ(memcmp(c.data(), ref.data(), len), 0) << len;
+
+        if (len % 16 != 0)
+        {
+            ASSERT_EQ(parallel.EcbEncrypt(p.data(), len, key, c.data()), -1);
+            continue;
+        }
+        ASSERT_EQ(aria.EcbEncrypt(p.data(), len, key, ref.data()), 0);
+        ASSERT_EQ(parallel.EcbEncrypt(p.data(), len, key, c.data()), 0);
+        ASSERT_EQ(memcmp(c.data(), ref.data(), len), 0) << len;
+        ASSERT_EQ(parallel.EcbDecrypt(c.data(), len, key, c.data()), 0);
+        ASSERT_EQ(memcmp(c.data(), p.data(), len), 0) << len;
+    }
+}
+
+TEST(CAriaParallel, async_test)
+{
+    CAria aria;
+    CAriaThreadPool pool(2);
+    CAriaParallel parallel(&pool, 256);
+
+    Byte mk[16] = {0}, iv[16] = {0};
+    CAriaKey key;
+    key.Setup(mk, 128);
+
+    std::vector<Byte> p(5000), c(5000), ref(5000);
+    for (size_t i = 0; i < p.size(); i++)
+        p[i] = i;
+
+    aria.CtrCrypt(p.data(), p.size(), iv, key, ref.data());
+    std::promise<int> ctrDone;
+    ASSERT_EQ(parallel.CtrCryptAsync(p.data(), p.size(), iv, key, c.data(),
+                                     [&ctrDone](int r) { ctrDone.set_value(r); }),
+              0);
+    ASSERT_EQ(ctrDone.get_future().get(), 0);
+    ASSERT_EQ(memcmp(c.data(), ref.data(), p.size()), 0);
+
+    aria.EcbEncrypt(p.data(), 4992, key, ref.data());
+    std::promise<int> ecbDone;
+    ASSERT_EQ(parallel.EcbEncryptAsync(p.data(), 4992, key, c.data(),
+                                       [&ecbDone](int r) { ecbDone.set_value(r); }),
+              0);
+    ASSERT_EQ(ecbDone.get_future().get(), 0);
+    ASSERT_EQ(memcmp(c.data(), ref.data(), 4992), 0);
+
+    ASSERT_EQ(parallel.EcbDecryptAsync(p.data(), 17, key, c.data(), nullptr), -1);
+
+    // pool의 thread 안에서 동기 함수를 불러도 멈추지 않는다
+    std::promise<bool> nested;
+    pool.Submit([&]() {
+        std::vector<Byte> out(p.size());
+        parallel.CtrCrypt(p.data(), p.size(), iv, key, out.data());
+        aria.CtrCrypt(p.data(), p.size(), iv, key, ref.data());
+        nested.set_value(memcmp(out.data(), ref.data(), p.size()) == 0);
+    });
+    ASSERT_TRUE(nested.get_future().get());
+}
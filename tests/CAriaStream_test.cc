@@ -0,0 +1,171 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#include "include/CAriaStream.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+using Awesome_mix_vol_1::CAria;
+using Awesome_mix_vol_1::CAriaKey;
+using Awesome_mix_vol_1::CAriaStream;
+
+namespace
+{
+std::shared_ptr<const CAriaKey> MakeKey(int keyBits)
+{
+    Byte mk[32];
+    for (int i = 0; i < 32; i++)
+        mk[i] = i * 9 + 1;
+    std::shared_ptr<CAriaKey> key = std::make_shared<CAriaKey>();
+    key->Setup(mk, keyBits);
+    return key;
+}
+
+// 입력을 frags 크기로 돌아가며 나누어 Update()에 넣는다
+std::vector<Byte> RunStream(CAriaStream *s, const std::vector<Byte> &in,
+                            const std::vector<size_t> &frags, int *ret)
+{
+    std::vector<Byte> out(in.size() + 32);
+    size_t pos = 0, total = 0, n, f = 0;
+    while (pos < in.size())
+    {
+        size_t len = frags[f++ % frags.size()];
+        if (len > in.size() - pos)
+            len = in.size() - pos;
+        EXPECT_EQ(s->Update(in.data() + pos, len, out.data() + total, &n), 0);
+        pos += len;
+        total += n;
+    }
+    *ret = s->Final(out.data() + total, &n);
+    out.resize(total + n);
+    return out;
+}
+}  // namespace
+
+TEST(CAriaStream, ctr_test)
+{
+    CAria aria;
+    std::shared_ptr<const CAriaKey> key = MakeKey(128);
+    Byte iv[16];
+    for (int i = 0; i < 16; i++)
+        iv[i] = 0xff - (i == 0);
+
+    std::vector<Byte> p(1000), ref(1000);
+    for (size_t i = 0; i < p.size(); i++)
+        p[i] = i * 3;
+    aria.CtrCrypt(p.data(), p.size(), iv, *key, ref.data());
+
+    const std::vector<size_t> fragments[] = {
+        {1}, {15}, {16}, {17}, {7, 33, 64, 5}, {1000}};
+    for (const std::vector<size_t> &frags : fragments)
+    {
+        CAriaStream s;
+        int ret;
+        ASSERT_EQ(s.Init(CAriaStream::kCtr, key, iv), 0);
+        std::vector<Byte> c = RunStream(&s, p, frags, &ret);
+        ASSERT_EQ(ret, 0);
+        ASSERT_EQ(c, ref);
+    }
+
+    // iovec 입력을 모아서 출력
+    std::vector<Byte> c(1000);
+    struct iovec iov[3] = {{&p[0], 5}, {&p[5], 300}, {&p[305], 695}};
+    size_t n;
+    CAriaStream s;
+    ASSERT_EQ(s.Update(p.data(), 1, c.data(), &n), -1);  // Init() 전
+    ASSERT_EQ(s.Init(CAriaStream::kCtr, key, iv), 0);
+    ASSERT_EQ(s.Update(iov, 3, c.data(), &n), 0);
+    ASSERT_EQ(n, 1000u);
+    ASSERT_EQ(c, ref);
+    ASSERT_EQ(s.Final(c.data(), &n), 0);
+    ASSERT_EQ(n, 0u);
+    n = 1234;
+    ASSERT_EQ(s.Update(iov, 3, c.data(), &n), -1);  // Final() 뒤
+    ASSERT_EQ(n, 0u);
+
+    // iovec 버퍼를 제자리에서
+    std::vector<Byte> q = p;
+    struct iovec qv[4] = {
+        {&q[0], 0}, {&q[0], 19}, {&q[19], 13}, {&q[32], 968}};
+    ASSERT_EQ(s.Init(CAriaStream::kCtr, key, iv), 0);
+    ASSERT_EQ(s.UpdateInPlace(qv, 4), 0);
+    ASSERT_EQ(q, ref);
+}
+
+TEST(CAriaStream, cbc_test)
+{
+    CAria aria;
+    std::shared_ptr<const CAriaKey> key = MakeKey(256);
+    Byte iv[16];
+    for (int i = 0; i < 16; i++)
+        iv[i] = i;
+
+    const size_t lens[] = {0, 1, 15, 16, 17, 160, 333};
+    const std::vector<size_t> fragments[] = {{1}, {16}, {5, 11, 40}, {1000}};
+    for (size_t len : lens)
+    {
+        std::vector<Byte> p(len);
+        for (size_t i = 0; i < len; i++)
+            p[i] = i * 13 + 7;
+
+        // padding을 직접 붙인 평문으로 만든 기준값
+        size_t pad = 16 - len % 16;
+        std::vector<Byte> padded = p;
+        padded.insert(padded.end(), pad, static_cast<Byte>(pad));
+        std::vector<Byte> ref(padded.size());
+        ASSERT_EQ(aria.CbcEncrypt(padded.data(), padded.size(), iv, *key,
+                                  ref.data()),
+                  0);
+
+        for (const std::vector<size_t> &frags : fragments)
+        {
+            int ret;
+            CAriaStream enc, dec;
+            ASSERT_EQ(enc.Init(CAriaStream::kCbcEncrypt, key, iv, true), 0);
+            std::vector<Byte> c = RunStream(&enc, p, frags, &ret);
+            ASSERT_EQ(ret, 0);
+            ASSERT_EQ(c, ref);
+
+            ASSERT_EQ(dec.Init(CAriaStream::kCbcDecrypt, key, iv, true), 0);
+            std::vector<Byte> d = RunStream(&dec, c, frags, &ret);
+            ASSERT_EQ(ret, 0);
+            ASSERT_EQ(d, p);
+
+            // padding 없이
+            if (len % 16 == 0)
+            {
+                ASSERT_EQ(enc.Init(CAriaStream::kCbcEncrypt, key, iv), 0);
+                c = RunStream(&enc, p, frags, &ret);
+                ASSERT_EQ(ret, 0);
+                ASSERT_EQ(memcmp(c.data(), ref.data(), len), 0);
+                ASSERT_EQ(dec.Init(CAriaStream::kCbcDecrypt, key, iv), 0);
+                d = RunStream(&dec, c, frags, &ret);
+                ASSERT_EQ(ret, 0);
+                ASSERT_EQ(d, p);
+            }
+            else
+            {
+                ASSERT_EQ(enc.Init(CAriaStream::kCbcEncrypt, key, iv), 0);
+                c = RunStream(&enc, p, frags, &ret);
+                ASSERT_EQ(ret, -1);
+            }
+        }
+    }
+
+    // 잘못된 padding
+    Byte block[16] = {0}, bad[16], out[16];
+    size_t n;
+    aria.CbcEncrypt(block, 16, iv, *key, bad);
+    CAriaStream dec;
+    ASSERT_EQ(dec.Init(CAriaStream::kCbcDecrypt, key, iv, true), 0);
+    ASSERT_EQ(dec.Update(bad, 16, out, &n), 0);
+    ASSERT_EQ(n, 0u);
+    ASSERT_EQ(dec.Final(out, &n), -1);
+    ASSERT_EQ(dec.Update(bad, 16, out, &n), -1);  // Final() 뒤
+
+    ASSERT_EQ(dec.Init(CAriaStream::kCbcDecrypt, nullptr, iv), -1);
+    ASSERT_EQ(dec.UpdateInPlace(nullptr, 0), -1);
+}
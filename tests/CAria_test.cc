@@ -5,6 +5,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <string>
+
 TEST(CAria, excute_test)
 {
     Awesome_mix_vol_1::CAria::CHECK_ENDIAN();
@@ -89,3 +92,231 @@ TEST(CAria, excute_test)
     }
     printf("END   testing the roundtrip.\n");
 }
+
+TEST(CAria, ctr_test)
+{
+    Awesome_mix_vol_1::CAria aria;
+
+    Byte rk[16 * 17] = {0}, mk[32] = {0}, iv[16] = {0};
+    Byte p[300], c[300], d[300], ref[300];
+    for (int i = 0; i < 32; i++)
+        mk[i] = i;
+    for (int i = 0; i < 16; i++)
+        iv[i] = 0xf0 + i;
+    // 카운터의 하위 Byte 들이 넘어가는 경우도 확인한다.
+    iv[15] = 0xfe;
+    iv[14] = 0xff;
+    for (int i = 0; i < 300; i++)
+        p[i] = i * 7;
+
+    for (int keyBits = 128; keyBits <= 256; keyBits += 64)
+    {
+        int Nr = aria.EncKeySetup(mk, rk, keyBits);
+
+        // 블록 단위 Crypt() 로 만든 기준 키 스트림
+        Byte ctr[16], ks[16];
+        memcpy(ctr, iv, 16);
+        for (int i = 0; i < 300; i += 16)
+        {
+            aria.Crypt(ctr, Nr, rk, ks);
+            for (int j = 0; j < 16 && i + j < 300; j++)
+                ref[i + j] = p[i + j] ^ ks[j];
+            for (int j = 15; j >= 0; j--)
+                if (++ctr[j] != 0)
+                    break;
+        }
+
+        const size_t lens[] = {0, 1, 15, 16, 17, 63, 64, 65, 127, 300};
+        for (size_t len : lens)
+        {
+            memset(c, 0, sizeof(c));
+            aria.CtrCrypt(p, len, iv, rk, Nr, c);
+            ASSERT_EQ(memcmp(c, ref, len), 0);
+
+            aria.CtrCrypt(c, len, iv, rk, Nr, d);
+            ASSERT_EQ(memcmp(d, p, len), 0);
+        }
+
+        // in-place
+        memcpy(d, p, sizeof(p));
+        aria.CtrCrypt(d, sizeof(d), iv, rk, Nr, d);
+        ASSERT_EQ(memcmp(d, ref, sizeof(d)), 0);
+    }
+}
+
+TEST(CAria, ecb_cbc_test)
+{
+    Awesome_mix_vol_1::CAria aria;
+
+    Byte erk[16 * 17] = {0}, drk[16 * 17] = {0}, mk[32] = {0}, iv[16] = {0};
+    Byte p[160], c[160], d[160], ref[160];
+    for (int i = 0; i < 32; i++)
+        mk[i] = 0xff - i;
+    for (int i = 0; i < 16; i++)
+        iv[i] = i * 0x10;
+    for (int i = 0; i < 160; i++)
+        p[i] = i * 3 + 1;
+
+    ASSERT_EQ(aria.EcbCrypt(p, 15, erk, 12, c), -1);
+    ASSERT_EQ(aria.CbcEncrypt(p, 17, iv, erk, 12, c), -1);
+    ASSERT_EQ(aria.CbcDecrypt(p, 33, iv, drk, 12, c), -1);
+
+    for (int keyBits = 128; keyBits <= 256; keyBits += 64)
+    {
+        int Nr = aria.EncKeySetup(mk, erk, keyBits);
+        aria.DecKeySetup(mk, drk, keyBits);
+
+        const size_t lens[] = {0, 16, 48, 64, 80, 160};
+        for (size_t len : lens)
+        {
+            // ECB
+            for (size_t i = 0; i < len; i += 16)
+                aria.Crypt(p + i, Nr, erk, ref + i);
+            ASSERT_EQ(aria.EcbCrypt(p, len, erk, Nr, c), 0);
+            ASSERT_EQ(memcmp(c, ref, len), 0);
+            ASSERT_EQ(aria.EcbCrypt(c, len, drk, Nr, d), 0);
+            ASSERT_EQ(memcmp(d, p, len), 0);
+
+            // CBC
+            Byte x[16];
+            const Byte *prev = iv;
+            for (size_t i = 0; i < len; i += 16)
+            {
+                for (int j = 0; j < 16; j++)
+                    x[j] = p[i + j] ^ prev[j];
+                aria.Crypt(x, Nr, erk, ref + i);
+                prev = ref + i;
+            }
+            ASSERT_EQ(aria.CbcEncrypt(p, len, iv, erk, Nr, c), 0);
+            ASSERT_EQ(memcmp(c, ref, len), 0);
+            ASSERT_EQ(aria.CbcDecrypt(c, len, iv, drk, Nr, d), 0);
+            ASSERT_EQ(memcmp(d, p, len), 0);
+
+            // in-place
+            memcpy(d, c, len);
+            ASSERT_EQ(aria.CbcDecrypt(d, len, iv, drk, Nr, d), 0);
+            ASSERT_EQ(memcmp(d, p, len), 0);
+        }
+    }
+}
+
+TEST(CAria, backend_test)
+{
+    Awesome_mix_vol_1::CAria aria;
+
+    const Awesome_mix_vol_1::CAriaBackend *const *backends =
+        Awesome_mix_vol_1::CAria::GetBackends();
+    ASSERT_NE(backends[0], nullptr);
+    ASSERT_EQ(Awesome_mix_vol_1::CAria::GetBackend(), backends[0]);
+
+    // 테이블 백엔드는 항상 마지막에 있다
+    int count = 0;
+    while (backends[count] != nullptr)
+        count++;
+    ASSERT_STREQ(backends[count - 1]->name, "table");
+
+    Byte rk[16 * 17] = {0}, mk[32] = {0};
+    Byte p[16 * 200], c[16 * 200], ref[16 * 200];
+    for (int i = 0; i < 32; i++)
+        mk[i] = i * 7 + 3;
+    for (int i = 0; i < 16 * 200; i++)
+        p[i] = i * 13 + (i >> 8);
+
+    for (int b = 0; b < count; b++)
+    {
+        const Awesome_mix_vol_1::CAriaBackend *backend = backends[b];
+        RecordProperty(std::string("backend_") + backend->name,
+                       static_cast<int>(backend->nParallel));
+
+        for (int keyBits = 128; keyBits <= 256; keyBits += 64)
+        {
+            for (int dec = 0; dec < 2; dec++)
+            {
+                int Nr = dec ? aria.DecKeySetup(mk, rk, keyBits)
+                             : aria.EncKeySetup(mk, rk, keyBits);
+                for (int i = 0; i < 200; i++)
+                    aria.Crypt(p + 16 * i, Nr, rk, ref + 16 * i);
+
+                const size_t counts[] = {1, 3, 4, 15, 16, 17, 33, 64, 65, 200};
+                for (size_t n : counts)
+                {
+                    memset(c, 0, sizeof(c));
+                    backend->CryptBlocks(p, n, Nr, rk, c);
+                    ASSERT_EQ(memcmp(c, ref, n * 16), 0)
+                        << backend->name << " keyBits=" << keyBits
+                        << " n=" << n;
+                    if (n < 200)
+                    {
+                        ASSERT_EQ(c[n * 16], 0);
+                    }
+
+                    // in-place
+                    memcpy(c, p, n * 16);
+                    backend->CryptBlocks(c, n, Nr, rk, c);
+                    ASSERT_EQ(memcmp(c, ref, n * 16), 0);
+                }
+            }
+        }
+
+        // 선택한 백엔드로 모드 함수가 동작하는지 확인
+        ASSERT_EQ(Awesome_mix_vol_1::CAria::SetBackend(backend->name), 0);
+        ASSERT_EQ(Awesome_mix_vol_1::CAria::GetBackend(), backend);
+        int Nr = aria.EncKeySetup(mk, rk, 256);
+        for (int i = 0; i < 200; i++)
+            aria.Crypt(p + 16 * i, Nr, rk, ref + 16 * i);
+        ASSERT_EQ(aria.EcbCrypt(p, sizeof(p), rk, Nr, c), 0);
+        ASSERT_EQ(memcmp(c, ref, sizeof(p)), 0);
+    }
+
+    ASSERT_EQ(Awesome_mix_vol_1::CAria::SetBackend("no-such-backend"), -1);
+    ASSERT_EQ(Awesome_mix_vol_1::CAria::SetBackend(nullptr), 0);
+    ASSERT_EQ(Awesome_mix_vol_1::CAria::GetBackend(), backends[0]);
+}
+
+TEST(CAria, template_test)
+{
+    Awesome_mix_vol_1::CAria aria;
+
+    Byte rk[16 * 17] = {0}, trk[16 * 17] = {0}, mk[32];
+    Byte p[16], c[16], tc[16];
+    for (int i = 0; i < 32; i++)
+        mk[i] = i;
+    for (int i = 0; i < 16; i++)
+        p[i] = i * 0x11;
+
+    // 128-bit
+    static_assert(Awesome_mix_vol_1::CAria::RoundsOf(128) == 12, "");
+    ASSERT_EQ(aria.EncKeySetup<128>(mk, trk), 12);
+    ASSERT_EQ(aria.EncKeySetup(mk, rk, 128), 12);
+    ASSERT_EQ(memcmp(rk, trk, sizeof(rk)), 0);
+    aria.Crypt(p, 12, rk, c);
+    aria.Crypt<12>(p, trk, tc);
+    ASSERT_EQ(memcmp(c, tc, 16), 0);
+    ASSERT_EQ(aria.DecKeySetup<128>(mk, trk), 12);
+    aria.Crypt<12>(c, trk, tc);
+    ASSERT_EQ(memcmp(p, tc, 16), 0);
+
+    // 192-bit
+    static_assert(Awesome_mix_vol_1::CAria::RoundsOf(192) == 14, "");
+    ASSERT_EQ(aria.EncKeySetup<192>(mk, trk), 14);
+    ASSERT_EQ(aria.EncKeySetup(mk, rk, 192), 14);
+    ASSERT_EQ(memcmp(rk, trk, sizeof(rk)), 0);
+    aria.Crypt(p, 14, rk, c);
+    aria.Crypt<14>(p, trk, tc);
+    ASSERT_EQ(memcmp(c, tc, 16), 0);
+    ASSERT_EQ(aria.DecKeySetup<192>(mk, trk), 14);
+    aria.Crypt<14>(c, trk, tc);
+    ASSERT_EQ(memcmp(p, tc, 16), 0);
+
+    // 256-bit
+    static_assert(Awesome_mix_vol_1::CAria::RoundsOf(256) == 16, "");
+    ASSERT_EQ(aria.EncKeySetup<256>(mk, trk), 16);
+    ASSERT_EQ(aria.EncKeySetup(mk, rk, 256), 16);
+    ASSERT_EQ(memcmp(rk, trk, sizeof(rk)), 0);
+    aria.Crypt(p, 16, rk, c);
+    aria.Crypt<16>(p, trk, tc);
+    ASSERT_EQ(memcmp(c, tc, 16), 0);
+    ASSERT_EQ(aria.DecKeySetup<256>(mk, trk), 16);
+    aria.Crypt<16>(c, trk, tc);
+    ASSERT_EQ(memcmp(p, tc, 16), 0);
+}
@@ -0,0 +1,26 @@
+// Copyright 2021~2022 `anothel` All rights reserved
+
+#ifndef TESTS_COUNTING_HEAP_HPP_
+#define TESTS_COUNTING_HEAP_HPP_
+
+#include "include/amvmem.hpp"
+
+// Allocate()/Reallocate() 호출 횟수를 센다
+class CCountingHeap : public AMV::CAmvHeap
+{
+public:
+    void *Allocate(size_t nBytes) throw() override
+    {
+        nAllocs++;
+        return AMV::CAmvHeap::Allocate(nBytes);
+    }
+    void *Reallocate(void *p, size_t nBytes) throw() override
+    {
+        nAllocs++;
+        return AMV::CAmvHeap::Reallocate(p, nBytes);
+    }
+
+    int nAllocs = 0;
+};
+
+#endif // TESTS_COUNTING_HEAP_HPP_